@@ -0,0 +1,37 @@
+#include "can_esp_lib.h"
+#include "can_esp_benchmark.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+static const char *TAG = "BENCHMARK";
+
+/* Cada resultado é uma linha JSON na saída padrão (filtrável por linhas iniciadas em '{') */
+static void print_result(const char *line, void *ctx)
+{
+    (void)ctx;
+    printf("%s\n", line);
+}
+
+void app_main(void)
+{
+    CanEspBenchmarkConfig_t config;
+
+    CAN_ESP_BenchmarkDefaultConfig(&config, print_result, NULL);
+
+    /* Micro benchmarks: fila de transmissão de uma instância privada, sem driver nem tarefas */
+    if (CAN_ESP_RunMicroBenchmarks(&config) != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha nos micro benchmarks.");
+    }
+
+    /* Vazão e latência sobre o barramento virtual (biblioteca, receptor e gerador de carga) */
+    if (CAN_ESP_RunMacroBenchmarks(&config) != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha nos macro benchmarks.");
+    }
+
+    ESP_LOGI(TAG, "Benchmarks concluídos.");
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
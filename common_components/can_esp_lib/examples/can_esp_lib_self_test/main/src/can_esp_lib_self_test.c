@@ -6,43 +6,57 @@
 
 static const char *TAG = "SELF_TEST";
 
-/* Tarefa de recepção: processa mensagens continuamente */
+/* Tarefa de recepção: processa mensagens continuamente (bloqueia até CAN_PROCESS_TIMEOUT_MS por lote) */
 static void receive_task(void *arg)
 {
     while (1) {
         CAN_ESP_ProcessReceivedMessages();
-        vTaskDelay(pdMS_TO_TICKS(10)); // Polling a cada 10 ms
     }
 }
 
-/* Tarefa de transmissão: envia várias mensagens com códigos distintos */
-static void transmit_task(void *arg)
+/* Tabela de comandos conforme a definição do projeto */
+static const uint16_t message_commands[] = {
+    0x001, 0x002, 0x003, 0x004,  // Controle do Motor Elétrico
+    0x101, 0x102,                // Controle da Aceleração
+    0x201, 0x202,                // Controle do Freio
+    0x301, 0x302, 0x303,         // Controle da Direção
+    0x401, 0x402, 0x403,         // Monitoramento da Bateria
+    0x501, 0x502,                // Controle da Velocidade do Veículo
+    0x601, 0x602, 0x603          // Diagnóstico (via OBD-II)
+};
+#define NUM_MESSAGES    (sizeof(message_commands) / sizeof(message_commands[0]))
+
+/* Período de cada mensagem cíclica do teste (1 s) */
+#define SELF_TEST_PERIOD_US     (1000000U)
+
+static can_esp_cyclic_t cyclic_handles[NUM_MESSAGES];
+
+/* Preenche a mensagem cíclica: índice do comando, padrão fixo e contador de liberações */
+static bool fill_cyclic_message(CanEspMessage_t *msg, void *ctx)
 {
-    /* Tabela de comandos conforme a definição do projeto */
-    static const uint16_t message_commands[] = {
-        0x001, 0x002, 0x003, 0x004,  // Controle do Motor Elétrico
-        0x101, 0x102,                // Controle da Aceleração
-        0x201, 0x202,                // Controle do Freio
-        0x301, 0x302, 0x303,         // Controle da Direção
-        0x401, 0x402, 0x403,         // Monitoramento da Bateria
-        0x501, 0x502,                // Controle da Velocidade do Veículo
-        0x601, 0x602, 0x603          // Diagnóstico (via OBD-II)
-    };
-    size_t num_msgs = sizeof(message_commands) / sizeof(message_commands[0]);
+    static uint8_t counters[NUM_MESSAGES];
+    size_t index = (size_t)(uintptr_t)ctx;
 
-    for (size_t i = 0; i < num_msgs; i++) {
+    msg->data[0] = (uint8_t)index;
+    msg->data[1] = 0xAA;
+    msg->data[2] = 0xBB;
+    msg->data[3] = counters[index]++;
+    msg->length = 4U;
+    return true;
+}
+
+/* Registra todas as mensagens no escalonador cíclico; as fases são distribuídas automaticamente */
+static void register_cyclic_messages(void)
+{
+    for (size_t i = 0; i < NUM_MESSAGES; i++) {
         /* Para este teste, usamos prioridade 1, módulo 1 e o comando conforme tabela */
         uint32_t id = CAN_ESP_EncodeID(1, 1, message_commands[i]);
-        uint8_t data[CAN_MAX_DATA_LENGTH] = { (uint8_t)i, 0xAA, 0xBB, 0xCC, 0, 0, 0, 0 };
-
-        if (CAN_ESP_SendMessage(id, data, 4) != CAN_ESP_OK) {
-            ESP_LOGE(TAG, "Erro ao enviar mensagem para comando 0x%03X", message_commands[i]);
-        } else {
-            ESP_LOGI(TAG, "Mensagem enviada para comando 0x%03X", message_commands[i]);
+        if (CAN_ESP_RegisterCyclicMessage(id, SELF_TEST_PERIOD_US, CAN_ESP_CYCLIC_AUTO_OFFSET,
+                                          fill_cyclic_message, (void *)(uintptr_t)i,
+                                          &cyclic_handles[i]) != CAN_ESP_OK) {
+            ESP_LOGE(TAG, "Erro ao registrar mensagem cíclica para comando 0x%03X", message_commands[i]);
         }
-        vTaskDelay(pdMS_TO_TICKS(200));  // Aguarda 200 ms entre envios
     }
-    vTaskDelete(NULL);
 }
 
 /* Callback para mensagens recebidas */
@@ -87,11 +101,17 @@ void app_main(void)
         ESP_LOGE(TAG, "Erro ao registrar callback de recepção.");
     }
 
-    /* Cria as tarefas de transmissão e recepção */
+    /* Cria a tarefa de recepção; a transmissão fica a cargo do escalonador cíclico */
     xTaskCreate(receive_task, "receive_task", 4096, NULL, 5, NULL);
-    xTaskCreate(transmit_task, "transmit_task", 4096, NULL, 5, NULL);
+    CAN_ESP_StartTransmitTask();
+    register_cyclic_messages();
 
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(1000));
+        CanEspCyclicStats_t stats;
+        if (CAN_ESP_GetCyclicStats(cyclic_handles[0], &stats) == CAN_ESP_OK) {
+            ESP_LOGI(TAG, "Cíclica 0x%03X: liberações = %" PRIu32 ", jitter médio = %" PRIu32 " us, máximo = %" PRIu32 " us",
+                     message_commands[0], stats.releases, stats.mean_jitter_us, stats.max_jitter_us);
+        }
     }
 }
@@ -0,0 +1,80 @@
+/*
+ * can_esp_benchmark.h
+ * Micro e macro benchmarks dos caminhos críticos da can_esp_lib
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#ifndef CAN_ESP_BENCHMARK_H
+#define CAN_ESP_BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "can_esp_lib.h"
+
+/* Valores padrão da configuração */
+#define CAN_ESP_BENCH_DEFAULT_MICRO_ITERATIONS   (20000U)
+#define CAN_ESP_BENCH_DEFAULT_THROUGHPUT_FRAMES  (2000U)
+#define CAN_ESP_BENCH_DEFAULT_LATENCY_SAMPLES    (500U)
+#define CAN_ESP_BENCH_DEFAULT_BITRATE            (500000U)
+
+/* Pontos de carga de barramento (%) da medição de latência fim a fim */
+#define CAN_ESP_BENCH_LOAD_POINTS                { 10U, 50U, 90U }
+
+/* Tamanho máximo de uma linha de resultado */
+#define CAN_ESP_BENCH_LINE_MAX                   (256U)
+
+/**
+ * @brief Destino dos resultados: recebe uma linha JSON completa (sem quebra de linha) por medição.
+ */
+typedef void (*can_esp_bench_writer_t)(const char *line, void *ctx);
+
+/**
+ * @brief Configuração dos benchmarks.
+ */
+typedef struct {
+    uint32_t micro_iterations;      /**< Iterações de cada micro benchmark. */
+    uint32_t throughput_frames;     /**< Quadros por medição de vazão. */
+    uint32_t latency_samples;       /**< Amostras de latência por ponto de carga. */
+    uint32_t bitrate;               /**< Taxa do barramento virtual dos macro benchmarks. */
+    can_esp_bench_writer_t writer;  /**< Destino das linhas JSON. */
+    void *ctx;                      /**< Contexto do destino. */
+} CanEspBenchmarkConfig_t;
+
+/**
+ * @brief Preenche a configuração com os valores padrão.
+ */
+void CAN_ESP_BenchmarkDefaultConfig(CanEspBenchmarkConfig_t *config, can_esp_bench_writer_t writer, void *ctx);
+
+/**
+ * @brief Mede o custo por operação de EncodeID/DecodeID, checksum, conversão para o driver,
+ *        cálculo de bits do quadro e enfileiramento/retirada da fila de transmissão.
+ *
+ * Não requer driver. A fila é exercitada numa instância privada (CAN_ESP_CreateInstance),
+ * removida ao final; a instância padrão e sua fila não são tocadas. Requer uma instância livre
+ * (CONFIG_CAN_ESP_MAX_INSTANCES >= 2).
+ */
+can_esp_status_t CAN_ESP_RunMicroBenchmarks(const CanEspBenchmarkConfig_t *config);
+
+/**
+ * @brief Mede vazão (SendMessage síncrono x EnqueueMessage assíncrono) e latência fim a fim a
+ *        10/50/90% de carga sobre o barramento virtual.
+ *
+ * Cria o barramento virtual com três nós (biblioteca, receptor e gerador de carga) e inicializa
+ * sobre o primeiro uma instância privada da biblioteca; a instância padrão não é usada. Ao final
+ * ou em caso de falha, desinstala o driver da instância privada, restaura nela o driver TWAI
+ * nativo e encerra o barramento virtual. A instância privada ocupa uma vaga do pool de forma
+ * permanente (sua tarefa de transmissão não pode ser encerrada) e é reaproveitada nas execuções
+ * seguintes. Deve ser chamada sem outro barramento virtual ativo.
+ */
+can_esp_status_t CAN_ESP_RunMacroBenchmarks(const CanEspBenchmarkConfig_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_BENCHMARK_H */
@@ -0,0 +1,192 @@
+/*
+ * can_esp_capture.h
+ * Captura de quadros brutos em anel com exportação nos formatos candump e Vector ASC
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * O anel é pré-alocado e registra, com o instante medido pela biblioteca, todos os quadros
+ * recebidos do driver e entregues a ele para transmissão, de todas as instâncias, além das
+ * mudanças de estado de erro observadas pelo supervisor de recuperação. Cheio, sobrescreve o
+ * registro mais antigo (gravador de voo); congelado, preserva o conteúdo até ser exportado.
+ *
+ * Uso típico:
+ *   CAN_ESP_CaptureDefaultConfig(&cfg);
+ *   CAN_ESP_CaptureStart(&cfg);
+ *   ...
+ *   if (CAN_ESP_CaptureIsFrozen()) {
+ *       CAN_ESP_CaptureExport(CAN_ESP_CAPTURE_FORMAT_ASC, writer, ctx);
+ *       CAN_ESP_CaptureResume(true);
+ *   }
+ */
+
+#ifndef CAN_ESP_CAPTURE_H
+#define CAN_ESP_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "can_esp_lib.h"
+
+/* Número de registros do anel (memória estática: 24 bytes por registro) */
+#ifndef CAN_ESP_CAPTURE_RING_SIZE
+#define CAN_ESP_CAPTURE_RING_SIZE       (1024U)
+#endif
+
+/* Registros gravados após o gatilho de bus-off antes do congelamento automático */
+#define CAN_ESP_CAPTURE_DEFAULT_POST_TRIGGER    (64U)
+
+/* Maior linha produzida por CAN_ESP_CaptureFormatRecord (sem o terminador) */
+#define CAN_ESP_CAPTURE_MAX_LINE_LENGTH (96U)
+
+/* Sinalizadores de um registro */
+#define CAN_ESP_CAPTURE_FLAG_TX         (0x01U)  /**< Quadro transmitido (ausente: recebido). */
+#define CAN_ESP_CAPTURE_FLAG_EXTD       (0x02U)  /**< Identificador estendido (29 bits). */
+#define CAN_ESP_CAPTURE_FLAG_RTR        (0x04U)  /**< Quadro remoto. */
+#define CAN_ESP_CAPTURE_FLAG_ERROR      (0x08U)  /**< Evento de erro: id contém o novo CanEspBusState_t. */
+
+/**
+ * @brief Formatos de exportação.
+ */
+typedef enum {
+    CAN_ESP_CAPTURE_FORMAT_CANDUMP = 0,     /**< Log do candump (can-utils): "(s.us) canN ID#DADOS". */
+    CAN_ESP_CAPTURE_FORMAT_ASC              /**< Vector ASC com timestamps relativos ao primeiro registro. */
+} CanEspCaptureFormat_t;
+
+/**
+ * @brief Registro de um quadro capturado.
+ *
+ * Em quadros recebidos o instante é o da retirada do driver; em transmitidos, o da entrega ao
+ * driver (para o instante de confirmação no barramento, use o callback de conclusão). Os dados
+ * são os do quadro bruto, incluindo o checksum quando habilitado.
+ */
+typedef struct {
+    int64_t  timestamp_us;              /**< esp_timer_get_time() do evento. */
+    uint32_t id;                        /**< Identificador, ou estado de barramento em eventos de erro. */
+    uint8_t  flags;                     /**< CAN_ESP_CAPTURE_FLAG_*. */
+    uint8_t  channel;                   /**< Índice da instância (0 = padrão). */
+    uint8_t  length;                    /**< DLC. */
+    uint8_t  data[CAN_MAX_DATA_LENGTH]; /**< Carga útil. */
+} CanEspCaptureRecord_t;
+
+/**
+ * @brief Configuração da captura.
+ */
+typedef struct {
+    bool     capture_rx;                /**< Registra quadros recebidos. */
+    bool     capture_tx;                /**< Registra quadros transmitidos. */
+    bool     capture_errors;            /**< Registra mudanças de estado de erro (requer o supervisor). */
+    bool     freeze_on_bus_off;         /**< Congela automaticamente após um bus-off. */
+    uint32_t post_trigger_records;      /**< Registros mantidos após o bus-off antes de congelar. */
+} CanEspCaptureConfig_t;
+
+/**
+ * @brief Estatísticas da captura.
+ */
+typedef struct {
+    uint32_t capacity;                  /**< CAN_ESP_CAPTURE_RING_SIZE. */
+    uint32_t count;                     /**< Registros disponíveis no anel. */
+    uint32_t recorded;                  /**< Registros gravados desde CAN_ESP_CaptureStart. */
+    uint32_t overwritten;               /**< Registros perdidos por sobrescrita antes de lidos. */
+    uint32_t dropped_while_frozen;      /**< Eventos ignorados com o anel congelado. */
+    uint32_t triggers;                  /**< Congelamentos automáticos por bus-off. */
+    bool     running;                   /**< Captura iniciada. */
+    bool     frozen;                    /**< Anel congelado. */
+} CanEspCaptureStats_t;
+
+/**
+ * @brief Destino das linhas exportadas (ex.: arquivo no SD card ou socket).
+ *
+ * @param text   Bloco com uma ou mais linhas terminadas em '\n' (não terminado em '\0').
+ * @param length Tamanho do bloco.
+ * @param ctx    Contexto informado na exportação.
+ * @return true para continuar; false interrompe a exportação.
+ */
+typedef bool (*can_esp_capture_writer_t)(const char *text, size_t length, void *ctx);
+
+/**
+ * @brief Preenche a configuração padrão (RX, TX e erros, congelamento em bus-off).
+ */
+void CAN_ESP_CaptureDefaultConfig(CanEspCaptureConfig_t *config);
+
+/**
+ * @brief Esvazia o anel e inicia a captura.
+ *
+ * @param config Configuração (NULL = padrão).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_CaptureStart(const CanEspCaptureConfig_t *config);
+
+/**
+ * @brief Interrompe a captura, preservando os registros para leitura ou exportação.
+ */
+void CAN_ESP_CaptureStop(void);
+
+/**
+ * @brief Congela o anel imediatamente; eventos posteriores são apenas contados.
+ */
+void CAN_ESP_CaptureFreeze(void);
+
+/**
+ * @brief Retoma a gravação após um congelamento.
+ *
+ * @param clear Descarta os registros ainda não lidos.
+ */
+void CAN_ESP_CaptureResume(bool clear);
+
+/**
+ * @brief Indica se o anel está congelado (manualmente ou pelo gatilho de bus-off).
+ */
+bool CAN_ESP_CaptureIsFrozen(void);
+
+/**
+ * @brief Retira do anel até max registros, do mais antigo ao mais recente (streaming).
+ *
+ * @param[out] records Destino.
+ * @param max          Capacidade do destino.
+ * @param[out] count   Registros copiados.
+ */
+can_esp_status_t CAN_ESP_CaptureRead(CanEspCaptureRecord_t *records, size_t max, size_t *count);
+
+/**
+ * @brief Obtém as estatísticas da captura.
+ */
+can_esp_status_t CAN_ESP_CaptureGetStats(CanEspCaptureStats_t *stats);
+
+/**
+ * @brief Formata um registro como uma linha do formato escolhido, terminada em '\n'.
+ *
+ * @param format    Formato.
+ * @param record    Registro.
+ * @param origin_us Origem dos timestamps relativos do ASC (ignorada no candump).
+ * @param[out] buf  Destino, com ao menos CAN_ESP_CAPTURE_MAX_LINE_LENGTH + 1 bytes.
+ * @param size      Tamanho do destino.
+ * @return Tamanho da linha, ou 0 se o destino for insuficiente.
+ */
+size_t CAN_ESP_CaptureFormatRecord(CanEspCaptureFormat_t format, const CanEspCaptureRecord_t *record,
+                                   int64_t origin_us, char *buf, size_t size);
+
+/**
+ * @brief Exporta o conteúdo do anel no formato escolhido, consumindo os registros.
+ *
+ * No ASC, o cabeçalho e o rodapé são incluídos e os timestamps são relativos ao primeiro
+ * registro exportado; no candump são os segundos desde a inicialização. Somente os registros
+ * presentes no início da chamada são exportados, de modo que, com a captura ativa, chamadas
+ * periódicas funcionam como streaming.
+ *
+ * @param format Formato.
+ * @param writer Destino das linhas.
+ * @param ctx    Contexto do destino.
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_TRANSMIT se o destino interromper a exportação.
+ */
+can_esp_status_t CAN_ESP_CaptureExport(CanEspCaptureFormat_t format, can_esp_capture_writer_t writer, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_CAPTURE_H */
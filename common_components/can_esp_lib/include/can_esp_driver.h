@@ -0,0 +1,77 @@
+/*
+ * can_esp_driver.h
+ * Interface de backend de driver da can_esp_lib
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#ifndef CAN_ESP_DRIVER_H
+#define CAN_ESP_DRIVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_esp_lib.h"
+
+/**
+ * @brief Operações de driver utilizadas pela biblioteca.
+ *
+ * Espelham a API twai_* do ESP-IDF, acrescidas de um contexto. O backend padrão encaminha as
+ * chamadas ao driver TWAI do chip; o barramento virtual (can_esp_virtual_bus.h) fornece um
+ * backend alternativo para builds de host e testes de carga.
+ */
+typedef struct {
+    esp_err_t (*install)(void *ctx, const twai_general_config_t *g_config,
+                         const twai_timing_config_t *t_config, const twai_filter_config_t *f_config);
+    esp_err_t (*uninstall)(void *ctx);
+    esp_err_t (*start)(void *ctx);
+    esp_err_t (*stop)(void *ctx);
+    esp_err_t (*transmit)(void *ctx, const twai_message_t *message, TickType_t ticks_to_wait);
+    esp_err_t (*receive)(void *ctx, twai_message_t *message, TickType_t ticks_to_wait);
+    esp_err_t (*get_status_info)(void *ctx, twai_status_info_t *status_info);
+    esp_err_t (*read_alerts)(void *ctx, uint32_t *alerts, TickType_t ticks_to_wait);
+    esp_err_t (*reconfigure_alerts)(void *ctx, uint32_t alerts_enabled, uint32_t *current_alerts);
+    esp_err_t (*initiate_recovery)(void *ctx);
+} CanEspDriverOps_t;
+
+/**
+ * @brief Retorna o backend do driver TWAI nativo (NULL no alvo linux).
+ */
+const CanEspDriverOps_t *CAN_ESP_GetTwaiDriverOps(void);
+
+/**
+ * @brief Seleciona o backend de driver utilizado pela biblioteca.
+ *
+ * Deve ser chamada antes de CAN_ESP_Init/CAN_ESP_InitWithConfig (ou com o driver desinstalado).
+ *
+ * @param ops Operações do backend; NULL restaura o driver TWAI nativo.
+ * @param ctx Contexto repassado a todas as operações.
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM se o driver estiver instalado.
+ */
+can_esp_status_t CAN_ESP_SetDriverBackend(const CanEspDriverOps_t *ops, void *ctx);
+
+/**
+ * @brief Variante de CAN_ESP_SetDriverBackend para uma instância específica (can_esp_instance.h).
+ */
+can_esp_status_t CAN_ESP_SetDriverBackend_v2(can_esp_handle_t handle, const CanEspDriverOps_t *ops, void *ctx);
+
+/**
+ * @brief Retorna o backend de um controlador TWAI específico (API twai_*_v2, ESP-IDF 5.2 ou superior).
+ *
+ * Permite associar cada instância da biblioteca a um dos controladores de chips com mais de um
+ * periférico TWAI (ex.: ESP32-C6). O controller_id da configuração geral é substituído pelo
+ * controlador escolhido na instalação.
+ *
+ * @param controller_id Índice do controlador.
+ * @param[out] ctx      Contexto a ser informado em CAN_ESP_SetDriverBackend_v2.
+ * @return Operações do backend, ou NULL se o controlador não existir (ou no alvo linux).
+ */
+const CanEspDriverOps_t *CAN_ESP_GetTwaiControllerDriverOps(uint32_t controller_id, void **ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_DRIVER_H */
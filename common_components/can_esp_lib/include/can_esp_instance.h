@@ -0,0 +1,161 @@
+/*
+ * can_esp_instance.h
+ * API por instância da can_esp_lib (vários controladores / barramentos)
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * Cada instância possui configuração, backend de driver, filas de transmissão e recepção,
+ * tarefas, callbacks, inscrições, escalonador cíclico e métricas próprios. As funções CAN_ESP_*
+ * de can_esp_lib.h operam sobre a instância padrão (CAN_ESP_GetDefaultHandle); as variantes
+ * _v2 abaixo, no estilo das funções twai_*_v2 do ESP-IDF, recebem a instância como primeiro
+ * parâmetro e têm a mesma semântica das originais (com handle nulo retornam
+ * CAN_ESP_ERR_NULL_POINTER, ou 0 nas que retornam contadores).
+ *
+ * Uso típico (gateway com dois barramentos):
+ *   CAN_ESP_CreateInstance(&bus_b);
+ *   CAN_ESP_SetDriverBackend_v2(bus_b, ops, ctx);   (ex.: CAN_ESP_GetTwaiControllerDriverOps)
+ *   CAN_ESP_InitWithConfig_v2(bus_b, &config_b);
+ *   CAN_ESP_StartTransmitTask_v2(bus_b);
+ *   CAN_ESP_StartReceiveTask_v2(bus_b);
+ */
+
+#ifndef CAN_ESP_INSTANCE_H
+#define CAN_ESP_INSTANCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_esp_lib.h"
+
+/**
+ * @brief Retorna o handle da instância padrão (usada pelas funções sem handle).
+ */
+can_esp_handle_t CAN_ESP_GetDefaultHandle(void);
+
+/**
+ * @brief Reserva uma nova instância, com a configuração padrão e o driver TWAI nativo.
+ *
+ * As instâncias residem em memória estática (até CAN_ESP_MAX_INSTANCES, incluindo a padrão; o
+ * padrão é 4 no alvo linux e 1 nas demais, ajustável em CONFIG_CAN_ESP_MAX_INSTANCES).
+ *
+ * @param[out] handle Handle da instância criada.
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_QUEUE_FULL se não houver instância livre.
+ */
+can_esp_status_t CAN_ESP_CreateInstance(can_esp_handle_t *handle);
+
+/**
+ * @brief Libera uma instância criada por CAN_ESP_CreateInstance.
+ *
+ * O driver deve estar desinstalado (CAN_ESP_Deinit_v2) e nenhuma tarefa da instância pode ter
+ * sido iniciada. A instância padrão não pode ser liberada.
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM se o handle for inválido ou estiver em uso.
+ */
+can_esp_status_t CAN_ESP_DeleteInstance(can_esp_handle_t handle);
+
+/* Configuração dinâmica */
+can_esp_status_t CAN_ESP_InitWithConfig_v2(can_esp_handle_t handle, const CanEspConfig_t *config);
+can_esp_status_t CAN_ESP_Init_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_UpdateConfig_v2(can_esp_handle_t handle, const CanEspConfig_t *config);
+can_esp_status_t CAN_ESP_Deinit_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_Reconfigure_v2(can_esp_handle_t handle, const CanEspConfig_t *config);
+can_esp_status_t CAN_ESP_GetReconfigStats_v2(can_esp_handle_t handle, CanEspReconfigStats_t *stats);
+can_esp_status_t CAN_ESP_SetFilterConfig_v2(can_esp_handle_t handle, const twai_filter_config_t *new_filter_config);
+can_esp_status_t CAN_ESP_SetTimeouts_v2(can_esp_handle_t handle, uint32_t tx_timeout_ms, uint32_t rx_timeout_ms);
+
+/* Comunicação síncrona e recepção */
+can_esp_status_t CAN_ESP_SendMessage_v2(can_esp_handle_t handle, uint32_t id, const uint8_t *data, uint8_t length);
+can_esp_status_t CAN_ESP_ReceiveMessage_v2(can_esp_handle_t handle, CanEspMessage_t *message, uint32_t timeout_ms);
+can_esp_status_t CAN_ESP_ReceiveBatch_v2(can_esp_handle_t handle, CanEspMessage_t *out, size_t max,
+                                         uint32_t timeout_ms, size_t *count);
+can_esp_status_t CAN_ESP_RegisterReceiveCallback_v2(can_esp_handle_t handle, can_esp_receive_callback_t callback);
+void CAN_ESP_ProcessReceivedMessages_v2(can_esp_handle_t handle);
+
+/* Inscrições e filtro de aceitação */
+can_esp_status_t CAN_ESP_Subscribe_v2(can_esp_handle_t handle, uint32_t id, uint32_t mask,
+                                      can_esp_subscription_handler_t handler, void *ctx,
+                                      can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_SubscribeId_v2(can_esp_handle_t handle, uint32_t id, can_esp_subscription_handler_t handler,
+                                        void *ctx, can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_SubscribeModuleCommand_v2(can_esp_handle_t handle, uint16_t module, uint16_t command,
+                                                   can_esp_subscription_handler_t handler, void *ctx,
+                                                   can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_Unsubscribe_v2(can_esp_handle_t handle, can_esp_subscription_t subscription);
+can_esp_status_t CAN_ESP_SynthesizeFilter_v2(can_esp_handle_t handle, CanEspFilterReport_t *report);
+can_esp_status_t CAN_ESP_ApplySynthesizedFilter_v2(can_esp_handle_t handle, CanEspFilterReport_t *report);
+
+/* Transmissão assíncrona e tarefas */
+can_esp_status_t CAN_ESP_EnqueueMessage_v2(can_esp_handle_t handle, const CanEspMessage_t *msg, bool high_priority);
+can_esp_status_t CAN_ESP_EnqueueBatch_v2(can_esp_handle_t handle, const CanEspMessage_t *msgs, size_t count,
+                                         bool high_priority);
+can_esp_status_t CAN_ESP_TryEnqueueBatch_v2(can_esp_handle_t handle, const CanEspMessage_t *msgs, size_t count,
+                                            bool high_priority, size_t *accepted);
+can_esp_status_t CAN_ESP_AllocMessage_v2(can_esp_handle_t handle, CanEspMessage_t **msg);
+can_esp_status_t CAN_ESP_EnqueuePooledMessage_v2(can_esp_handle_t handle, CanEspMessage_t *msg, bool high_priority);
+can_esp_status_t CAN_ESP_FreeMessage_v2(can_esp_handle_t handle, CanEspMessage_t *msg);
+can_esp_status_t CAN_ESP_GetMessagePoolStats_v2(can_esp_handle_t handle, CanEspPoolStats_t *stats);
+can_esp_status_t CAN_ESP_SetTaskConfig_v2(can_esp_handle_t handle, const CanEspTaskConfig_t *config);
+can_esp_status_t CAN_ESP_GetTaskConfig_v2(can_esp_handle_t handle, CanEspTaskConfig_t *config);
+void CAN_ESP_StartTransmitTask_v2(can_esp_handle_t handle);
+void CAN_ESP_StartReceiveTask_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_AdjustTransmitTaskPriority_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_RegisterTransmitCallback_v2(can_esp_handle_t handle, can_esp_transmit_callback_t callback);
+can_esp_status_t CAN_ESP_RegisterTransmitCompleteCallback_v2(can_esp_handle_t handle,
+                                                             can_esp_transmit_complete_callback_t callback);
+
+/* Limitação de taxa de transmissão */
+can_esp_status_t CAN_ESP_AddRateLimit_v2(can_esp_handle_t handle, const CanEspRateLimitConfig_t *config,
+                                         can_esp_rate_limit_t *limit);
+can_esp_status_t CAN_ESP_RemoveRateLimit_v2(can_esp_handle_t handle, can_esp_rate_limit_t limit);
+can_esp_status_t CAN_ESP_GetRateLimitStats_v2(can_esp_handle_t handle, can_esp_rate_limit_t limit,
+                                              CanEspRateLimitStats_t *stats);
+uint32_t CAN_ESP_GetRateLimitRejections_v2(can_esp_handle_t handle);
+
+/* Prazos e substituição na fila de transmissão */
+can_esp_status_t CAN_ESP_AddTxDeadlinePolicy_v2(can_esp_handle_t handle, const CanEspTxDeadlinePolicy_t *policy,
+                                                can_esp_tx_policy_t *policy_handle);
+can_esp_status_t CAN_ESP_RemoveTxDeadlinePolicy_v2(can_esp_handle_t handle, can_esp_tx_policy_t policy_handle);
+can_esp_status_t CAN_ESP_GetTxDeadlineStats_v2(can_esp_handle_t handle, CanEspTxDeadlineStats_t *stats);
+
+/* Supervisor de recuperação de bus-off */
+can_esp_status_t CAN_ESP_StartRecoverySupervisor_v2(can_esp_handle_t handle, const CanEspRecoveryPolicy_t *policy);
+can_esp_status_t CAN_ESP_InitiateRecovery_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_GetRecoveryStats_v2(can_esp_handle_t handle, CanEspRecoveryStats_t *stats);
+can_esp_status_t CAN_ESP_RegisterBusStateCallback_v2(can_esp_handle_t handle, can_esp_bus_state_callback_t callback);
+
+/* Mensagens cíclicas */
+can_esp_status_t CAN_ESP_RegisterCyclicMessage_v2(can_esp_handle_t handle, uint32_t id, uint32_t period_us,
+                                                  uint32_t offset_us, can_esp_cyclic_fill_t fill_callback,
+                                                  void *ctx, can_esp_cyclic_t *cyclic);
+can_esp_status_t CAN_ESP_UnregisterCyclicMessage_v2(can_esp_handle_t handle, can_esp_cyclic_t cyclic);
+can_esp_status_t CAN_ESP_GetCyclicStats_v2(can_esp_handle_t handle, can_esp_cyclic_t cyclic, CanEspCyclicStats_t *stats);
+
+/* Diagnóstico e métricas */
+can_esp_status_t CAN_ESP_GetDiagnostics_v2(can_esp_handle_t handle, CanEspDiagnostics_t *diag);
+can_esp_status_t CAN_ESP_GetLatencyMetrics_v2(can_esp_handle_t handle, CanEspLatencyMetrics_t *metrics);
+can_esp_status_t CAN_ESP_GetLatencyPercentile_v2(can_esp_handle_t handle, float percentile, int64_t *latency_us);
+can_esp_status_t CAN_ESP_ResetLatencyWindow_v2(can_esp_handle_t handle, CanEspLatencyMetrics_t *closed_window);
+can_esp_status_t CAN_ESP_GetQueueStatus_v2(can_esp_handle_t handle, CanEspQueueStatus_t *status);
+can_esp_status_t CAN_ESP_GetRxRingStats_v2(can_esp_handle_t handle, CanEspRxRingStats_t *stats);
+void CAN_ESP_ResetRxRingHighWaterMark_v2(can_esp_handle_t handle);
+uint32_t CAN_ESP_GetBusLoad_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_GetBusLoadStats_v2(can_esp_handle_t handle, CanEspBusLoadStats_t *stats);
+can_esp_status_t CAN_ESP_SetBusLoadStuffingMode_v2(can_esp_handle_t handle, CanEspStuffingMode_t mode);
+can_esp_status_t CAN_ESP_GetIdStats_v2(can_esp_handle_t handle, CanEspIdStats_t *out, size_t max, size_t *count,
+                                       uint32_t *untracked_frames);
+can_esp_status_t CAN_ESP_GetIdStatsEntry_v2(can_esp_handle_t handle, uint32_t id, CanEspIdStats_t *out);
+void CAN_ESP_ResetIdStats_v2(can_esp_handle_t handle);
+uint32_t CAN_ESP_GetTransmissionAttempts_v2(can_esp_handle_t handle);
+uint32_t CAN_ESP_GetRetransmissionCount_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_GetRetryStats_v2(can_esp_handle_t handle, CanEspRetryStats_t *stats);
+uint32_t CAN_ESP_GetCollisionCount_v2(can_esp_handle_t handle);
+uint32_t CAN_ESP_GetCollisionRate_v2(can_esp_handle_t handle);
+can_esp_status_t CAN_ESP_MeasureRoundTripTime_v2(can_esp_handle_t handle, int64_t *round_trip_time, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_INSTANCE_H */
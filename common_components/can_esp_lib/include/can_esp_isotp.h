@@ -0,0 +1,154 @@
+/*
+ * can_esp_isotp.h
+ * Camada de transporte segmentado ISO-TP (ISO 15765-2) sobre a can_esp_lib
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#ifndef CAN_ESP_ISOTP_H
+#define CAN_ESP_ISOTP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "can_esp_lib.h"
+
+/* Número máximo de sessões ISO-TP simultâneas */
+#define CAN_ESP_ISOTP_MAX_SESSIONS      (4U)
+
+/* Maior mensagem com campo de tamanho de 12 bits; acima disso usa-se o escape de 32 bits */
+#define CAN_ESP_ISOTP_MAX_12BIT_LENGTH  (4095U)
+
+/* Timeout padrão de N_Bs (espera por Flow Control) e N_Cr (espera por Consecutive Frame) */
+#define CAN_ESP_ISOTP_DEFAULT_TIMEOUT_MS    (1000U)
+
+/* Número máximo de Flow Control com status WAIT aceitos em sequência (N_WFTmax) */
+#define CAN_ESP_ISOTP_MAX_WFT           (10U)
+
+/* Byte de preenchimento padrão dos quadros */
+#define CAN_ESP_ISOTP_DEFAULT_PADDING   (0xCCU)
+
+typedef uint32_t can_esp_isotp_t;
+
+/**
+ * @brief Callback de mensagem ISO-TP completa.
+ *
+ * Executado na tarefa de despacho da can_esp_lib. Os dados residem no buffer de recepção da
+ * sessão e só são válidos durante a chamada.
+ *
+ * @param handle Sessão que recebeu a mensagem.
+ * @param data   Dados remontados.
+ * @param length Tamanho da mensagem.
+ * @param ctx    Contexto informado na abertura da sessão.
+ */
+typedef void (*can_esp_isotp_rx_callback_t)(can_esp_isotp_t handle, const uint8_t *data, size_t length, void *ctx);
+
+/**
+ * @brief Configuração de uma sessão ISO-TP (endereçamento normal).
+ */
+typedef struct {
+    uint32_t tx_id;                 /**< ID dos quadros transmitidos (dados e Flow Control). */
+    uint32_t rx_id;                 /**< ID dos quadros recebidos do par. */
+    uint8_t  block_size;            /**< BS anunciado ao receber (0 = sem Flow Control intermediário). */
+    uint8_t  st_min;                /**< STmin anunciado ao receber (codificação ISO: 0-127 ms, 0xF1-0xF9 = 100-900 us). */
+    uint8_t  tx_dl;                 /**< Bytes por quadro (7 ou 8; use 7 se use_checksum estiver habilitado). */
+    bool     use_padding;           /**< Preenche os quadros até tx_dl com padding_byte. */
+    uint8_t  padding_byte;          /**< Byte de preenchimento. */
+    uint32_t timeout_ms;            /**< Timeout de N_Bs e N_Cr. */
+    uint8_t *rx_buffer;             /**< Buffer de remontagem fornecido pelo chamador. */
+    size_t   rx_buffer_size;        /**< Tamanho do buffer (mensagens maiores recebem Flow Control OVFLW). */
+    can_esp_isotp_rx_callback_t on_receive;   /**< Callback de mensagem completa. */
+    void    *ctx;                   /**< Contexto do callback. */
+} CanEspIsoTpConfig_t;
+
+/**
+ * @brief Estatísticas de uma sessão ISO-TP.
+ *
+ * A vazão é medida do primeiro ao último quadro da mensagem (First Frame ao último
+ * Consecutive Frame) e expressa em bytes de carga útil por segundo.
+ */
+typedef struct {
+    uint32_t tx_messages;           /**< Mensagens transmitidas com sucesso. */
+    uint32_t rx_messages;           /**< Mensagens recebidas com sucesso. */
+    uint64_t tx_bytes;              /**< Bytes de carga útil transmitidos. */
+    uint64_t rx_bytes;              /**< Bytes de carga útil recebidos. */
+    uint32_t tx_errors;             /**< Transmissões abortadas (timeout de FC, OVFLW, erro de envio). */
+    uint32_t rx_errors;             /**< Recepções abortadas (sequência inválida, buffer insuficiente). */
+    uint32_t rx_timeouts;           /**< Recepções abortadas por N_Cr expirado. */
+    uint32_t fc_wait_frames;        /**< Flow Control WAIT recebidos. */
+    uint32_t last_tx_bytes_per_s;   /**< Vazão da última mensagem segmentada transmitida. */
+    uint32_t last_rx_bytes_per_s;   /**< Vazão da última mensagem segmentada recebida. */
+    uint32_t max_tx_bytes_per_s;    /**< Maior vazão de transmissão observada. */
+    uint32_t max_rx_bytes_per_s;    /**< Maior vazão de recepção observada. */
+} CanEspIsoTpStats_t;
+
+/**
+ * @brief Preenche a configuração com valores padrão (BS 0, STmin 0, quadros de 8 bytes com padding).
+ *
+ * @param[out] config Configuração a preencher.
+ * @param tx_id       ID de transmissão.
+ * @param rx_id       ID de recepção.
+ * @param rx_buffer   Buffer de remontagem.
+ * @param rx_buffer_size Tamanho do buffer.
+ */
+void CAN_ESP_IsoTpDefaultConfig(CanEspIsoTpConfig_t *config, uint32_t tx_id, uint32_t rx_id,
+                                uint8_t *rx_buffer, size_t rx_buffer_size);
+
+/**
+ * @brief Abre uma sessão ISO-TP na instância padrão, inscrevendo-a no ID de recepção.
+ *
+ * A recepção depende da tarefa de despacho (CAN_ESP_StartReceiveTask). Os Flow Control são
+ * enfileirados sem bloqueio no nível mais urgente da fila de transmissão e, portanto, dependem
+ * da tarefa de transmissão (CAN_ESP_StartTransmitTask). First Frames com FF_DL menor que 8, ou
+ * com o escape de 32 bits para até 4095 bytes, são ignorados e contam em rx_errors.
+ *
+ * @param config      Configuração da sessão (copiada; o buffer deve permanecer válido).
+ * @param[out] handle Identificador da sessão.
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_IsoTpOpen(const CanEspIsoTpConfig_t *config, can_esp_isotp_t *handle);
+
+/**
+ * @brief Como CAN_ESP_IsoTpOpen, na instância informada (ver can_esp_instance.h).
+ *
+ * As demais funções operam sobre a instância em que a sessão foi aberta.
+ *
+ * @return CAN_ESP_ERR_NULL_POINTER com inst nulo; demais códigos como CAN_ESP_IsoTpOpen.
+ */
+can_esp_status_t CAN_ESP_IsoTpOpen_v2(can_esp_handle_t inst, const CanEspIsoTpConfig_t *config,
+                                      can_esp_isotp_t *handle);
+
+/**
+ * @brief Encerra a sessão e remove sua inscrição.
+ */
+can_esp_status_t CAN_ESP_IsoTpClose(can_esp_isotp_t handle);
+
+/**
+ * @brief Transmite uma mensagem ISO-TP (bloqueante).
+ *
+ * Mensagens curtas seguem em um Single Frame; as demais são segmentadas em First Frame e
+ * Consecutive Frames, respeitando o BS e o STmin recebidos no Flow Control do par.
+ *
+ * @param handle Sessão.
+ * @param data   Dados a transmitir.
+ * @param length Tamanho (1 a UINT32_MAX).
+ * @return CAN_ESP_OK, CAN_ESP_ERR_TIMEOUT (sem Flow Control), CAN_ESP_ERR_QUEUE_FULL (OVFLW do par)
+ *         ou outro código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_IsoTpSend(can_esp_isotp_t handle, const uint8_t *data, size_t length);
+
+/**
+ * @brief Obtém as estatísticas da sessão.
+ */
+can_esp_status_t CAN_ESP_IsoTpGetStats(can_esp_isotp_t handle, CanEspIsoTpStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_ISOTP_H */
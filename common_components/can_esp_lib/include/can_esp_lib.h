@@ -15,7 +15,8 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "driver/twai.h"  /* Para os tipos twai_filter_config_t, twai_mode_t, twai_timing_config_t */
+#include <stddef.h>
+#include "can_esp_twai_types.h"  /* Tipos twai_* (driver/twai.h no ESP32, definições próprias no alvo linux) */
 
 /* Número máximo de bytes de dados em uma mensagem CAN */
 #define CAN_MAX_DATA_LENGTH    (8U)
@@ -33,13 +34,118 @@ extern "C" {
 #define CAN_RX_GPIO    (4U)
 #endif
 
-/* Controle de retransmissões */
+/* Controle de retransmissões (backoff exponencial: CAN_ESP_BACKOFF_MS, 2x, 4x, ...) */
 #define CAN_ESP_MAX_RETRANSMISSIONS  (3U)
 #define CAN_ESP_BACKOFF_MS           (50U)
 
+/* Roda de temporização das retransmissões (quadros estacionados durante o backoff) */
+#ifndef CAN_ESP_RETRY_WHEEL_SLOTS
+#define CAN_ESP_RETRY_WHEEL_SLOTS    (32U)
+#endif
+#ifndef CAN_ESP_RETRY_WHEEL_TICK_MS
+#define CAN_ESP_RETRY_WHEEL_TICK_MS  (10U)
+#endif
+#ifndef CAN_ESP_RETRY_POOL_SIZE
+#define CAN_ESP_RETRY_POOL_SIZE      (16U)
+#endif
+
 #define CAN_PROCESS_TIMEOUT_MS    (10U)
+/* Número máximo de quadros drenados por chamada de CAN_ESP_ProcessReceivedMessages */
+#define CAN_PROCESS_BATCH_SIZE    (16U)
 #define TX_QUEUE_LENGTH 32
 
+/* Níveis de prioridade de transmissão (campo de 3 bits de CAN_ESP_EncodeID; 0 = mais urgente) */
+#define CAN_ESP_NUM_PRIORITY_LEVELS    (8U)
+/* Capacidade da fila de cada nível de prioridade */
+#ifndef CAN_ESP_TX_LEVEL_QUEUE_LENGTH
+#define CAN_ESP_TX_LEVEL_QUEUE_LENGTH  (TX_QUEUE_LENGTH)
+#endif
+
+/*
+ * Pool de mensagens de transmissão: os níveis da fila armazenam apenas índices de 16 bits,
+ * de modo que a memória das mensagens é limitada pelo pool e não pela soma das capacidades
+ * dos níveis (no máximo 65535 slots).
+ */
+#ifndef CAN_ESP_MSG_POOL_SIZE
+#define CAN_ESP_MSG_POOL_SIZE   (2U * TX_QUEUE_LENGTH)
+#endif
+
+/* Escalonador de mensagens cíclicas */
+#define CAN_ESP_MAX_CYCLIC_MESSAGES         (32U)
+#define CAN_ESP_CYCLIC_MIN_PERIOD_US        (1000U)
+#define CAN_ESP_CYCLIC_OFFSET_CANDIDATES    (32U)
+#define CAN_ESP_CYCLIC_AUTO_OFFSET          (UINT32_MAX)    /**< Fase escolhida pelo escalonador. */
+
+/* Entradas da tabela de estatísticas por ID (potência de 2; IDs excedentes são apenas contados) */
+#define CAN_ESP_ID_STATS_TABLE_SIZE     (128U)
+
+/* Baldes do histograma de latência: 16 sub-baldes por potência de 2, até ~8 s */
+#define CAN_ESP_LATENCY_HIST_BUCKETS    (320U)
+
+/* Baldes por janela deslizante de bus load (100 ms, 1 s e 10 s) */
+#define CAN_ESP_BUSLOAD_BUCKETS     (10U)
+
+/* Espera máxima da tarefa de recepção por quadro antes de verificar pedidos de pausa */
+#define CAN_ESP_RX_PAUSE_POLL_MS    (20U)
+
+/* Quadros acompanhados até a confirmação de transmissão (deve exceder a fila TX do driver) */
+#define CAN_ESP_TX_INFLIGHT_LENGTH  (16U)
+
+/* Espera máxima da tarefa de alertas antes de reconciliar com o estado do driver */
+#define CAN_ESP_TX_COMPLETE_POLL_MS (100U)
+
+/* Política padrão do supervisor de recuperação (ver CanEspRecoveryPolicy_t) */
+#define CAN_ESP_RECOVERY_DEFAULT_DELAY_MS       (0U)
+#define CAN_ESP_RECOVERY_DEFAULT_MAX_ATTEMPTS   (5U)
+#define CAN_ESP_RECOVERY_DEFAULT_STABLE_MS      (1000U)
+#define CAN_ESP_RECOVERY_DEFAULT_FLUSH_LEVEL    (4U)
+
+/* Anel SPSC de recepção (tamanho deve ser potência de 2) */
+#ifndef CAN_ESP_RX_RING_SIZE
+#define CAN_ESP_RX_RING_SIZE    (256U)
+#endif
+
+/*
+ * Instâncias da biblioteca (uma por barramento), incluindo a instância padrão usada pelas
+ * funções sem handle. Cada instância adicional ocupa cerca de 30 KB de memória estática para
+ * suas filas e tabelas; o limite vem do menuconfig (CONFIG_CAN_ESP_MAX_INSTANCES: 4 no alvo
+ * linux, para simular vários nós no mesmo processo, e 1 nas ECUs) ou do build (ex.:
+ * -DCAN_ESP_MAX_INSTANCES=2U); ver can_esp_instance.h.
+ */
+#ifndef CAN_ESP_MAX_INSTANCES
+#if defined(CONFIG_CAN_ESP_MAX_INSTANCES)
+#define CAN_ESP_MAX_INSTANCES   (CONFIG_CAN_ESP_MAX_INSTANCES)
+#elif defined(CONFIG_IDF_TARGET_LINUX) && CONFIG_IDF_TARGET_LINUX
+#define CAN_ESP_MAX_INSTANCES   (4U)
+#else
+#define CAN_ESP_MAX_INSTANCES   (1U)
+#endif
+#endif
+
+/*
+ * Parâmetros padrão das tarefas da biblioteca (ver CanEspTaskConfig_t). Em chips com dois
+ * núcleos as tarefas CAN ficam no núcleo 1, longe das interrupções de Wi-Fi/mesh do núcleo 0.
+ */
+#ifndef CAN_ESP_TASK_CORE_ID
+#define CAN_ESP_TASK_CORE_ID            ((portNUM_PROCESSORS > 1) ? 1 : tskNO_AFFINITY)
+#endif
+#ifndef CAN_ESP_TASK_STACK_SIZE
+#define CAN_ESP_TASK_STACK_SIZE         (4096U)
+#endif
+#define CAN_ESP_TX_TASK_PRIORITY        (10U)
+#define CAN_ESP_TX_TASK_BOOST_PRIORITY  (15U)
+#define CAN_ESP_RX_TASK_PRIORITY        (10U)
+#define CAN_ESP_DISPATCH_TASK_PRIORITY  (9U)
+#define CAN_ESP_ALERT_TASK_PRIORITY     (11U)
+/* Histerese da elevação de prioridade: ocupação (% do nível mais cheio) que eleva e que restaura */
+#define CAN_ESP_TX_BOOST_HIGH_PCT       (80U)
+#define CAN_ESP_TX_BOOST_LOW_PCT        (50U)
+
+/**
+ * @brief Handle de uma instância da biblioteca (configuração, driver, filas, tarefas e métricas).
+ */
+typedef struct can_esp_instance *can_esp_handle_t;
+
 /**
  * @brief Estrutura para configuração dinâmica da camada CAN.
  */
@@ -63,7 +169,10 @@ typedef struct
 /**
  * @brief Estrutura para mensagens CAN.
  *
- * O campo retry_count armazena o número de tentativas de retransmissão.
+ * O campo retry_count armazena o número de tentativas de retransmissão. O campo timestamp_us
+ * (esp_timer_get_time) registra, em quadros recebidos, o instante em que o quadro foi retirado
+ * do driver e, em quadros transmitidos entregues ao callback de conclusão, o instante em que a
+ * transmissão foi confirmada; é ignorado ao transmitir.
  */
 typedef struct
 {
@@ -71,6 +180,7 @@ typedef struct
     uint8_t  length;
     uint8_t  data[CAN_MAX_DATA_LENGTH];
     uint8_t  retry_count;
+    int64_t  timestamp_us;
 } CanEspMessage_t;
 
 /**
@@ -84,22 +194,142 @@ typedef struct {
 
 /**
  * @brief Estrutura para status da fila de transmissão.
+ *
+ * A fila possui um nível por prioridade; messages_waiting e queue_capacity são os totais.
  */
 typedef struct {
     UBaseType_t messages_waiting;
     UBaseType_t queue_capacity;
+    uint16_t level_waiting[CAN_ESP_NUM_PRIORITY_LEVELS];    /**< Mensagens aguardando em cada nível. */
+    uint16_t level_capacity;                                /**< Capacidade de cada nível. */
 } CanEspQueueStatus_t;
 
 /**
- * @brief Estrutura para métricas de latência de transmissão.
+ * @brief Estrutura para métricas de latência de transmissão (em microsegundos).
+ *
+ * Os percentis são obtidos de um histograma log-linear com erro relativo de até 1/16
+ * (o valor reportado é o limite superior do balde, limitado ao máximo observado).
  */
 typedef struct {
     uint32_t num_samples;
     int64_t total_latency;
     int64_t min_latency;
     int64_t max_latency;
+    int64_t p50_latency;        /**< Mediana. */
+    int64_t p90_latency;        /**< Percentil 90. */
+    int64_t p99_latency;        /**< Percentil 99. */
+    int64_t p999_latency;       /**< Percentil 99,9. */
+    int64_t stddev_latency;     /**< Desvio padrão estimado a partir do histograma. */
 } CanEspLatencyMetrics_t;
 
+/**
+ * @brief Estrutura para estatísticas do anel de recepção (SPSC).
+ *
+ * O anel é preenchido pela tarefa de recepção (produtor) e drenado pela tarefa de
+ * despacho (consumidor), que invoca o callback de recepção registrado.
+ */
+typedef struct {
+    uint32_t capacity;          /**< Número de slots do anel. */
+    uint32_t level;             /**< Mensagens atualmente armazenadas. */
+    uint32_t high_water_mark;   /**< Maior ocupação observada desde a inicialização. */
+    uint32_t pushed;            /**< Total de mensagens inseridas pelo produtor. */
+    uint32_t popped;            /**< Total de mensagens consumidas. */
+    uint32_t overflows;         /**< Mensagens descartadas por anel cheio. */
+} CanEspRxRingStats_t;
+
+/**
+ * @brief Estrutura para estatísticas das retransmissões agendadas.
+ *
+ * Quadros com falha de transmissão aguardam o backoff em uma roda de temporização, sem
+ * bloquear os demais quadros da fila.
+ */
+typedef struct {
+    uint32_t parked_now;            /**< Quadros aguardando backoff neste momento. */
+    uint32_t parked_high_water;     /**< Maior número de quadros estacionados simultaneamente. */
+    uint32_t retries_scheduled;     /**< Retransmissões agendadas na roda. */
+    uint32_t retry_successes;       /**< Quadros transmitidos com sucesso após ao menos uma retransmissão. */
+    uint32_t retry_exhausted;       /**< Quadros descartados após CAN_ESP_MAX_RETRANSMISSIONS. */
+    uint32_t wheel_overflows;       /**< Falhas sem entrada livre na roda (reenfileirados sem backoff). */
+    uint64_t total_backoff_us;      /**< Soma do tempo efetivamente estacionado (em microsegundos). */
+    uint32_t max_backoff_us;        /**< Maior tempo estacionado (em microsegundos). */
+} CanEspRetryStats_t;
+
+/**
+ * @brief Modo de contabilização dos bits de stuffing no cálculo do tamanho do quadro.
+ */
+typedef enum {
+    CAN_ESP_STUFFING_WORST_CASE = 0,    /**< Pior caso: floor((bits_stuffable - 1) / 4). Custo constante. */
+    CAN_ESP_STUFFING_EXACT              /**< Exato: reconstrói o quadro, incluindo o CRC-15. */
+} CanEspStuffingMode_t;
+
+/**
+ * @brief Estrutura para estatísticas de utilização do barramento.
+ *
+ * Calculada a partir dos bits no fio (SOF até IFS, com stuffing) de todos os quadros
+ * transmitidos com sucesso e recebidos. Quadros com self_rx são contados nas duas direções.
+ */
+typedef struct {
+    uint32_t load_100ms_permille;       /**< Utilização na janela de 100 ms (décimos de porcento). */
+    uint32_t load_1s_permille;          /**< Utilização na janela de 1 s (décimos de porcento). */
+    uint32_t load_10s_permille;         /**< Utilização na janela de 10 s (décimos de porcento). */
+    uint64_t total_bits;                /**< Bits contabilizados desde a inicialização. */
+    uint32_t tx_frames;                 /**< Quadros transmitidos contabilizados. */
+    uint32_t rx_frames;                 /**< Quadros recebidos contabilizados. */
+    uint32_t bitrate;                   /**< Taxa de bits usada como capacidade. */
+    CanEspStuffingMode_t stuffing_mode; /**< Modo de stuffing em uso. */
+} CanEspBusLoadStats_t;
+
+/**
+ * @brief Estatísticas de tráfego de um identificador em uma direção.
+ */
+typedef struct {
+    uint32_t frames;                /**< Quadros contabilizados. */
+    uint32_t bytes;                 /**< Bytes de dados contabilizados. */
+    int64_t  last_timestamp_us;     /**< Instante do último quadro (esp_timer). */
+    uint32_t mean_interarrival_us;  /**< Intervalo médio entre quadros (taxa = 1e6 / média). */
+    uint32_t max_interarrival_us;   /**< Maior intervalo entre quadros. */
+    uint32_t jitter_us;             /**< Jitter do intervalo (média exponencial 1/16 da variação, RFC 3550). */
+} CanEspIdDirStats_t;
+
+/**
+ * @brief Estatísticas de tráfego por identificador CAN (recepção e transmissão).
+ */
+typedef struct {
+    uint32_t id;
+    CanEspIdDirStats_t rx;
+    CanEspIdDirStats_t tx;
+} CanEspIdStats_t;
+
+/**
+ * @brief Estatísticas de liberação de uma mensagem cíclica.
+ *
+ * O jitter é o atraso entre o instante nominal de liberação e a execução do escalonador.
+ */
+typedef struct {
+    uint32_t offset_us;         /**< Fase efetiva da mensagem dentro do período. */
+    uint32_t releases;          /**< Liberações executadas. */
+    uint32_t missed_releases;   /**< Liberações descartadas por atraso maior que um período. */
+    uint32_t skipped;           /**< Liberações em que o callback optou por não enviar. */
+    uint32_t enqueue_failures;  /**< Liberações descartadas por fila cheia ou limite de taxa. */
+    uint32_t last_jitter_us;    /**< Jitter da última liberação. */
+    uint32_t mean_jitter_us;    /**< Jitter médio. */
+    uint32_t max_jitter_us;     /**< Maior jitter observado. */
+    uint32_t lock_contentions;  /**< Execuções do escalonador com o mutex ocupado (comum a todas as mensagens). */
+} CanEspCyclicStats_t;
+
+/**
+ * @brief Estrutura para estatísticas da reconfiguração sem perda (CAN_ESP_Reconfigure).
+ */
+typedef struct {
+    uint32_t count;                 /**< Reconfigurações realizadas. */
+    uint32_t failures;              /**< Reconfigurações cuja reinstalação do driver falhou. */
+    uint32_t last_blackout_us;      /**< Última janela com o driver parado (em microsegundos). */
+    uint32_t max_blackout_us;       /**< Maior janela com o driver parado (em microsegundos). */
+    uint32_t last_pause_us;         /**< Última pausa total das tarefas, incluindo drenagem (em microsegundos). */
+    uint32_t tx_frames_lost;        /**< Quadros ainda no driver ao esgotar a drenagem (descartados no stop). */
+    uint32_t rollbacks;             /**< Falhas em que a configuração anterior foi reinstalada. */
+} CanEspReconfigStats_t;
+
 /**
  * @brief Enumeração dos códigos de status da biblioteca.
  */
@@ -115,7 +345,12 @@ typedef enum
     CAN_ESP_ERR_DRIVER_STOP,
     CAN_ESP_ERR_DRIVER_UNINSTALL,
     CAN_ESP_ERR_TIMEOUT,
-    CAN_ESP_ERR_UNKNOWN
+    CAN_ESP_ERR_QUEUE_FULL,
+    CAN_ESP_ERR_INVALID_PARAM,
+    CAN_ESP_ERR_UNKNOWN,
+    CAN_ESP_ERR_RATE_LIMITED,   /**< Quadro recusado por limite de taxa (acrescentado ao fim para preservar os códigos). */
+    CAN_ESP_ERR_TX_UNATTRIBUTED, /**< Concluído junto com quadros dos quais algum falhou, sem saber qual. */
+    CAN_ESP_ERR_ABORTED         /**< Operação interrompida a pedido (ex.: CAN_ESP_ReplayStop). */
 } can_esp_status_t;
 
 /* Protótipos de funções de configuração dinâmica */
@@ -124,6 +359,28 @@ can_esp_status_t CAN_ESP_Init(void);
 can_esp_status_t CAN_ESP_UpdateConfig(const CanEspConfig_t *config);
 can_esp_status_t CAN_ESP_Deinit(void);
 
+/**
+ * @brief Reconfigura o driver TWAI sem perder o estado da biblioteca.
+ *
+ * Pausa as tarefas de transmissão e recepção entre quadros, drena os quadros recebidos para o
+ * anel de recepção, aguarda o driver esvaziar sua fila de transmissão (até transmit_timeout_ms),
+ * reinstala o driver com a nova configuração e retoma as tarefas. As filas de transmissão,
+ * os contadores e as métricas de latência e bus load são preservados. A duração da janela
+ * sem driver é registrada em CanEspReconfigStats_t. CAN_ESP_UpdateConfig e
+ * CAN_ESP_SetFilterConfig utilizam este caminho.
+ *
+ * Se a nova configuração não puder ser instalada, a anterior é reinstalada e o erro é retornado;
+ * se nenhuma das duas for aceita, as tarefas permanecem pausadas até a próxima instalação
+ * bem-sucedida (nova chamada a esta função ou a CAN_ESP_InitWithConfig). Não deve ser chamada
+ * pelas tarefas de transmissão ou recepção (ex.: callback de transmissão).
+ *
+ * @param config Nova configuração.
+ * @return CAN_ESP_OK em caso de sucesso; CAN_ESP_ERR_INVALID_PARAM se chamada pelas tarefas de
+ *         transmissão ou recepção; o erro do driver se a nova configuração for recusada.
+ */
+can_esp_status_t CAN_ESP_Reconfigure(const CanEspConfig_t *config);
+can_esp_status_t CAN_ESP_GetReconfigStats(CanEspReconfigStats_t *stats);
+
 /* Protótipos de funções de atualização parcial */
 can_esp_status_t CAN_ESP_SetFilterConfig(const twai_filter_config_t *new_filter_config);
 can_esp_status_t CAN_ESP_SetTimeouts(uint32_t tx_timeout_ms, uint32_t rx_timeout_ms);
@@ -132,18 +389,347 @@ can_esp_status_t CAN_ESP_SetTimeouts(uint32_t tx_timeout_ms, uint32_t rx_timeout
 can_esp_status_t CAN_ESP_SendMessage(uint32_t id, const uint8_t *data, uint8_t length);
 can_esp_status_t CAN_ESP_ReceiveMessage(CanEspMessage_t *message, uint32_t timeout_ms);
 
+/**
+ * @brief Recebe um lote de mensagens CAN em uma única chamada.
+ *
+ * Bloqueia por até timeout_ms apenas pelo primeiro quadro; em seguida drena, sem novas
+ * esperas, todos os quadros já enfileirados no driver TWAI (até max). Quadros com falha
+ * de checksum são descartados e não contam em count.
+ *
+ * @param[out] out Vetor que receberá as mensagens.
+ * @param[in] max Capacidade do vetor out.
+ * @param[in] timeout_ms Tempo máximo de espera pelo primeiro quadro (em milissegundos).
+ * @param[out] count Número de mensagens válidas copiadas para out.
+ * @return CAN_ESP_OK se ao menos uma mensagem foi recebida, CAN_ESP_ERR_TIMEOUT caso contrário.
+ */
+can_esp_status_t CAN_ESP_ReceiveBatch(CanEspMessage_t *out, size_t max, uint32_t timeout_ms, size_t *count);
+
 /* Protótipos de funções de callback e processamento de mensagens recebidas */
 typedef void (*can_esp_receive_callback_t)(const CanEspMessage_t *msg);
 can_esp_status_t CAN_ESP_RegisterReceiveCallback(can_esp_receive_callback_t callback);
 void CAN_ESP_ProcessReceivedMessages(void);
 
-/* Protótipos de funções para transmissão assíncrona */
+/*
+ * Inscrições de recepção por identificador.
+ * Uma inscrição recebe os quadros cujo (id & mask) coincide com (sub_id & mask). A tabela de
+ * despacho é reconstruída a cada (des)inscrição, agrupando as inscrições por máscara e
+ * ordenando-as pela chave, de modo que cada quadro é resolvido por busca binária em cada
+ * grupo. Várias inscrições podem coincidir com o mesmo ID; todas são chamadas, na ordem de
+ * registro, após o callback global. Os handlers são chamados fora do mutex da tabela e podem
+ * (des)registrar inscrições; um handler removido ainda pode receber o quadro que já estava em
+ * despacho. CAN_ESP_Unsubscribe retorna CAN_ESP_ERR_INVALID_PARAM para um handle fora da
+ * tabela ou de inscrição inexistente.
+ */
+#define CAN_ESP_MAX_SUBSCRIPTIONS        (32U)
+#define CAN_ESP_ID_MASK_EXACT            (0x1FFFFFFFU)   /**< Compara os 29 bits do ID. */
+#define CAN_ESP_ID_MASK_MODULE_COMMAND   (0x03FFFFFFU)   /**< Ignora a prioridade (bits 26-28). */
+#define CAN_ESP_ID_MASK_MODULE           (0x03FF0000U)   /**< Todos os comandos de um módulo. */
+
+typedef void (*can_esp_subscription_handler_t)(const CanEspMessage_t *msg, void *ctx);
+typedef uint32_t can_esp_subscription_t;
+
+can_esp_status_t CAN_ESP_Subscribe(uint32_t id, uint32_t mask, can_esp_subscription_handler_t handler,
+                                   void *ctx, can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_SubscribeId(uint32_t id, can_esp_subscription_handler_t handler,
+                                     void *ctx, can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_SubscribeModuleCommand(uint16_t module, uint16_t command, can_esp_subscription_handler_t handler,
+                                                void *ctx, can_esp_subscription_t *subscription);
+can_esp_status_t CAN_ESP_Unsubscribe(can_esp_subscription_t subscription);
+
+/**
+ * @brief Relatório da síntese do filtro de aceitação de hardware.
+ *
+ * Os espaços de ID são contados sobre os 2^29 identificadores estendidos; as estimativas
+ * supõem IDs uniformemente distribuídos. Os contadores observados vêm da tabela de despacho,
+ * que atua como filtro de software para o restante.
+ */
+typedef struct {
+    twai_filter_config_t filter;            /**< Configuração sintetizada (simples ou dupla). */
+    bool accept_all;                        /**< Callback global registrado ou nenhuma inscrição ativa. */
+    uint32_t subscriptions;                 /**< Inscrições consideradas. */
+    uint64_t accepted_id_space;             /**< IDs aceitos pelo hardware. */
+    uint64_t subscribed_id_space;           /**< IDs efetivamente inscritos (limitado a accepted_id_space). */
+    uint32_t estimated_false_accept_ppm;    /**< Fração estimada dos aceitos que nenhuma inscrição quer (ppm). */
+    uint32_t estimated_hw_reject_ppm;       /**< Fração estimada do tráfego descartada pelo hardware (ppm). */
+    uint32_t observed_dispatched;           /**< Quadros entregues à tabela de despacho. */
+    uint32_t observed_unmatched;            /**< Quadros aceitos pelo hardware sem inscrição coincidente. */
+} CanEspFilterReport_t;
+
+/**
+ * @brief Sintetiza o melhor filtro de aceitação TWAI (simples ou duplo) para as inscrições ativas.
+ *
+ * Escolhe entre o filtro simples (29 bits) e o filtro duplo (apenas ID[28:13] em cada metade)
+ * aquele que aceita o menor espaço de IDs. Com um callback global registrado o resultado é
+ * TWAI_FILTER_CONFIG_ACCEPT_ALL(). Quadros aceitos pelo hardware mas sem inscrição continuam
+ * sendo descartados em software. Não altera a configuração do driver.
+ *
+ * @param[out] report Relatório com o filtro sintetizado e as estimativas.
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_SynthesizeFilter(CanEspFilterReport_t *report);
+
+/**
+ * @brief Sintetiza e aplica o filtro de aceitação ao driver (via CAN_ESP_SetFilterConfig).
+ *
+ * @note Quadros fora das inscrições (ex.: CAN_ESP_SELF_TEST_ID) deixam de ser recebidos.
+ *
+ * @param[out] report Relatório do filtro aplicado (pode ser NULL).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_ApplySynthesizedFilter(CanEspFilterReport_t *report);
+
+/**
+ * @brief Parâmetros de criação de uma tarefa da biblioteca.
+ */
+typedef struct {
+    BaseType_t  core_id;        /**< Núcleo (0 ou 1) ou tskNO_AFFINITY. */
+    uint32_t    stack_size;     /**< Tamanho da pilha em bytes. */
+    UBaseType_t priority;       /**< Prioridade FreeRTOS. */
+} CanEspTaskParams_t;
+
+/**
+ * @brief Configuração das tarefas da biblioteca e da política de prioridade da transmissão.
+ *
+ * A tarefa de transmissão é elevada a tx_boost_priority quando o nível de prioridade mais
+ * ocupado da fila atinge tx_boost_high_pct da capacidade e só volta à prioridade base quando
+ * a ocupação cai abaixo de tx_boost_low_pct, evitando alternâncias a cada quadro.
+ */
+typedef struct {
+    CanEspTaskParams_t transmit;    /**< Tarefa de transmissão assíncrona. */
+    CanEspTaskParams_t receive;     /**< Tarefa de recepção (driver -> anel). */
+    CanEspTaskParams_t dispatch;    /**< Tarefa de despacho (anel -> callbacks). */
+    CanEspTaskParams_t alert;       /**< Tarefa de alertas (conclusão e recuperação). */
+    UBaseType_t tx_boost_priority;  /**< Prioridade sob saturação (0 = sem elevação). */
+    uint8_t     tx_boost_high_pct;  /**< Ocupação que eleva a prioridade. */
+    uint8_t     tx_boost_low_pct;   /**< Ocupação que restaura a prioridade base. */
+} CanEspTaskConfig_t;
+
+/**
+ * @brief Preenche a configuração com os valores padrão (CAN_ESP_TASK_CORE_ID e afins).
+ */
+void CAN_ESP_TaskDefaultConfig(CanEspTaskConfig_t *config);
+
+/**
+ * @brief Define núcleo, pilha e prioridade das tarefas e a política de prioridade.
+ *
+ * Núcleo e pilha valem para as tarefas criadas depois da chamada (chame antes de
+ * CAN_ESP_StartTransmitTask/CAN_ESP_StartReceiveTask); as prioridades das tarefas já em
+ * execução são atualizadas imediatamente.
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM para pilha nula, núcleo inexistente ou
+ *         histerese invertida.
+ */
+can_esp_status_t CAN_ESP_SetTaskConfig(const CanEspTaskConfig_t *config);
+
+/**
+ * @brief Obtém a configuração de tarefas em uso.
+ */
+can_esp_status_t CAN_ESP_GetTaskConfig(CanEspTaskConfig_t *config);
+
+/*
+ * Protótipos de funções para transmissão assíncrona.
+ * A mensagem entra na fila do nível de prioridade codificado no seu ID (bits 26-28) e os
+ * níveis são servidos estritamente por prioridade, em ordem FIFO dentro de cada nível.
+ * high_priority promove a mensagem ao nível 0 (mais urgente), também em ordem FIFO.
+ * Mensagens com prazo (CAN_ESP_AddTxDeadlinePolicy) são ordenadas por prazo dentro do nível
+ * (EDF), à frente das mensagens sem prazo.
+ */
 can_esp_status_t CAN_ESP_EnqueueMessage(const CanEspMessage_t *msg, bool high_priority);
 void CAN_ESP_StartTransmitTask(void);
 
+/**
+ * @brief Enfileira um lote de mensagens de forma atômica.
+ *
+ * Todas as mensagens são inseridas em uma única seção crítica e a tarefa de transmissão é
+ * acordada no máximo uma vez. Bloqueia até haver espaço para o lote inteiro; nenhuma outra
+ * mensagem é intercalada entre as do lote. Se algum quadro for recusado pelos limites de taxa,
+ * nenhum é enfileirado e o retorno é CAN_ESP_ERR_RATE_LIMITED. Nos limites DELAY, max_delay_ms
+ * é um prazo único para o lote, contado a partir da chamada (e não uma espera por mensagem).
+ *
+ * @param msgs Vetor de mensagens a transmitir (na ordem desejada).
+ * @param count Número de mensagens (1 a CAN_ESP_TX_LEVEL_QUEUE_LENGTH).
+ * @param high_priority Se verdadeiro, todo o lote é promovido ao nível de prioridade 0.
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_EnqueueBatch(const CanEspMessage_t *msgs, size_t count, bool high_priority);
+
+/**
+ * @brief Variante não bloqueante de CAN_ESP_EnqueueBatch.
+ *
+ * Insere o maior prefixo do lote que couber na fila e for admitido pelos limites de taxa
+ * (sem espera) e informa quantas mensagens foram aceitas.
+ *
+ * @param msgs Vetor de mensagens a transmitir.
+ * @param count Número de mensagens.
+ * @param high_priority Se verdadeiro, as mensagens aceitas são promovidas ao nível de prioridade 0.
+ * @param[out] accepted Número de mensagens efetivamente enfileiradas.
+ * @return CAN_ESP_OK se todas foram aceitas; CAN_ESP_ERR_QUEUE_FULL ou CAN_ESP_ERR_RATE_LIMITED,
+ *         conforme o que interrompeu o lote, se apenas parte (ou nenhuma).
+ */
+can_esp_status_t CAN_ESP_TryEnqueueBatch(const CanEspMessage_t *msgs, size_t count, bool high_priority, size_t *accepted);
+
+/**
+ * @brief Estatísticas do pool de mensagens de transmissão.
+ */
+typedef struct {
+    uint32_t capacity;          /**< Número de slots do pool. */
+    uint32_t in_use;            /**< Slots ocupados (enfileirados, estacionados ou com o produtor). */
+    uint32_t high_water_mark;   /**< Maior ocupação observada. */
+    uint32_t allocations;       /**< Total de slots obtidos. */
+    uint32_t exhausted;         /**< Pedidos recusados por pool esgotado. */
+    uint32_t invalid_releases;  /**< Devoluções ou enfileiramentos de slots que não estavam com o chamador. */
+} CanEspPoolStats_t;
+
+/**
+ * @brief Obtém um slot do pool para ser preenchido no lugar (sem cópia) pelo produtor.
+ *
+ * O slot deve ser entregue a CAN_ESP_EnqueuePooledMessage ou devolvido com CAN_ESP_FreeMessage.
+ *
+ * @param[out] msg Ponteiro para o slot.
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_QUEUE_FULL se o pool estiver esgotado.
+ */
+can_esp_status_t CAN_ESP_AllocMessage(CanEspMessage_t **msg);
+
+/**
+ * @brief Enfileira um slot obtido com CAN_ESP_AllocMessage (apenas o índice entra na fila).
+ *
+ * Em caso de sucesso o slot passa à biblioteca, que o devolve ao pool após a transmissão ou o
+ * descarte. Não bloqueia: com o nível cheio retorna CAN_ESP_ERR_QUEUE_FULL e, sem token nos
+ * limites de taxa, CAN_ESP_ERR_RATE_LIMITED; em ambos os casos o slot continua com o chamador.
+ *
+ * @param msg Slot preenchido.
+ * @param high_priority Se verdadeiro, a mensagem é promovida ao nível de prioridade 0.
+ * @return CAN_ESP_OK; CAN_ESP_ERR_INVALID_PARAM se o slot não estiver com o chamador (livre ou
+ *         já enfileirado); CAN_ESP_ERR_QUEUE_FULL ou CAN_ESP_ERR_RATE_LIMITED.
+ */
+can_esp_status_t CAN_ESP_EnqueuePooledMessage(CanEspMessage_t *msg, bool high_priority);
+
+/**
+ * @brief Devolve ao pool um slot não enfileirado.
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM se o ponteiro não pertencer ao pool ou o slot
+ *         não estiver com o chamador (já devolvido, enfileirado ou aguardando retransmissão).
+ */
+can_esp_status_t CAN_ESP_FreeMessage(CanEspMessage_t *msg);
+
+/**
+ * @brief Obtém as estatísticas do pool de mensagens.
+ */
+can_esp_status_t CAN_ESP_GetMessagePoolStats(CanEspPoolStats_t *stats);
+
+/*
+ * Limitação de taxa de transmissão por identificador (token bucket, proteção contra "babbling idiot").
+ * Um limite cobre os quadros cujo (id & mask) coincide com (limit_id & mask) e acumula tokens à
+ * taxa rate_per_s, até burst. Um quadro só é admitido se houver token em todos os limites que o
+ * cobrem, de modo que um limite por ID pode ser combinado com outro por módulo. A admissão ocorre
+ * na entrada da fila (CAN_ESP_Enqueue*, inclusive mensagens cíclicas) e em CAN_ESP_SendMessage;
+ * retransmissões não consomem tokens.
+ */
+#define CAN_ESP_MAX_RATE_LIMITS     (16U)
+
+/**
+ * @brief Tratamento de um quadro sem token disponível.
+ */
+typedef enum {
+    CAN_ESP_RATE_LIMIT_DROP = 0,    /**< Recusa o quadro com CAN_ESP_ERR_RATE_LIMITED. */
+    CAN_ESP_RATE_LIMIT_DELAY        /**< Bloqueia o produtor até haver token (no máximo max_delay_ms).
+                                         Nas funções não bloqueantes equivale a DROP. */
+} CanEspRateLimitPolicy_t;
+
+/**
+ * @brief Configuração de um limite de taxa.
+ */
+typedef struct {
+    uint32_t id;                        /**< Identificador de referência. */
+    uint32_t mask;                      /**< Bits comparados (ex.: CAN_ESP_ID_MASK_EXACT, CAN_ESP_ID_MASK_MODULE). */
+    uint32_t rate_per_s;                /**< Taxa sustentada, em quadros por segundo (1 a 1000000). */
+    uint32_t burst;                     /**< Rajada máxima (capacidade do balde, mínimo 1). */
+    CanEspRateLimitPolicy_t policy;     /**< Tratamento sem token. */
+    uint32_t max_delay_ms;              /**< Espera máxima com CAN_ESP_RATE_LIMIT_DELAY. */
+} CanEspRateLimitConfig_t;
+
+/**
+ * @brief Estatísticas de um limite de taxa.
+ */
+typedef struct {
+    uint32_t admitted;                  /**< Quadros admitidos. */
+    uint32_t delayed;                   /**< Quadros admitidos após espera (incluídos em admitted). */
+    uint32_t rejected;                  /**< Quadros recusados. */
+    uint32_t tokens;                    /**< Tokens inteiros disponíveis no momento da consulta. */
+} CanEspRateLimitStats_t;
+
+typedef uint32_t can_esp_rate_limit_t;
+
+/**
+ * @brief Adiciona um limite de taxa, inicialmente com o balde cheio.
+ *
+ * @param config Configuração do limite.
+ * @param[out] limit Handle do limite (opcional).
+ * @return CAN_ESP_OK, CAN_ESP_ERR_INVALID_PARAM para configuração inválida ou
+ *         CAN_ESP_ERR_QUEUE_FULL se não houver entrada livre.
+ */
+can_esp_status_t CAN_ESP_AddRateLimit(const CanEspRateLimitConfig_t *config, can_esp_rate_limit_t *limit);
+can_esp_status_t CAN_ESP_RemoveRateLimit(can_esp_rate_limit_t limit);
+can_esp_status_t CAN_ESP_GetRateLimitStats(can_esp_rate_limit_t limit, CanEspRateLimitStats_t *stats);
+
+/* Total de quadros recusados por limites de taxa desde a inicialização (inclui limites removidos) */
+uint32_t CAN_ESP_GetRateLimitRejections(void);
+
+/*
+ * Prazos e substituição de valores na fila de transmissão.
+ * Uma política cobre os quadros cujo (id & mask) coincide com (policy_id & mask); vale a
+ * primeira registrada. Com lifetime_us, o quadro recebe ao ser enfileirado o prazo
+ * (instante do enfileiramento + lifetime_us), ocupa seu nível em ordem de prazo e é descartado,
+ * sem ir ao barramento, se o prazo vencer antes da transmissão ou do fim do backoff de uma
+ * retransmissão. Com replace_queued, um novo quadro do mesmo ID substitui o valor que ainda
+ * aguarda no mesmo nível sem ocupar outro slot e sem perder a posição na fila (avança apenas se
+ * o novo prazo for menor), e as retransmissões de valores anteriores a um mais recente já
+ * enfileirado são canceladas, mesmo que este já tenha sido transmitido. Quadros descartados
+ * por prazo são informados ao callback de transmissão com CAN_ESP_ERR_TIMEOUT.
+ */
+#define CAN_ESP_MAX_TX_DEADLINE_POLICIES    (16U)
+
+/**
+ * @brief Política de prazo e substituição de um conjunto de IDs.
+ */
+typedef struct {
+    uint32_t id;                /**< Identificador de referência. */
+    uint32_t mask;              /**< Bits comparados (ex.: CAN_ESP_ID_MASK_EXACT). */
+    uint32_t lifetime_us;       /**< Validade após o enfileiramento (0 = sem prazo). */
+    bool     replace_queued;    /**< O valor mais recente substitui o que aguarda na fila. */
+} CanEspTxDeadlinePolicy_t;
+
+/**
+ * @brief Estatísticas de prazos e substituições.
+ */
+typedef struct {
+    uint32_t expired_queued;        /**< Quadros descartados na fila com o prazo vencido. */
+    uint32_t expired_retries;       /**< Retransmissões canceladas por terminarem após o prazo. */
+    uint32_t replaced;              /**< Valores na fila substituídos por um mais recente. */
+    uint32_t superseded_retries;    /**< Retransmissões canceladas por haver valor mais recente enfileirado. */
+} CanEspTxDeadlineStats_t;
+
+typedef uint32_t can_esp_tx_policy_t;
+
+/**
+ * @brief Adiciona uma política de prazo e substituição.
+ *
+ * @param policy Política (lifetime_us e/ou replace_queued).
+ * @param[out] handle Handle da política (opcional).
+ * @return CAN_ESP_OK, CAN_ESP_ERR_INVALID_PARAM para política vazia ou CAN_ESP_ERR_QUEUE_FULL
+ *         se não houver entrada livre.
+ */
+can_esp_status_t CAN_ESP_AddTxDeadlinePolicy(const CanEspTxDeadlinePolicy_t *policy, can_esp_tx_policy_t *handle);
+can_esp_status_t CAN_ESP_RemoveTxDeadlinePolicy(can_esp_tx_policy_t handle);
+can_esp_status_t CAN_ESP_GetTxDeadlineStats(CanEspTxDeadlineStats_t *stats);
+
 /* Função para iniciar a tarefa de recepção baseada em eventos */
 void CAN_ESP_StartReceiveTask(void);
 
+/* Estatísticas do anel SPSC entre a tarefa de recepção e a tarefa de despacho */
+can_esp_status_t CAN_ESP_GetRxRingStats(CanEspRxRingStats_t *stats);
+void CAN_ESP_ResetRxRingHighWaterMark(void);
+
 /* Protótipos de funções auxiliares para codificação do ID CAN */
 uint32_t CAN_ESP_EncodeID(uint8_t priority, uint16_t module, uint16_t command);
 void CAN_ESP_DecodeID(uint32_t id, uint8_t *priority, uint16_t *module, uint16_t *command);
@@ -152,16 +738,219 @@ void CAN_ESP_DecodeID(uint32_t id, uint8_t *priority, uint16_t *module, uint16_t
 typedef void (*can_esp_transmit_callback_t)(uint32_t id, const uint8_t *data, uint8_t length, can_esp_status_t status);
 can_esp_status_t CAN_ESP_RegisterTransmitCallback(can_esp_transmit_callback_t callback);
 
+/**
+ * @brief Callback de conclusão de transmissão.
+ *
+ * Chamado, na ordem de transmissão, quando o driver confirma o envio do quadro no barramento
+ * (alerta TX_SUCCESS), com msg->timestamp_us igual ao instante em que a conclusão do quadro foi
+ * observada. O driver informa apenas quantos quadros falharam (alerta TX_FAILED), não quais:
+ * status é CAN_ESP_ERR_TRANSMIT quando todos os quadros concluídos na mesma leitura falharam ou
+ * foram descartados por bus-off, e CAN_ESP_ERR_TX_UNATTRIBUTED para os quadros concluídos junto
+ * com falhas que não podem ser atribuídas a um quadro específico. Executa na tarefa de alertas.
+ */
+typedef void (*can_esp_transmit_complete_callback_t)(const CanEspMessage_t *msg, can_esp_status_t status);
+
+/**
+ * @brief Registra o callback de conclusão de transmissão (NULL desativa o acompanhamento).
+ *
+ * Na primeira chamada cria a tarefa que aguarda os alertas de transmissão do driver. Enquanto
+ * não houver callback, os quadros transmitidos não são acompanhados e os alertas TX_SUCCESS e
+ * TX_FAILED ficam desligados no driver (custo nulo); registrar ou remover o callback os liga ou
+ * desliga também com o driver já instalado.
+ */
+can_esp_status_t CAN_ESP_RegisterTransmitCompleteCallback(can_esp_transmit_complete_callback_t callback);
+
+/**
+ * @brief Estado de confinamento de falhas do controlador, visto pelo supervisor de recuperação.
+ */
+typedef enum {
+    CAN_ESP_BUS_STATE_ERROR_ACTIVE = 0,     /**< TEC e REC abaixo de 96. */
+    CAN_ESP_BUS_STATE_ERROR_WARNING,        /**< TEC ou REC a partir de 96. */
+    CAN_ESP_BUS_STATE_ERROR_PASSIVE,        /**< TEC ou REC a partir de 128. */
+    CAN_ESP_BUS_STATE_BUS_OFF,              /**< TEC acima de 255: o nó não transmite nem recebe. */
+    CAN_ESP_BUS_STATE_RECOVERING            /**< Aguardando 128 ocorrências de 11 bits recessivos. */
+} CanEspBusState_t;
+
+/**
+ * @brief Política do supervisor de recuperação de bus-off.
+ *
+ * No bus-off a tarefa de transmissão é suspensa: as mensagens dos níveis 0 a flush_from_level - 1
+ * são retidas e transmitidas após a recuperação, e as dos níveis flush_from_level em diante são
+ * descartadas (o callback de transmissão recebe CAN_ESP_ERR_TRANSMIT). Com flush_from_level igual
+ * a CAN_ESP_NUM_PRIORITY_LEVELS nada é descartado.
+ */
+typedef struct {
+    bool     auto_recover;          /**< Inicia a recuperação automaticamente após o bus-off. */
+    uint32_t recovery_delay_ms;     /**< Espera entre o bus-off e o início da recuperação. */
+    uint32_t max_attempts;          /**< Bus-offs consecutivos recuperados automaticamente (0 = sem limite). */
+    uint32_t stable_time_ms;        /**< Tempo em error-active que zera a contagem de bus-offs consecutivos. */
+    uint8_t  flush_from_level;      /**< Primeiro nível de prioridade descartado no bus-off. */
+} CanEspRecoveryPolicy_t;
+
+/**
+ * @brief Estatísticas do supervisor de recuperação.
+ *
+ * O tempo de recuperação vai da detecção do bus-off (alerta BUS_OFF) ao reinício do driver
+ * após o alerta BUS_RECOVERED.
+ */
+typedef struct {
+    CanEspBusState_t state;             /**< Estado atual. */
+    uint32_t error_warning_events;      /**< Entradas em error-warning. */
+    uint32_t error_passive_events;      /**< Entradas em error-passive. */
+    uint32_t bus_off_events;            /**< Entradas em bus-off. */
+    uint32_t recoveries;                /**< Recuperações concluídas. */
+    uint32_t recovery_failures;         /**< Falhas ao iniciar a recuperação ou reiniciar o driver. */
+    uint32_t suppressed_recoveries;     /**< Bus-offs não recuperados por exceder max_attempts. */
+    uint32_t consecutive_bus_offs;      /**< Bus-offs desde o último período estável. */
+    uint32_t flushed_frames;            /**< Mensagens descartadas da fila no bus-off. */
+    uint32_t held_frames;               /**< Mensagens retidas na fila no último bus-off. */
+    int64_t  last_bus_off_us;           /**< Instante do último bus-off (esp_timer_get_time). */
+    int64_t  last_recovery_time_us;     /**< Duração da última recuperação. */
+    int64_t  max_recovery_time_us;      /**< Maior duração de recuperação. */
+    int64_t  total_downtime_us;         /**< Soma das durações de recuperação. */
+} CanEspRecoveryStats_t;
+
+/**
+ * @brief Callback de mudança de estado do barramento (executa na tarefa de alertas).
+ */
+typedef void (*can_esp_bus_state_callback_t)(CanEspBusState_t previous, CanEspBusState_t current);
+
+/**
+ * @brief Preenche a política com os valores padrão (recuperação automática imediata, até 5
+ *        bus-offs consecutivos, níveis 4 a 7 descartados).
+ */
+void CAN_ESP_RecoveryDefaultPolicy(CanEspRecoveryPolicy_t *policy);
+
+/**
+ * @brief Inicia o supervisor de recuperação (ou atualiza sua política).
+ *
+ * O supervisor compartilha com o acompanhamento de conclusão a tarefa que aguarda os alertas do
+ * driver, de modo que error-passive e bus-off são tratados assim que o alerta é sinalizado.
+ *
+ * @param policy Política a aplicar (NULL = padrão).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_StartRecoverySupervisor(const CanEspRecoveryPolicy_t *policy);
+
+/**
+ * @brief Inicia manualmente a recuperação de um bus-off (ex.: após max_attempts).
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM se o controlador não estiver em bus-off.
+ */
+can_esp_status_t CAN_ESP_InitiateRecovery(void);
+
+/**
+ * @brief Obtém as estatísticas do supervisor de recuperação.
+ */
+can_esp_status_t CAN_ESP_GetRecoveryStats(CanEspRecoveryStats_t *stats);
+
+/**
+ * @brief Registra o callback de mudança de estado do barramento (NULL remove).
+ */
+can_esp_status_t CAN_ESP_RegisterBusStateCallback(can_esp_bus_state_callback_t callback);
+
 /* Protótipos de funções de diagnóstico e monitoramento */
 can_esp_status_t CAN_ESP_GetDiagnostics(CanEspDiagnostics_t *diag);
 can_esp_status_t CAN_ESP_GetLatencyMetrics(CanEspLatencyMetrics_t *metrics);
+
+/**
+ * @brief Obtém um percentil arbitrário da latência de transmissão acumulada.
+ *
+ * @param percentile Percentil desejado (0 a 100, ex.: 99.9).
+ * @param[out] latency_us Latência correspondente (em microsegundos).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_GetLatencyPercentile(float percentile, int64_t *latency_us);
+
+/**
+ * @brief Fecha a janela de latência corrente e inicia uma nova.
+ *
+ * As métricas acumuladas (CAN_ESP_GetLatencyMetrics) não são afetadas.
+ *
+ * @param[out] closed_window Métricas da janela encerrada (pode ser NULL).
+ * @return CAN_ESP_OK.
+ */
+can_esp_status_t CAN_ESP_ResetLatencyWindow(CanEspLatencyMetrics_t *closed_window);
 can_esp_status_t CAN_ESP_GetQueueStatus(CanEspQueueStatus_t *status);
 uint32_t CAN_ESP_GetBusLoad(void);
+can_esp_status_t CAN_ESP_GetBusLoadStats(CanEspBusLoadStats_t *stats);
+
+/**
+ * @brief Copia as estatísticas de todos os identificadores observados.
+ *
+ * @param[out] out              Vetor de destino.
+ * @param max                   Capacidade do vetor (CAN_ESP_ID_STATS_TABLE_SIZE cobre a tabela inteira).
+ * @param[out] count            Número de entradas copiadas.
+ * @param[out] untracked_frames Quadros não contabilizados por tabela cheia (pode ser NULL).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_GetIdStats(CanEspIdStats_t *out, size_t max, size_t *count, uint32_t *untracked_frames);
+
+/**
+ * @brief Obtém as estatísticas de um identificador.
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_INVALID_PARAM se o ID ainda não foi observado.
+ */
+can_esp_status_t CAN_ESP_GetIdStatsEntry(uint32_t id, CanEspIdStats_t *out);
+void CAN_ESP_ResetIdStats(void);
+can_esp_status_t CAN_ESP_SetBusLoadStuffingMode(CanEspStuffingMode_t mode);
+
+/**
+ * @brief Calcula o número de bits que um quadro ocupa no barramento (SOF até o fim do IFS).
+ *
+ * @param id       Identificador do quadro.
+ * @param extended true para identificador de 29 bits.
+ * @param rtr      true para quadro remoto (sem campo de dados).
+ * @param dlc      Código de tamanho dos dados (0 a 8).
+ * @param data     Dados do quadro (necessário apenas no modo exato).
+ * @param mode     Modo de contabilização do stuffing.
+ * @return uint32_t Número de bits no fio.
+ */
+uint32_t CAN_ESP_CalculateFrameBits(uint32_t id, bool extended, bool rtr, uint8_t dlc,
+                                    const uint8_t *data, CanEspStuffingMode_t mode);
+
+/**
+ * @brief Callback que preenche os dados de uma mensagem cíclica a cada liberação.
+ *
+ * Executado no contexto da tarefa do esp_timer, fora do mutex do escalonador: deve ser curto
+ * e não bloqueante. Uma liberação já em curso ainda pode chamá-lo logo após
+ * CAN_ESP_UnregisterCyclicMessage retornar.
+ *
+ * @param msg Mensagem com o ID já preenchido; o callback define data e length.
+ * @param ctx Contexto informado no registro.
+ * @return true para enviar a mensagem nesta liberação, false para pular.
+ */
+typedef bool (*can_esp_cyclic_fill_t)(CanEspMessage_t *msg, void *ctx);
+typedef uint32_t can_esp_cyclic_t;
+
+/**
+ * @brief Registra uma mensagem de transmissão periódica.
+ *
+ * Todas as mensagens cíclicas são liberadas por um único esp_timer e enfileiradas sem
+ * bloqueio (CAN_ESP_TryEnqueueBatch) no nível de prioridade do seu ID.
+ *
+ * @param id            Identificador CAN.
+ * @param period_us     Período (mínimo CAN_ESP_CYCLIC_MIN_PERIOD_US).
+ * @param offset_us     Fase dentro do período, ou CAN_ESP_CYCLIC_AUTO_OFFSET para que o
+ *                      escalonador escolha a fase mais distante das mensagens já registradas.
+ * @param fill_callback Callback de preenchimento (NULL envia quadro sem dados).
+ * @param ctx           Contexto repassado ao callback.
+ * @param[out] cyclic   Identificador da mensagem registrada (pode ser NULL).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_RegisterCyclicMessage(uint32_t id, uint32_t period_us, uint32_t offset_us,
+                                               can_esp_cyclic_fill_t fill_callback, void *ctx,
+                                               can_esp_cyclic_t *cyclic);
+can_esp_status_t CAN_ESP_UnregisterCyclicMessage(can_esp_cyclic_t cyclic);
+can_esp_status_t CAN_ESP_GetCyclicStats(can_esp_cyclic_t cyclic, CanEspCyclicStats_t *stats);
 
 /* Protótipo da função para calcular checksum */
 uint8_t CAN_ESP_CalculateChecksum(const uint8_t *data, uint8_t length);
 
-/* Protótipo para ajuste dinâmico da prioridade da tarefa de transmissão */
+/*
+ * Ajuste dinâmico da prioridade da tarefa de transmissão conforme a ocupação da fila, com a
+ * histerese de CanEspTaskConfig_t (chamado pela própria tarefa a cada quadro).
+ */
 can_esp_status_t CAN_ESP_AdjustTransmitTaskPriority(void);
 
 /* Função para obter o total de transmissões ocorridas */
@@ -170,6 +959,9 @@ uint32_t CAN_ESP_GetTransmissionAttempts(void);
 /* Função para obter o total de retransmissões ocorridas */
 uint32_t CAN_ESP_GetRetransmissionCount(void);
 
+/* Função para obter as estatísticas da roda de retransmissões (backoff e resultado) */
+can_esp_status_t CAN_ESP_GetRetryStats(CanEspRetryStats_t *stats);
+
 /* Nova funcionalidade: Métricas de colisões */
 uint32_t CAN_ESP_GetCollisionCount(void);
 uint32_t CAN_ESP_GetCollisionRate(void);
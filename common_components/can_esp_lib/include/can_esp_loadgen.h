@@ -0,0 +1,119 @@
+/*
+ * can_esp_loadgen.h
+ * Gerador de tráfego CAN sintético com carga de barramento alvo
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * Cada fluxo do gerador é uma mensagem cíclica (CAN_ESP_RegisterCyclicMessage_v2) e passa pela
+ * fila de transmissão, pelo backend de driver e pelas métricas da instância, de modo que o
+ * mesmo cenário exercita o escalonador de transmissão, o diagnóstico e os alertas tanto no
+ * TWAI quanto no barramento virtual (alvo linux ou testes no host). Os períodos nominais da
+ * mistura são escalados para que a soma dos bits no fio atinja a carga alvo no bitrate da
+ * instância.
+ *
+ * Uso típico:
+ *   CAN_ESP_LoadGenDefaultConfig(&cfg);
+ *   cfg.target_load_pct = 60U;
+ *   CAN_ESP_LoadGenStart(&cfg);
+ *   ...
+ *   CAN_ESP_LoadGenGetStats(&stats);
+ *   CAN_ESP_LoadGenStop();
+ */
+
+#ifndef CAN_ESP_LOADGEN_H
+#define CAN_ESP_LOADGEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "can_esp_lib.h"
+
+/* Fluxos simultâneos (cada um ocupa uma mensagem cíclica da instância) */
+#define CAN_ESP_LOADGEN_MAX_STREAMS     (16U)
+
+/* Módulo (campo de CAN_ESP_EncodeID) dos identificadores da mistura padrão */
+#ifndef CAN_ESP_LOADGEN_MODULE
+#define CAN_ESP_LOADGEN_MODULE          (0x3F0U)
+#endif
+
+/**
+ * @brief Fluxo da mistura de tráfego.
+ *
+ * O período informado é nominal: somente as proporções entre os fluxos são preservadas.
+ */
+typedef struct {
+    uint32_t id;                /**< Identificador estendido (ex.: CAN_ESP_EncodeID). */
+    uint8_t  dlc;               /**< Bytes de dados (0 a CAN_MAX_DATA_LENGTH, sem o checksum). */
+    uint32_t period_us;         /**< Período nominal. */
+} CanEspLoadGenStream_t;
+
+/**
+ * @brief Configuração do gerador.
+ */
+typedef struct {
+    can_esp_handle_t handle;                /**< Instância usada na transmissão (NULL = padrão). */
+    uint32_t target_load_pct;               /**< Carga alvo (1 a 100 %). */
+    const CanEspLoadGenStream_t *streams;   /**< Mistura (NULL = mistura padrão de 12 fluxos). */
+    size_t   stream_count;                  /**< Quantidade de fluxos em streams. */
+    bool     random_phase;                  /**< Fases aleatórias (ausente: distribuídas pelo escalonador). */
+    bool     random_payload;                /**< Dados aleatórios (ausente: contador de sequência). */
+    uint32_t seed;                          /**< Semente do gerador pseudoaleatório (0 = padrão). */
+} CanEspLoadGenConfig_t;
+
+/**
+ * @brief Estatísticas do gerador.
+ *
+ * A carga planejada é estimada com os bits no fio das cargas úteis produzidas pelo gerador; a
+ * medida é a da janela de 1 s da instância e inclui todo o tráfego do barramento observado.
+ */
+typedef struct {
+    bool     running;                   /**< Gerador ativo. */
+    uint32_t streams;                   /**< Fluxos registrados. */
+    uint32_t target_permille;           /**< Carga alvo (por mil). */
+    uint32_t planned_permille;          /**< Carga resultante dos períodos escalados (por mil). */
+    uint32_t measured_permille;         /**< Carga medida na janela de 1 s (por mil). */
+    uint32_t releases;                  /**< Liberações somadas de todos os fluxos. */
+    uint32_t missed_releases;           /**< Liberações perdidas por atraso do escalonador. */
+    uint32_t enqueue_failures;          /**< Quadros recusados pela fila de transmissão. */
+    uint32_t max_jitter_us;             /**< Maior atraso de liberação entre os fluxos. */
+} CanEspLoadGenStats_t;
+
+/**
+ * @brief Preenche a configuração padrão (instância padrão, 30 %, mistura padrão, fases
+ *        distribuídas e contador de sequência).
+ */
+void CAN_ESP_LoadGenDefaultConfig(CanEspLoadGenConfig_t *config);
+
+/**
+ * @brief Escala a mistura para a carga alvo e registra seus fluxos como mensagens cíclicas.
+ *
+ * O driver da instância deve estar configurado (o bitrate define a capacidade do barramento) e
+ * a tarefa de transmissão, iniciada. Um gerador por vez.
+ *
+ * @param config Configuração (NULL = padrão).
+ * @return CAN_ESP_OK; CAN_ESP_ERR_INVALID_PARAM se a mistura for inválida, exigir período
+ *         menor que CAN_ESP_CYCLIC_MIN_PERIOD_US ou já houver um gerador ativo;
+ *         CAN_ESP_ERR_QUEUE_FULL se não houver mensagens cíclicas livres.
+ */
+can_esp_status_t CAN_ESP_LoadGenStart(const CanEspLoadGenConfig_t *config);
+
+/**
+ * @brief Remove os fluxos do gerador.
+ */
+void CAN_ESP_LoadGenStop(void);
+
+/**
+ * @brief Obtém as estatísticas do gerador.
+ */
+can_esp_status_t CAN_ESP_LoadGenGetStats(CanEspLoadGenStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_LOADGEN_H */
@@ -0,0 +1,132 @@
+/*
+ * can_esp_replay.h
+ * Reprodução temporizada de logs CAN (candump, Vector ASC ou registros da captura)
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * Por padrão os quadros entram na fila de transmissão da instância (CAN_ESP_EnqueueMessage_v2),
+ * sujeitos aos mesmos níveis, limites de taxa, prazos e retransmissões das mensagens da
+ * aplicação; a instância precisa da tarefa de transmissão e o quadro segue o formato da
+ * biblioteca (identificador estendido e checksum, se configurado). Quadros que a fila não
+ * representa (identificador padrão ou RTR) são contados como ignorados.
+ *
+ * Com bypass_tx_queue, os quadros vão direto ao driver (backend, estatísticas, captura e
+ * confirmação de conclusão), preservando o formato bruto do log (identificador padrão ou
+ * estendido, RTR e dados, sem o checksum), mas sem passar pela fila: níveis, limites de taxa,
+ * prazos e retransmissões não se aplicam e o envio compete com a tarefa de transmissão.
+ *
+ * O instante de cada quadro é o do log, relativo ao primeiro quadro reproduzido e dividido pelo
+ * fator de velocidade; o atraso de cada envio em relação a esse cronograma é medido e reportado.
+ *
+ * A reprodução é bloqueante e executa na tarefa chamadora: use uma tarefa de prioridade
+ * adequada e, para logs no SD Card, um leitor de linhas (ex.: fgets) como fonte.
+ */
+
+#ifndef CAN_ESP_REPLAY_H
+#define CAN_ESP_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "can_esp_lib.h"
+#include "can_esp_capture.h"
+
+/* Maior linha de log aceita por CAN_ESP_ReplayLog */
+#define CAN_ESP_REPLAY_MAX_LINE_LENGTH  (128U)
+
+/**
+ * @brief Configuração da reprodução.
+ */
+typedef struct {
+    can_esp_handle_t handle;    /**< Instância usada na transmissão (NULL = padrão). */
+    float    speed_factor;      /**< 1,0 = tempo real, 2,0 = duas vezes mais rápido, 0 = sem espera. */
+    bool     replay_rx;         /**< Reproduz quadros registrados como recebidos. */
+    bool     replay_tx;         /**< Reproduz quadros registrados como transmitidos. */
+    int32_t  channel;           /**< Canal do log a reproduzir (-1 = todos). */
+    bool     bypass_tx_queue;   /**< Transmite direto no driver, fora da fila (ver descrição acima). */
+} CanEspReplayConfig_t;
+
+/**
+ * @brief Resultado da reprodução.
+ *
+ * O desvio de cronograma é o atraso entre o instante previsto e o início da transmissão de cada
+ * quadro; suas métricas usam o mesmo histograma da latência de transmissão. Sem espera
+ * (speed_factor = 0) o desvio não é medido.
+ */
+typedef struct {
+    uint32_t frames_sent;               /**< Quadros enfileirados (ou transmitidos, com bypass_tx_queue). */
+    uint32_t frames_failed;             /**< Quadros recusados pela fila ou pelo driver. */
+    uint32_t frames_skipped;            /**< Quadros filtrados ou não representáveis na fila, eventos de erro e linhas sem quadro. */
+    int64_t  log_span_us;               /**< Duração do log reproduzido (sem o fator de velocidade). */
+    int64_t  elapsed_us;                /**< Duração real da reprodução. */
+    bool     aborted;                   /**< Interrompida por CAN_ESP_ReplayStop. */
+    CanEspLatencyMetrics_t deviation;   /**< Desvio de cronograma (us). */
+} CanEspReplayStats_t;
+
+/**
+ * @brief Fonte de linhas do log.
+ *
+ * @param[out] line Destino da próxima linha (terminada em '\0').
+ * @param size      Tamanho do destino.
+ * @param ctx       Contexto informado na reprodução.
+ * @return true se uma linha foi lida; false no fim do log.
+ */
+typedef bool (*can_esp_replay_line_reader_t)(char *line, size_t size, void *ctx);
+
+/**
+ * @brief Preenche a configuração padrão (instância padrão, tempo real, RX e TX, todos os canais,
+ *        pela fila de transmissão).
+ */
+void CAN_ESP_ReplayDefaultConfig(CanEspReplayConfig_t *config);
+
+/**
+ * @brief Converte uma linha de log em registro.
+ *
+ * No candump o canal é o número final do nome da interface; no ASC, o canal menos um. O
+ * instante é o do log (segundos desde a inicialização no candump, relativos no ASC).
+ *
+ * @return CAN_ESP_OK se a linha contém um quadro, CAN_ESP_ERR_INVALID_PARAM caso contrário
+ *         (cabeçalho, comentário, evento de erro, quadro CAN FD ou linha malformada).
+ */
+can_esp_status_t CAN_ESP_ReplayParseLine(CanEspCaptureFormat_t format, const char *line, CanEspCaptureRecord_t *record);
+
+/**
+ * @brief Reproduz um vetor de registros (ex.: lido com CAN_ESP_CaptureRead).
+ *
+ * @param config Configuração (NULL = padrão).
+ * @param records Registros, em ordem cronológica.
+ * @param count  Quantidade de registros.
+ * @param[out] stats Resultado (opcional).
+ * @return CAN_ESP_OK ao fim dos registros; CAN_ESP_ERR_ABORTED se interrompida por CAN_ESP_ReplayStop.
+ */
+can_esp_status_t CAN_ESP_ReplayRecords(const CanEspReplayConfig_t *config, const CanEspCaptureRecord_t *records,
+                                       size_t count, CanEspReplayStats_t *stats);
+
+/**
+ * @brief Reproduz um log textual lido linha a linha.
+ *
+ * @param config Configuração (NULL = padrão).
+ * @param format Formato do log.
+ * @param reader Fonte das linhas.
+ * @param ctx    Contexto da fonte.
+ * @param[out] stats Resultado (opcional).
+ * @return CAN_ESP_OK ao fim do log; CAN_ESP_ERR_ABORTED se interrompida por CAN_ESP_ReplayStop.
+ */
+can_esp_status_t CAN_ESP_ReplayLog(const CanEspReplayConfig_t *config, CanEspCaptureFormat_t format,
+                                   can_esp_replay_line_reader_t reader, void *ctx, CanEspReplayStats_t *stats);
+
+/**
+ * @brief Solicita a interrupção da reprodução em andamento (chamada de outra tarefa).
+ */
+void CAN_ESP_ReplayStop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_REPLAY_H */
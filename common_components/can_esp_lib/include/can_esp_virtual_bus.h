@@ -0,0 +1,125 @@
+/*
+ * can_esp_virtual_bus.h
+ * Barramento CAN virtual em processo (múltiplos nós) para builds de host e testes
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#ifndef CAN_ESP_VIRTUAL_BUS_H
+#define CAN_ESP_VIRTUAL_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "can_esp_lib.h"
+#include "can_esp_driver.h"
+
+/* Número máximo de nós no barramento virtual */
+#define CAN_ESP_VBUS_MAX_NODES          (8U)
+
+/* Prioridade e pilha da tarefa que arbitra o barramento */
+#define CAN_ESP_VBUS_TASK_PRIORITY      (configMAX_PRIORITIES - 2)
+#define CAN_ESP_VBUS_TASK_STACK_SIZE    (4096U)
+
+/* Limiares de estado de erro (ISO 11898-1) */
+#define CAN_ESP_VBUS_ERR_WARN_LIMIT     (96U)
+#define CAN_ESP_VBUS_ERR_PASSIVE_LIMIT  (128U)
+#define CAN_ESP_VBUS_BUS_OFF_LIMIT      (256U)
+
+/* Recuperação de bus-off: 128 ocorrências de 11 bits recessivos */
+#define CAN_ESP_VBUS_RECOVERY_BITS      (128U * 11U)
+
+typedef uint32_t can_esp_vbus_node_t;
+
+/**
+ * @brief Estatísticas globais do barramento virtual.
+ */
+typedef struct {
+    uint32_t bitrate;               /**< Taxa de bits simulada. */
+    uint32_t node_count;            /**< Nós criados. */
+    uint64_t frames;                /**< Quadros transmitidos com sucesso. */
+    uint64_t error_frames;          /**< Quadros destruídos por erro (injetado ou falta de ACK). */
+    uint64_t arbitration_losses;    /**< Perdas de arbitragem somadas entre os nós. */
+    uint64_t busy_bits;             /**< Tempo de bit ocupado (quadros e quadros de erro). */
+    uint64_t virtual_time_us;       /**< Tempo de barramento ocupado, em microssegundos. */
+} CanEspVirtualBusStats_t;
+
+/**
+ * @brief Inicializa o barramento virtual e cria a tarefa de arbitragem.
+ *
+ * Cada quadro ocupa o barramento pelo número exato de bits (com stuffing) à taxa informada;
+ * a tarefa cadencia o tempo virtual contra o tempo real. As configurações de temporização dos
+ * nós são ignoradas em favor desta taxa.
+ *
+ * @param bitrate Taxa de bits do barramento (bps).
+ * @return CAN_ESP_OK em caso de sucesso ou um código de erro apropriado.
+ */
+can_esp_status_t CAN_ESP_VirtualBusInit(uint32_t bitrate);
+
+/**
+ * @brief Encerra a tarefa de arbitragem e libera os nós do barramento virtual.
+ *
+ * As instâncias da biblioteca conectadas ao barramento devem ser desinicializadas antes e ter o
+ * backend restaurado (CAN_ESP_SetDriverBackend com NULL).
+ *
+ * @return CAN_ESP_OK, ou CAN_ESP_ERR_UNKNOWN se o barramento não estiver inicializado.
+ */
+can_esp_status_t CAN_ESP_VirtualBusDeinit(void);
+
+/**
+ * @brief Cria um nó no barramento virtual.
+ *
+ * @param[out] node Identificador do nó.
+ * @return CAN_ESP_OK ou CAN_ESP_ERR_QUEUE_FULL se não houver nós livres.
+ */
+can_esp_status_t CAN_ESP_VirtualBusAddNode(can_esp_vbus_node_t *node);
+
+/**
+ * @brief Operações de driver do barramento virtual (usadas com CAN_ESP_VirtualBusNodeContext).
+ */
+const CanEspDriverOps_t *CAN_ESP_VirtualBusGetOps(void);
+
+/**
+ * @brief Contexto de driver do nó, a ser passado às operações de CAN_ESP_VirtualBusGetOps.
+ *
+ * @return Contexto do nó ou NULL se o identificador for inválido.
+ */
+void *CAN_ESP_VirtualBusNodeContext(can_esp_vbus_node_t node);
+
+/**
+ * @brief Seleciona o nó como backend de driver da biblioteca (CAN_ESP_SetDriverBackend).
+ */
+can_esp_status_t CAN_ESP_VirtualBusAttach(can_esp_vbus_node_t node);
+
+/**
+ * @brief Seleciona o nó como backend de driver da instância informada (CAN_ESP_SetDriverBackend_v2).
+ *
+ * Permite simular vários ECUs no mesmo processo, um por instância da biblioteca.
+ */
+can_esp_status_t CAN_ESP_VirtualBusAttach_v2(can_esp_handle_t handle, can_esp_vbus_node_t node);
+
+/**
+ * @brief Injeta erros nas próximas transmissões do nó.
+ *
+ * Cada erro destrói um quadro do nó: o transmissor soma 8 ao TEC e os receptores somam 1 ao REC,
+ * podendo levar o nó a error-passive e bus-off.
+ *
+ * @param node  Nó alvo.
+ * @param count Número de quadros a corromper.
+ */
+can_esp_status_t CAN_ESP_VirtualBusInjectErrors(can_esp_vbus_node_t node, uint32_t count);
+
+/**
+ * @brief Obtém as estatísticas do barramento virtual.
+ */
+can_esp_status_t CAN_ESP_VirtualBusGetStats(CanEspVirtualBusStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_ESP_VIRTUAL_BUS_H */
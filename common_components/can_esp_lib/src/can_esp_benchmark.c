@@ -0,0 +1,562 @@
+/*
+ * can_esp_benchmark.c
+ * Micro e macro benchmarks dos caminhos críticos da can_esp_lib
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * Cada medição gera uma linha JSON entregue ao writer da configuração, para comparação entre
+ * execuções (ex.: detecção de regressões em CI com o alvo linux).
+ */
+
+#include "can_esp_benchmark.h"
+#include "can_esp_virtual_bus.h"
+#include "can_esp_instance.h"
+#include "can_esp_lib_internal.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "CAN_ESP_BENCH";
+
+/* Módulo reservado aos quadros do benchmark */
+#define BENCH_MODULE                (0x3F0U)
+#define BENCH_PROBE_COMMAND         (0x001U)
+#define BENCH_DATA_COMMAND          (0x002U)
+#define BENCH_FILLER_COMMAND        (0x003U)
+
+/* Intervalo entre sondas de latência e aquecimento da carga antes da coleta */
+#define BENCH_PROBE_PERIOD_MS       (5U)
+#define BENCH_LOAD_WARMUP_MS        (200U)
+#define BENCH_DRAIN_MS              (50U)
+
+/* Fila de transmissão do nó gerador de carga (absorve a granularidade do tick) */
+#define BENCH_LOAD_TX_QUEUE_LEN     (64U)
+
+#define BENCH_TASK_STACK_SIZE       (4096U)
+#define BENCH_TASK_PRIORITY         (configMAX_PRIORITIES - 3)
+
+/* Impede que o compilador descarte os laços dos micro benchmarks */
+static volatile uint32_t benchSink = 0U;
+
+/* Estado dos macro benchmarks */
+static const CanEspDriverOps_t *benchOps = NULL;
+static void *benchSinkCtx = NULL;
+static void *benchLoadCtx = NULL;
+static volatile bool benchSinkRunning = false;
+static volatile bool benchLoadRunning = false;
+static volatile uint32_t benchLoadPermille = 0U;
+static volatile uint32_t benchSinkFrames = 0U;
+static SemaphoreHandle_t benchDoneSemaphore = NULL;
+static CanEspLatencyHist_t benchLatency;
+
+/*
+ * Instância privada dos macro benchmarks: criada na primeira execução e reaproveitada nas
+ * seguintes, pois a tarefa de transmissão iniciada nela não pode ser encerrada (e uma instância
+ * com tarefas não pode ser removida).
+ */
+static can_esp_handle_t benchInstance = NULL;
+static bool benchTxTaskStarted = false;
+
+/*==============================================================================
+                               SAÍDA DOS RESULTADOS
+ ==============================================================================*/
+
+static void bench_emit(const CanEspBenchmarkConfig_t *config, const char *line)
+{
+    if (config->writer != NULL) {
+        config->writer(line, config->ctx);
+    }
+}
+
+static void bench_emit_micro(const CanEspBenchmarkConfig_t *config, const char *name, int64_t elapsed_us)
+{
+    char line[CAN_ESP_BENCH_LINE_MAX];
+    double ns_per_op = ((double)elapsed_us * 1000.0) / (double)config->micro_iterations;
+
+    (void)snprintf(line, sizeof(line),
+                   "{\"bench\":\"%s\",\"kind\":\"micro\",\"iterations\":%" PRIu32 ",\"ns_per_op\":%.1f}",
+                   name, config->micro_iterations, ns_per_op);
+    bench_emit(config, line);
+}
+
+static void bench_emit_meta(const CanEspBenchmarkConfig_t *config)
+{
+    char line[CAN_ESP_BENCH_LINE_MAX];
+#ifdef CONFIG_IDF_TARGET
+    const char *target = CONFIG_IDF_TARGET;
+#else
+    const char *target = "unknown";
+#endif
+#ifdef configTICK_RATE_HZ
+    uint32_t tick_hz = (uint32_t)configTICK_RATE_HZ;
+#else
+    uint32_t tick_hz = 1000U / (uint32_t)portTICK_PERIOD_MS;
+#endif
+
+    (void)snprintf(line, sizeof(line),
+                   "{\"bench\":\"meta\",\"target\":\"%s\",\"bitrate\":%" PRIu32 ",\"tick_hz\":%" PRIu32 "}",
+                   target, config->bitrate, tick_hz);
+    bench_emit(config, line);
+}
+
+/*==============================================================================
+                                MICRO BENCHMARKS
+ ==============================================================================*/
+
+void CAN_ESP_BenchmarkDefaultConfig(CanEspBenchmarkConfig_t *config, can_esp_bench_writer_t writer, void *ctx)
+{
+    if (config == NULL) {
+        return;
+    }
+    config->micro_iterations = CAN_ESP_BENCH_DEFAULT_MICRO_ITERATIONS;
+    config->throughput_frames = CAN_ESP_BENCH_DEFAULT_THROUGHPUT_FRAMES;
+    config->latency_samples = CAN_ESP_BENCH_DEFAULT_LATENCY_SAMPLES;
+    config->bitrate = CAN_ESP_BENCH_DEFAULT_BITRATE;
+    config->writer = writer;
+    config->ctx = ctx;
+}
+
+can_esp_status_t CAN_ESP_RunMicroBenchmarks(const CanEspBenchmarkConfig_t *config)
+{
+    CanEspMessage_t msg = {0};
+    CanEspMessage_t *out;
+    twai_message_t frame;
+    can_esp_handle_t inst;
+    can_esp_status_t status;
+    int64_t start;
+    uint32_t n;
+    uint32_t acc = 0U;
+
+    if (config == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (config->micro_iterations == 0U) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    /* A fila é exercitada numa instância própria, sem tocar na instância padrão da aplicação */
+    status = CAN_ESP_CreateInstance(&inst);
+    if (status != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao criar a instância privada do benchmark.");
+        return status;
+    }
+    if (!can_esp_tx_ring_init(inst)) {
+        ESP_LOGE(TAG, "Falha ao inicializar a fila de transmissão para o benchmark.");
+        (void)CAN_ESP_DeleteInstance(inst);
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    n = config->micro_iterations;
+    msg.id = CAN_ESP_EncodeID(4U, BENCH_MODULE, BENCH_DATA_COMMAND);
+    msg.length = CAN_MAX_DATA_LENGTH;
+    for (uint8_t i = 0U; i < CAN_MAX_DATA_LENGTH; i++) {
+        msg.data[i] = (uint8_t)(0x5AU ^ i);
+    }
+
+    bench_emit_meta(config);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        acc += CAN_ESP_EncodeID((uint8_t)(i & 7U), (uint16_t)(i & 0x3FFU), (uint16_t)i);
+    }
+    bench_emit_micro(config, "encode_id", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        uint8_t priority;
+        uint16_t module;
+        uint16_t command;
+        CAN_ESP_DecodeID(i * 2654435761UL, &priority, &module, &command);
+        acc += (uint32_t)priority + module + command;
+    }
+    bench_emit_micro(config, "decode_id", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        msg.data[0] = (uint8_t)i;
+        acc += CAN_ESP_CalculateChecksum(msg.data, CAN_MAX_DATA_LENGTH);
+    }
+    bench_emit_micro(config, "checksum_8", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        msg.data[0] = (uint8_t)i;
+        can_esp_convert_canesp_to_twai(inst, &msg, &frame);
+        acc += frame.data[0];
+    }
+    bench_emit_micro(config, "convert_to_twai", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        msg.data[0] = (uint8_t)i;
+        acc += CAN_ESP_CalculateFrameBits(msg.id, true, false, (uint8_t)(i & 7U), msg.data, CAN_ESP_STUFFING_WORST_CASE);
+    }
+    bench_emit_micro(config, "frame_bits_worst_case", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        msg.data[0] = (uint8_t)i;
+        acc += CAN_ESP_CalculateFrameBits(msg.id, true, false, (uint8_t)(i & 7U), msg.data, CAN_ESP_STUFFING_EXACT);
+    }
+    bench_emit_micro(config, "frame_bits_exact", esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        if (CAN_ESP_EnqueueMessage_v2(inst, &msg, false) == CAN_ESP_OK) {
+            out = can_esp_tx_ring_pop(inst);
+            if (out != NULL) {
+                acc += out->length;
+                can_esp_tx_ring_release(inst, out);
+            }
+        }
+    }
+    bench_emit_micro(config, "enqueue_dequeue", esp_timer_get_time() - start);
+
+    /* Mesmo ciclo com o slot preenchido no lugar (sem a cópia do enfileiramento) */
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        if (CAN_ESP_AllocMessage_v2(inst, &out) != CAN_ESP_OK) {
+            continue;
+        }
+        out->id = msg.id;
+        out->length = msg.length;
+        out->data[0] = (uint8_t)i;
+        if (CAN_ESP_EnqueuePooledMessage_v2(inst, out, false) != CAN_ESP_OK) {
+            (void)CAN_ESP_FreeMessage_v2(inst, out);
+            continue;
+        }
+        out = can_esp_tx_ring_pop(inst);
+        if (out != NULL) {
+            acc += out->length;
+            can_esp_tx_ring_release(inst, out);
+        }
+    }
+    bench_emit_micro(config, "pooled_enqueue_dequeue", esp_timer_get_time() - start);
+
+    benchSink = acc;
+    return CAN_ESP_DeleteInstance(inst);
+}
+
+/*==============================================================================
+                                MACRO BENCHMARKS
+ ==============================================================================*/
+
+/* Nó receptor: conta quadros de dados e registra a latência das sondas (carimbo nos dados) */
+static void bench_sink_task(void *arg)
+{
+    uint32_t probe_id = CAN_ESP_EncodeID(1U, BENCH_MODULE, BENCH_PROBE_COMMAND);
+    uint32_t data_id = CAN_ESP_EncodeID(4U, BENCH_MODULE, BENCH_DATA_COMMAND);
+    twai_message_t rx;
+
+    (void)arg;
+    while (benchSinkRunning) {
+        if (benchOps->receive(benchSinkCtx, &rx, pdMS_TO_TICKS(10)) != ESP_OK) {
+            continue;
+        }
+        if (rx.identifier == probe_id && rx.data_length_code >= sizeof(int64_t)) {
+            int64_t sent;
+            memcpy(&sent, rx.data, sizeof(sent));
+            can_esp_latency_hist_record(&benchLatency, esp_timer_get_time() - sent);
+        } else if (rx.identifier == data_id) {
+            benchSinkFrames++;
+        }
+    }
+    (void)xSemaphoreGive(benchDoneSemaphore);
+    vTaskDelete(NULL);
+}
+
+/* Nó gerador de carga: quadros de menor prioridade à taxa que ocupa benchLoadPermille do barramento */
+static void bench_load_task(void *arg)
+{
+    const CanEspBenchmarkConfig_t *config = (const CanEspBenchmarkConfig_t *)arg;
+    twai_message_t filler = {0};
+    uint32_t frame_bits;
+    uint64_t sent = 0U;
+    int64_t start = esp_timer_get_time();
+
+    filler.identifier = CAN_ESP_EncodeID(7U, BENCH_MODULE, BENCH_FILLER_COMMAND);
+    filler.extd = 1U;
+    filler.data_length_code = CAN_MAX_DATA_LENGTH;
+    memset(filler.data, 0xA5, CAN_MAX_DATA_LENGTH);
+    frame_bits = CAN_ESP_CalculateFrameBits(filler.identifier, true, false, CAN_MAX_DATA_LENGTH,
+                                            filler.data, CAN_ESP_STUFFING_EXACT);
+
+    while (benchLoadRunning) {
+        int64_t elapsed = esp_timer_get_time() - start;
+        uint64_t due = ((uint64_t)elapsed * config->bitrate * benchLoadPermille) /
+                       ((uint64_t)frame_bits * 1000ULL * 1000000ULL);
+        while (sent < due) {
+            if (benchOps->transmit(benchLoadCtx, &filler, 0) != ESP_OK) {
+                /* Fila cheia: descarta o atraso acumulado em vez de gerar rajadas */
+                sent = due;
+                break;
+            }
+            sent++;
+        }
+        vTaskDelay(1);
+    }
+    (void)xSemaphoreGive(benchDoneSemaphore);
+    vTaskDelete(NULL);
+}
+
+static bool bench_wait_frames(uint32_t expected, int64_t timeout_us)
+{
+    int64_t deadline = esp_timer_get_time() + timeout_us;
+
+    while (benchSinkFrames < expected) {
+        if (esp_timer_get_time() >= deadline) {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+static uint64_t bench_bus_bits(void)
+{
+    CanEspVirtualBusStats_t stats;
+
+    if (CAN_ESP_VirtualBusGetStats(&stats) != CAN_ESP_OK) {
+        return 0U;
+    }
+    return stats.busy_bits;
+}
+
+static double bench_load_pct(const CanEspBenchmarkConfig_t *config, uint64_t bits, int64_t elapsed_us)
+{
+    if (elapsed_us <= 0) {
+        return 0.0;
+    }
+    return ((double)bits * 1000000.0 * 100.0) / ((double)elapsed_us * (double)config->bitrate);
+}
+
+/* Vazão de SendMessage (síncrono) ou EnqueueMessage (assíncrono) até a entrega ao receptor */
+static void bench_throughput(const CanEspBenchmarkConfig_t *config, bool async)
+{
+    char line[CAN_ESP_BENCH_LINE_MAX];
+    CanEspMessage_t msg = {0};
+    uint32_t n = config->throughput_frames;
+    uint32_t frame_bits;
+    int64_t start;
+    int64_t calls_us;
+    int64_t elapsed;
+    uint64_t bits0;
+    uint32_t errors = 0U;
+
+    msg.id = CAN_ESP_EncodeID(4U, BENCH_MODULE, BENCH_DATA_COMMAND);
+    msg.length = CAN_MAX_DATA_LENGTH;
+    frame_bits = CAN_ESP_CalculateFrameBits(msg.id, true, false, msg.length, msg.data, CAN_ESP_STUFFING_WORST_CASE);
+
+    benchSinkFrames = 0U;
+    bits0 = bench_bus_bits();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < n; i++) {
+        can_esp_status_t status;
+        msg.data[0] = (uint8_t)i;
+        if (async) {
+            status = CAN_ESP_EnqueueMessage_v2(benchInstance, &msg, false);
+        } else {
+            status = CAN_ESP_SendMessage_v2(benchInstance, msg.id, msg.data, msg.length);
+        }
+        if (status != CAN_ESP_OK) {
+            errors++;
+        }
+    }
+    calls_us = esp_timer_get_time() - start;
+    /* Prazo: o dobro do tempo de barramento dos quadros, mais 1 s */
+    (void)bench_wait_frames(n - errors, (((int64_t)n * frame_bits * 2000000LL) / config->bitrate) + 1000000LL);
+    elapsed = esp_timer_get_time() - start;
+
+    (void)snprintf(line, sizeof(line),
+                   "{\"bench\":\"%s\",\"kind\":\"throughput\",\"frames\":%" PRIu32 ",\"delivered\":%" PRIu32
+                   ",\"errors\":%" PRIu32 ",\"call_us\":%.2f,\"frames_per_s\":%.1f,\"bus_load_pct\":%.1f}",
+                   async ? "enqueue_async" : "send_sync", n, benchSinkFrames, errors,
+                   (double)calls_us / (double)n,
+                   (elapsed > 0) ? ((double)benchSinkFrames * 1000000.0) / (double)elapsed : 0.0,
+                   bench_load_pct(config, bench_bus_bits() - bits0, elapsed));
+    bench_emit(config, line);
+}
+
+/* Latência fim a fim (enfileiramento até a recepção no outro nó) sob carga de fundo */
+static void bench_latency(const CanEspBenchmarkConfig_t *config, uint32_t load_pct)
+{
+    char line[CAN_ESP_BENCH_LINE_MAX];
+    CanEspMessage_t probe = {0};
+    CanEspLatencyMetrics_t metrics;
+    int64_t start;
+    int64_t elapsed;
+    uint64_t bits0;
+
+    benchLoadPermille = load_pct * 10U;
+    benchLoadRunning = true;
+    if (xTaskCreate(bench_load_task, "can_bench_load", BENCH_TASK_STACK_SIZE, (void *)config,
+                    BENCH_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar a tarefa de carga do benchmark.");
+        benchLoadRunning = false;
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(BENCH_LOAD_WARMUP_MS));
+
+    can_esp_latency_hist_reset(&benchLatency);
+    probe.id = CAN_ESP_EncodeID(1U, BENCH_MODULE, BENCH_PROBE_COMMAND);
+    probe.length = CAN_MAX_DATA_LENGTH;
+    bits0 = bench_bus_bits();
+    start = esp_timer_get_time();
+    for (uint32_t i = 0U; i < config->latency_samples; i++) {
+        int64_t now = esp_timer_get_time();
+        memcpy(probe.data, &now, sizeof(now));
+        (void)CAN_ESP_EnqueueMessage_v2(benchInstance, &probe, false);
+        vTaskDelay(pdMS_TO_TICKS(BENCH_PROBE_PERIOD_MS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(BENCH_DRAIN_MS));
+    elapsed = esp_timer_get_time() - start;
+
+    benchLoadRunning = false;
+    (void)xSemaphoreTake(benchDoneSemaphore, portMAX_DELAY);
+
+    can_esp_latency_hist_snapshot(&benchLatency, &metrics);
+    (void)snprintf(line, sizeof(line),
+                   "{\"bench\":\"e2e_latency\",\"kind\":\"latency\",\"target_load_pct\":%" PRIu32
+                   ",\"measured_load_pct\":%.1f,\"samples\":%" PRIu32 ",\"p50_us\":%" PRId64
+                   ",\"p90_us\":%" PRId64 ",\"p99_us\":%" PRId64 ",\"max_us\":%" PRId64 "}",
+                   load_pct, bench_load_pct(config, bench_bus_bits() - bits0, elapsed),
+                   metrics.num_samples, metrics.p50_latency, metrics.p90_latency,
+                   metrics.p99_latency, metrics.max_latency);
+    bench_emit(config, line);
+}
+
+/*
+ * Desfaz a montagem do macro benchmark: driver da instância privada, backend, barramento virtual
+ * e semáforo. A instância é mantida para a próxima execução.
+ */
+static void bench_teardown(bool lib_initialized)
+{
+    if (lib_initialized) {
+        (void)CAN_ESP_Deinit_v2(benchInstance);
+    }
+    if (benchInstance != NULL) {
+        (void)CAN_ESP_SetDriverBackend_v2(benchInstance, NULL, NULL);
+    }
+    (void)CAN_ESP_VirtualBusDeinit();
+    vSemaphoreDelete(benchDoneSemaphore);
+    benchDoneSemaphore = NULL;
+}
+
+can_esp_status_t CAN_ESP_RunMacroBenchmarks(const CanEspBenchmarkConfig_t *config)
+{
+    static const uint32_t load_points[] = CAN_ESP_BENCH_LOAD_POINTS;
+    can_esp_vbus_node_t libNode;
+    can_esp_vbus_node_t sinkNode;
+    can_esp_vbus_node_t loadNode;
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = {0};
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    CanEspConfig_t libConfig = {0};
+    can_esp_status_t status;
+
+    if (config == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (config->throughput_frames == 0U || config->bitrate == 0U) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+
+    if (benchInstance == NULL) {
+        status = CAN_ESP_CreateInstance(&benchInstance);
+        if (status != CAN_ESP_OK) {
+            ESP_LOGE(TAG, "Falha ao criar a instância privada do benchmark.");
+            benchInstance = NULL;
+            return status;
+        }
+    }
+    benchDoneSemaphore = xSemaphoreCreateBinary();
+    if (benchDoneSemaphore == NULL) {
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    status = CAN_ESP_VirtualBusInit(config->bitrate);
+    if (status != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao montar o barramento virtual do benchmark.");
+        vSemaphoreDelete(benchDoneSemaphore);
+        benchDoneSemaphore = NULL;
+        return status;
+    }
+    status = CAN_ESP_VirtualBusAddNode(&libNode);
+    if (status == CAN_ESP_OK) {
+        status = CAN_ESP_VirtualBusAddNode(&sinkNode);
+    }
+    if (status == CAN_ESP_OK) {
+        status = CAN_ESP_VirtualBusAddNode(&loadNode);
+    }
+    if (status != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao montar o barramento virtual do benchmark.");
+        bench_teardown(false);
+        return status;
+    }
+
+    benchOps = CAN_ESP_VirtualBusGetOps();
+    benchSinkCtx = CAN_ESP_VirtualBusNodeContext(sinkNode);
+    benchLoadCtx = CAN_ESP_VirtualBusNodeContext(loadNode);
+    general.rx_queue_len = BENCH_LOAD_TX_QUEUE_LEN;
+    (void)benchOps->install(benchSinkCtx, &general, &timing, &filter);
+    (void)benchOps->start(benchSinkCtx);
+    general.tx_queue_len = BENCH_LOAD_TX_QUEUE_LEN;
+    (void)benchOps->install(benchLoadCtx, &general, &timing, &filter);
+    (void)benchOps->start(benchLoadCtx);
+
+    /* A biblioteca só precisa receber as próprias sondas; descarta o restante no filtro */
+    libConfig.bitrate = config->bitrate;
+    libConfig.tx_gpio = CAN_TX_GPIO;
+    libConfig.rx_gpio = CAN_RX_GPIO;
+    libConfig.transmit_timeout_ms = CAN_DEFAULT_TRANSMIT_TIMEOUT_MS;
+    libConfig.receive_timeout_ms = CAN_DEFAULT_RECEIVE_TIMEOUT_MS;
+    libConfig.filter_config = (twai_filter_config_t){
+        .acceptance_code = CAN_ESP_EncodeID(1U, BENCH_MODULE, BENCH_PROBE_COMMAND) << 3,
+        .acceptance_mask = 0x7U,
+        .single_filter = true
+    };
+    libConfig.mode = TWAI_MODE_NORMAL;
+    libConfig.auto_retransmit = true;
+    status = CAN_ESP_VirtualBusAttach_v2(benchInstance, libNode);
+    if (status == CAN_ESP_OK) {
+        status = CAN_ESP_InitWithConfig_v2(benchInstance, &libConfig);
+    }
+    if (status != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao inicializar a biblioteca sobre o barramento virtual.");
+        bench_teardown(false);
+        return status;
+    }
+
+    benchSinkRunning = true;
+    if (xTaskCreate(bench_sink_task, "can_bench_sink", BENCH_TASK_STACK_SIZE, NULL,
+                    BENCH_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar a tarefa receptora do benchmark.");
+        benchSinkRunning = false;
+        bench_teardown(true);
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    bench_emit_meta(config);
+    bench_throughput(config, false);
+    if (!benchTxTaskStarted) {
+        CAN_ESP_StartTransmitTask_v2(benchInstance);
+        benchTxTaskStarted = true;
+    }
+    bench_throughput(config, true);
+    for (size_t i = 0U; i < (sizeof(load_points) / sizeof(load_points[0])); i++) {
+        bench_latency(config, load_points[i]);
+    }
+
+    benchSinkRunning = false;
+    (void)xSemaphoreTake(benchDoneSemaphore, portMAX_DELAY);
+    status = CAN_ESP_Deinit_v2(benchInstance);
+    bench_teardown(false);
+    return status;
+}
@@ -0,0 +1,480 @@
+/*
+ * can_esp_capture.c
+ * Implementação da captura de quadros brutos em anel e da exportação candump/ASC
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_capture.h"
+#include "can_esp_lib_internal.h"
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+
+#define TAG    "CAN_ESP_CAPTURE"
+
+/* Registros retirados do anel por iteração da exportação */
+#define CAPTURE_EXPORT_BATCH    (16U)
+
+/* Bloco de texto entregue ao destino da exportação */
+#define CAPTURE_EXPORT_CHUNK    (512U)
+
+#define CAPTURE_US_PER_S        ((int64_t)1000000)
+
+/* Quadros de erro do SocketCAN (linux/can/error.h) usados na exportação candump */
+#define CANDUMP_ERR_FLAG        (0x20000000U)
+#define CANDUMP_ERR_CRTL        (0x00000004U)
+#define CANDUMP_ERR_BUSOFF      (0x00000040U)
+#define CANDUMP_ERR_RESTARTED   (0x00000100U)
+#define CANDUMP_CRTL_WARNING    (0x0CU)     /* CAN_ERR_CRTL_RX_WARNING | CAN_ERR_CRTL_TX_WARNING */
+#define CANDUMP_CRTL_PASSIVE    (0x30U)     /* CAN_ERR_CRTL_RX_PASSIVE | CAN_ERR_CRTL_TX_PASSIVE */
+#define CANDUMP_CRTL_ACTIVE     (0x40U)
+
+/*
+ * Anel da captura. head aponta o registro mais antigo; gravar com o anel cheio avança head
+ * (sobrescrita). Gravação e leitura ocorrem sob captureLock, que cobre apenas a cópia de um
+ * registro, para que as tarefas de recepção e transmissão não sejam retidas.
+ */
+static CanEspCaptureRecord_t captureRing[CAN_ESP_CAPTURE_RING_SIZE];
+static uint32_t captureHead;
+static uint32_t captureCount;
+static CanEspCaptureConfig_t captureConfig;
+static CanEspCaptureStats_t captureStats;
+static uint32_t captureTriggerLeft;         /* Registros restantes até congelar (0 = sem gatilho armado) */
+static volatile bool captureRunning;
+static portMUX_TYPE captureLock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================
+                         GRAVAÇÃO (CHAMADA PELA BIBLIOTECA)
+ ==============================================================================*/
+
+/* Grava um registro; chamada com captureLock adquirido */
+static void capture_push_locked(const CanEspCaptureRecord_t *record)
+{
+    uint32_t index;
+
+    if (captureStats.frozen) {
+        captureStats.dropped_while_frozen++;
+        return;
+    }
+    if (captureCount == CAN_ESP_CAPTURE_RING_SIZE) {
+        captureHead = (captureHead + 1U) % CAN_ESP_CAPTURE_RING_SIZE;
+        captureCount--;
+        captureStats.overwritten++;
+    }
+    index = (captureHead + captureCount) % CAN_ESP_CAPTURE_RING_SIZE;
+    captureRing[index] = *record;
+    captureCount++;
+    captureStats.recorded++;
+    if (captureTriggerLeft > 0U) {
+        captureTriggerLeft--;
+        if (captureTriggerLeft == 0U) {
+            captureStats.frozen = true;
+        }
+    }
+}
+
+void can_esp_capture_record_frame(uint8_t channel, const twai_message_t *frame, bool is_tx, int64_t now)
+{
+    CanEspCaptureRecord_t record;
+    uint8_t length;
+
+    if (!captureRunning || (is_tx ? !captureConfig.capture_tx : !captureConfig.capture_rx)) {
+        return;
+    }
+    length = (frame->data_length_code <= CAN_MAX_DATA_LENGTH) ? (uint8_t)frame->data_length_code : CAN_MAX_DATA_LENGTH;
+    record.timestamp_us = now;
+    record.id = frame->identifier;
+    record.flags = (uint8_t)((is_tx ? CAN_ESP_CAPTURE_FLAG_TX : 0U) |
+                             (frame->extd ? CAN_ESP_CAPTURE_FLAG_EXTD : 0U) |
+                             (frame->rtr ? CAN_ESP_CAPTURE_FLAG_RTR : 0U));
+    record.channel = channel;
+    record.length = length;
+    (void)memset(record.data, 0, sizeof(record.data));
+    if (!frame->rtr) {
+        (void)memcpy(record.data, frame->data, length);
+    }
+    portENTER_CRITICAL(&captureLock);
+    capture_push_locked(&record);
+    portEXIT_CRITICAL(&captureLock);
+}
+
+void can_esp_capture_record_bus_state(uint8_t channel, CanEspBusState_t state, int64_t now)
+{
+    CanEspCaptureRecord_t record = {0};
+
+    if (!captureRunning || !captureConfig.capture_errors) {
+        return;
+    }
+    record.timestamp_us = now;
+    record.id = (uint32_t)state;
+    record.flags = CAN_ESP_CAPTURE_FLAG_ERROR;
+    record.channel = channel;
+    portENTER_CRITICAL(&captureLock);
+    capture_push_locked(&record);
+    /* O gatilho é armado depois de gravar o próprio evento de bus-off */
+    if (state == CAN_ESP_BUS_STATE_BUS_OFF && captureConfig.freeze_on_bus_off &&
+        !captureStats.frozen && captureTriggerLeft == 0U) {
+        captureStats.triggers++;
+        if (captureConfig.post_trigger_records == 0U) {
+            captureStats.frozen = true;
+        } else {
+            captureTriggerLeft = captureConfig.post_trigger_records;
+        }
+    }
+    portEXIT_CRITICAL(&captureLock);
+}
+
+/*==============================================================================
+                              CONTROLE DA CAPTURA
+ ==============================================================================*/
+
+void CAN_ESP_CaptureDefaultConfig(CanEspCaptureConfig_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    config->capture_rx = true;
+    config->capture_tx = true;
+    config->capture_errors = true;
+    config->freeze_on_bus_off = true;
+    config->post_trigger_records = CAN_ESP_CAPTURE_DEFAULT_POST_TRIGGER;
+}
+
+can_esp_status_t CAN_ESP_CaptureStart(const CanEspCaptureConfig_t *config)
+{
+    CanEspCaptureConfig_t applied;
+
+    if (config == NULL) {
+        CAN_ESP_CaptureDefaultConfig(&applied);
+    } else {
+        applied = *config;
+    }
+    if (applied.post_trigger_records >= CAN_ESP_CAPTURE_RING_SIZE) {
+        ESP_LOGE(TAG, "Registros pós-gatilho devem ser menores que o anel (%u).",
+                 (unsigned int)CAN_ESP_CAPTURE_RING_SIZE);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&captureLock);
+    captureConfig = applied;
+    captureHead = 0U;
+    captureCount = 0U;
+    captureTriggerLeft = 0U;
+    (void)memset(&captureStats, 0, sizeof(captureStats));
+    captureRunning = true;
+    portEXIT_CRITICAL(&captureLock);
+    ESP_LOGI(TAG, "Captura iniciada (%u registros).", (unsigned int)CAN_ESP_CAPTURE_RING_SIZE);
+    return CAN_ESP_OK;
+}
+
+void CAN_ESP_CaptureStop(void)
+{
+    captureRunning = false;
+}
+
+void CAN_ESP_CaptureFreeze(void)
+{
+    portENTER_CRITICAL(&captureLock);
+    captureStats.frozen = true;
+    captureTriggerLeft = 0U;
+    portEXIT_CRITICAL(&captureLock);
+}
+
+void CAN_ESP_CaptureResume(bool clear)
+{
+    portENTER_CRITICAL(&captureLock);
+    if (clear) {
+        captureHead = 0U;
+        captureCount = 0U;
+    }
+    captureStats.frozen = false;
+    captureTriggerLeft = 0U;
+    portEXIT_CRITICAL(&captureLock);
+}
+
+bool CAN_ESP_CaptureIsFrozen(void)
+{
+    bool frozen;
+
+    portENTER_CRITICAL(&captureLock);
+    frozen = captureStats.frozen;
+    portEXIT_CRITICAL(&captureLock);
+    return frozen;
+}
+
+can_esp_status_t CAN_ESP_CaptureRead(CanEspCaptureRecord_t *records, size_t max, size_t *count)
+{
+    size_t n = 0U;
+
+    if (records == NULL || count == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na leitura da captura.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    /* Um registro por seção crítica: a gravação concorrente nunca espera pela cópia do lote */
+    while (n < max) {
+        portENTER_CRITICAL(&captureLock);
+        if (captureCount == 0U) {
+            portEXIT_CRITICAL(&captureLock);
+            break;
+        }
+        records[n] = captureRing[captureHead];
+        captureHead = (captureHead + 1U) % CAN_ESP_CAPTURE_RING_SIZE;
+        captureCount--;
+        portEXIT_CRITICAL(&captureLock);
+        n++;
+    }
+    *count = n;
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_CaptureGetStats(CanEspCaptureStats_t *stats)
+{
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na consulta da captura.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&captureLock);
+    *stats = captureStats;
+    stats->count = captureCount;
+    portEXIT_CRITICAL(&captureLock);
+    stats->capacity = CAN_ESP_CAPTURE_RING_SIZE;
+    stats->running = captureRunning;
+    return CAN_ESP_OK;
+}
+
+/*==============================================================================
+                        FORMATAÇÃO (CANDUMP E VECTOR ASC)
+ ==============================================================================*/
+
+/* Acrescenta " XX" (ASC) ou "XX" (candump) para cada byte; retorna o novo comprimento */
+static size_t capture_append_hex(char *buf, size_t pos, const uint8_t *data, uint8_t length, bool spaced)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    for (uint8_t i = 0U; i < length; i++) {
+        if (spaced) {
+            buf[pos++] = ' ';
+        }
+        buf[pos++] = hexDigits[data[i] >> 4];
+        buf[pos++] = hexDigits[data[i] & 0x0FU];
+    }
+    return pos;
+}
+
+/* Converte um evento de estado em quadro de erro do SocketCAN; false se não houver equivalente */
+static bool capture_candump_error(CanEspBusState_t state, uint32_t *id, uint8_t *data)
+{
+    (void)memset(data, 0, CAN_MAX_DATA_LENGTH);
+    switch (state) {
+    case CAN_ESP_BUS_STATE_BUS_OFF:
+        *id = CANDUMP_ERR_FLAG | CANDUMP_ERR_BUSOFF;
+        return true;
+    case CAN_ESP_BUS_STATE_ERROR_PASSIVE:
+        *id = CANDUMP_ERR_FLAG | CANDUMP_ERR_CRTL;
+        data[1] = CANDUMP_CRTL_PASSIVE;
+        return true;
+    case CAN_ESP_BUS_STATE_ERROR_WARNING:
+        *id = CANDUMP_ERR_FLAG | CANDUMP_ERR_CRTL;
+        data[1] = CANDUMP_CRTL_WARNING;
+        return true;
+    case CAN_ESP_BUS_STATE_ERROR_ACTIVE:
+        *id = CANDUMP_ERR_FLAG | CANDUMP_ERR_CRTL | CANDUMP_ERR_RESTARTED;
+        data[1] = CANDUMP_CRTL_ACTIVE;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static const char *capture_asc_status(CanEspBusState_t state)
+{
+    switch (state) {
+    case CAN_ESP_BUS_STATE_BUS_OFF:
+        return "bus off";
+    case CAN_ESP_BUS_STATE_ERROR_PASSIVE:
+        return "error passive";
+    case CAN_ESP_BUS_STATE_ERROR_WARNING:
+        return "warning level";
+    case CAN_ESP_BUS_STATE_ERROR_ACTIVE:
+        return "error active";
+    default:
+        return NULL;
+    }
+}
+
+static size_t capture_format_candump(const CanEspCaptureRecord_t *rec, char *buf, size_t size)
+{
+    uint32_t id = rec->id;
+    uint8_t errData[CAN_MAX_DATA_LENGTH];
+    const uint8_t *data = rec->data;
+    uint8_t length = rec->length;
+    bool extended = (rec->flags & CAN_ESP_CAPTURE_FLAG_EXTD) != 0U;
+    int n;
+    size_t pos;
+
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_ERROR) != 0U) {
+        if (!capture_candump_error((CanEspBusState_t)rec->id, &id, errData)) {
+            return 0U;
+        }
+        data = errData;
+        length = CAN_MAX_DATA_LENGTH;
+        extended = true;
+    }
+    n = snprintf(buf, size, extended ? "(%" PRId64 ".%06" PRId64 ") can%u %08" PRIX32 "#"
+                                     : "(%" PRId64 ".%06" PRId64 ") can%u %03" PRIX32 "#",
+                 rec->timestamp_us / CAPTURE_US_PER_S, rec->timestamp_us % CAPTURE_US_PER_S, (unsigned int)rec->channel, id);
+    if (n < 0) {
+        return 0U;
+    }
+    pos = (size_t)n;
+    if (pos + (2U * CAN_MAX_DATA_LENGTH) + 2U > size) {
+        return 0U;
+    }
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_RTR) != 0U) {
+        buf[pos++] = 'R';
+    } else {
+        pos = capture_append_hex(buf, pos, data, length, false);
+    }
+    buf[pos++] = '\n';
+    buf[pos] = '\0';
+    return pos;
+}
+
+static size_t capture_format_asc(const CanEspCaptureRecord_t *rec, int64_t origin_us, char *buf, size_t size)
+{
+    int64_t rel = rec->timestamp_us - origin_us;
+    unsigned int channel = (unsigned int)rec->channel + 1U;     /* Canais ASC começam em 1 */
+    const char *status;
+    char id[12];
+    int n;
+    size_t pos;
+
+    if (rel < 0) {
+        rel = 0;
+    }
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_ERROR) != 0U) {
+        status = capture_asc_status((CanEspBusState_t)rec->id);
+        if (status == NULL) {
+            return 0U;
+        }
+        n = snprintf(buf, size, "%4" PRId64 ".%06" PRId64 " CAN %u Status:chip status %s\n",
+                     rel / CAPTURE_US_PER_S, rel % CAPTURE_US_PER_S, channel, status);
+        return (n < 0 || (size_t)n >= size) ? 0U : (size_t)n;
+    }
+    (void)snprintf(id, sizeof(id), ((rec->flags & CAN_ESP_CAPTURE_FLAG_EXTD) != 0U) ? "%" PRIX32 "x" : "%" PRIX32,
+                   rec->id);
+    n = snprintf(buf, size, "%4" PRId64 ".%06" PRId64 " %u  %-15s %s   %c %u",
+                 rel / CAPTURE_US_PER_S, rel % CAPTURE_US_PER_S, channel, id,
+                 ((rec->flags & CAN_ESP_CAPTURE_FLAG_TX) != 0U) ? "Tx" : "Rx",
+                 ((rec->flags & CAN_ESP_CAPTURE_FLAG_RTR) != 0U) ? 'r' : 'd', (unsigned int)rec->length);
+    if (n < 0) {
+        return 0U;
+    }
+    pos = (size_t)n;
+    if (pos + (3U * CAN_MAX_DATA_LENGTH) + 2U > size) {
+        return 0U;
+    }
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_RTR) == 0U) {
+        pos = capture_append_hex(buf, pos, rec->data, rec->length, true);
+    }
+    buf[pos++] = '\n';
+    buf[pos] = '\0';
+    return pos;
+}
+
+size_t CAN_ESP_CaptureFormatRecord(CanEspCaptureFormat_t format, const CanEspCaptureRecord_t *record,
+                                   int64_t origin_us, char *buf, size_t size)
+{
+    if (record == NULL || buf == NULL || size == 0U) {
+        return 0U;
+    }
+    if (format == CAN_ESP_CAPTURE_FORMAT_ASC) {
+        return capture_format_asc(record, origin_us, buf, size);
+    }
+    return capture_format_candump(record, buf, size);
+}
+
+/*==============================================================================
+                                   EXPORTAÇÃO
+ ==============================================================================*/
+
+/* Cabeçalho ASC; a data vem do relógio do sistema (válida se sincronizado por SNTP/RTC) */
+static size_t capture_asc_header(char *buf, size_t size)
+{
+    time_t now = time(NULL);
+    struct tm tmNow;
+    char date[40] = "";
+    int n;
+
+    if (localtime_r(&now, &tmNow) != NULL) {
+        (void)strftime(date, sizeof(date), "%a %b %d %I:%M:%S.000 %p %Y", &tmNow);
+    }
+    n = snprintf(buf, size, "date %s\nbase hex  timestamps absolute\ninternal events logged\nBegin Triggerblock %s\n",
+                 date, date);
+    return (n < 0 || (size_t)n >= size) ? 0U : (size_t)n;
+}
+
+can_esp_status_t CAN_ESP_CaptureExport(CanEspCaptureFormat_t format, can_esp_capture_writer_t writer, void *ctx)
+{
+    static const char ascFooter[] = "End TriggerBlock\n";
+    CanEspCaptureRecord_t batch[CAPTURE_EXPORT_BATCH];
+    char chunk[CAPTURE_EXPORT_CHUNK];
+    size_t used = 0U;
+    size_t got = 0U;
+    uint32_t remaining;
+    int64_t origin = 0;
+    bool haveOrigin = false;
+
+    if (writer == NULL) {
+        ESP_LOGE(TAG, "Destino nulo na exportação da captura.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&captureLock);
+    remaining = captureCount;
+    portEXIT_CRITICAL(&captureLock);
+
+    if (format == CAN_ESP_CAPTURE_FORMAT_ASC) {
+        used = capture_asc_header(chunk, sizeof(chunk));
+    }
+    while (remaining > 0U) {
+        (void)CAN_ESP_CaptureRead(batch, (remaining < CAPTURE_EXPORT_BATCH) ? remaining : CAPTURE_EXPORT_BATCH, &got);
+        if (got == 0U) {
+            break;
+        }
+        remaining -= (uint32_t)got;
+        for (size_t i = 0U; i < got; i++) {
+            if (!haveOrigin) {
+                origin = batch[i].timestamp_us;
+                haveOrigin = true;
+            }
+            if (sizeof(chunk) - used <= CAN_ESP_CAPTURE_MAX_LINE_LENGTH) {
+                if (!writer(chunk, used, ctx)) {
+                    return CAN_ESP_ERR_TRANSMIT;
+                }
+                used = 0U;
+            }
+            used += CAN_ESP_CaptureFormatRecord(format, &batch[i], origin, &chunk[used], sizeof(chunk) - used);
+        }
+    }
+    if (format == CAN_ESP_CAPTURE_FORMAT_ASC) {
+        if (sizeof(chunk) - used < sizeof(ascFooter)) {
+            if (!writer(chunk, used, ctx)) {
+                return CAN_ESP_ERR_TRANSMIT;
+            }
+            used = 0U;
+        }
+        (void)memcpy(&chunk[used], ascFooter, sizeof(ascFooter) - 1U);
+        used += sizeof(ascFooter) - 1U;
+    }
+    if (used > 0U && !writer(chunk, used, ctx)) {
+        return CAN_ESP_ERR_TRANSMIT;
+    }
+    return CAN_ESP_OK;
+}
@@ -0,0 +1,222 @@
+/*
+ * can_esp_driver_twai.c
+ * Backend padrão da can_esp_lib: driver TWAI nativo do ESP-IDF
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_driver.h"
+
+#if defined(CONFIG_IDF_TARGET_LINUX) && CONFIG_IDF_TARGET_LINUX
+
+/* Sem periférico TWAI no host: é obrigatório selecionar um backend (ex.: barramento virtual) */
+const CanEspDriverOps_t *CAN_ESP_GetTwaiDriverOps(void)
+{
+    return NULL;
+}
+
+const CanEspDriverOps_t *CAN_ESP_GetTwaiControllerDriverOps(uint32_t controller_id, void **ctx)
+{
+    (void)controller_id;
+    if (ctx != NULL) {
+        *ctx = NULL;
+    }
+    return NULL;
+}
+
+#else
+
+#include "driver/twai.h"
+#include "esp_idf_version.h"
+#include "soc/soc_caps.h"
+
+static esp_err_t twai_backend_install(void *ctx, const twai_general_config_t *g_config,
+                                      const twai_timing_config_t *t_config, const twai_filter_config_t *f_config)
+{
+    (void)ctx;
+    return twai_driver_install(g_config, t_config, f_config);
+}
+
+static esp_err_t twai_backend_uninstall(void *ctx)
+{
+    (void)ctx;
+    return twai_driver_uninstall();
+}
+
+static esp_err_t twai_backend_start(void *ctx)
+{
+    (void)ctx;
+    return twai_start();
+}
+
+static esp_err_t twai_backend_stop(void *ctx)
+{
+    (void)ctx;
+    return twai_stop();
+}
+
+static esp_err_t twai_backend_transmit(void *ctx, const twai_message_t *message, TickType_t ticks_to_wait)
+{
+    (void)ctx;
+    return twai_transmit(message, ticks_to_wait);
+}
+
+static esp_err_t twai_backend_receive(void *ctx, twai_message_t *message, TickType_t ticks_to_wait)
+{
+    (void)ctx;
+    return twai_receive(message, ticks_to_wait);
+}
+
+static esp_err_t twai_backend_get_status_info(void *ctx, twai_status_info_t *status_info)
+{
+    (void)ctx;
+    return twai_get_status_info(status_info);
+}
+
+static esp_err_t twai_backend_read_alerts(void *ctx, uint32_t *alerts, TickType_t ticks_to_wait)
+{
+    (void)ctx;
+    return twai_read_alerts(alerts, ticks_to_wait);
+}
+
+static esp_err_t twai_backend_reconfigure_alerts(void *ctx, uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    (void)ctx;
+    return twai_reconfigure_alerts(alerts_enabled, current_alerts);
+}
+
+static esp_err_t twai_backend_initiate_recovery(void *ctx)
+{
+    (void)ctx;
+    return twai_initiate_recovery();
+}
+
+static const CanEspDriverOps_t twaiDriverOps = {
+    .install = twai_backend_install,
+    .uninstall = twai_backend_uninstall,
+    .start = twai_backend_start,
+    .stop = twai_backend_stop,
+    .transmit = twai_backend_transmit,
+    .receive = twai_backend_receive,
+    .get_status_info = twai_backend_get_status_info,
+    .read_alerts = twai_backend_read_alerts,
+    .reconfigure_alerts = twai_backend_reconfigure_alerts,
+    .initiate_recovery = twai_backend_initiate_recovery,
+};
+
+const CanEspDriverOps_t *CAN_ESP_GetTwaiDriverOps(void)
+{
+    return &twaiDriverOps;
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+
+/*
+ * Backend por controlador (API twai_*_v2): o contexto identifica o controlador e guarda o
+ * handle devolvido pela instalação. Uma posição por controlador do chip.
+ */
+typedef struct {
+    uint32_t controller_id;
+    twai_handle_t handle;
+} CanEspTwaiController_t;
+
+static CanEspTwaiController_t twaiControllers[SOC_TWAI_CONTROLLER_NUM];
+
+static esp_err_t twai_v2_backend_install(void *ctx, const twai_general_config_t *g_config,
+                                         const twai_timing_config_t *t_config, const twai_filter_config_t *f_config)
+{
+    CanEspTwaiController_t *controller = (CanEspTwaiController_t *)ctx;
+    twai_general_config_t config = *g_config;
+    config.controller_id = (int)controller->controller_id;
+    return twai_driver_install_v2(&config, t_config, f_config, &controller->handle);
+}
+
+static esp_err_t twai_v2_backend_uninstall(void *ctx)
+{
+    CanEspTwaiController_t *controller = (CanEspTwaiController_t *)ctx;
+    esp_err_t err = twai_driver_uninstall_v2(controller->handle);
+    if (err == ESP_OK) {
+        controller->handle = NULL;
+    }
+    return err;
+}
+
+static esp_err_t twai_v2_backend_start(void *ctx)
+{
+    return twai_start_v2(((CanEspTwaiController_t *)ctx)->handle);
+}
+
+static esp_err_t twai_v2_backend_stop(void *ctx)
+{
+    return twai_stop_v2(((CanEspTwaiController_t *)ctx)->handle);
+}
+
+static esp_err_t twai_v2_backend_transmit(void *ctx, const twai_message_t *message, TickType_t ticks_to_wait)
+{
+    return twai_transmit_v2(((CanEspTwaiController_t *)ctx)->handle, message, ticks_to_wait);
+}
+
+static esp_err_t twai_v2_backend_receive(void *ctx, twai_message_t *message, TickType_t ticks_to_wait)
+{
+    return twai_receive_v2(((CanEspTwaiController_t *)ctx)->handle, message, ticks_to_wait);
+}
+
+static esp_err_t twai_v2_backend_get_status_info(void *ctx, twai_status_info_t *status_info)
+{
+    return twai_get_status_info_v2(((CanEspTwaiController_t *)ctx)->handle, status_info);
+}
+
+static esp_err_t twai_v2_backend_read_alerts(void *ctx, uint32_t *alerts, TickType_t ticks_to_wait)
+{
+    return twai_read_alerts_v2(((CanEspTwaiController_t *)ctx)->handle, alerts, ticks_to_wait);
+}
+
+static esp_err_t twai_v2_backend_reconfigure_alerts(void *ctx, uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    return twai_reconfigure_alerts_v2(((CanEspTwaiController_t *)ctx)->handle, alerts_enabled, current_alerts);
+}
+
+static esp_err_t twai_v2_backend_initiate_recovery(void *ctx)
+{
+    return twai_initiate_recovery_v2(((CanEspTwaiController_t *)ctx)->handle);
+}
+
+static const CanEspDriverOps_t twaiControllerDriverOps = {
+    .install = twai_v2_backend_install,
+    .uninstall = twai_v2_backend_uninstall,
+    .start = twai_v2_backend_start,
+    .stop = twai_v2_backend_stop,
+    .transmit = twai_v2_backend_transmit,
+    .receive = twai_v2_backend_receive,
+    .get_status_info = twai_v2_backend_get_status_info,
+    .read_alerts = twai_v2_backend_read_alerts,
+    .reconfigure_alerts = twai_v2_backend_reconfigure_alerts,
+    .initiate_recovery = twai_v2_backend_initiate_recovery,
+};
+
+const CanEspDriverOps_t *CAN_ESP_GetTwaiControllerDriverOps(uint32_t controller_id, void **ctx)
+{
+    if (ctx == NULL || controller_id >= (uint32_t)SOC_TWAI_CONTROLLER_NUM) {
+        return NULL;
+    }
+    twaiControllers[controller_id].controller_id = controller_id;
+    *ctx = &twaiControllers[controller_id];
+    return &twaiControllerDriverOps;
+}
+
+#else
+
+/* Sem a API twai_*_v2 apenas o controlador 0 é suportado, pelo backend padrão */
+const CanEspDriverOps_t *CAN_ESP_GetTwaiControllerDriverOps(uint32_t controller_id, void **ctx)
+{
+    if (ctx == NULL || controller_id != 0U) {
+        return NULL;
+    }
+    *ctx = NULL;
+    return &twaiDriverOps;
+}
+
+#endif /* ESP_IDF_VERSION */
+
+#endif /* CONFIG_IDF_TARGET_LINUX */
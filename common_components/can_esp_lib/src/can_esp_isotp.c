@@ -0,0 +1,672 @@
+/*
+ * can_esp_isotp.c
+ * Implementação da camada de transporte segmentado ISO-TP (ISO 15765-2)
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_isotp.h"
+#include "can_esp_instance.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <string.h>
+
+#define TAG    "CAN_ESP_ISOTP"
+
+/* Tipos de quadro (nibble superior do PCI) */
+#define ISOTP_PCI_SF    (0x0U)
+#define ISOTP_PCI_FF    (0x1U)
+#define ISOTP_PCI_CF    (0x2U)
+#define ISOTP_PCI_FC    (0x3U)
+
+/* Status do Flow Control */
+#define ISOTP_FC_CTS    (0x0U)
+#define ISOTP_FC_WAIT   (0x1U)
+#define ISOTP_FC_OVFLW  (0x2U)
+
+/* Menor FF_DL válido: mensagens menores cabem em um Single Frame */
+#define ISOTP_FF_MIN_LENGTH     (8U)
+
+typedef struct {
+    bool in_use;
+    can_esp_handle_t inst;      /* Instância da can_esp_lib usada pela sessão */
+    CanEspIsoTpConfig_t cfg;
+    can_esp_subscription_t sub;
+
+    /* Transmissão: uma mensagem por vez; o handler de recepção entrega o Flow Control */
+    SemaphoreHandle_t tx_mutex;
+    SemaphoreHandle_t fc_semaphore;
+    volatile bool tx_waiting_fc;
+    uint8_t fc_status;
+    uint8_t fc_bs;
+    uint8_t fc_stmin;
+
+    /*
+     * Recepção (executada pela tarefa de despacho). rx_timer verifica o N_Cr mesmo sem novos
+     * quadros; rx_active e rx_last_us, compartilhados com ele, são alterados sob isotpLock.
+     */
+    esp_timer_handle_t rx_timer;
+    bool     rx_active;
+    size_t   rx_expected;
+    size_t   rx_received;
+    uint8_t  rx_next_sn;
+    uint8_t  rx_block_left;
+    int64_t  rx_start_us;
+    int64_t  rx_last_us;
+
+    CanEspIsoTpStats_t stats;
+} CanEspIsoTpSession_t;
+
+static CanEspIsoTpSession_t isotpSessions[CAN_ESP_ISOTP_MAX_SESSIONS];
+static portMUX_TYPE isotpLock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================
+                          FUNÇÕES AUXILIARES
+ ==============================================================================*/
+
+/* Converte o STmin (codificação ISO 15765-2) em microsegundos */
+static uint32_t isotp_stmin_to_us(uint8_t st_min)
+{
+    if (st_min <= 0x7FU) {
+        return (uint32_t)st_min * 1000U;
+    }
+    if (st_min >= 0xF1U && st_min <= 0xF9U) {
+        return (uint32_t)(st_min - 0xF0U) * 100U;
+    }
+    return 127000U;     /* Valores reservados: usa-se o maior STmin */
+}
+
+/* Aguarda o STmin entre Consecutive Frames: ticks inteiros quando possível, espera ativa abaixo de um tick */
+static void isotp_wait_stmin(uint32_t stmin_us)
+{
+    const uint32_t tick_us = (uint32_t)portTICK_PERIOD_MS * 1000U;
+    if (stmin_us == 0U) {
+        return;
+    }
+    if (stmin_us >= tick_us) {
+        vTaskDelay((TickType_t)((stmin_us + tick_us - 1U) / tick_us));
+    } else {
+        esp_rom_delay_us(stmin_us);
+    }
+}
+
+/* Vazão em bytes por segundo entre dois instantes */
+static uint32_t isotp_throughput(size_t bytes, int64_t start_us, int64_t end_us)
+{
+    int64_t elapsed = end_us - start_us;
+    if (elapsed <= 0) {
+        return 0U;
+    }
+    return (uint32_t)(((uint64_t)bytes * 1000000ULL) / (uint64_t)elapsed);
+}
+
+/* Preenchimento opcional do quadro até tx_dl; retorna o tamanho final */
+static uint8_t isotp_pad_frame(const CanEspIsoTpSession_t *session, uint8_t *frame, uint8_t length)
+{
+    if (session->cfg.use_padding) {
+        while (length < session->cfg.tx_dl) {
+            frame[length++] = session->cfg.padding_byte;
+        }
+    }
+    return length;
+}
+
+/* Transmite um quadro de dados da sessão (bloqueante, na tarefa de quem chamou CAN_ESP_IsoTpSend) */
+static can_esp_status_t isotp_send_frame(const CanEspIsoTpSession_t *session, uint8_t *frame, uint8_t length)
+{
+    length = isotp_pad_frame(session, frame, length);
+    return CAN_ESP_SendMessage_v2(session->inst, session->cfg.tx_id, frame, length);
+}
+
+/*
+ * Enfileira um Flow Control sem bloquear: é emitido pela tarefa de despacho, que não pode
+ * aguardar o driver. Segue no nível mais urgente da fila de transmissão.
+ */
+static can_esp_status_t isotp_send_flow_control(const CanEspIsoTpSession_t *session, uint8_t status)
+{
+    CanEspMessage_t msg;
+    size_t accepted = 0U;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.id = session->cfg.tx_id;
+    msg.data[0] = (uint8_t)((ISOTP_PCI_FC << 4) | status);
+    msg.data[1] = session->cfg.block_size;
+    msg.data[2] = session->cfg.st_min;
+    msg.length = isotp_pad_frame(session, msg.data, 3U);
+    return CAN_ESP_TryEnqueueBatch_v2(session->inst, &msg, 1U, true, &accepted);
+}
+
+static CanEspIsoTpSession_t *isotp_session(can_esp_isotp_t handle)
+{
+    if (handle >= CAN_ESP_ISOTP_MAX_SESSIONS || !isotpSessions[handle].in_use) {
+        return NULL;
+    }
+    return &isotpSessions[handle];
+}
+
+/*==============================================================================
+                 RECEPÇÃO (HANDLER DA INSCRIÇÃO NO ID DE RECEPÇÃO)
+ ==============================================================================*/
+
+/*
+ * Temporizador de N_Cr (tarefa do esp_timer): encerra a recepção se nenhum quadro chegou dentro
+ * do timeout ou se rearma pelo tempo restante desde o último quadro. Disparos de uma recepção
+ * já encerrada não têm efeito.
+ */
+static void isotp_rx_timer_callback(void *arg)
+{
+    CanEspIsoTpSession_t *session = (CanEspIsoTpSession_t *)arg;
+    int64_t remaining_us = 0;
+    bool expired = false;
+
+    portENTER_CRITICAL(&isotpLock);
+    if (session->rx_active) {
+        remaining_us = (session->rx_last_us + ((int64_t)session->cfg.timeout_ms * 1000LL)) - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            session->rx_active = false;
+            session->stats.rx_timeouts++;
+            expired = true;
+        }
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    if (expired) {
+        ESP_LOGW(TAG, "Timeout N_Cr aguardando Consecutive Frame (ID: 0x%08X).", (unsigned int)session->cfg.rx_id);
+    } else if (remaining_us > 0) {
+        (void)esp_timer_start_once(session->rx_timer, (uint64_t)remaining_us);
+    }
+}
+
+/* Arma o N_Cr no início da recepção (já armado, o disparo pendente se rearma sozinho) */
+static void isotp_rx_arm_timeout(CanEspIsoTpSession_t *session)
+{
+    if (!esp_timer_is_active(session->rx_timer)) {
+        (void)esp_timer_start_once(session->rx_timer, (uint64_t)session->cfg.timeout_ms * 1000ULL);
+    }
+}
+
+static void isotp_rx_abort(CanEspIsoTpSession_t *session, bool timeout)
+{
+    portENTER_CRITICAL(&isotpLock);
+    session->rx_active = false;
+    if (timeout) {
+        session->stats.rx_timeouts++;
+    } else {
+        session->stats.rx_errors++;
+    }
+    portEXIT_CRITICAL(&isotpLock);
+}
+
+static void isotp_rx_deliver(CanEspIsoTpSession_t *session, size_t length, int64_t now, bool segmented)
+{
+    can_esp_isotp_t handle = (can_esp_isotp_t)(session - isotpSessions);
+
+    portENTER_CRITICAL(&isotpLock);
+    session->rx_active = false;
+    session->stats.rx_messages++;
+    session->stats.rx_bytes += length;
+    if (segmented) {
+        session->stats.last_rx_bytes_per_s = isotp_throughput(length, session->rx_start_us, now);
+        if (session->stats.last_rx_bytes_per_s > session->stats.max_rx_bytes_per_s) {
+            session->stats.max_rx_bytes_per_s = session->stats.last_rx_bytes_per_s;
+        }
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    if (session->cfg.on_receive != NULL) {
+        session->cfg.on_receive(handle, session->cfg.rx_buffer, length, session->cfg.ctx);
+    }
+}
+
+static void isotp_on_single_frame(CanEspIsoTpSession_t *session, const CanEspMessage_t *msg, int64_t now)
+{
+    size_t length = (size_t)(msg->data[0] & 0x0FU);
+    if (length == 0U || length > (size_t)(msg->length - 1U) || length > session->cfg.rx_buffer_size) {
+        isotp_rx_abort(session, false);
+        return;
+    }
+    if (session->rx_active) {
+        isotp_rx_abort(session, false);     /* SF interrompe a recepção segmentada em curso */
+    }
+    memcpy(session->cfg.rx_buffer, &msg->data[1], length);
+    isotp_rx_deliver(session, length, now, false);
+}
+
+/* FF com tamanho inválido: ignorado (ISO 15765-2), sem interromper a recepção em curso */
+static void isotp_rx_ignore(CanEspIsoTpSession_t *session)
+{
+    portENTER_CRITICAL(&isotpLock);
+    session->stats.rx_errors++;
+    portEXIT_CRITICAL(&isotpLock);
+}
+
+static void isotp_on_first_frame(CanEspIsoTpSession_t *session, const CanEspMessage_t *msg, int64_t now)
+{
+    size_t length;
+    size_t header;
+
+    if (msg->length < 2U) {
+        isotp_rx_abort(session, false);
+        return;
+    }
+    length = ((size_t)(msg->data[0] & 0x0FU) << 8) | (size_t)msg->data[1];
+    header = 2U;
+    if (length == 0U) {
+        /* Escape para mensagens acima de 4095 bytes: tamanho em 32 bits */
+        if (msg->length < 6U) {
+            isotp_rx_abort(session, false);
+            return;
+        }
+        length = ((size_t)msg->data[2] << 24) | ((size_t)msg->data[3] << 16) |
+                 ((size_t)msg->data[4] << 8) | (size_t)msg->data[5];
+        header = 6U;
+        if (length <= CAN_ESP_ISOTP_MAX_12BIT_LENGTH) {
+            isotp_rx_ignore(session);
+            return;
+        }
+    } else if (length < ISOTP_FF_MIN_LENGTH) {
+        isotp_rx_ignore(session);
+        return;
+    }
+    if (session->rx_active) {
+        isotp_rx_abort(session, false);     /* Novo FF interrompe a recepção em curso */
+    }
+    if (length > session->cfg.rx_buffer_size) {
+        (void)isotp_send_flow_control(session, ISOTP_FC_OVFLW);
+        isotp_rx_abort(session, false);
+        return;
+    }
+    session->rx_expected = length;
+    session->rx_received = (size_t)(msg->length - header);
+    if (session->rx_received > length) {
+        session->rx_received = length;
+    }
+    memcpy(session->cfg.rx_buffer, &msg->data[header], session->rx_received);
+    session->rx_next_sn = 1U;
+    session->rx_block_left = session->cfg.block_size;
+    session->rx_start_us = now;
+    portENTER_CRITICAL(&isotpLock);
+    session->rx_last_us = now;
+    session->rx_active = true;
+    portEXIT_CRITICAL(&isotpLock);
+    isotp_rx_arm_timeout(session);
+    if (isotp_send_flow_control(session, ISOTP_FC_CTS) != CAN_ESP_OK) {
+        isotp_rx_abort(session, false);
+    }
+}
+
+static void isotp_on_consecutive_frame(CanEspIsoTpSession_t *session, const CanEspMessage_t *msg, int64_t now)
+{
+    size_t chunk;
+    bool active;
+    bool expired = false;
+
+    /* Renova o N_Cr na mesma seção crítica em que o temporizador o verifica */
+    portENTER_CRITICAL(&isotpLock);
+    active = session->rx_active;
+    if (active) {
+        expired = (now - session->rx_last_us) > ((int64_t)session->cfg.timeout_ms * 1000LL);
+        if (!expired) {
+            session->rx_last_us = now;
+        }
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    if (!active) {
+        return;     /* CF sem FF correspondente (ou após o timeout) é ignorado */
+    }
+    if (expired) {
+        isotp_rx_abort(session, true);
+        return;
+    }
+    if ((msg->data[0] & 0x0FU) != session->rx_next_sn || msg->length < 2U) {
+        isotp_rx_abort(session, false);
+        return;
+    }
+    chunk = (size_t)(msg->length - 1U);
+    if (chunk > (session->rx_expected - session->rx_received)) {
+        chunk = session->rx_expected - session->rx_received;
+    }
+    memcpy(&session->cfg.rx_buffer[session->rx_received], &msg->data[1], chunk);
+    session->rx_received += chunk;
+    session->rx_next_sn = (uint8_t)((session->rx_next_sn + 1U) & 0x0FU);
+
+    if (session->rx_received >= session->rx_expected) {
+        isotp_rx_deliver(session, session->rx_expected, now, true);
+        return;
+    }
+    if (session->cfg.block_size != 0U) {
+        session->rx_block_left--;
+        if (session->rx_block_left == 0U) {
+            session->rx_block_left = session->cfg.block_size;
+            if (isotp_send_flow_control(session, ISOTP_FC_CTS) != CAN_ESP_OK) {
+                isotp_rx_abort(session, false);
+            }
+        }
+    }
+}
+
+static void isotp_on_flow_control(CanEspIsoTpSession_t *session, const CanEspMessage_t *msg)
+{
+    if (msg->length < 3U || !session->tx_waiting_fc) {
+        return;
+    }
+    portENTER_CRITICAL(&isotpLock);
+    session->fc_status = (uint8_t)(msg->data[0] & 0x0FU);
+    session->fc_bs = msg->data[1];
+    session->fc_stmin = msg->data[2];
+    session->tx_waiting_fc = false;
+    portEXIT_CRITICAL(&isotpLock);
+    (void)xSemaphoreGive(session->fc_semaphore);
+}
+
+/* Handler da inscrição: classifica o quadro pelo PCI */
+static void isotp_on_frame(const CanEspMessage_t *msg, void *ctx)
+{
+    CanEspIsoTpSession_t *session = (CanEspIsoTpSession_t *)ctx;
+    int64_t now = esp_timer_get_time();
+
+    if (!session->in_use || msg->length == 0U) {
+        return;
+    }
+    switch (msg->data[0] >> 4) {
+    case ISOTP_PCI_SF:
+        isotp_on_single_frame(session, msg, now);
+        break;
+    case ISOTP_PCI_FF:
+        isotp_on_first_frame(session, msg, now);
+        break;
+    case ISOTP_PCI_CF:
+        isotp_on_consecutive_frame(session, msg, now);
+        break;
+    case ISOTP_PCI_FC:
+        isotp_on_flow_control(session, msg);
+        break;
+    default:
+        break;
+    }
+}
+
+/*==============================================================================
+                          TRANSMISSÃO
+ ==============================================================================*/
+
+/* Aguarda um Flow Control CTS; trata WAIT (até N_WFTmax) e OVFLW */
+static can_esp_status_t isotp_wait_flow_control(CanEspIsoTpSession_t *session)
+{
+    for (uint32_t waits = 0U; waits <= CAN_ESP_ISOTP_MAX_WFT; waits++) {
+        if (xSemaphoreTake(session->fc_semaphore, pdMS_TO_TICKS(session->cfg.timeout_ms)) != pdTRUE) {
+            session->tx_waiting_fc = false;
+            ESP_LOGE(TAG, "Timeout aguardando Flow Control (ID: 0x%08X).", (unsigned int)session->cfg.rx_id);
+            return CAN_ESP_ERR_TIMEOUT;
+        }
+        switch (session->fc_status) {
+        case ISOTP_FC_CTS:
+            return CAN_ESP_OK;
+        case ISOTP_FC_WAIT:
+            portENTER_CRITICAL(&isotpLock);
+            session->stats.fc_wait_frames++;
+            session->tx_waiting_fc = true;
+            portEXIT_CRITICAL(&isotpLock);
+            break;
+        case ISOTP_FC_OVFLW:
+            ESP_LOGE(TAG, "Par sem espaço para a mensagem (Flow Control OVFLW).");
+            return CAN_ESP_ERR_QUEUE_FULL;
+        default:
+            return CAN_ESP_ERR_RECEIVE;
+        }
+    }
+    session->tx_waiting_fc = false;
+    ESP_LOGE(TAG, "Excesso de Flow Control WAIT.");
+    return CAN_ESP_ERR_TIMEOUT;
+}
+
+static can_esp_status_t isotp_send_segmented(CanEspIsoTpSession_t *session, const uint8_t *data, size_t length)
+{
+    uint8_t frame[CAN_MAX_DATA_LENGTH];
+    uint8_t dl = session->cfg.tx_dl;
+    size_t offset;
+    size_t chunk;
+    uint8_t sn = 1U;
+    can_esp_status_t status;
+    int64_t start_us = esp_timer_get_time();
+
+    /* First Frame */
+    if (length <= CAN_ESP_ISOTP_MAX_12BIT_LENGTH) {
+        frame[0] = (uint8_t)((ISOTP_PCI_FF << 4) | ((length >> 8) & 0x0FU));
+        frame[1] = (uint8_t)(length & 0xFFU);
+        chunk = (size_t)dl - 2U;
+        memcpy(&frame[2], data, chunk);
+    } else {
+        frame[0] = (uint8_t)(ISOTP_PCI_FF << 4);
+        frame[1] = 0U;
+        frame[2] = (uint8_t)((length >> 24) & 0xFFU);
+        frame[3] = (uint8_t)((length >> 16) & 0xFFU);
+        frame[4] = (uint8_t)((length >> 8) & 0xFFU);
+        frame[5] = (uint8_t)(length & 0xFFU);
+        chunk = (size_t)dl - 6U;
+        memcpy(&frame[6], data, chunk);
+    }
+    (void)xSemaphoreTake(session->fc_semaphore, 0);    /* Descarta FC antigo */
+    session->tx_waiting_fc = true;
+    status = isotp_send_frame(session, frame, dl);
+    if (status != CAN_ESP_OK) {
+        session->tx_waiting_fc = false;
+        return status;
+    }
+    offset = chunk;
+
+    /* Blocos de Consecutive Frames, cada um liberado por um Flow Control */
+    while (offset < length) {
+        uint8_t bs;
+        uint32_t stmin_us;
+        uint32_t sent_in_block = 0U;
+
+        status = isotp_wait_flow_control(session);
+        if (status != CAN_ESP_OK) {
+            return status;
+        }
+        bs = session->fc_bs;
+        stmin_us = isotp_stmin_to_us(session->fc_stmin);
+        while (offset < length && (bs == 0U || sent_in_block < bs)) {
+            if (sent_in_block > 0U) {
+                isotp_wait_stmin(stmin_us);
+            }
+            chunk = length - offset;
+            if (chunk > ((size_t)dl - 1U)) {
+                chunk = (size_t)dl - 1U;
+            }
+            frame[0] = (uint8_t)((ISOTP_PCI_CF << 4) | sn);
+            memcpy(&frame[1], &data[offset], chunk);
+            /* O próximo FC é esperado ao final do bloco: arma a espera antes do último CF */
+            if (bs != 0U && (sent_in_block + 1U) == bs && (offset + chunk) < length) {
+                session->tx_waiting_fc = true;
+            }
+            status = isotp_send_frame(session, frame, (uint8_t)(chunk + 1U));
+            if (status != CAN_ESP_OK) {
+                session->tx_waiting_fc = false;
+                return status;
+            }
+            offset += chunk;
+            sn = (uint8_t)((sn + 1U) & 0x0FU);
+            sent_in_block++;
+        }
+    }
+
+    portENTER_CRITICAL(&isotpLock);
+    session->stats.last_tx_bytes_per_s = isotp_throughput(length, start_us, esp_timer_get_time());
+    if (session->stats.last_tx_bytes_per_s > session->stats.max_tx_bytes_per_s) {
+        session->stats.max_tx_bytes_per_s = session->stats.last_tx_bytes_per_s;
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    return CAN_ESP_OK;
+}
+
+/*==============================================================================
+                          API PÚBLICA
+ ==============================================================================*/
+
+void CAN_ESP_IsoTpDefaultConfig(CanEspIsoTpConfig_t *config, uint32_t tx_id, uint32_t rx_id,
+                                uint8_t *rx_buffer, size_t rx_buffer_size)
+{
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->tx_id = tx_id;
+    config->rx_id = rx_id;
+    config->tx_dl = CAN_MAX_DATA_LENGTH;
+    config->use_padding = true;
+    config->padding_byte = CAN_ESP_ISOTP_DEFAULT_PADDING;
+    config->timeout_ms = CAN_ESP_ISOTP_DEFAULT_TIMEOUT_MS;
+    config->rx_buffer = rx_buffer;
+    config->rx_buffer_size = rx_buffer_size;
+}
+
+can_esp_status_t CAN_ESP_IsoTpOpen_v2(can_esp_handle_t inst, const CanEspIsoTpConfig_t *config, can_esp_isotp_t *handle)
+{
+    CanEspIsoTpSession_t *session = NULL;
+    uint32_t slot;
+    can_esp_status_t status;
+
+    if (inst == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL || handle == NULL || config->rx_buffer == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na abertura da sessão ISO-TP.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (config->tx_dl < 7U || config->tx_dl > CAN_MAX_DATA_LENGTH || config->rx_buffer_size == 0U) {
+        ESP_LOGE(TAG, "Configuração ISO-TP inválida (tx_dl deve ser 7 ou 8).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&isotpLock);
+    for (slot = 0U; slot < CAN_ESP_ISOTP_MAX_SESSIONS; slot++) {
+        if (!isotpSessions[slot].in_use) {
+            session = &isotpSessions[slot];
+            session->in_use = true;     /* Reserva o slot; a inscrição só é criada ao final */
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    if (session == NULL) {
+        ESP_LOGE(TAG, "Limite de sessões ISO-TP atingido.");
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+
+    if (session->tx_mutex == NULL) {
+        session->tx_mutex = xSemaphoreCreateMutex();
+    }
+    if (session->fc_semaphore == NULL) {
+        session->fc_semaphore = xSemaphoreCreateBinary();
+    }
+    if (session->rx_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = isotp_rx_timer_callback,
+            .arg = session,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "isotp_ncr",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&args, &session->rx_timer) != ESP_OK) {
+            session->rx_timer = NULL;
+        }
+    }
+    if (session->tx_mutex == NULL || session->fc_semaphore == NULL || session->rx_timer == NULL) {
+        session->in_use = false;
+        ESP_LOGE(TAG, "Falha ao criar semáforos ou temporizador da sessão ISO-TP.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    session->inst = inst;
+    session->cfg = *config;
+    session->rx_active = false;
+    session->tx_waiting_fc = false;
+    memset(&session->stats, 0, sizeof(session->stats));
+
+    status = CAN_ESP_SubscribeId_v2(inst, config->rx_id, isotp_on_frame, session, &session->sub);
+    if (status != CAN_ESP_OK) {
+        session->in_use = false;
+        return status;
+    }
+    *handle = slot;
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_IsoTpOpen(const CanEspIsoTpConfig_t *config, can_esp_isotp_t *handle)
+{
+    return CAN_ESP_IsoTpOpen_v2(CAN_ESP_GetDefaultHandle(), config, handle);
+}
+
+can_esp_status_t CAN_ESP_IsoTpClose(can_esp_isotp_t handle)
+{
+    CanEspIsoTpSession_t *session = isotp_session(handle);
+    if (session == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    (void)CAN_ESP_Unsubscribe_v2(session->inst, session->sub);
+    (void)esp_timer_stop(session->rx_timer);
+    portENTER_CRITICAL(&isotpLock);
+    session->rx_active = false;
+    portEXIT_CRITICAL(&isotpLock);
+    xSemaphoreTake(session->tx_mutex, portMAX_DELAY);
+    session->in_use = false;
+    xSemaphoreGive(session->tx_mutex);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_IsoTpSend(can_esp_isotp_t handle, const uint8_t *data, size_t length)
+{
+    CanEspIsoTpSession_t *session = isotp_session(handle);
+    uint8_t frame[CAN_MAX_DATA_LENGTH];
+    can_esp_status_t status;
+
+    if (session == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (data == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de dados nulo na transmissão ISO-TP.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (length == 0U) {
+        return CAN_ESP_ERR_INVALID_LENGTH;
+    }
+    xSemaphoreTake(session->tx_mutex, portMAX_DELAY);
+    if (length <= ((size_t)session->cfg.tx_dl - 1U)) {
+        frame[0] = (uint8_t)((ISOTP_PCI_SF << 4) | length);
+        memcpy(&frame[1], data, length);
+        status = isotp_send_frame(session, frame, (uint8_t)(length + 1U));
+    } else {
+        status = isotp_send_segmented(session, data, length);
+    }
+    portENTER_CRITICAL(&isotpLock);
+    if (status == CAN_ESP_OK) {
+        session->stats.tx_messages++;
+        session->stats.tx_bytes += length;
+    } else {
+        session->stats.tx_errors++;
+    }
+    portEXIT_CRITICAL(&isotpLock);
+    xSemaphoreGive(session->tx_mutex);
+    return status;
+}
+
+can_esp_status_t CAN_ESP_IsoTpGetStats(can_esp_isotp_t handle, CanEspIsoTpStats_t *stats)
+{
+    CanEspIsoTpSession_t *session = isotp_session(handle);
+    if (stats == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (session == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&isotpLock);
+    *stats = session->stats;
+    portEXIT_CRITICAL(&isotpLock);
+    return CAN_ESP_OK;
+}
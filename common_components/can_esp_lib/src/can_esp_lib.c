@@ -7,9 +7,11 @@
  */
 
 #include "can_esp_lib.h"
+#include "can_esp_driver.h"
+#include "can_esp_instance.h"
+#include "can_esp_lib_internal.h"
 
 #include "esp_log.h"
-#include "driver/twai.h"
 #include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
@@ -19,572 +21,4844 @@
 
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 #define TAG    "CAN_ESP_LIB"
 
-/* Mutexes para proteção da configuração e das métricas de latência */
-static SemaphoreHandle_t configMutex = NULL;
-static SemaphoreHandle_t latencyMutex = NULL;
+/*==============================================================================
+                          ESTADO DE UMA INSTÂNCIA DA BIBLIOTECA
+ ==============================================================================*/
+
+/*
+ * Nível de prioridade da fila de transmissão: heap mínimo de índices no pool de mensagens,
+ * ordenado pela chave de cada slot (prazo EDF) e, entre chaves iguais, pela sequência de entrada.
+ */
+typedef struct {
+    uint16_t slots[CAN_ESP_TX_LEVEL_QUEUE_LENGTH];
+    uint32_t count;     /* Mensagens armazenadas */
+    int64_t backSeq;    /* Sequência da próxima mensagem inserida no fim (crescente) */
+    int64_t frontSeq;   /* Sequência da próxima mensagem devolvida à frente (decrescente) */
+} CanEspTxLevel_t;
+
+/* Tabela de inscrições de recepção (ver CAN_ESP_Subscribe) */
+typedef struct {
+    uint32_t id;
+    uint32_t mask;
+    can_esp_subscription_handler_t handler;
+    void *ctx;
+    bool in_use;
+} CanEspSubscription_t;
+
+/* Grupo de inscrições com a mesma máscara: intervalo [start, start + length) de dispatchIndex */
+typedef struct {
+    uint32_t mask;
+    uint16_t start;
+    uint16_t length;
+} CanEspDispatchGroup_t;
+
+/* Entrada do índice de despacho, ordenado por (grupo, chave, ordem de registro) */
+typedef struct {
+    uint32_t key;       /* id & mask */
+    uint16_t sub;       /* índice em subscriptions[] */
+} CanEspDispatchEntry_t;
+
+/*
+ * Janela deslizante de bits no barramento: CAN_ESP_BUSLOAD_BUCKETS baldes de bucket_us cada,
+ * indexados pela época (tempo / bucket_us). Baldes de épocas passadas são zerados ao avançar.
+ */
+typedef struct {
+    int64_t  bucket_us;
+    int64_t  epoch;
+    uint32_t bits[CAN_ESP_BUSLOAD_BUCKETS];
+} CanEspLoadWindow_t;
+
+/* Quadro estacionado na roda de retransmissões durante o seu backoff */
+typedef struct CanEspRetryEntry {
+    uint16_t slot;                      /* Slot do pool que contém o quadro */
+    int64_t parked_us;                  /* Instante em que o quadro foi estacionado */
+    int64_t due_us;                     /* Instante a partir do qual pode ser retransmitido */
+    struct CanEspRetryEntry *next;
+} CanEspRetryEntry_t;
+
+/* Estatísticas internas de uma direção (jitter em ponto fixo x16, como na RFC 3550) */
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;
+    int64_t  last_timestamp_us;
+    uint64_t sum_interarrival_us;
+    uint32_t last_interarrival_us;
+    uint32_t max_interarrival_us;
+    uint32_t jitter_x16;
+} CanEspIdDirAcc_t;
+
+typedef struct {
+    uint32_t key;               /* id | ID_STATS_KEY_VALID; 0 = slot livre */
+    CanEspIdDirAcc_t rx;
+    CanEspIdDirAcc_t tx;
+} CanEspIdStatsEntry_t;
+
+/* Política de prazo e substituição da fila de transmissão */
+typedef struct {
+    bool in_use;
+    CanEspTxDeadlinePolicy_t policy;
+} CanEspTxPolicyEntry_t;
+
+/* Limite de taxa de transmissão (tokens em milionésimos de quadro) */
+typedef struct {
+    bool     in_use;
+    CanEspRateLimitConfig_t config;
+    uint64_t tokens;
+    int64_t  last_refill_us;
+    CanEspRateLimitStats_t stats;
+} CanEspRateLimitEntry_t;
+
+/* Mensagem registrada no escalonador cíclico */
+typedef struct {
+    bool     in_use;
+    uint32_t id;
+    uint32_t period_us;
+    uint32_t offset_us;
+    int64_t  next_release_us;
+    can_esp_cyclic_fill_t fill;
+    void    *ctx;
+    uint32_t generation;    /* Muda a cada registro: resultados de um lote só contam para o mesmo registro */
+    CanEspCyclicStats_t stats;
+    uint64_t sum_jitter_us;
+} CanEspCyclicEntry_t;
+
+/*
+ * Todo o estado de um barramento: configuração, backend de driver, filas, tarefas, callbacks e
+ * métricas. As funções CAN_ESP_* sem handle operam sobre defaultInstance; as variantes _v2
+ * (can_esp_instance.h) recebem a instância explicitamente.
+ */
+struct can_esp_instance {
+    /* Configuração corrente, protegida por configMutex */
+    SemaphoreHandle_t configMutex;
+    CanEspConfig_t currentConfig;
+    bool configInitialized;
+    bool driverInstalled;
+
+    /*
+     * Backend de driver: por padrão o TWAI nativo; pode ser substituído (ex.: barramento virtual)
+     * via CAN_ESP_SetDriverBackend enquanto o driver não estiver instalado.
+     */
+    const CanEspDriverOps_t *driverOps;
+    void *driverCtx;
+    bool driverOpsSelected;
+
+    /*
+     * Fila de transmissão: um heap de mensagens por nível de prioridade (campo de 3 bits de
+     * CAN_ESP_EncodeID, 0 = mais urgente), todos protegidos pelo mesmo spinlock (portMUX), o que
+     * permite inserir um lote inteiro em uma única seção crítica. Inserção e retirada custam
+     * O(log n) no nível. txLevelBitmap marca os níveis não vazios, de modo que a escolha do
+     * nível do próximo quadro é O(1). Produtores bloqueados por
+     * falta de espaço aguardam txSpaceSemaphore, sinalizado quando um slot volta ao pool.
+     */
+    CanEspTxLevel_t txLevels[CAN_ESP_NUM_PRIORITY_LEVELS];
+    uint32_t txLevelBitmap;             /* Bit n ligado se o nível n possui mensagens */
+    uint32_t txTotalCount;              /* Total de mensagens em todos os níveis */
+    uint32_t txWaiters;                 /* Produtores aguardando espaço livre */
+    portMUX_TYPE txRingLock;
+    SemaphoreHandle_t txSpaceSemaphore;
+
+    /*
+     * Pool de mensagens de transmissão. Os níveis, a roda de retransmissões e a tarefa de
+     * transmissão referenciam apenas slots; o quadro é convertido diretamente do slot e o slot
+     * volta à pilha livre quando o driver o aceita ou quando a mensagem é descartada. A pilha,
+     * o dono de cada slot (POOL_SLOT_*) e as estatísticas são protegidos por txRingLock.
+     */
+    CanEspMessage_t msgPool[CAN_ESP_MSG_POOL_SIZE];
+    uint16_t msgPoolFree[CAN_ESP_MSG_POOL_SIZE];
+    uint8_t msgPoolOwner[CAN_ESP_MSG_POOL_SIZE];
+    uint32_t msgPoolFreeCount;
+    bool msgPoolInitialized;
+    CanEspPoolStats_t msgPoolStats;
+
+    /*
+     * Prazo absoluto de cada slot (0 = sem prazo), que ordena os níveis por EDF, e as políticas
+     * que o definem no enfileiramento. msgPoolKey/msgPoolSeq são a ordem do slot no heap do
+     * nível msgPoolLevel e msgPoolHeapPos a sua posição nele (TX_HEAP_POS_NONE fora da fila).
+     * msgPoolSuperseded marca os slots de um ID com replace_queued que já possui valor mais
+     * recente enfileirado (retransmissão cancelada). Protegidos por txRingLock, como os níveis.
+     */
+    int64_t msgPoolDeadline[CAN_ESP_MSG_POOL_SIZE];
+    int64_t msgPoolKey[CAN_ESP_MSG_POOL_SIZE];
+    int64_t msgPoolSeq[CAN_ESP_MSG_POOL_SIZE];
+    uint16_t msgPoolHeapPos[CAN_ESP_MSG_POOL_SIZE];
+    uint8_t msgPoolLevel[CAN_ESP_MSG_POOL_SIZE];
+    bool msgPoolSuperseded[CAN_ESP_MSG_POOL_SIZE];
+
+    /*
+     * Índice por ID dos slots enfileirados com replace_queued: txIdBuckets[hash] encabeça uma
+     * lista (msgPoolIdNext) que contém apenas o slot mais recente de cada ID, de modo que
+     * substituir ou superar o valor anterior não varre a fila nem o pool sob o spinlock.
+     */
+    uint16_t txIdBuckets[CAN_ESP_MSG_POOL_SIZE];
+    uint16_t msgPoolIdNext[CAN_ESP_MSG_POOL_SIZE];
+    bool msgPoolIndexed[CAN_ESP_MSG_POOL_SIZE];
+    CanEspTxPolicyEntry_t txPolicies[CAN_ESP_MAX_TX_DEADLINE_POLICIES];
+    uint32_t txPolicyCount;
+    CanEspTxDeadlineStats_t txDeadlineStats;
+
+    /*
+     * Limites de taxa verificados na admissão dos quadros (token bucket). Os tokens são
+     * repostos sob demanda, pelo tempo decorrido desde a última consulta, sem temporizador.
+     * rateLimitCount dispensa o spinlock enquanto nenhum limite estiver ativo.
+     */
+    CanEspRateLimitEntry_t rateLimits[CAN_ESP_MAX_RATE_LIMITS];
+    volatile uint32_t rateLimitCount;
+    uint32_t rateLimitRejections;
+    portMUX_TYPE rateLimitLock;
+
+    /* Handles das tarefas de transmissão (ajuste dinâmico de prioridade), despacho e recepção */
+    TaskHandle_t canTxTaskHandle;
+    TaskHandle_t canDispatchTaskHandle;
+    TaskHandle_t canRxTaskHandle;
+
+    /*
+     * Anel SPSC de recepção. Somente a tarefa de recepção escreve em rxRingHead e somente a
+     * tarefa de despacho escreve em rxRingTail; os índices crescem livremente e são mascarados
+     * no acesso aos slots. A ordem acquire/release garante a visibilidade do slot entre núcleos.
+     */
+    CanEspMessage_t rxRing[CAN_ESP_RX_RING_SIZE];
+    atomic_uint rxRingHead;
+    atomic_uint rxRingTail;
+    atomic_uint rxRingOverflows;
+    atomic_uint rxRingHighWater;
+
+    /* Variáveis para medição de retransmissões, colisões e tentativas */
+    uint32_t totalRetransmissions;
+    uint32_t totalCollisions;
+    uint32_t totalTransmissionAttempts;
+
+    /* Callbacks */
+    can_esp_receive_callback_t receive_callback;
+    can_esp_transmit_callback_t transmit_callback;
+    can_esp_transmit_complete_callback_t transmit_complete_callback;
+
+    /* Inscrições de recepção e índice de despacho */
+    SemaphoreHandle_t subscriptionMutex;
+    CanEspSubscription_t subscriptions[CAN_ESP_MAX_SUBSCRIPTIONS];
+    CanEspDispatchEntry_t dispatchIndex[CAN_ESP_MAX_SUBSCRIPTIONS];
+    CanEspDispatchGroup_t dispatchGroups[CAN_ESP_MAX_SUBSCRIPTIONS];
+    uint16_t dispatchGroupCount;
+    uint32_t dispatchedFrames;
+    uint32_t unmatchedFrames;
+
+    /*
+     * Reconfiguração sem reinstalação perceptível: as tarefas de transmissão e recepção param em
+     * pontos seguros (entre quadros), confirmam via reconfigAckSemaphore e aguardam a liberação.
+     * reconfigTasksParked indica tarefas mantidas pausadas por falta de driver após uma falha de
+     * reinstalação; a próxima instalação bem-sucedida as libera.
+     */
+    volatile bool reconfigPauseRequested;
+    bool reconfigTasksParked;
+    SemaphoreHandle_t reconfigMutex;
+    SemaphoreHandle_t reconfigAckSemaphore;
+    SemaphoreHandle_t txResumeSemaphore;
+    SemaphoreHandle_t rxResumeSemaphore;
+    CanEspReconfigStats_t reconfigStats;
+    portMUX_TYPE reconfigStatsLock;
+
+    /* Histograma acumulado e dois histogramas de janela (um ativo e um fechado); ver CanEspLatencyHist_t */
+    CanEspLatencyHist_t latencyTotal;
+    CanEspLatencyHist_t latencyWindows[2];
+    atomic_uint latencyActiveWindow;
+
+    /* Medição do bus load (bits no fio de todos os quadros TX e RX) */
+    int64_t busLoadStartTime;
+    portMUX_TYPE busLoadLock;
+    CanEspLoadWindow_t busLoadWindows[3];
+    uint64_t busLoadTotalBits;
+    uint32_t busLoadTxFrames;
+    uint32_t busLoadRxFrames;
+    CanEspStuffingMode_t busLoadStuffingMode;
+
+    /*
+     * Quadros entregues ao driver aguardam a confirmação neste anel. O TWAI transmite em ordem
+     * FIFO, portanto os msgs_to_tx quadros mais recentes ainda estão pendentes e os anteriores já
+     * foram concluídos. txInflightMutex cobre a entrega ao driver e o registro no anel, de modo que
+     * a reconciliação nunca observa um quadro no driver que ainda não foi registrado.
+     */
+    CanEspMessage_t txInflight[CAN_ESP_TX_INFLIGHT_LENGTH];
+    uint32_t txInflightHead;
+    uint32_t txInflightCount;
+    uint32_t txFailedSeen;              /* tx_failed_count do driver já atribuído a quadros do anel */
+    SemaphoreHandle_t txInflightMutex;
+
+    /*
+     * Tarefa que aguarda os alertas do driver (conclusão de transmissão e supervisor de recuperação).
+     * A leitura de alertas bloqueia em objetos do driver: a desinstalação pausa a tarefa fora dela
+     * (alertPauseRequested / alertAckSemaphore) e a libera em seguida (alertResumeSemaphore).
+     */
+    TaskHandle_t canAlertTaskHandle;
+    volatile bool alertPauseRequested;
+    SemaphoreHandle_t alertAckSemaphore;
+    SemaphoreHandle_t alertResumeSemaphore;
+
+    /*
+     * Supervisor de recuperação. Somente a tarefa de alertas altera o estado e o agendamento;
+     * recoveryLock protege a política e as estatísticas lidas por outras tarefas.
+     * txHeldByBusOff suspende a tarefa de transmissão enquanto o nó não pode transmitir.
+     */
+    volatile bool recoveryEnabled;
+    CanEspRecoveryPolicy_t recoveryPolicy;
+    CanEspRecoveryStats_t recoveryStats;
+    portMUX_TYPE recoveryLock;
+    int64_t recoveryDueUs;              /* Instante de iniciar a recuperação (0 = não agendada) */
+    int64_t busStableSinceUs;           /* Início do período corrente em error-active (0 = fora dele) */
+    volatile bool txHeldByBusOff;
+    can_esp_bus_state_callback_t bus_state_callback;
+
+    /*
+     * Núcleo, pilha e prioridade das tarefas. txPriorityBoosted registra se a tarefa de
+     * transmissão está elevada, dispensando consultar o escalonador a cada quadro.
+     */
+    CanEspTaskConfig_t taskConfig;
+    bool txPriorityBoosted;
+
+    /*
+     * Quadros cuja transmissão falhou ficam estacionados na roda até o fim do seu backoff, sem
+     * bloquear a fila. A roda tem CAN_ESP_RETRY_WHEEL_SLOTS posições de CAN_ESP_RETRY_WHEEL_TICK_MS;
+     * a posição de um quadro é o tick absoluto do seu prazo módulo o número de posições, e prazos
+     * além de uma volta permanecem na lista até a volta correta. Toda a estrutura é acessada
+     * somente pela tarefa de transmissão; apenas as estatísticas usam retryStatsLock.
+     */
+    CanEspRetryEntry_t retryPool[CAN_ESP_RETRY_POOL_SIZE];
+    CanEspRetryEntry_t *retryFreeList;
+    CanEspRetryEntry_t *retryWheel[CAN_ESP_RETRY_WHEEL_SLOTS];
+    int64_t retryWheelTick;             /* Último tick absoluto processado */
+    bool retryWheelInitialized;
+    CanEspRetryStats_t retryStats;
+    portMUX_TYPE retryStatsLock;
+
+    /* Estatísticas de tráfego por identificador (tabela hash de sondagem linear) */
+    CanEspIdStatsEntry_t idStatsTable[CAN_ESP_ID_STATS_TABLE_SIZE];
+    uint32_t idStatsUntracked;
+    portMUX_TYPE idStatsLock;
+
+    /*
+     * Todas as mensagens cíclicas compartilham um único esp_timer one-shot, rearmado para a
+     * próxima liberação mais próxima. As liberações são ancoradas em uma época comum
+     * (cyclicEpochUs), de modo que os deslocamentos de fase entre mensagens se mantêm.
+     * O callback do temporizador não espera por cyclicMutex: se ocupado, conta a contenção em
+     * cyclicLockContentions (escrito apenas pelo callback) e tenta novamente em seguida.
+     */
+    CanEspCyclicEntry_t cyclicEntries[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    SemaphoreHandle_t cyclicMutex;
+    esp_timer_handle_t cyclicTimer;
+    int64_t cyclicEpochUs;
+    uint32_t cyclicGeneration;
+    volatile uint32_t cyclicLockContentions;
+};
+
+/* Configuração padrão; self_rx e use_checksum desabilitados */
+#define INSTANCE_DEFAULT_CONFIG {                               \
+    .bitrate = 1000000U,                                        \
+    .tx_gpio = CAN_TX_GPIO,                                     \
+    .rx_gpio = CAN_RX_GPIO,                                     \
+    .transmit_timeout_ms = CAN_DEFAULT_TRANSMIT_TIMEOUT_MS,     \
+    .receive_timeout_ms = CAN_DEFAULT_RECEIVE_TIMEOUT_MS,       \
+    .filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL(),           \
+    .mode = TWAI_MODE_NO_ACK,                                   \
+    .use_custom_timing = false,                                 \
+    .custom_timing_config = {0},                                \
+    .auto_retransmit = true,                                    \
+    .debug_level = 2U,                                          \
+    .self_rx = false,                                           \
+    .use_checksum = false                                       \
+}
+
+/* Janelas de bus load de 100 ms, 1 s e 10 s (balde = janela / CAN_ESP_BUSLOAD_BUCKETS) */
+#define INSTANCE_BUS_LOAD_WINDOWS {                             \
+    { 10000LL, 0, {0} },                                        \
+    { 100000LL, 0, {0} },                                       \
+    { 1000000LL, 0, {0} },                                      \
+}
+
+#define INSTANCE_DEFAULT_TASK_CONFIG {                                                          \
+    .transmit = { CAN_ESP_TASK_CORE_ID, CAN_ESP_TASK_STACK_SIZE, CAN_ESP_TX_TASK_PRIORITY },     \
+    .receive = { CAN_ESP_TASK_CORE_ID, CAN_ESP_TASK_STACK_SIZE, CAN_ESP_RX_TASK_PRIORITY },      \
+    .dispatch = { CAN_ESP_TASK_CORE_ID, CAN_ESP_TASK_STACK_SIZE, CAN_ESP_DISPATCH_TASK_PRIORITY }, \
+    .alert = { CAN_ESP_TASK_CORE_ID, CAN_ESP_TASK_STACK_SIZE, CAN_ESP_ALERT_TASK_PRIORITY },     \
+    .tx_boost_priority = CAN_ESP_TX_TASK_BOOST_PRIORITY,                                        \
+    .tx_boost_high_pct = CAN_ESP_TX_BOOST_HIGH_PCT,                                             \
+    .tx_boost_low_pct = CAN_ESP_TX_BOOST_LOW_PCT                                                \
+}
+
+/*
+ * Instância usada pela API sem handle. Fica zerada em .bss (sem ocupar flash como imagem de
+ * .data) e recebe os valores iniciais de instance_reset antes de app_main (default_instance_init).
+ */
+static struct can_esp_instance defaultInstance;
+
+#if CAN_ESP_MAX_INSTANCES > 1U
+/* Instâncias adicionais (CAN_ESP_CreateInstance), em memória estática */
+static struct can_esp_instance instancePool[CAN_ESP_MAX_INSTANCES - 1U];
+static bool instancePoolUsed[CAN_ESP_MAX_INSTANCES - 1U];
+static portMUX_TYPE instancePoolLock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+can_esp_handle_t CAN_ESP_GetDefaultHandle(void)
+{
+    return &defaultInstance;
+}
+
+/* Atribui os valores iniciais de uma instância (padrão ou do pool) */
+static void instance_reset(can_esp_handle_t inst)
+{
+    static const CanEspConfig_t defaultConfig = INSTANCE_DEFAULT_CONFIG;
+    static const CanEspLoadWindow_t defaultWindows[3] = INSTANCE_BUS_LOAD_WINDOWS;
+    static const CanEspTaskConfig_t defaultTaskConfig = INSTANCE_DEFAULT_TASK_CONFIG;
+
+    (void)memset(inst, 0, sizeof(*inst));
+    inst->currentConfig = defaultConfig;
+    (void)memcpy(inst->busLoadWindows, defaultWindows, sizeof(defaultWindows));
+    inst->busLoadStuffingMode = CAN_ESP_STUFFING_WORST_CASE;
+    inst->taskConfig = defaultTaskConfig;
+    portMUX_INITIALIZE(&inst->txRingLock);
+    portMUX_INITIALIZE(&inst->rateLimitLock);
+    portMUX_INITIALIZE(&inst->busLoadLock);
+    portMUX_INITIALIZE(&inst->retryStatsLock);
+    portMUX_INITIALIZE(&inst->idStatsLock);
+    portMUX_INITIALIZE(&inst->recoveryLock);
+    portMUX_INITIALIZE(&inst->reconfigStatsLock);
+}
+
+/* Inicializa a instância padrão na partida, antes de qualquer tarefa da aplicação */
+__attribute__((constructor)) static void default_instance_init(void)
+{
+    instance_reset(&defaultInstance);
+}
+
+can_esp_status_t CAN_ESP_CreateInstance(can_esp_handle_t *handle)
+{
+    can_esp_handle_t inst = NULL;
+
+    if (handle == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de handle nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+#if CAN_ESP_MAX_INSTANCES > 1U
+    portENTER_CRITICAL(&instancePoolLock);
+    for (uint32_t i = 0U; i < (CAN_ESP_MAX_INSTANCES - 1U); i++) {
+        if (!instancePoolUsed[i]) {
+            instancePoolUsed[i] = true;
+            inst = &instancePool[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&instancePoolLock);
+#endif
+    if (inst == NULL) {
+        ESP_LOGE(TAG, "Limite de instâncias atingido (%u).", (unsigned int)CAN_ESP_MAX_INSTANCES);
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    instance_reset(inst);
+    *handle = inst;
+    return CAN_ESP_OK;
+}
+
+/* Libera um semáforo (se criado) */
+static void instance_delete_semaphore(SemaphoreHandle_t *sem)
+{
+    if (*sem != NULL) {
+        vSemaphoreDelete(*sem);
+        *sem = NULL;
+    }
+}
+
+/* Posição de uma instância no pool, ou CAN_ESP_MAX_INSTANCES se o handle não pertencer a ele */
+static uint32_t instance_pool_index(can_esp_handle_t handle)
+{
+#if CAN_ESP_MAX_INSTANCES > 1U
+    for (uint32_t i = 0U; i < (CAN_ESP_MAX_INSTANCES - 1U); i++) {
+        if (handle == &instancePool[i] && instancePoolUsed[i]) {
+            return i;
+        }
+    }
+#endif
+    (void)handle;
+    return CAN_ESP_MAX_INSTANCES;
+}
+
+/* Canal da instância nas capturas: 0 para a padrão, 1 em diante para as do pool */
+static uint8_t instance_channel(can_esp_handle_t inst)
+{
+#if CAN_ESP_MAX_INSTANCES > 1U
+    if (inst != &defaultInstance) {
+        return (uint8_t)((inst - instancePool) + 1);
+    }
+#endif
+    (void)inst;
+    return 0U;
+}
+
+can_esp_status_t CAN_ESP_DeleteInstance(can_esp_handle_t handle)
+{
+    uint32_t index = instance_pool_index(handle);
+
+    if (index == CAN_ESP_MAX_INSTANCES) {
+        ESP_LOGE(TAG, "Handle de instância inválido (a instância padrão não pode ser removida).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (handle->driverInstalled || handle->canTxTaskHandle != NULL || handle->canRxTaskHandle != NULL ||
+        handle->canDispatchTaskHandle != NULL || handle->canAlertTaskHandle != NULL) {
+        ESP_LOGE(TAG, "Instância com driver instalado ou tarefas ativas não pode ser removida.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (handle->cyclicTimer != NULL) {
+        (void)esp_timer_stop(handle->cyclicTimer);
+        (void)esp_timer_delete(handle->cyclicTimer);
+        handle->cyclicTimer = NULL;
+    }
+    instance_delete_semaphore(&handle->configMutex);
+    instance_delete_semaphore(&handle->txSpaceSemaphore);
+    instance_delete_semaphore(&handle->subscriptionMutex);
+    instance_delete_semaphore(&handle->reconfigMutex);
+    instance_delete_semaphore(&handle->reconfigAckSemaphore);
+    instance_delete_semaphore(&handle->txResumeSemaphore);
+    instance_delete_semaphore(&handle->rxResumeSemaphore);
+    instance_delete_semaphore(&handle->txInflightMutex);
+    instance_delete_semaphore(&handle->alertAckSemaphore);
+    instance_delete_semaphore(&handle->alertResumeSemaphore);
+    instance_delete_semaphore(&handle->cyclicMutex);
+#if CAN_ESP_MAX_INSTANCES > 1U
+    portENTER_CRITICAL(&instancePoolLock);
+    instancePoolUsed[index] = false;
+    portEXIT_CRITICAL(&instancePoolLock);
+#endif
+    return CAN_ESP_OK;
+}
+
+#if (CAN_ESP_RX_RING_SIZE & (CAN_ESP_RX_RING_SIZE - 1U)) != 0U
+#error "CAN_ESP_RX_RING_SIZE deve ser potência de 2"
+#endif
+
+static const CanEspDriverOps_t *drv_ops(can_esp_handle_t inst)
+{
+    if (!inst->driverOpsSelected) {
+        inst->driverOps = CAN_ESP_GetTwaiDriverOps();
+        inst->driverCtx = NULL;
+        inst->driverOpsSelected = true;
+    }
+    return inst->driverOps;
+}
+
+static esp_err_t drv_install(can_esp_handle_t inst, const twai_general_config_t *g, const twai_timing_config_t *t, const twai_filter_config_t *f)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->install(inst->driverCtx, g, t, f) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_uninstall(can_esp_handle_t inst)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->uninstall(inst->driverCtx) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_start(can_esp_handle_t inst)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->start(inst->driverCtx) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_stop(can_esp_handle_t inst)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->stop(inst->driverCtx) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_transmit(can_esp_handle_t inst, const twai_message_t *message, TickType_t ticks)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->transmit(inst->driverCtx, message, ticks) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_receive(can_esp_handle_t inst, twai_message_t *message, TickType_t ticks)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->receive(inst->driverCtx, message, ticks) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_get_status_info(can_esp_handle_t inst, twai_status_info_t *info)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->get_status_info(inst->driverCtx, info) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_read_alerts(can_esp_handle_t inst, uint32_t *alerts, TickType_t ticks)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->read_alerts(inst->driverCtx, alerts, ticks) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_reconfigure_alerts(can_esp_handle_t inst, uint32_t alerts)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->reconfigure_alerts(inst->driverCtx, alerts, NULL) : ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t drv_initiate_recovery(can_esp_handle_t inst)
+{
+    const CanEspDriverOps_t *ops = drv_ops(inst);
+    return (ops != NULL) ? ops->initiate_recovery(inst->driverCtx) : ESP_ERR_INVALID_STATE;
+}
+
+can_esp_status_t CAN_ESP_SetDriverBackend_v2(can_esp_handle_t handle, const CanEspDriverOps_t *ops, void *ctx)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (handle->driverInstalled) {
+        ESP_LOGE(TAG, "Backend de driver não pode ser trocado com o driver instalado.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (ops == NULL) {
+        handle->driverOps = CAN_ESP_GetTwaiDriverOps();
+        handle->driverCtx = NULL;
+    } else {
+        handle->driverOps = ops;
+        handle->driverCtx = ctx;
+    }
+    handle->driverOpsSelected = true;
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_SetDriverBackend(const CanEspDriverOps_t *ops, void *ctx)
+{
+    return CAN_ESP_SetDriverBackend_v2(&defaultInstance, ops, ctx);
+}
+
+/* Protótipo para função auxiliar de temporização */
+static twai_timing_config_t GetTimingConfig(uint32_t bitrate);
+static void account_frame(can_esp_handle_t inst, const twai_message_t *frame, bool is_tx, int64_t now);
+
+/* Função auxiliar para obter configuração de temporização baseada no bitrate */
+static twai_timing_config_t GetTimingConfig(uint32_t bitrate)
+{
+    if (bitrate == 1000000U) {
+        static const twai_timing_config_t timing_config_1mbits = TWAI_TIMING_CONFIG_1MBITS();
+        return timing_config_1mbits;
+    } else if (bitrate == 500000U) {
+        static const twai_timing_config_t timing_config_500kbits = TWAI_TIMING_CONFIG_500KBITS();
+        return timing_config_500kbits;
+    } else {
+        static const twai_timing_config_t timing_config_1mbits = TWAI_TIMING_CONFIG_1MBITS();
+        return timing_config_1mbits;
+    }
+}
+
+/* Função auxiliar para converter CanEspMessage_t para twai_message_t */
+void can_esp_convert_canesp_to_twai(can_esp_handle_t inst, const CanEspMessage_t *src, twai_message_t *dst)
+{
+    if (src == NULL || dst == NULL) {
+        return;
+    }
+    dst->identifier = src->id;
+    if (inst->currentConfig.use_checksum && src->length < CAN_MAX_DATA_LENGTH) {
+        dst->data_length_code = src->length + 1;
+    } else {
+        dst->data_length_code = src->length;
+    }
+    memcpy(dst->data, src->data, src->length);
+    dst->extd = 1U;
+    dst->rtr = 0;
+    dst->ss = 0;
+    dst->self = inst->currentConfig.self_rx ? 1U : 0U;
+}
+
+#if CAN_ESP_MSG_POOL_SIZE > 65535U
+#error "CAN_ESP_MSG_POOL_SIZE deve caber em um índice de 16 bits"
+#endif
+
+#if CAN_ESP_TX_LEVEL_QUEUE_LENGTH >= 65535U
+#error "CAN_ESP_TX_LEVEL_QUEUE_LENGTH deve caber em uma posição de 16 bits"
+#endif
+
+/* Posição no heap de um slot que não está em nenhum nível */
+#define TX_HEAP_POS_NONE        (UINT16_MAX)
+
+/*
+ * Dono de cada slot do pool: livre, com o produtor (AllocMessage) ou com a biblioteca (na fila,
+ * estacionado para retransmissão ou em transmissão). Somente o produtor devolve ou enfileira.
+ */
+#define POOL_SLOT_FREE          (0U)
+#define POOL_SLOT_CALLER        (1U)
+#define POOL_SLOT_LIBRARY       (2U)
+
+/* Cria os recursos da fila de transmissão e preenche a pilha livre do pool (idempotente) */
+bool can_esp_tx_ring_init(can_esp_handle_t inst)
+{
+    if (inst->txSpaceSemaphore == NULL) {
+        inst->txSpaceSemaphore = xSemaphoreCreateBinary();
+    }
+    portENTER_CRITICAL(&inst->txRingLock);
+    if (!inst->msgPoolInitialized) {
+        for (uint32_t i = 0U; i < CAN_ESP_MSG_POOL_SIZE; i++) {
+            inst->msgPoolFree[i] = (uint16_t)(CAN_ESP_MSG_POOL_SIZE - 1U - i);
+        }
+        inst->msgPoolFreeCount = CAN_ESP_MSG_POOL_SIZE;
+        for (uint32_t i = 0U; i < CAN_ESP_MSG_POOL_SIZE; i++) {
+            inst->msgPoolHeapPos[i] = TX_HEAP_POS_NONE;
+            inst->txIdBuckets[i] = (uint16_t)CAN_ESP_MSG_POOL_SIZE;
+        }
+        inst->msgPoolStats.capacity = CAN_ESP_MSG_POOL_SIZE;
+        inst->msgPoolInitialized = true;
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    return (inst->txSpaceSemaphore != NULL);
+}
+
+/* Obtém um slot livre do pool para o dono informado; deve ser chamada com txRingLock adquirido */
+static bool msg_pool_alloc_locked(can_esp_handle_t inst, uint16_t *slot, uint8_t owner)
+{
+    uint32_t in_use;
+    if (inst->msgPoolFreeCount == 0U) {
+        inst->msgPoolStats.exhausted++;
+        return false;
+    }
+    inst->msgPoolFreeCount--;
+    *slot = inst->msgPoolFree[inst->msgPoolFreeCount];
+    inst->msgPoolOwner[*slot] = owner;
+    inst->msgPoolStats.allocations++;
+    in_use = CAN_ESP_MSG_POOL_SIZE - inst->msgPoolFreeCount;
+    if (in_use > inst->msgPoolStats.high_water_mark) {
+        inst->msgPoolStats.high_water_mark = in_use;
+    }
+    return true;
+}
+
+/* Índice do slot apontado por msg, ou CAN_ESP_MSG_POOL_SIZE se o ponteiro não pertencer ao pool */
+static uint32_t msg_pool_index(can_esp_handle_t inst, const CanEspMessage_t *msg)
+{
+    uintptr_t base = (uintptr_t)&inst->msgPool[0];
+    uintptr_t addr = (uintptr_t)msg;
+    if (addr < base || addr >= (base + sizeof(inst->msgPool)) || ((addr - base) % sizeof(CanEspMessage_t)) != 0U) {
+        return CAN_ESP_MSG_POOL_SIZE;
+    }
+    return (uint32_t)((addr - base) / sizeof(CanEspMessage_t));
+}
+
+/* Bucket do índice por ID */
+static uint32_t tx_id_bucket(uint32_t id)
+{
+    return (id ^ (id >> 7) ^ (id >> 17)) % CAN_ESP_MSG_POOL_SIZE;
+}
+
+/* Slot mais recente do ID no índice, ou CAN_ESP_MSG_POOL_SIZE se ausente (chamar com txRingLock) */
+static uint16_t tx_id_index_find_locked(can_esp_handle_t inst, uint32_t id)
+{
+    uint16_t slot = inst->txIdBuckets[tx_id_bucket(id)];
+    while (slot < CAN_ESP_MSG_POOL_SIZE && inst->msgPool[slot].id != id) {
+        slot = inst->msgPoolIdNext[slot];
+    }
+    return slot;
+}
+
+/* Retira um slot do índice por ID, se presente (chamar com txRingLock) */
+static void tx_id_index_remove_locked(can_esp_handle_t inst, uint16_t slot)
+{
+    uint16_t *link;
+
+    if (!inst->msgPoolIndexed[slot]) {
+        return;
+    }
+    link = &inst->txIdBuckets[tx_id_bucket(inst->msgPool[slot].id)];
+    while (*link != slot) {
+        link = &inst->msgPoolIdNext[*link];
+    }
+    *link = inst->msgPoolIdNext[slot];
+    inst->msgPoolIndexed[slot] = false;
+}
+
+/* Devolve um slot à pilha livre; retorna true se houver produtor a acordar (chamar com txRingLock) */
+static bool msg_pool_free_locked(can_esp_handle_t inst, uint16_t slot)
+{
+    tx_id_index_remove_locked(inst, slot);
+    inst->msgPoolFree[inst->msgPoolFreeCount] = slot;
+    inst->msgPoolFreeCount++;
+    inst->msgPoolOwner[slot] = POOL_SLOT_FREE;
+    inst->msgPoolDeadline[slot] = 0;
+    inst->msgPoolSuperseded[slot] = false;
+    return (inst->txWaiters > 0U);
+}
+
+/* Devolve um slot ao pool e acorda um produtor bloqueado por falta de espaço */
+void can_esp_tx_ring_release(can_esp_handle_t inst, CanEspMessage_t *msg)
+{
+    bool wake_producer;
+
+    portENTER_CRITICAL(&inst->txRingLock);
+    wake_producer = msg_pool_free_locked(inst, (uint16_t)(msg - inst->msgPool));
+    portEXIT_CRITICAL(&inst->txRingLock);
+    if (wake_producer) {
+        (void)xSemaphoreGive(inst->txSpaceSemaphore);
+    }
+}
+
+/* Nível de prioridade de uma mensagem (high_priority promove ao nível 0) */
+static uint8_t tx_level_of(const CanEspMessage_t *msg, bool high_priority)
+{
+    uint8_t level = 0U;
+    if (!high_priority) {
+        CAN_ESP_DecodeID(msg->id, &level, NULL, NULL);
+    }
+    return level;
+}
+
+/* Chave EDF de um slot: prazo absoluto, ou INT64_MAX sem prazo */
+static int64_t tx_deadline_key(can_esp_handle_t inst, uint16_t slot)
+{
+    return (inst->msgPoolDeadline[slot] != 0) ? inst->msgPoolDeadline[slot] : INT64_MAX;
+}
+
+/* Ordem do heap: chave menor primeiro e, entre chaves iguais, a sequência menor */
+static bool tx_heap_before(can_esp_handle_t inst, uint16_t a, uint16_t b)
+{
+    if (inst->msgPoolKey[a] != inst->msgPoolKey[b]) {
+        return inst->msgPoolKey[a] < inst->msgPoolKey[b];
+    }
+    return inst->msgPoolSeq[a] < inst->msgPoolSeq[b];
+}
+
+/* Grava o slot na posição pos do heap, mantendo msgPoolHeapPos (chamar com txRingLock) */
+static void tx_heap_place(can_esp_handle_t inst, CanEspTxLevel_t *q, uint32_t pos, uint16_t slot)
+{
+    q->slots[pos] = slot;
+    inst->msgPoolHeapPos[slot] = (uint16_t)pos;
+}
+
+/* Sobe o slot da posição pos até a sua ordem (chamar com txRingLock) */
+static void tx_heap_sift_up(can_esp_handle_t inst, CanEspTxLevel_t *q, uint32_t pos)
+{
+    uint16_t slot = q->slots[pos];
+    while (pos > 0U && tx_heap_before(inst, slot, q->slots[(pos - 1U) / 2U])) {
+        tx_heap_place(inst, q, pos, q->slots[(pos - 1U) / 2U]);
+        pos = (pos - 1U) / 2U;
+    }
+    tx_heap_place(inst, q, pos, slot);
+}
+
+/* Desce o slot da posição pos até a sua ordem (chamar com txRingLock) */
+static void tx_heap_sift_down(can_esp_handle_t inst, CanEspTxLevel_t *q, uint32_t pos)
+{
+    uint16_t slot = q->slots[pos];
+    uint32_t child;
+    for (;;) {
+        child = (2U * pos) + 1U;
+        if (child >= q->count) {
+            break;
+        }
+        if ((child + 1U) < q->count && tx_heap_before(inst, q->slots[child + 1U], q->slots[child])) {
+            child++;
+        }
+        if (!tx_heap_before(inst, q->slots[child], slot)) {
+            break;
+        }
+        tx_heap_place(inst, q, pos, q->slots[child]);
+        pos = child;
+    }
+    tx_heap_place(inst, q, pos, slot);
+}
+
+/*
+ * Insere um slot do pool no nível indicado; deve ser chamada com txRingLock adquirido e espaço
+ * garantido. Com front, a mensagem passa à frente das demais do mesmo nível (usado apenas por
+ * retransmissões, que já eram as mais antigas); sem front, entra após todas as de prazo menor ou
+ * igual (EDF, FIFO entre prazos iguais e entre mensagens sem prazo). O(log n) no nível.
+ */
+static void tx_ring_push_locked(can_esp_handle_t inst, uint16_t slot, uint8_t level, bool front)
+{
+    CanEspTxLevel_t *q = &inst->txLevels[level];
+    if (front) {
+        inst->msgPoolKey[slot] = INT64_MIN;
+        inst->msgPoolSeq[slot] = --q->frontSeq;
+    } else {
+        inst->msgPoolKey[slot] = tx_deadline_key(inst, slot);
+        inst->msgPoolSeq[slot] = q->backSeq++;
+    }
+    inst->msgPoolLevel[slot] = level;
+    q->slots[q->count] = slot;
+    q->count++;
+    tx_heap_sift_up(inst, q, q->count - 1U);
+    inst->txTotalCount++;
+    inst->txLevelBitmap |= (1UL << level);
+}
+
+/* Retira do nível o slot da posição pos do heap (chamar com txRingLock) */
+static uint16_t tx_level_remove_locked(can_esp_handle_t inst, uint8_t level, uint32_t pos)
+{
+    CanEspTxLevel_t *q = &inst->txLevels[level];
+    uint16_t slot = q->slots[pos];
+    uint16_t moved;
+    q->count--;
+    if (pos < q->count) {
+        /* O último elemento ocupa a posição liberada e sobe ou desce até a sua ordem */
+        moved = q->slots[q->count];
+        tx_heap_place(inst, q, pos, moved);
+        tx_heap_sift_up(inst, q, pos);
+        if (inst->msgPoolHeapPos[moved] == pos) {
+            tx_heap_sift_down(inst, q, pos);
+        }
+    }
+    inst->msgPoolHeapPos[slot] = TX_HEAP_POS_NONE;
+    inst->txTotalCount--;
+    if (q->count == 0U) {
+        inst->txLevelBitmap &= ~(1UL << level);
+    }
+    return slot;
+}
+
+/* Política de prazo que cobre o ID (a primeira registrada), ou NULL (chamar com txRingLock) */
+static const CanEspTxDeadlinePolicy_t *tx_policy_find_locked(can_esp_handle_t inst, uint32_t id)
+{
+    if (inst->txPolicyCount == 0U) {
+        return NULL;
+    }
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_TX_DEADLINE_POLICIES; i++) {
+        const CanEspTxPolicyEntry_t *entry = &inst->txPolicies[i];
+        if (entry->in_use && ((id & entry->policy.mask) == (entry->policy.id & entry->policy.mask))) {
+            return &entry->policy;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Registra newest como o slot mais recente do ID no índice e marca como superado o anterior,
+ * ainda com a biblioteca (estacionado para retransmissão, em transmissão ou em outro nível).
+ * Os mais antigos já foram marcados quando o anterior entrou. Chamar com txRingLock.
+ */
+static void tx_supersede_older_locked(can_esp_handle_t inst, uint32_t id, uint16_t newest)
+{
+    uint16_t previous = tx_id_index_find_locked(inst, id);
+    uint32_t bucket = tx_id_bucket(id);
+
+    if (previous == newest) {
+        return;
+    }
+    if (previous < CAN_ESP_MSG_POOL_SIZE) {
+        inst->msgPoolSuperseded[previous] = true;
+        tx_id_index_remove_locked(inst, previous);
+    }
+    inst->msgPoolIdNext[newest] = inst->txIdBuckets[bucket];
+    inst->txIdBuckets[bucket] = newest;
+    inst->msgPoolIndexed[newest] = true;
+}
+
+/*
+ * Aplica a política do ID a uma mensagem que entra no nível: calcula o seu prazo e, com
+ * replace_queued, sobrescreve o valor anterior ainda na fila (localizado pelo índice por ID) na
+ * posição que ele já ocupa; o slot só avança se o novo prazo for menor, de modo que atualizações
+ * frequentes não o atrasam. Retorna true se a mensagem substituiu um valor (não ocupa slot
+ * novo). Caso contrário, *supersede indica que o slot novo deve ser registrado com
+ * tx_supersede_older_locked. Chamar com txRingLock.
+ */
+static bool tx_policy_apply_locked(can_esp_handle_t inst, const CanEspMessage_t *msg, uint8_t level, int64_t now,
+                                   int64_t *deadline, bool *supersede)
+{
+    const CanEspTxDeadlinePolicy_t *policy = tx_policy_find_locked(inst, msg->id);
+    uint16_t slot;
+    int64_t key;
+
+    *deadline = 0;
+    *supersede = false;
+    if (policy == NULL) {
+        return false;
+    }
+    if (policy->lifetime_us > 0U) {
+        *deadline = now + (int64_t)policy->lifetime_us;
+    }
+    if (!policy->replace_queued) {
+        return false;
+    }
+    slot = tx_id_index_find_locked(inst, msg->id);
+    if (slot == CAN_ESP_MSG_POOL_SIZE || inst->msgPoolHeapPos[slot] == TX_HEAP_POS_NONE ||
+        inst->msgPoolLevel[slot] != level) {
+        *supersede = true;
+        return false;
+    }
+    inst->msgPool[slot] = *msg;
+    inst->msgPool[slot].retry_count = 0U;
+    inst->msgPoolDeadline[slot] = *deadline;
+    inst->msgPoolSuperseded[slot] = false;
+    key = tx_deadline_key(inst, slot);
+    if (key < inst->msgPoolKey[slot]) {
+        inst->msgPoolKey[slot] = key;
+        tx_heap_sift_up(inst, &inst->txLevels[level], inst->msgPoolHeapPos[slot]);
+    }
+    inst->txDeadlineStats.replaced++;
+    return true;
+}
+
+/*
+ * Copia até count mensagens (na ordem fornecida) para slots do pool, cada uma no fim da fila
+ * do seu nível, e retorna quantas couberam (sempre um prefixo do lote). Se all_or_nothing for
+ * verdadeiro, nada é inserido quando o lote não cabe inteiro e o chamador é registrado como aguardando
+ * espaço na mesma seção crítica (evita perder o sinal da tarefa de transmissão).
+ * *was_empty indica se a fila estava vazia antes da inserção, caso em que a tarefa de
+ * transmissão precisa ser acordada.
+ */
+static size_t tx_ring_push_batch(can_esp_handle_t inst, const CanEspMessage_t *msgs, size_t count, bool high_priority,
+                                 bool all_or_nothing, bool *was_empty)
+{
+    uint32_t needed[CAN_ESP_NUM_PRIORITY_LEVELS] = {0};
+    size_t accepted = 0U;
+    size_t i;
+    uint8_t level;
+    uint16_t slot;
+    int64_t deadline;
+    bool supersede;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&inst->txRingLock);
+    *was_empty = (inst->txTotalCount == 0U);
+    if (all_or_nothing) {
+        for (i = 0U; i < count; i++) {
+            needed[tx_level_of(&msgs[i], high_priority)]++;
+        }
+        for (level = 0U; level < CAN_ESP_NUM_PRIORITY_LEVELS; level++) {
+            if (inst->txLevels[level].count + needed[level] > CAN_ESP_TX_LEVEL_QUEUE_LENGTH) {
+                break;
+            }
+        }
+        if (level < CAN_ESP_NUM_PRIORITY_LEVELS || count > inst->msgPoolFreeCount) {
+            inst->txWaiters++;
+            portEXIT_CRITICAL(&inst->txRingLock);
+            return 0U;
+        }
+    }
+    for (i = 0U; i < count; i++) {
+        level = tx_level_of(&msgs[i], high_priority);
+        if (tx_policy_apply_locked(inst, &msgs[i], level, now, &deadline, &supersede)) {
+            accepted++;
+            continue;
+        }
+        if (inst->txLevels[level].count >= CAN_ESP_TX_LEVEL_QUEUE_LENGTH || !msg_pool_alloc_locked(inst, &slot, POOL_SLOT_LIBRARY)) {
+            break;
+        }
+        inst->msgPool[slot] = msgs[i];
+        inst->msgPool[slot].retry_count = 0U;
+        inst->msgPoolDeadline[slot] = deadline;
+        tx_ring_push_locked(inst, slot, level, false);
+        if (supersede) {
+            tx_supersede_older_locked(inst, msgs[i].id, slot);
+        }
+        accepted++;
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    return accepted;
+}
+
+/* Retira o slot da frente (menor prazo) de um nível não vazio; deve ser chamada com txRingLock adquirido */
+static uint16_t tx_ring_take_locked(can_esp_handle_t inst, uint8_t level)
+{
+    return tx_level_remove_locked(inst, level, 0U);
+}
+
+/*
+ * Retira a próxima mensagem do nível mais urgente não vazio, retornando o seu slot no pool
+ * (NULL se a fila estiver vazia). O chamador devolve o slot com can_esp_tx_ring_release.
+ */
+CanEspMessage_t *can_esp_tx_ring_pop(can_esp_handle_t inst)
+{
+    CanEspMessage_t *msg = NULL;
+
+    portENTER_CRITICAL(&inst->txRingLock);
+    if (inst->txLevelBitmap != 0U) {
+        msg = &inst->msgPool[tx_ring_take_locked(inst, (uint8_t)__builtin_ctz(inst->txLevelBitmap))];
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    return msg;
+}
+
+/* Número total de mensagens aguardando na fila de transmissão */
+static uint32_t tx_ring_count(can_esp_handle_t inst)
+{
+    uint32_t count;
+    portENTER_CRITICAL(&inst->txRingLock);
+    count = inst->txTotalCount;
+    portEXIT_CRITICAL(&inst->txRingLock);
+    return count;
+}
+
+/* Calcula um checksum simples (XOR de todos os bytes) */
+uint8_t CAN_ESP_CalculateChecksum(const uint8_t *data, uint8_t length)
+{
+    uint8_t cs = 0;
+    for (uint8_t i = 0U; i < length; i++) {
+        cs ^= data[i];
+    }
+    return cs;
+}
+
+/*==============================================================================
+                         FUNÇÕES DE CONFIGURAÇÃO DINÂMICA
+ ==============================================================================*/
+
+/*
+ * Alertas consumidos pela tarefa de alertas: os de estado de erro (recuperação) sempre; os de
+ * conclusão de transmissão só com o acompanhamento de conclusão registrado, pois sem ele cada
+ * quadro transmitido apenas acordaria a tarefa.
+ */
+static uint32_t driver_alert_mask(can_esp_handle_t inst)
+{
+    uint32_t alerts = TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_ERR_PASS | TWAI_ALERT_ERR_ACTIVE |
+                      TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_BELOW_ERR_WARN;
+
+    if (inst->transmit_complete_callback != NULL) {
+        alerts |= TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED;
+    }
+    return alerts;
+}
+
+/* Instala e inicia o driver TWAI com a configuração corrente */
+static can_esp_status_t driver_install_and_start(can_esp_handle_t inst)
+{
+    twai_general_config_t generalConfig;
+    twai_timing_config_t timingConfig;
+    twai_filter_config_t filterConfig;
+
+    generalConfig = (twai_general_config_t)TWAI_GENERAL_CONFIG_DEFAULT(inst->currentConfig.tx_gpio, inst->currentConfig.rx_gpio, inst->currentConfig.mode);
+    if (inst->currentConfig.use_custom_timing) {
+        timingConfig = inst->currentConfig.custom_timing_config;
+    } else {
+        timingConfig = GetTimingConfig(inst->currentConfig.bitrate);
+    }
+    filterConfig = inst->currentConfig.filter_config;
+    generalConfig.alerts_enabled = driver_alert_mask(inst);
+
+    if (drv_install(inst, &generalConfig, &timingConfig, &filterConfig) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha na instalação do driver TWAI.");
+        return CAN_ESP_ERR_DRIVER_INSTALL;
+    }
+    inst->driverInstalled = true;
+    /* A instalação zera os contadores do driver */
+    inst->txFailedSeen = 0U;
+    if (drv_start(inst) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar o barramento CAN.");
+        return CAN_ESP_ERR_DRIVER_START;
+    }
+    return CAN_ESP_OK;
+}
+
+static void reconfig_release_parked_tasks(can_esp_handle_t inst);
+
+can_esp_status_t CAN_ESP_InitWithConfig_v2(can_esp_handle_t handle, const CanEspConfig_t *config)
+{
+    can_esp_status_t status;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de configuração nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (handle->configMutex == NULL) {
+        handle->configMutex = xSemaphoreCreateMutex();
+        if (handle->configMutex == NULL) {
+            ESP_LOGE(TAG, "Falha ao criar mutex de configuração.");
+            return CAN_ESP_ERR_UNKNOWN;
+        }
+    }
+    can_esp_latency_hist_reset(&handle->latencyTotal);
+    can_esp_latency_hist_reset(&handle->latencyWindows[0]);
+    can_esp_latency_hist_reset(&handle->latencyWindows[1]);
+    xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+    handle->currentConfig = *config;
+    handle->configInitialized = true;
+    xSemaphoreGive(handle->configMutex);
+
+    /* Inicializa a medição do bus load */
+    portENTER_CRITICAL(&handle->busLoadLock);
+    handle->busLoadStartTime = esp_timer_get_time();
+    for (uint32_t w = 0U; w < 3U; w++) {
+        handle->busLoadWindows[w].epoch = handle->busLoadStartTime / handle->busLoadWindows[w].bucket_us;
+        memset(handle->busLoadWindows[w].bits, 0, sizeof(handle->busLoadWindows[w].bits));
+    }
+    handle->busLoadTotalBits = 0U;
+    handle->busLoadTxFrames = 0U;
+    handle->busLoadRxFrames = 0U;
+    portEXIT_CRITICAL(&handle->busLoadLock);
+
+    status = driver_install_and_start(handle);
+    if (status != CAN_ESP_OK) {
+        return status;
+    }
+    ESP_LOGI(TAG, "Barramento CAN iniciado com configuração dinâmica.");
+    reconfig_release_parked_tasks(handle);
+
+    if (!can_esp_tx_ring_init(handle)) {
+        ESP_LOGE(TAG, "Falha ao criar a fila de transmissão.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_InitWithConfig(const CanEspConfig_t *config)
+{
+    return CAN_ESP_InitWithConfig_v2(&defaultInstance, config);
+}
+
+can_esp_status_t CAN_ESP_Init_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (!handle->configInitialized) {
+        handle->currentConfig.bitrate = 1000000U;
+        handle->currentConfig.tx_gpio = CAN_TX_GPIO;
+        handle->currentConfig.rx_gpio = CAN_RX_GPIO;
+        handle->currentConfig.transmit_timeout_ms = CAN_DEFAULT_TRANSMIT_TIMEOUT_MS;
+        handle->currentConfig.receive_timeout_ms = CAN_DEFAULT_RECEIVE_TIMEOUT_MS;
+        handle->currentConfig.use_checksum = false;  /* Padrão: checksum desabilitado */
+        handle->configInitialized = true;
+    }
+    return CAN_ESP_InitWithConfig_v2(handle, &handle->currentConfig);
+}
+
+can_esp_status_t CAN_ESP_Init(void)
+{
+    return CAN_ESP_Init_v2(&defaultInstance);
+}
+
+can_esp_status_t CAN_ESP_UpdateConfig_v2(can_esp_handle_t handle, const CanEspConfig_t *config)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de configuração nulo na atualização.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    return CAN_ESP_Reconfigure_v2(handle, config);
+}
+
+can_esp_status_t CAN_ESP_UpdateConfig(const CanEspConfig_t *config)
+{
+    return CAN_ESP_UpdateConfig_v2(&defaultInstance, config);
+}
+
+static bool alert_task_pause(can_esp_handle_t inst);
+static void alert_task_resume(can_esp_handle_t inst);
+
+can_esp_status_t CAN_ESP_Deinit_v2(can_esp_handle_t handle)
+{
+    can_esp_status_t status = CAN_ESP_OK;
+    bool alert_paused;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    /* A tarefa de alertas não pode estar bloqueada no driver durante a desinstalação */
+    alert_paused = alert_task_pause(handle);
+    if (drv_stop(handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao parar o barramento CAN.");
+        status = CAN_ESP_ERR_DRIVER_STOP;
+    } else if (drv_uninstall(handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao desinstalar o driver TWAI.");
+        status = CAN_ESP_ERR_DRIVER_UNINSTALL;
+    } else {
+        handle->driverInstalled = false;
+        ESP_LOGI(TAG, "Barramento CAN desinicializado com sucesso.");
+    }
+    if (alert_paused) {
+        alert_task_resume(handle);
+    }
+    return status;
+}
+
+can_esp_status_t CAN_ESP_Deinit(void)
+{
+    return CAN_ESP_Deinit_v2(&defaultInstance);
+}
+
+/*==============================================================================
+            RECONFIGURAÇÃO SEM PERDA (PAUSA, DRENAGEM, TROCA E RETOMADA)
+ ==============================================================================*/
+
+/* Ponto de pausa da tarefa de transmissão (chamado entre quadros) */
+static void tx_task_pause_point(can_esp_handle_t inst)
+{
+    if (inst->reconfigPauseRequested) {
+        (void)xSemaphoreGive(inst->reconfigAckSemaphore);
+        (void)xSemaphoreTake(inst->txResumeSemaphore, portMAX_DELAY);
+    }
+}
+
+/* Cria os semáforos usados pela reconfiguração (idempotente) */
+static bool reconfig_init(can_esp_handle_t inst)
+{
+    if (inst->reconfigMutex == NULL) {
+        inst->reconfigMutex = xSemaphoreCreateMutex();
+    }
+    if (inst->reconfigAckSemaphore == NULL) {
+        inst->reconfigAckSemaphore = xSemaphoreCreateCounting(2U, 0U);
+    }
+    if (inst->txResumeSemaphore == NULL) {
+        inst->txResumeSemaphore = xSemaphoreCreateBinary();
+    }
+    if (inst->rxResumeSemaphore == NULL) {
+        inst->rxResumeSemaphore = xSemaphoreCreateBinary();
+    }
+    return (inst->reconfigMutex != NULL) && (inst->reconfigAckSemaphore != NULL) &&
+           (inst->txResumeSemaphore != NULL) && (inst->rxResumeSemaphore != NULL);
+}
+
+/* Aguarda o driver esvaziar sua fila de transmissão, por no máximo timeout_ms */
+static uint32_t wait_driver_tx_drained(can_esp_handle_t inst, uint32_t timeout_ms)
+{
+    twai_status_info_t info;
+    int64_t deadline = esp_timer_get_time() + ((int64_t)timeout_ms * 1000LL);
+    for (;;) {
+        if (drv_get_status_info(inst, &info) != ESP_OK) {
+            return 0U;
+        }
+        if (info.msgs_to_tx == 0U || esp_timer_get_time() >= deadline) {
+            return info.msgs_to_tx;
+        }
+        vTaskDelay(1);
+    }
+}
+
+/* Pausa as tarefas entre quadros; a de recepção drena o driver para o anel antes de confirmar */
+static void reconfig_pause_tasks(can_esp_handle_t inst)
+{
+    uint32_t paused_tasks = 0U;
+
+    /* Descarta confirmações de tarefas criadas enquanto outras estavam estacionadas */
+    while (xSemaphoreTake(inst->reconfigAckSemaphore, 0) == pdTRUE) {
+    }
+    inst->reconfigPauseRequested = true;
+    if (inst->canTxTaskHandle != NULL) {
+        xTaskNotifyGive(inst->canTxTaskHandle);
+        paused_tasks++;
+    }
+    if (inst->canRxTaskHandle != NULL) {
+        paused_tasks++;
+    }
+    for (uint32_t i = 0U; i < paused_tasks; i++) {
+        (void)xSemaphoreTake(inst->reconfigAckSemaphore, portMAX_DELAY);
+    }
+}
+
+static void reconfig_resume_tasks(can_esp_handle_t inst)
+{
+    inst->reconfigTasksParked = false;
+    inst->reconfigPauseRequested = false;
+    if (inst->canTxTaskHandle != NULL) {
+        (void)xSemaphoreGive(inst->txResumeSemaphore);
+    }
+    if (inst->canRxTaskHandle != NULL) {
+        (void)xSemaphoreGive(inst->rxResumeSemaphore);
+    }
+}
+
+/* Libera as tarefas estacionadas por uma reconfiguração que terminou sem driver */
+static void reconfig_release_parked_tasks(can_esp_handle_t inst)
+{
+    if (inst->reconfigTasksParked) {
+        reconfig_resume_tasks(inst);
+        ESP_LOGI(TAG, "Driver reinstalado: tarefas de transmissão e recepção retomadas.");
+    }
+}
+
+/*
+ * Instala a configuração já gravada em currentConfig após uma desinstalação. Um driver instalado
+ * mas não iniciado é desinstalado, para que a tentativa seguinte parta do mesmo estado.
+ */
+static can_esp_status_t reconfig_install(can_esp_handle_t inst)
+{
+    can_esp_status_t status = driver_install_and_start(inst);
+
+    if (status != CAN_ESP_OK && inst->driverInstalled) {
+        if (drv_uninstall(inst) == ESP_OK) {
+            inst->driverInstalled = false;
+        }
+    }
+    return status;
+}
+
+static void reconfig_set_config(can_esp_handle_t inst, const CanEspConfig_t *config)
+{
+    xSemaphoreTake(inst->configMutex, portMAX_DELAY);
+    inst->currentConfig = *config;
+    xSemaphoreGive(inst->configMutex);
+}
+
+can_esp_status_t CAN_ESP_Reconfigure_v2(can_esp_handle_t handle, const CanEspConfig_t *config)
+{
+    can_esp_status_t status;
+    CanEspConfig_t previous;
+    TaskHandle_t caller;
+    bool rolled_back = false;
+    uint32_t lost_tx;
+    uint32_t blackout_us, pause_us;
+    int64_t pause_start, blackout_start, blackout_end;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de configuração nulo na reconfiguração.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    /* As tarefas pausadas não podem aguardar a si mesmas (ex.: callback de transmissão) */
+    caller = xTaskGetCurrentTaskHandle();
+    if (caller != NULL && (caller == handle->canTxTaskHandle || caller == handle->canRxTaskHandle)) {
+        ESP_LOGE(TAG, "Reconfiguração chamada pela tarefa de transmissão ou recepção.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (!reconfig_init(handle)) {
+        ESP_LOGE(TAG, "Falha ao criar semáforos de reconfiguração.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    xSemaphoreTake(handle->reconfigMutex, portMAX_DELAY);
+    if (!handle->driverInstalled) {
+        /* Inicialização, ou nova tentativa após falha de reinstalação com tarefas estacionadas */
+        status = CAN_ESP_InitWithConfig_v2(handle, config);
+        xSemaphoreGive(handle->reconfigMutex);
+        return status;
+    }
+    pause_start = esp_timer_get_time();
+
+    /* 1. Pausa as tarefas entre quadros */
+    reconfig_pause_tasks(handle);
+
+    /* 2. Aguarda os quadros já entregues ao driver saírem para o barramento */
+    lost_tx = wait_driver_tx_drained(handle, handle->currentConfig.transmit_timeout_ms);
+
+    /* 3. Troca a configuração do driver (janela sem comunicação); em falha, volta à anterior */
+    blackout_start = esp_timer_get_time();
+    previous = handle->currentConfig;
+    status = CAN_ESP_Deinit_v2(handle);
+    if (status == CAN_ESP_OK) {
+        reconfig_set_config(handle, config);
+        status = reconfig_install(handle);
+        if (status != CAN_ESP_OK) {
+            ESP_LOGE(TAG, "Falha ao instalar a nova configuração; restaurando a anterior.");
+            reconfig_set_config(handle, &previous);
+            rolled_back = (reconfig_install(handle) == CAN_ESP_OK);
+        }
+    } else if (handle->driverInstalled && status == CAN_ESP_ERR_DRIVER_UNINSTALL) {
+        /* Driver parado mas não removido: mantém a configuração anterior em operação */
+        (void)drv_start(handle);
+    }
+    blackout_end = esp_timer_get_time();
+
+    /*
+     * 4. Retoma as tarefas preservando filas, contadores e métricas. Sem driver (nova e antiga
+     * configurações recusadas) elas permanecem pausadas até a próxima instalação.
+     */
+    if (handle->driverInstalled) {
+        reconfig_resume_tasks(handle);
+    } else {
+        handle->reconfigTasksParked = true;
+        ESP_LOGE(TAG, "Driver ausente após a reconfiguração; tarefas mantidas pausadas.");
+    }
+
+    blackout_us = (uint32_t)(blackout_end - blackout_start);
+    pause_us = (uint32_t)(esp_timer_get_time() - pause_start);
+    portENTER_CRITICAL(&handle->reconfigStatsLock);
+    handle->reconfigStats.count++;
+    handle->reconfigStats.last_blackout_us = blackout_us;
+    handle->reconfigStats.last_pause_us = pause_us;
+    handle->reconfigStats.tx_frames_lost += lost_tx;
+    if (blackout_us > handle->reconfigStats.max_blackout_us) {
+        handle->reconfigStats.max_blackout_us = blackout_us;
+    }
+    if (status != CAN_ESP_OK) {
+        handle->reconfigStats.failures++;
+    }
+    if (rolled_back) {
+        handle->reconfigStats.rollbacks++;
+    }
+    portEXIT_CRITICAL(&handle->reconfigStatsLock);
+    xSemaphoreGive(handle->reconfigMutex);
+
+    ESP_LOGI(TAG, "Reconfiguração concluída: blackout de %" PRIu32 " us, pausa total de %" PRIu32 " us.",
+             blackout_us, pause_us);
+    return status;
+}
+
+can_esp_status_t CAN_ESP_Reconfigure(const CanEspConfig_t *config)
+{
+    return CAN_ESP_Reconfigure_v2(&defaultInstance, config);
+}
+
+can_esp_status_t CAN_ESP_GetReconfigStats_v2(can_esp_handle_t handle, CanEspReconfigStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas de reconfiguração nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->reconfigStatsLock);
+    *stats = handle->reconfigStats;
+    portEXIT_CRITICAL(&handle->reconfigStatsLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetReconfigStats(CanEspReconfigStats_t *stats)
+{
+    return CAN_ESP_GetReconfigStats_v2(&defaultInstance, stats);
+}
+
+/*==============================================================================
+                   FUNÇÕES DE ATUALIZAÇÃO PARCIAL
+ ==============================================================================*/
+
+can_esp_status_t CAN_ESP_SetFilterConfig_v2(can_esp_handle_t handle, const twai_filter_config_t *new_filter_config)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (new_filter_config == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de nova configuração de filtro nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    CanEspConfig_t new_config;
+    xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+    new_config = handle->currentConfig;
+    xSemaphoreGive(handle->configMutex);
+    new_config.filter_config = *new_filter_config;
+    ESP_LOGI(TAG, "Nova configuração de filtro. Reconfigurando driver sem perda de filas...");
+    return CAN_ESP_Reconfigure_v2(handle, &new_config);
+}
+
+can_esp_status_t CAN_ESP_SetFilterConfig(const twai_filter_config_t *new_filter_config)
+{
+    return CAN_ESP_SetFilterConfig_v2(&defaultInstance, new_filter_config);
+}
+
+can_esp_status_t CAN_ESP_SetTimeouts_v2(can_esp_handle_t handle, uint32_t tx_timeout_ms, uint32_t rx_timeout_ms)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+    handle->currentConfig.transmit_timeout_ms = tx_timeout_ms;
+    handle->currentConfig.receive_timeout_ms  = rx_timeout_ms;
+    xSemaphoreGive(handle->configMutex);
+    ESP_LOGI(TAG, "Timeouts atualizados: Tx = %" PRIu32 " ms, Rx = %" PRIu32 " ms", tx_timeout_ms, rx_timeout_ms);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_SetTimeouts(uint32_t tx_timeout_ms, uint32_t rx_timeout_ms)
+{
+    return CAN_ESP_SetTimeouts_v2(&defaultInstance, tx_timeout_ms, rx_timeout_ms);
+}
+
+/*==============================================================================
+                        CONFIGURAÇÃO DAS TAREFAS
+ ==============================================================================*/
+
+/* Cria uma tarefa da biblioteca no núcleo, pilha e prioridade configurados */
+static bool task_create(TaskFunction_t fn, const char *name, const CanEspTaskParams_t *params,
+                        can_esp_handle_t inst, TaskHandle_t *task)
+{
+    if (xTaskCreatePinnedToCore(fn, name, params->stack_size, inst, params->priority, task,
+                                params->core_id) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar a tarefa %s.", name);
+        *task = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool task_params_valid(const CanEspTaskParams_t *params)
+{
+    if (params->stack_size < (uint32_t)configMINIMAL_STACK_SIZE ||
+        params->priority >= (UBaseType_t)configMAX_PRIORITIES) {
+        return false;
+    }
+    return (params->core_id == tskNO_AFFINITY) ||
+           (params->core_id >= 0 && params->core_id < (BaseType_t)portNUM_PROCESSORS);
+}
+
+void CAN_ESP_TaskDefaultConfig(CanEspTaskConfig_t *config)
+{
+    static const CanEspTaskConfig_t defaultTaskConfig = INSTANCE_DEFAULT_TASK_CONFIG;
+
+    if (config != NULL) {
+        *config = defaultTaskConfig;
+    }
+}
+
+can_esp_status_t CAN_ESP_SetTaskConfig_v2(can_esp_handle_t handle, const CanEspTaskConfig_t *config)
+{
+    bool boosted;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL || !task_params_valid(&config->transmit) || !task_params_valid(&config->receive) ||
+        !task_params_valid(&config->dispatch) || !task_params_valid(&config->alert) ||
+        config->tx_boost_priority >= (UBaseType_t)configMAX_PRIORITIES ||
+        config->tx_boost_high_pct > 100U || config->tx_boost_low_pct > config->tx_boost_high_pct) {
+        ESP_LOGE(TAG, "Configuração de tarefas inválida.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    /* A tarefa de transmissão lê a política de prioridade sob txRingLock */
+    portENTER_CRITICAL(&handle->txRingLock);
+    handle->taskConfig = *config;
+    if (config->tx_boost_priority <= config->transmit.priority) {
+        handle->txPriorityBoosted = false;
+    }
+    boosted = handle->txPriorityBoosted;
+    portEXIT_CRITICAL(&handle->txRingLock);
+
+    /* Núcleo e pilha valem na próxima criação; prioridades são aplicadas já */
+    if (handle->canTxTaskHandle != NULL) {
+        vTaskPrioritySet(handle->canTxTaskHandle, boosted ? config->tx_boost_priority : config->transmit.priority);
+    }
+    if (handle->canRxTaskHandle != NULL) {
+        vTaskPrioritySet(handle->canRxTaskHandle, config->receive.priority);
+    }
+    if (handle->canDispatchTaskHandle != NULL) {
+        vTaskPrioritySet(handle->canDispatchTaskHandle, config->dispatch.priority);
+    }
+    if (handle->canAlertTaskHandle != NULL) {
+        vTaskPrioritySet(handle->canAlertTaskHandle, config->alert.priority);
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_SetTaskConfig(const CanEspTaskConfig_t *config)
+{
+    return CAN_ESP_SetTaskConfig_v2(&defaultInstance, config);
+}
+
+can_esp_status_t CAN_ESP_GetTaskConfig_v2(can_esp_handle_t handle, CanEspTaskConfig_t *config)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    *config = handle->taskConfig;
+    portEXIT_CRITICAL(&handle->txRingLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetTaskConfig(CanEspTaskConfig_t *config)
+{
+    return CAN_ESP_GetTaskConfig_v2(&defaultInstance, config);
+}
+
+/*==============================================================================
+                  ACOMPANHAMENTO DA CONCLUSÃO DE TRANSMISSÃO
+ ==============================================================================*/
+
+/* Entrega o quadro ao driver, registrando-o para confirmação se houver callback de conclusão */
+static esp_err_t transmit_tracked(can_esp_handle_t inst, const twai_message_t *frame, const CanEspMessage_t *msg, TickType_t ticks)
+{
+    esp_err_t err;
+
+    if (inst->transmit_complete_callback == NULL || inst->txInflightMutex == NULL) {
+        return drv_transmit(inst, frame, ticks);
+    }
+    (void)xSemaphoreTake(inst->txInflightMutex, portMAX_DELAY);
+    err = drv_transmit(inst, frame, ticks);
+    if (err == ESP_OK) {
+        if (inst->txInflightCount == CAN_ESP_TX_INFLIGHT_LENGTH) {
+            /* Tarefa de conclusão atrasada: o mais antigo certamente já foi transmitido */
+            inst->txInflightHead = (inst->txInflightHead + 1U) % CAN_ESP_TX_INFLIGHT_LENGTH;
+            inst->txInflightCount--;
+        }
+        inst->txInflight[(inst->txInflightHead + inst->txInflightCount) % CAN_ESP_TX_INFLIGHT_LENGTH] = *msg;
+        inst->txInflightCount++;
+    }
+    (void)xSemaphoreGive(inst->txInflightMutex);
+    return err;
+}
+
+/*
+ * Reconcilia o anel com a fila do driver após um alerta: cada quadro concluído recebe o
+ * instante em que é retirado do anel e é entregue ao callback fora do mutex. O acréscimo de
+ * tx_failed_count desde a última reconciliação indica quantos dos quadros concluídos falharam,
+ * mas não quais: sem falhas todos foram confirmados (TX_SUCCESS); se todos falharam, cada um
+ * recebe CAN_ESP_ERR_TRANSMIT; caso contrário nenhum é adivinhado e todos recebem
+ * CAN_ESP_ERR_TX_UNATTRIBUTED. Em bus-off os quadros ainda pendentes no driver são descartados
+ * pela recuperação e falham com certeza.
+ */
+static void tx_complete_process(can_esp_handle_t inst)
+{
+    CanEspMessage_t done[CAN_ESP_TX_INFLIGHT_LENGTH];
+    can_esp_status_t status[CAN_ESP_TX_INFLIGHT_LENGTH];
+    twai_status_info_t info;
+    can_esp_transmit_complete_callback_t callback;
+    uint32_t pending;
+    uint32_t completed = 0U;
+    uint32_t confirmed_count = 0U;
+    uint32_t failed;
+    uint32_t n = 0U;
+    can_esp_status_t confirmed = CAN_ESP_OK;
+    bool bus_off;
+
+    if (inst->transmit_complete_callback == NULL || inst->txInflightMutex == NULL) {
+        return;
+    }
+    (void)xSemaphoreTake(inst->txInflightMutex, portMAX_DELAY);
+    if (drv_get_status_info(inst, &info) == ESP_OK) {
+        bus_off = (info.state == TWAI_STATE_BUS_OFF) || (info.state == TWAI_STATE_RECOVERING);
+        pending = (info.msgs_to_tx < inst->txInflightCount) ? info.msgs_to_tx : inst->txInflightCount;
+        completed = inst->txInflightCount - pending;
+        failed = info.tx_failed_count - inst->txFailedSeen;
+        inst->txFailedSeen = info.tx_failed_count;
+        if (failed == 0U) {
+            confirmed = CAN_ESP_OK;
+        } else if (failed >= completed) {
+            confirmed = CAN_ESP_ERR_TRANSMIT;
+        } else {
+            confirmed = CAN_ESP_ERR_TX_UNATTRIBUTED;
+        }
+        confirmed_count = completed;
+        if (bus_off) {
+            /* Bus-off: o que resta na fila do driver se perde na recuperação */
+            completed += pending;
+        }
+        while (n < completed) {
+            done[n] = inst->txInflight[inst->txInflightHead];
+            done[n].timestamp_us = esp_timer_get_time();
+            status[n] = (n < confirmed_count) ? confirmed : CAN_ESP_ERR_TRANSMIT;
+            n++;
+            inst->txInflightHead = (inst->txInflightHead + 1U) % CAN_ESP_TX_INFLIGHT_LENGTH;
+            inst->txInflightCount--;
+        }
+    }
+    callback = inst->transmit_complete_callback;
+    (void)xSemaphoreGive(inst->txInflightMutex);
+
+    for (uint32_t i = 0U; i < n && callback != NULL; i++) {
+        callback(&done[i], status[i]);
+    }
+}
+
+static void recovery_process(can_esp_handle_t inst, int64_t now);
+static TickType_t recovery_wait_ticks(can_esp_handle_t inst);
+
+/*
+ * Tarefa de alertas: única leitora dos alertas do driver (a leitura os consome), atende o
+ * acompanhamento de conclusão e o supervisor de recuperação a cada despertar.
+ */
+static void CAN_ESP_AlertTask(void *arg)
+{
+    can_esp_handle_t inst = (can_esp_handle_t)arg;
+    uint32_t alerts;
+    esp_err_t err;
+    TickType_t wait;
+
+    for (;;) {
+        if (inst->alertPauseRequested) {
+            (void)xSemaphoreGive(inst->alertAckSemaphore);
+            (void)xSemaphoreTake(inst->alertResumeSemaphore, portMAX_DELAY);
+            continue;
+        }
+        wait = recovery_wait_ticks(inst);
+        alerts = 0U;
+        err = drv_read_alerts(inst, &alerts, wait);
+        if (err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+            /* Driver ausente (ex.: janela de reconfiguração) */
+            vTaskDelay(wait);
+            continue;
+        }
+        tx_complete_process(inst);
+        if (inst->recoveryEnabled) {
+            recovery_process(inst, esp_timer_get_time());
+        }
+    }
+}
+
+/*
+ * Pausa a tarefa de alertas fora da leitura do driver (espera no máximo um período de leitura).
+ * Retorna false se não houver tarefa a pausar ou se a chamada partir dela própria (um callback
+ * executado pela tarefa, que portanto não está bloqueada no driver).
+ */
+static bool alert_task_pause(can_esp_handle_t inst)
+{
+    if (inst->canAlertTaskHandle == NULL || inst->canAlertTaskHandle == xTaskGetCurrentTaskHandle()) {
+        return false;
+    }
+    inst->alertPauseRequested = true;
+    (void)xSemaphoreTake(inst->alertAckSemaphore, portMAX_DELAY);
+    return true;
+}
+
+static void alert_task_resume(can_esp_handle_t inst)
+{
+    inst->alertPauseRequested = false;
+    (void)xSemaphoreGive(inst->alertResumeSemaphore);
+}
+
+/* Cria a tarefa de alertas (idempotente); prioridade acima da de transmissão para reagir ao bus-off */
+static can_esp_status_t alert_task_start(can_esp_handle_t inst)
+{
+    if (inst->alertAckSemaphore == NULL) {
+        inst->alertAckSemaphore = xSemaphoreCreateBinary();
+    }
+    if (inst->alertResumeSemaphore == NULL) {
+        inst->alertResumeSemaphore = xSemaphoreCreateBinary();
+    }
+    if (inst->alertAckSemaphore == NULL || inst->alertResumeSemaphore == NULL) {
+        ESP_LOGE(TAG, "Falha ao criar semáforos da tarefa de alertas.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    if (inst->canAlertTaskHandle == NULL) {
+        if (!task_create(CAN_ESP_AlertTask, "CAN_ALERT_Task", &inst->taskConfig.alert, inst,
+                         &inst->canAlertTaskHandle)) {
+            return CAN_ESP_ERR_UNKNOWN;
+        }
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_RegisterTransmitCompleteCallback_v2(can_esp_handle_t handle, can_esp_transmit_complete_callback_t callback)
+{
+    twai_status_info_t info;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (handle->txInflightMutex == NULL) {
+        handle->txInflightMutex = xSemaphoreCreateMutex();
+        if (handle->txInflightMutex == NULL) {
+            ESP_LOGE(TAG, "Falha ao criar mutex de conclusão de transmissão.");
+            return CAN_ESP_ERR_UNKNOWN;
+        }
+    }
+    (void)xSemaphoreTake(handle->txInflightMutex, portMAX_DELAY);
+    if (callback != NULL && handle->transmit_complete_callback == NULL &&
+        drv_get_status_info(handle, &info) == ESP_OK) {
+        /* Falhas anteriores ao acompanhamento não pertencem a quadros do anel */
+        handle->txFailedSeen = info.tx_failed_count;
+    }
+    handle->transmit_complete_callback = callback;
+    if (callback == NULL) {
+        handle->txInflightHead = 0U;
+        handle->txInflightCount = 0U;
+    }
+    (void)xSemaphoreGive(handle->txInflightMutex);
+
+    /* Liga ou desliga os alertas de conclusão no driver já instalado */
+    if (handle->driverInstalled && drv_reconfigure_alerts(handle, driver_alert_mask(handle)) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao reconfigurar os alertas do driver.");
+    }
+
+    if (callback != NULL && alert_task_start(handle) != CAN_ESP_OK) {
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    ESP_LOGI(TAG, "Callback de conclusão de transmissão %s.", (callback != NULL) ? "registrado" : "removido");
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_RegisterTransmitCompleteCallback(can_esp_transmit_complete_callback_t callback)
+{
+    return CAN_ESP_RegisterTransmitCompleteCallback_v2(&defaultInstance, callback);
+}
+
+/*==============================================================================
+          LIMITAÇÃO DE TAXA DE TRANSMISSÃO (TOKEN BUCKET POR ID / MÁSCARA)
+ ==============================================================================*/
+
+/* Um token (quadro) em milionésimos: a reposição taxa x microssegundos é exata em inteiros */
+#define RATE_LIMIT_TOKEN        (1000000ULL)
+#define RATE_LIMIT_MAX_RATE     (1000000U)
+/* Início de operação que impede a espera nos limites DELAY (caminhos não bloqueantes) */
+#define RATE_LIMIT_NO_WAIT      (-1)
+
+static bool rate_limit_matches(const CanEspRateLimitEntry_t *entry, uint32_t id)
+{
+    return entry->in_use && ((id & entry->config.mask) == (entry->config.id & entry->config.mask));
+}
+
+/* Repõe os tokens acumulados até now, limitados à rajada (chamar com rateLimitLock) */
+static void rate_limit_refill(CanEspRateLimitEntry_t *entry, int64_t now)
+{
+    uint64_t capacity = (uint64_t)entry->config.burst * RATE_LIMIT_TOKEN;
+
+    if (now > entry->last_refill_us) {
+        entry->tokens += (uint64_t)(now - entry->last_refill_us) * entry->config.rate_per_s;
+        if (entry->tokens > capacity) {
+            entry->tokens = capacity;
+        }
+        entry->last_refill_us = now;
+    }
+}
+
+/*
+ * Consome um token de cada limite que cobre o ID, ou de nenhum se algum estiver vazio. Nesse
+ * caso *wait_us recebe o tempo até todos terem token e *max_wait_us a menor espera permitida
+ * entre os limites vazios (0 se algum deles for DROP).
+ */
+static bool rate_limit_try(can_esp_handle_t inst, uint32_t id, int64_t now, bool delayed,
+                           int64_t *wait_us, int64_t *max_wait_us)
+{
+    bool admitted = true;
+
+    *wait_us = 0;
+    *max_wait_us = INT64_MAX;
+    portENTER_CRITICAL(&inst->rateLimitLock);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_RATE_LIMITS; i++) {
+        CanEspRateLimitEntry_t *entry = &inst->rateLimits[i];
+        if (!rate_limit_matches(entry, id)) {
+            continue;
+        }
+        rate_limit_refill(entry, now);
+        if (entry->tokens < RATE_LIMIT_TOKEN) {
+            int64_t wait = (int64_t)(((RATE_LIMIT_TOKEN - entry->tokens) + entry->config.rate_per_s - 1U) /
+                                     entry->config.rate_per_s);
+            int64_t allowed = (entry->config.policy == CAN_ESP_RATE_LIMIT_DELAY)
+                              ? ((int64_t)entry->config.max_delay_ms * 1000) : 0;
+            admitted = false;
+            if (wait > *wait_us) {
+                *wait_us = wait;
+            }
+            if (allowed < *max_wait_us) {
+                *max_wait_us = allowed;
+            }
+        }
+    }
+    if (admitted) {
+        for (uint32_t i = 0U; i < CAN_ESP_MAX_RATE_LIMITS; i++) {
+            CanEspRateLimitEntry_t *entry = &inst->rateLimits[i];
+            if (rate_limit_matches(entry, id)) {
+                entry->tokens -= RATE_LIMIT_TOKEN;
+                entry->stats.admitted++;
+                if (delayed) {
+                    entry->stats.delayed++;
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL(&inst->rateLimitLock);
+    return admitted;
+}
+
+/* Contabiliza a recusa nos limites que estavam sem token */
+static void rate_limit_count_rejection(can_esp_handle_t inst, uint32_t id)
+{
+    portENTER_CRITICAL(&inst->rateLimitLock);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_RATE_LIMITS; i++) {
+        CanEspRateLimitEntry_t *entry = &inst->rateLimits[i];
+        if (rate_limit_matches(entry, id) && entry->tokens < RATE_LIMIT_TOKEN) {
+            entry->stats.rejected++;
+        }
+    }
+    inst->rateLimitRejections++;
+    portEXIT_CRITICAL(&inst->rateLimitLock);
+}
+
+/*
+ * Admite um quadro pelos limites de taxa. Limites DELAY bloqueiam a tarefa chamadora até
+ * since + max_delay_ms, em que since é o início da operação (o mesmo para todo um lote); com
+ * RATE_LIMIT_NO_WAIT (caminhos não bloqueantes e esp_timer), qualquer limite vazio recusa o quadro.
+ */
+static can_esp_status_t rate_limit_admit(can_esp_handle_t inst, uint32_t id, int64_t since)
+{
+    int64_t now;
+    int64_t wait_us;
+    int64_t max_wait_us;
+    bool delayed = false;
+
+    if (inst->rateLimitCount == 0U) {
+        return CAN_ESP_OK;
+    }
+    now = esp_timer_get_time();
+    while (!rate_limit_try(inst, id, now, delayed, &wait_us, &max_wait_us)) {
+        if (since == RATE_LIMIT_NO_WAIT || ((now - since) + wait_us) > max_wait_us) {
+            rate_limit_count_rejection(inst, id);
+            return CAN_ESP_ERR_RATE_LIMITED;
+        }
+        TickType_t ticks = pdMS_TO_TICKS((uint32_t)((wait_us + 999) / 1000));
+        vTaskDelay((ticks > 0U) ? ticks : 1U);
+        delayed = true;
+        now = esp_timer_get_time();
+    }
+    return CAN_ESP_OK;
+}
+
+/* Devolve o token de um quadro admitido que não chegou a entrar na fila */
+static void rate_limit_refund(can_esp_handle_t inst, uint32_t id)
+{
+    if (inst->rateLimitCount == 0U) {
+        return;
+    }
+    portENTER_CRITICAL(&inst->rateLimitLock);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_RATE_LIMITS; i++) {
+        CanEspRateLimitEntry_t *entry = &inst->rateLimits[i];
+        if (rate_limit_matches(entry, id)) {
+            uint64_t capacity = (uint64_t)entry->config.burst * RATE_LIMIT_TOKEN;
+            entry->tokens = ((entry->tokens + RATE_LIMIT_TOKEN) > capacity) ? capacity : (entry->tokens + RATE_LIMIT_TOKEN);
+            if (entry->stats.admitted > 0U) {
+                entry->stats.admitted--;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&inst->rateLimitLock);
+}
+
+can_esp_status_t CAN_ESP_AddRateLimit_v2(can_esp_handle_t handle, const CanEspRateLimitConfig_t *config,
+                                         can_esp_rate_limit_t *limit)
+{
+    uint32_t slot = CAN_ESP_MAX_RATE_LIMITS;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (config == NULL) {
+        ESP_LOGE(TAG, "Configuração de limite de taxa nula.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (config->rate_per_s == 0U || config->rate_per_s > RATE_LIMIT_MAX_RATE || config->burst == 0U ||
+        (config->policy != CAN_ESP_RATE_LIMIT_DROP && config->policy != CAN_ESP_RATE_LIMIT_DELAY)) {
+        ESP_LOGE(TAG, "Limite de taxa inválido (taxa de 1 a %u quadros/s, rajada mínima de 1).",
+                 (unsigned int)RATE_LIMIT_MAX_RATE);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&handle->rateLimitLock);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_RATE_LIMITS; i++) {
+        if (!handle->rateLimits[i].in_use) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < CAN_ESP_MAX_RATE_LIMITS) {
+        CanEspRateLimitEntry_t *entry = &handle->rateLimits[slot];
+        (void)memset(entry, 0, sizeof(*entry));
+        entry->config = *config;
+        entry->tokens = (uint64_t)config->burst * RATE_LIMIT_TOKEN;
+        entry->last_refill_us = esp_timer_get_time();
+        entry->in_use = true;
+        handle->rateLimitCount++;
+    }
+    portEXIT_CRITICAL(&handle->rateLimitLock);
+
+    if (slot == CAN_ESP_MAX_RATE_LIMITS) {
+        ESP_LOGE(TAG, "Número máximo de limites de taxa atingido.");
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    ESP_LOGI(TAG, "Limite de taxa %u: ID 0x%08X, máscara 0x%08X, %u quadros/s, rajada %u.",
+             (unsigned int)slot, (unsigned int)config->id, (unsigned int)config->mask,
+             (unsigned int)config->rate_per_s, (unsigned int)config->burst);
+    if (limit != NULL) {
+        *limit = slot;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_AddRateLimit(const CanEspRateLimitConfig_t *config, can_esp_rate_limit_t *limit)
+{
+    return CAN_ESP_AddRateLimit_v2(&defaultInstance, config, limit);
+}
+
+can_esp_status_t CAN_ESP_RemoveRateLimit_v2(can_esp_handle_t handle, can_esp_rate_limit_t limit)
+{
+    bool removed = false;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (limit >= CAN_ESP_MAX_RATE_LIMITS) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&handle->rateLimitLock);
+    if (handle->rateLimits[limit].in_use) {
+        handle->rateLimits[limit].in_use = false;
+        handle->rateLimitCount--;
+        removed = true;
+    }
+    portEXIT_CRITICAL(&handle->rateLimitLock);
+    return removed ? CAN_ESP_OK : CAN_ESP_ERR_INVALID_PARAM;
+}
+
+can_esp_status_t CAN_ESP_RemoveRateLimit(can_esp_rate_limit_t limit)
+{
+    return CAN_ESP_RemoveRateLimit_v2(&defaultInstance, limit);
+}
+
+can_esp_status_t CAN_ESP_GetRateLimitStats_v2(can_esp_handle_t handle, can_esp_rate_limit_t limit,
+                                              CanEspRateLimitStats_t *stats)
+{
+    bool valid = false;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas de limite de taxa nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (limit >= CAN_ESP_MAX_RATE_LIMITS) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&handle->rateLimitLock);
+    if (handle->rateLimits[limit].in_use) {
+        CanEspRateLimitEntry_t *entry = &handle->rateLimits[limit];
+        rate_limit_refill(entry, now);
+        *stats = entry->stats;
+        stats->tokens = (uint32_t)(entry->tokens / RATE_LIMIT_TOKEN);
+        valid = true;
+    }
+    portEXIT_CRITICAL(&handle->rateLimitLock);
+    return valid ? CAN_ESP_OK : CAN_ESP_ERR_INVALID_PARAM;
+}
+
+can_esp_status_t CAN_ESP_GetRateLimitStats(can_esp_rate_limit_t limit, CanEspRateLimitStats_t *stats)
+{
+    return CAN_ESP_GetRateLimitStats_v2(&defaultInstance, limit, stats);
+}
+
+uint32_t CAN_ESP_GetRateLimitRejections_v2(can_esp_handle_t handle)
+{
+    uint32_t rejections;
+
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    portENTER_CRITICAL(&handle->rateLimitLock);
+    rejections = handle->rateLimitRejections;
+    portEXIT_CRITICAL(&handle->rateLimitLock);
+    return rejections;
+}
+
+uint32_t CAN_ESP_GetRateLimitRejections(void)
+{
+    return CAN_ESP_GetRateLimitRejections_v2(&defaultInstance);
+}
+
+/*==============================================================================
+                        FUNÇÕES DE COMUNICAÇÃO SÍNCRONA
+ ==============================================================================*/
+
+can_esp_status_t CAN_ESP_SendMessage_v2(can_esp_handle_t handle, uint32_t id, const uint8_t *data, uint8_t length)
+{
+    twai_message_t message;
+    CanEspMessage_t tracked = {0};
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (data == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de dados nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (length > CAN_MAX_DATA_LENGTH) {
+        ESP_LOGE(TAG, "Tamanho inválido dos dados. Máximo de %u bytes permitido.", (unsigned int)CAN_MAX_DATA_LENGTH);
+        return CAN_ESP_ERR_INVALID_LENGTH;
+    }
+    message.identifier = id;
+    message.data_length_code = length;
+    message.extd = 1U;
+    message.rtr = 0;
+    message.ss = 0;
+    message.self = handle->currentConfig.self_rx ? 1U : 0U;
+    memcpy(message.data, data, length);
+    if (handle->currentConfig.use_checksum) {
+        if (length < CAN_MAX_DATA_LENGTH) {
+            uint8_t cs = CAN_ESP_CalculateChecksum(data, length);
+            message.data[length] = cs;
+            message.data_length_code = length + 1;
+        } else {
+            ESP_LOGE(TAG, "Não há espaço para checksum nos dados.");
+            return CAN_ESP_ERR_INVALID_LENGTH;
+        }
+    }
+    if (rate_limit_admit(handle, id, esp_timer_get_time()) != CAN_ESP_OK) {
+        return CAN_ESP_ERR_RATE_LIMITED;
+    }
+    tracked.id = id;
+    tracked.length = length;
+    memcpy(tracked.data, data, length);
+    if (transmit_tracked(handle, &message, &tracked, pdMS_TO_TICKS(handle->currentConfig.transmit_timeout_ms)) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao transmitir mensagem CAN (ID: 0x%08X).", (unsigned int)id);
+        if (handle->transmit_callback != NULL) {
+            handle->transmit_callback(id, data, length, CAN_ESP_ERR_TRANSMIT);
+        }
+        return CAN_ESP_ERR_TRANSMIT;
+    }
+    account_frame(handle, &message, true, esp_timer_get_time());
+    if (handle->transmit_callback != NULL) {
+        handle->transmit_callback(id, data, length, CAN_ESP_OK);
+    }
+    return CAN_ESP_OK;
+}
+
+/* Transmite um quadro já no formato do driver, sem conversão nem checksum (reprodução de logs) */
+can_esp_status_t can_esp_transmit_raw_frame(can_esp_handle_t inst, const twai_message_t *frame)
+{
+    CanEspMessage_t tracked = {0};
+
+    tracked.id = frame->identifier;
+    tracked.length = (frame->data_length_code <= CAN_MAX_DATA_LENGTH) ? frame->data_length_code : CAN_MAX_DATA_LENGTH;
+    memcpy(tracked.data, frame->data, tracked.length);
+    if (transmit_tracked(inst, frame, &tracked, pdMS_TO_TICKS(inst->currentConfig.transmit_timeout_ms)) != ESP_OK) {
+        return CAN_ESP_ERR_TRANSMIT;
+    }
+    account_frame(inst, frame, true, esp_timer_get_time());
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_SendMessage(uint32_t id, const uint8_t *data, uint8_t length)
+{
+    return CAN_ESP_SendMessage_v2(&defaultInstance, id, data, length);
+}
+
+/* Função auxiliar para converter twai_message_t recebida em CanEspMessage_t (com verificação de checksum) */
+/* rx_time: instante em que o quadro foi retirado do driver (esp_timer_get_time) */
+static can_esp_status_t convert_twai_to_canesp(can_esp_handle_t inst, const twai_message_t *src, CanEspMessage_t *dst, int64_t rx_time)
+{
+    /* Todo quadro retirado do driver passa por aqui: contabiliza-o no bus load e por ID */
+    account_frame(inst, src, false, rx_time);
+    dst->id = src->identifier;
+    dst->length = src->data_length_code;
+    dst->retry_count = 0U;
+    dst->timestamp_us = rx_time;
+    memcpy(dst->data, src->data, src->data_length_code);
+    if (inst->currentConfig.use_checksum) {
+        if (dst->length < 1U) {
+            ESP_LOGE(TAG, "Mensagem recebida sem dados para checksum.");
+            return CAN_ESP_ERR_RECEIVE;
+        }
+        uint8_t calc_cs = CAN_ESP_CalculateChecksum(dst->data, dst->length - 1);
+        if (calc_cs != dst->data[dst->length - 1]) {
+            ESP_LOGE(TAG, "Falha na verificação de checksum para a mensagem (ID: 0x%08X).", (unsigned int)dst->id);
+            return CAN_ESP_ERR_RECEIVE;
+        }
+        dst->length -= 1;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_ReceiveMessage_v2(can_esp_handle_t handle, CanEspMessage_t *message, uint32_t timeout_ms)
+{
+    twai_message_t rx_message;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (message == NULL) {
+        ESP_LOGE(TAG, "Ponteiro para mensagem nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (drv_receive(handle, &rx_message, pdMS_TO_TICKS(timeout_ms)) == ESP_OK) {
+        return convert_twai_to_canesp(handle, &rx_message, message, esp_timer_get_time());
+    }
+    ESP_LOGE(TAG, "Timeout ou erro ao receber mensagem CAN.");
+    return CAN_ESP_ERR_TIMEOUT;
+}
+
+can_esp_status_t CAN_ESP_ReceiveMessage(CanEspMessage_t *message, uint32_t timeout_ms)
+{
+    return CAN_ESP_ReceiveMessage_v2(&defaultInstance, message, timeout_ms);
+}
+
+can_esp_status_t CAN_ESP_ReceiveBatch_v2(can_esp_handle_t handle, CanEspMessage_t *out, size_t max, uint32_t timeout_ms, size_t *count)
+{
+    twai_message_t rx_message;
+    TickType_t wait_ticks = pdMS_TO_TICKS(timeout_ms);
+    size_t received = 0U;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (out == NULL || count == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na recepção em lote.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    *count = 0U;
+    if (max == 0U) {
+        return CAN_ESP_ERR_INVALID_LENGTH;
+    }
+    /* Somente o primeiro quadro aguarda; os demais são drenados com timeout zero */
+    while (received < max && drv_receive(handle, &rx_message, wait_ticks) == ESP_OK) {
+        wait_ticks = 0;
+        if (convert_twai_to_canesp(handle, &rx_message, &out[received], esp_timer_get_time()) == CAN_ESP_OK) {
+            received++;
+        }
+    }
+    *count = received;
+    return (received > 0U) ? CAN_ESP_OK : CAN_ESP_ERR_TIMEOUT;
+}
+
+can_esp_status_t CAN_ESP_ReceiveBatch(CanEspMessage_t *out, size_t max, uint32_t timeout_ms, size_t *count)
+{
+    return CAN_ESP_ReceiveBatch_v2(&defaultInstance, out, max, timeout_ms, count);
+}
+
+/* Função para registrar callback de recepção */
+can_esp_status_t CAN_ESP_RegisterReceiveCallback_v2(can_esp_handle_t handle, can_esp_receive_callback_t callback)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (callback == NULL) {
+        ESP_LOGE(TAG, "Tentativa de registrar callback de recepção nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    handle->receive_callback = callback;
+    ESP_LOGI(TAG, "Callback de recepção registrado com sucesso.");
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_RegisterReceiveCallback(can_esp_receive_callback_t callback)
+{
+    return CAN_ESP_RegisterReceiveCallback_v2(&defaultInstance, callback);
+}
+
+/*==============================================================================
+            TABELA DE DESPACHO POR INSCRIÇÃO (ID / MÓDULO-COMANDO / MÁSCARA)
+ ==============================================================================*/
+
+/* Reconstrói o índice de despacho; deve ser chamada com subscriptionMutex adquirido */
+static void rebuild_dispatch_table(can_esp_handle_t inst)
+{
+    uint16_t count = 0U;
+    uint16_t i, j;
+
+    inst->dispatchGroupCount = 0U;
+    for (i = 0U; i < CAN_ESP_MAX_SUBSCRIPTIONS; i++) {
+        if (!inst->subscriptions[i].in_use) {
+            continue;
+        }
+        /* Localiza (ou cria) o grupo da máscara desta inscrição */
+        for (j = 0U; j < inst->dispatchGroupCount; j++) {
+            if (inst->dispatchGroups[j].mask == inst->subscriptions[i].mask) {
+                break;
+            }
+        }
+        if (j == inst->dispatchGroupCount) {
+            inst->dispatchGroups[j].mask = inst->subscriptions[i].mask;
+            inst->dispatchGroups[j].length = 0U;
+            inst->dispatchGroupCount++;
+        }
+        inst->dispatchGroups[j].length++;
+    }
+    /* Distribui as entradas por grupo e ordena cada grupo pela chave (inserção estável) */
+    for (j = 0U; j < inst->dispatchGroupCount; j++) {
+        uint16_t start = count;
+        inst->dispatchGroups[j].start = start;
+        for (i = 0U; i < CAN_ESP_MAX_SUBSCRIPTIONS; i++) {
+            if (!inst->subscriptions[i].in_use || inst->subscriptions[i].mask != inst->dispatchGroups[j].mask) {
+                continue;
+            }
+            CanEspDispatchEntry_t entry = { inst->subscriptions[i].id & inst->subscriptions[i].mask, i };
+            uint16_t pos = count;
+            while (pos > start && inst->dispatchIndex[pos - 1U].key > entry.key) {
+                inst->dispatchIndex[pos] = inst->dispatchIndex[pos - 1U];
+                pos--;
+            }
+            inst->dispatchIndex[pos] = entry;
+            count++;
+        }
+    }
+}
+
+/*
+ * Entrega a mensagem ao callback global e a todas as inscrições coincidentes. Os pares
+ * handler/contexto são copiados sob subscriptionMutex e chamados após liberá-lo, de modo que um
+ * handler lento não bloqueia (des)inscrições e pode ele próprio (des)inscrever-se.
+ */
+static void dispatch_received_message(can_esp_handle_t inst, const CanEspMessage_t *msg)
+{
+    can_esp_subscription_handler_t handlers[CAN_ESP_MAX_SUBSCRIPTIONS];
+    void *contexts[CAN_ESP_MAX_SUBSCRIPTIONS];
+    uint32_t count = 0U;
+    uint16_t g;
+    bool matched = (inst->receive_callback != NULL);
+
+    inst->dispatchedFrames++;
+    if (inst->receive_callback != NULL) {
+        inst->receive_callback(msg);
+    }
+    if (inst->subscriptionMutex == NULL) {
+        if (!matched) {
+            inst->unmatchedFrames++;
+        }
+        return;
+    }
+    xSemaphoreTake(inst->subscriptionMutex, portMAX_DELAY);
+    for (g = 0U; g < inst->dispatchGroupCount; g++) {
+        const CanEspDispatchGroup_t *group = &inst->dispatchGroups[g];
+        uint32_t key = msg->id & group->mask;
+        uint16_t lo = group->start;
+        uint16_t hi = (uint16_t)(group->start + group->length);
+        /* Busca binária pela primeira entrada com chave >= key */
+        while (lo < hi) {
+            uint16_t mid = (uint16_t)(lo + ((hi - lo) / 2U));
+            if (inst->dispatchIndex[mid].key < key) {
+                lo = (uint16_t)(mid + 1U);
+            } else {
+                hi = mid;
+            }
+        }
+        for (; lo < group->start + group->length && inst->dispatchIndex[lo].key == key; lo++) {
+            const CanEspSubscription_t *sub = &inst->subscriptions[inst->dispatchIndex[lo].sub];
+            handlers[count] = sub->handler;
+            contexts[count] = sub->ctx;
+            count++;
+        }
+    }
+    xSemaphoreGive(inst->subscriptionMutex);
+    for (uint32_t i = 0U; i < count; i++) {
+        handlers[i](msg, contexts[i]);
+        matched = true;
+    }
+    if (!matched) {
+        /* Filtro de software: aceito pelo hardware, mas sem interessados */
+        inst->unmatchedFrames++;
+    }
+}
+
+can_esp_status_t CAN_ESP_Subscribe_v2(can_esp_handle_t handle, uint32_t id, uint32_t mask, can_esp_subscription_handler_t handler,
+                                      void *ctx, can_esp_subscription_t *subscription)
+{
+    uint16_t i;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (handler == NULL) {
+        ESP_LOGE(TAG, "Tentativa de registrar inscrição com handler nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (handle->subscriptionMutex == NULL) {
+        handle->subscriptionMutex = xSemaphoreCreateMutex();
+        if (handle->subscriptionMutex == NULL) {
+            ESP_LOGE(TAG, "Falha ao criar mutex de inscrições.");
+            return CAN_ESP_ERR_UNKNOWN;
+        }
+    }
+    xSemaphoreTake(handle->subscriptionMutex, portMAX_DELAY);
+    for (i = 0U; i < CAN_ESP_MAX_SUBSCRIPTIONS; i++) {
+        if (!handle->subscriptions[i].in_use) {
+            break;
+        }
+    }
+    if (i == CAN_ESP_MAX_SUBSCRIPTIONS) {
+        xSemaphoreGive(handle->subscriptionMutex);
+        ESP_LOGE(TAG, "Tabela de inscrições cheia (%u).", (unsigned int)CAN_ESP_MAX_SUBSCRIPTIONS);
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    handle->subscriptions[i].id = id & CAN_ESP_ID_MASK_EXACT;
+    handle->subscriptions[i].mask = mask & CAN_ESP_ID_MASK_EXACT;
+    handle->subscriptions[i].handler = handler;
+    handle->subscriptions[i].ctx = ctx;
+    handle->subscriptions[i].in_use = true;
+    rebuild_dispatch_table(handle);
+    xSemaphoreGive(handle->subscriptionMutex);
+    if (subscription != NULL) {
+        *subscription = i;
+    }
+    ESP_LOGI(TAG, "Inscrição %u registrada (ID: 0x%08X, máscara: 0x%08X).",
+             (unsigned int)i, (unsigned int)id, (unsigned int)mask);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_Subscribe(uint32_t id, uint32_t mask, can_esp_subscription_handler_t handler,
+                                   void *ctx, can_esp_subscription_t *subscription)
+{
+    return CAN_ESP_Subscribe_v2(&defaultInstance, id, mask, handler, ctx, subscription);
+}
+
+can_esp_status_t CAN_ESP_SubscribeId_v2(can_esp_handle_t handle, uint32_t id, can_esp_subscription_handler_t handler,
+                                        void *ctx, can_esp_subscription_t *subscription)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    return CAN_ESP_Subscribe_v2(handle, id, CAN_ESP_ID_MASK_EXACT, handler, ctx, subscription);
+}
+
+can_esp_status_t CAN_ESP_SubscribeId(uint32_t id, can_esp_subscription_handler_t handler,
+                                     void *ctx, can_esp_subscription_t *subscription)
+{
+    return CAN_ESP_SubscribeId_v2(&defaultInstance, id, handler, ctx, subscription);
+}
+
+can_esp_status_t CAN_ESP_SubscribeModuleCommand_v2(can_esp_handle_t handle, uint16_t module, uint16_t command, can_esp_subscription_handler_t handler,
+                                                   void *ctx, can_esp_subscription_t *subscription)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    return CAN_ESP_Subscribe_v2(handle, CAN_ESP_EncodeID(0U, module, command), CAN_ESP_ID_MASK_MODULE_COMMAND,
+                             handler, ctx, subscription);
+}
+
+can_esp_status_t CAN_ESP_SubscribeModuleCommand(uint16_t module, uint16_t command, can_esp_subscription_handler_t handler,
+                                                void *ctx, can_esp_subscription_t *subscription)
+{
+    return CAN_ESP_SubscribeModuleCommand_v2(&defaultInstance, module, command, handler, ctx, subscription);
+}
+
+can_esp_status_t CAN_ESP_Unsubscribe_v2(can_esp_handle_t handle, can_esp_subscription_t subscription)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (handle->subscriptionMutex == NULL || subscription >= CAN_ESP_MAX_SUBSCRIPTIONS) {
+        ESP_LOGE(TAG, "Inscrição inválida (%u).", (unsigned int)subscription);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    xSemaphoreTake(handle->subscriptionMutex, portMAX_DELAY);
+    if (!handle->subscriptions[subscription].in_use) {
+        xSemaphoreGive(handle->subscriptionMutex);
+        ESP_LOGE(TAG, "Inscrição %u não está registrada.", (unsigned int)subscription);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    handle->subscriptions[subscription].in_use = false;
+    rebuild_dispatch_table(handle);
+    xSemaphoreGive(handle->subscriptionMutex);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_Unsubscribe(can_esp_subscription_t subscription)
+{
+    return CAN_ESP_Unsubscribe_v2(&defaultInstance, subscription);
+}
+
+/*==============================================================================
+            SÍNTESE DO FILTRO DE ACEITAÇÃO A PARTIR DAS INSCRIÇÕES
+ ==============================================================================*/
+
+#define FILTER_ID_BITS           (29U)
+#define FILTER_DUAL_CARE_MASK    (0x1FFFE000U)  /* Filtro duplo compara apenas ID[28:13] */
+
+/* Acumulador de um filtro código/máscara: bits "care" em que todas as inscrições concordam */
+typedef struct {
+    uint32_t care;
+    uint32_t value;
+    bool empty;
+} CanEspFilterAcc_t;
+
+static void filter_acc_add(CanEspFilterAcc_t *acc, uint32_t id, uint32_t mask)
+{
+    if (acc->empty) {
+        acc->care = mask;
+        acc->value = id & mask;
+        acc->empty = false;
+    } else {
+        acc->care &= mask & ~(acc->value ^ id);
+        acc->value &= acc->care;
+    }
+}
+
+/* Número de IDs de 29 bits aceitos por um conjunto de bits "care" */
+static uint64_t filter_space(uint32_t care)
+{
+    return 1ULL << (FILTER_ID_BITS - (uint32_t)__builtin_popcount(care & CAN_ESP_ID_MASK_EXACT));
+}
+
+/* IDs aceitos por dois filtros (união), descontando a interseção quando compatíveis */
+static uint64_t filter_union_space(const CanEspFilterAcc_t *a, const CanEspFilterAcc_t *b)
+{
+    uint64_t space = filter_space(a->care) + filter_space(b->care);
+    if (((a->value ^ b->value) & a->care & b->care) == 0U) {
+        space -= filter_space(a->care | b->care);
+    }
+    return space;
+}
+
+can_esp_status_t CAN_ESP_SynthesizeFilter_v2(can_esp_handle_t handle, CanEspFilterReport_t *report)
+{
+    CanEspDispatchEntry_t sorted[CAN_ESP_MAX_SUBSCRIPTIONS];
+    CanEspFilterAcc_t single = { 0U, 0U, true };
+    uint16_t count = 0U;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    uint16_t i, k;
+
+    if (report == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de relatório de filtro nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    (void)memset(report, 0, sizeof(*report));
+    report->filter = (twai_filter_config_t)TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    report->accepted_id_space = 1ULL << FILTER_ID_BITS;
+    report->observed_dispatched = handle->dispatchedFrames;
+    report->observed_unmatched = handle->unmatchedFrames;
+
+    if (handle->subscriptionMutex != NULL) {
+        xSemaphoreTake(handle->subscriptionMutex, portMAX_DELAY);
+        /* O índice de despacho já está agrupado; reordena tudo pela chave para as divisões */
+        for (i = 0U; i < CAN_ESP_MAX_SUBSCRIPTIONS; i++) {
+            if (!handle->subscriptions[i].in_use) {
+                continue;
+            }
+            CanEspDispatchEntry_t entry = { handle->subscriptions[i].id & handle->subscriptions[i].mask, i };
+            k = count;
+            while (k > 0U && sorted[k - 1U].key > entry.key) {
+                sorted[k] = sorted[k - 1U];
+                k--;
+            }
+            sorted[k] = entry;
+            count++;
+            filter_acc_add(&single, handle->subscriptions[i].id, handle->subscriptions[i].mask);
+            report->subscribed_id_space += filter_space(handle->subscriptions[i].mask);
+        }
+        xSemaphoreGive(handle->subscriptionMutex);
+    }
+    report->subscriptions = count;
+    report->accept_all = (handle->receive_callback != NULL) || (count == 0U);
+    if (report->accept_all) {
+        report->subscribed_id_space = report->accepted_id_space;
+        return CAN_ESP_OK;
+    }
+
+    /* Filtro simples: 29 bits de ID em [31:3]; RTR e bits livres são "don't care" */
+    uint64_t best_space = filter_space(single.care);
+    report->filter.single_filter = true;
+    report->filter.acceptance_code = single.value << 3;
+    report->filter.acceptance_mask = (~single.care << 3) | 0x7U;
+
+    /* Filtro duplo: testa todas as divisões contíguas da lista ordenada em dois grupos */
+    for (k = 1U; k < count; k++) {
+        CanEspFilterAcc_t first = { 0U, 0U, true };
+        CanEspFilterAcc_t second = { 0U, 0U, true };
+        for (i = 0U; i < count; i++) {
+            const CanEspSubscription_t *sub = &handle->subscriptions[sorted[i].sub];
+            filter_acc_add((i < k) ? &first : &second, sub->id, sub->mask & FILTER_DUAL_CARE_MASK);
+        }
+        uint64_t space = filter_union_space(&first, &second);
+        if (space < best_space) {
+            best_space = space;
+            report->filter.single_filter = false;
+            report->filter.acceptance_code = ((first.value >> 13) << 16) | (second.value >> 13);
+            report->filter.acceptance_mask = ((~(first.care >> 13) & 0xFFFFU) << 16) |
+                                             (~(second.care >> 13) & 0xFFFFU);
+        }
+    }
+
+    report->accepted_id_space = best_space;
+    if (report->subscribed_id_space > best_space) {
+        report->subscribed_id_space = best_space;
+    }
+    report->estimated_false_accept_ppm = (uint32_t)(((best_space - report->subscribed_id_space) * 1000000ULL) / best_space);
+    report->estimated_hw_reject_ppm = (uint32_t)((((1ULL << FILTER_ID_BITS) - best_space) * 1000000ULL) >> FILTER_ID_BITS);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_SynthesizeFilter(CanEspFilterReport_t *report)
+{
+    return CAN_ESP_SynthesizeFilter_v2(&defaultInstance, report);
+}
+
+can_esp_status_t CAN_ESP_ApplySynthesizedFilter_v2(can_esp_handle_t handle, CanEspFilterReport_t *report)
+{
+    CanEspFilterReport_t local_report;
+    CanEspFilterReport_t *out = (report != NULL) ? report : &local_report;
+    can_esp_status_t status = CAN_ESP_SynthesizeFilter_v2(handle, out);
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (status != CAN_ESP_OK) {
+        return status;
+    }
+    ESP_LOGI(TAG, "Filtro sintetizado (%s): código 0x%08X, máscara 0x%08X, falso aceite estimado %" PRIu32 " ppm.",
+             out->filter.single_filter ? "simples" : "duplo",
+             (unsigned int)out->filter.acceptance_code, (unsigned int)out->filter.acceptance_mask,
+             out->estimated_false_accept_ppm);
+    return CAN_ESP_SetFilterConfig_v2(handle, &out->filter);
+}
+
+can_esp_status_t CAN_ESP_ApplySynthesizedFilter(CanEspFilterReport_t *report)
+{
+    return CAN_ESP_ApplySynthesizedFilter_v2(&defaultInstance, report);
+}
+
+/* Processa mensagens recebidas (em lote) chamando o callback registrado */
+void CAN_ESP_ProcessReceivedMessages_v2(can_esp_handle_t handle)
+{
+    CanEspMessage_t received_msgs[CAN_PROCESS_BATCH_SIZE];
+    size_t count = 0U;
+
+    if (handle == NULL) {
+        return;
+    }
+
+    if (CAN_ESP_ReceiveBatch_v2(handle, received_msgs, CAN_PROCESS_BATCH_SIZE, CAN_PROCESS_TIMEOUT_MS, &count) == CAN_ESP_OK) {
+        for (size_t i = 0U; i < count; i++) {
+            if (handle->currentConfig.debug_level >= 2) {
+                ESP_LOGI(TAG, "Mensagem recebida - ID: 0x%08X, Length: %u",
+                         (unsigned int)received_msgs[i].id, (unsigned int)received_msgs[i].length);
+            }
+            dispatch_received_message(handle, &received_msgs[i]);
+        }
+    }
+}
+
+void CAN_ESP_ProcessReceivedMessages(void)
+{
+    CAN_ESP_ProcessReceivedMessages_v2(&defaultInstance);
+}
+
+/*==============================================================================
+                    FUNÇÕES DE TRANSMISSÃO ASSÍNCRONA
+ ==============================================================================*/
+
+can_esp_status_t CAN_ESP_EnqueueMessage_v2(can_esp_handle_t handle, const CanEspMessage_t *msg, bool high_priority)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    return CAN_ESP_EnqueueBatch_v2(handle, msg, 1U, high_priority);
+}
+
+can_esp_status_t CAN_ESP_EnqueueMessage(const CanEspMessage_t *msg, bool high_priority)
+{
+    return CAN_ESP_EnqueueMessage_v2(&defaultInstance, msg, high_priority);
+}
+
+/* Acorda a tarefa de transmissão quando a fila deixa de estar vazia */
+static void notify_transmit_task(can_esp_handle_t inst, bool was_empty)
+{
+    if (was_empty && inst->canTxTaskHandle != NULL) {
+        xTaskNotifyGive(inst->canTxTaskHandle);
+    }
+}
+
+can_esp_status_t CAN_ESP_EnqueueBatch_v2(can_esp_handle_t handle, const CanEspMessage_t *msgs, size_t count, bool high_priority)
+{
+    bool was_empty = false;
+    bool more_waiters = false;
+    int64_t start;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (msgs == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de mensagem nulo ao enfileirar.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (handle->txSpaceSemaphore == NULL) {
+        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    if (count == 0U || count > CAN_ESP_TX_LEVEL_QUEUE_LENGTH) {
+        ESP_LOGE(TAG, "Tamanho de lote inválido (%u). Máximo de %u mensagens.",
+                 (unsigned int)count, (unsigned int)CAN_ESP_TX_LEVEL_QUEUE_LENGTH);
+        return CAN_ESP_ERR_INVALID_LENGTH;
+    }
+    /*
+     * O lote é atômico também na admissão: uma recusa devolve os tokens já consumidos. A espera
+     * máxima dos limites DELAY vale para o lote inteiro, contada a partir deste instante.
+     */
+    start = esp_timer_get_time();
+    for (size_t i = 0U; i < count; i++) {
+        if (rate_limit_admit(handle, msgs[i].id, start) != CAN_ESP_OK) {
+            while (i > 0U) {
+                i--;
+                rate_limit_refund(handle, msgs[i].id);
+            }
+            return CAN_ESP_ERR_RATE_LIMITED;
+        }
+    }
+    for (;;) {
+        if (tx_ring_push_batch(handle, msgs, count, high_priority, true, &was_empty) == count) {
+            break;
+        }
+        /* Sem espaço para o lote inteiro: já registrado como aguardando, bloqueia */
+        (void)xSemaphoreTake(handle->txSpaceSemaphore, portMAX_DELAY);
+        portENTER_CRITICAL(&handle->txRingLock);
+        handle->txWaiters--;
+        portEXIT_CRITICAL(&handle->txRingLock);
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    more_waiters = (handle->txWaiters > 0U);
+    portEXIT_CRITICAL(&handle->txRingLock);
+    if (more_waiters) {
+        /* Repassa o sinal de espaço livre a outro produtor bloqueado */
+        (void)xSemaphoreGive(handle->txSpaceSemaphore);
+    }
+    notify_transmit_task(handle, was_empty);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_EnqueueBatch(const CanEspMessage_t *msgs, size_t count, bool high_priority)
+{
+    return CAN_ESP_EnqueueBatch_v2(&defaultInstance, msgs, count, high_priority);
+}
+
+can_esp_status_t CAN_ESP_TryEnqueueBatch_v2(can_esp_handle_t handle, const CanEspMessage_t *msgs, size_t count, bool high_priority, size_t *accepted)
+{
+    bool was_empty = false;
+    size_t admitted = 0U;
+    size_t inserted;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (msgs == NULL || accepted == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo ao enfileirar lote.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    *accepted = 0U;
+    if (handle->txSpaceSemaphore == NULL) {
+        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    while (admitted < count && rate_limit_admit(handle, msgs[admitted].id, RATE_LIMIT_NO_WAIT) == CAN_ESP_OK) {
+        admitted++;
+    }
+    inserted = tx_ring_push_batch(handle, msgs, admitted, high_priority, false, &was_empty);
+    for (size_t i = inserted; i < admitted; i++) {
+        rate_limit_refund(handle, msgs[i].id);
+    }
+    *accepted = inserted;
+    if (inserted > 0U) {
+        notify_transmit_task(handle, was_empty);
+    }
+    if (inserted == count) {
+        return CAN_ESP_OK;
+    }
+    return (inserted < admitted) ? CAN_ESP_ERR_QUEUE_FULL : CAN_ESP_ERR_RATE_LIMITED;
+}
+
+can_esp_status_t CAN_ESP_TryEnqueueBatch(const CanEspMessage_t *msgs, size_t count, bool high_priority, size_t *accepted)
+{
+    return CAN_ESP_TryEnqueueBatch_v2(&defaultInstance, msgs, count, high_priority, accepted);
+}
+
+can_esp_status_t CAN_ESP_AllocMessage_v2(can_esp_handle_t handle, CanEspMessage_t **msg)
+{
+    uint16_t slot = 0U;
+    bool allocated;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (msg == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de mensagem nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    *msg = NULL;
+    if (handle->txSpaceSemaphore == NULL) {
+        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    allocated = msg_pool_alloc_locked(handle, &slot, POOL_SLOT_CALLER);
+    portEXIT_CRITICAL(&handle->txRingLock);
+    if (!allocated) {
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    *msg = &handle->msgPool[slot];
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_AllocMessage(CanEspMessage_t **msg)
+{
+    return CAN_ESP_AllocMessage_v2(&defaultInstance, msg);
+}
+
+/* Verifica se o slot está com o produtor, contabilizando o uso indevido */
+static bool msg_pool_owned_by_caller(can_esp_handle_t inst, uint32_t slot)
+{
+    bool owned;
+
+    portENTER_CRITICAL(&inst->txRingLock);
+    owned = (inst->msgPoolOwner[slot] == POOL_SLOT_CALLER);
+    if (!owned) {
+        inst->msgPoolStats.invalid_releases++;
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    return owned;
+}
+
+can_esp_status_t CAN_ESP_EnqueuePooledMessage_v2(can_esp_handle_t handle, CanEspMessage_t *msg, bool high_priority)
+{
+    uint32_t slot = msg_pool_index(handle, msg);
+    uint8_t level;
+    bool was_empty;
+    bool queued = false;
+    bool owned = true;
+    bool supersede;
+    bool wake_producer = false;
+    int64_t deadline;
+    int64_t now = esp_timer_get_time();
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (slot == CAN_ESP_MSG_POOL_SIZE) {
+        ESP_LOGE(TAG, "Mensagem não pertence ao pool de transmissão.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (!msg_pool_owned_by_caller(handle, slot)) {
+        ESP_LOGE(TAG, "Slot do pool não está com o produtor (livre ou já enfileirado).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (rate_limit_admit(handle, msg->id, RATE_LIMIT_NO_WAIT) != CAN_ESP_OK) {
+        return CAN_ESP_ERR_RATE_LIMITED;
+    }
+    level = tx_level_of(msg, high_priority);
+    portENTER_CRITICAL(&handle->txRingLock);
+    was_empty = (handle->txTotalCount == 0U);
+    if (handle->msgPoolOwner[slot] != POOL_SLOT_CALLER) {
+        /* Devolvido ou enfileirado por outra tarefa desde a verificação */
+        handle->msgPoolStats.invalid_releases++;
+        owned = false;
+    } else if (tx_policy_apply_locked(handle, msg, level, now, &deadline, &supersede)) {
+        /* O valor foi copiado para o slot já enfileirado: o slot do chamador volta ao pool */
+        wake_producer = msg_pool_free_locked(handle, (uint16_t)slot);
+        queued = true;
+    } else if (handle->txLevels[level].count < CAN_ESP_TX_LEVEL_QUEUE_LENGTH) {
+        msg->retry_count = 0U;
+        handle->msgPoolOwner[slot] = POOL_SLOT_LIBRARY;
+        handle->msgPoolDeadline[slot] = deadline;
+        tx_ring_push_locked(handle, (uint16_t)slot, level, false);
+        if (supersede) {
+            tx_supersede_older_locked(handle, msg->id, (uint16_t)slot);
+        }
+        queued = true;
+    }
+    portEXIT_CRITICAL(&handle->txRingLock);
+    if (!owned) {
+        rate_limit_refund(handle, msg->id);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (!queued) {
+        rate_limit_refund(handle, msg->id);
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    if (wake_producer) {
+        (void)xSemaphoreGive(handle->txSpaceSemaphore);
+    }
+    notify_transmit_task(handle, was_empty);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_EnqueuePooledMessage(CanEspMessage_t *msg, bool high_priority)
+{
+    return CAN_ESP_EnqueuePooledMessage_v2(&defaultInstance, msg, high_priority);
+}
+
+can_esp_status_t CAN_ESP_FreeMessage_v2(can_esp_handle_t handle, CanEspMessage_t *msg)
+{
+    uint32_t slot;
+    bool owned = false;
+    bool wake_producer = false;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    slot = msg_pool_index(handle, msg);
+
+    if (slot == CAN_ESP_MSG_POOL_SIZE) {
+        ESP_LOGE(TAG, "Mensagem não pertence ao pool de transmissão.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    if (handle->msgPoolOwner[slot] == POOL_SLOT_CALLER) {
+        wake_producer = msg_pool_free_locked(handle, (uint16_t)slot);
+        owned = true;
+    } else {
+        handle->msgPoolStats.invalid_releases++;
+    }
+    portEXIT_CRITICAL(&handle->txRingLock);
+    if (!owned) {
+        ESP_LOGE(TAG, "Slot do pool não está com o produtor (já devolvido ou enfileirado).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (wake_producer) {
+        (void)xSemaphoreGive(handle->txSpaceSemaphore);
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_FreeMessage(CanEspMessage_t *msg)
+{
+    return CAN_ESP_FreeMessage_v2(&defaultInstance, msg);
+}
+
+can_esp_status_t CAN_ESP_GetMessagePoolStats_v2(can_esp_handle_t handle, CanEspPoolStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas do pool nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    *stats = handle->msgPoolStats;
+    stats->capacity = CAN_ESP_MSG_POOL_SIZE;
+    stats->in_use = handle->msgPoolInitialized ? (CAN_ESP_MSG_POOL_SIZE - handle->msgPoolFreeCount) : 0U;
+    portEXIT_CRITICAL(&handle->txRingLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetMessagePoolStats(CanEspPoolStats_t *stats)
+{
+    return CAN_ESP_GetMessagePoolStats_v2(&defaultInstance, stats);
+}
+
+can_esp_status_t CAN_ESP_AddTxDeadlinePolicy_v2(can_esp_handle_t handle, const CanEspTxDeadlinePolicy_t *policy,
+                                                can_esp_tx_policy_t *policy_handle)
+{
+    uint32_t slot = CAN_ESP_MAX_TX_DEADLINE_POLICIES;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (policy == NULL) {
+        ESP_LOGE(TAG, "Política de prazo nula.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (policy->lifetime_us == 0U && !policy->replace_queued) {
+        ESP_LOGE(TAG, "Política de prazo sem prazo nem substituição.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_TX_DEADLINE_POLICIES; i++) {
+        if (!handle->txPolicies[i].in_use) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < CAN_ESP_MAX_TX_DEADLINE_POLICIES) {
+        handle->txPolicies[slot].policy = *policy;
+        handle->txPolicies[slot].in_use = true;
+        handle->txPolicyCount++;
+    }
+    portEXIT_CRITICAL(&handle->txRingLock);
+
+    if (slot == CAN_ESP_MAX_TX_DEADLINE_POLICIES) {
+        ESP_LOGE(TAG, "Número máximo de políticas de prazo atingido.");
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    ESP_LOGI(TAG, "Política de prazo %u: ID 0x%08X, máscara 0x%08X, validade %" PRIu32 " us%s.",
+             (unsigned int)slot, (unsigned int)policy->id, (unsigned int)policy->mask, policy->lifetime_us,
+             policy->replace_queued ? ", substituição" : "");
+    if (policy_handle != NULL) {
+        *policy_handle = slot;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_AddTxDeadlinePolicy(const CanEspTxDeadlinePolicy_t *policy, can_esp_tx_policy_t *handle)
+{
+    return CAN_ESP_AddTxDeadlinePolicy_v2(&defaultInstance, policy, handle);
+}
+
+can_esp_status_t CAN_ESP_RemoveTxDeadlinePolicy_v2(can_esp_handle_t handle, can_esp_tx_policy_t policy_handle)
+{
+    bool removed = false;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (policy_handle >= CAN_ESP_MAX_TX_DEADLINE_POLICIES) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    /* Os prazos já atribuídos aos quadros na fila são mantidos */
+    portENTER_CRITICAL(&handle->txRingLock);
+    if (handle->txPolicies[policy_handle].in_use) {
+        handle->txPolicies[policy_handle].in_use = false;
+        handle->txPolicyCount--;
+        removed = true;
+    }
+    portEXIT_CRITICAL(&handle->txRingLock);
+    return removed ? CAN_ESP_OK : CAN_ESP_ERR_INVALID_PARAM;
+}
+
+can_esp_status_t CAN_ESP_RemoveTxDeadlinePolicy(can_esp_tx_policy_t handle)
+{
+    return CAN_ESP_RemoveTxDeadlinePolicy_v2(&defaultInstance, handle);
+}
+
+can_esp_status_t CAN_ESP_GetTxDeadlineStats_v2(can_esp_handle_t handle, CanEspTxDeadlineStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas de prazo nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->txRingLock);
+    *stats = handle->txDeadlineStats;
+    portEXIT_CRITICAL(&handle->txRingLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetTxDeadlineStats(CanEspTxDeadlineStats_t *stats)
+{
+    return CAN_ESP_GetTxDeadlineStats_v2(&defaultInstance, stats);
+}
+
+/*
+ * Ajusta dinamicamente a prioridade da tarefa de transmissão com base na saturação da fila.
+ * A elevação ocorre ao atingir tx_boost_high_pct e só é desfeita abaixo de tx_boost_low_pct;
+ * entre os dois limiares nada muda, e vTaskPrioritySet só é chamado nas transições.
+ */
+can_esp_status_t CAN_ESP_AdjustTransmitTaskPriority_v2(can_esp_handle_t handle)
+{
+    UBaseType_t count = 0U;
+    UBaseType_t basePriority;
+    UBaseType_t boostPriority;
+    UBaseType_t highCount;
+    UBaseType_t lowCount;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (handle->txSpaceSemaphore == NULL || handle->canTxTaskHandle == NULL) {
+        ESP_LOGE(TAG, "Fila de transmissão ou handle da tarefa nula.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    /* A saturação é medida pelo nível de prioridade mais ocupado */
+    portENTER_CRITICAL(&handle->txRingLock);
+    for (uint8_t level = 0U; level < CAN_ESP_NUM_PRIORITY_LEVELS; level++) {
+        if (handle->txLevels[level].count > count) {
+            count = handle->txLevels[level].count;
+        }
+    }
+    basePriority = handle->taskConfig.transmit.priority;
+    boostPriority = handle->taskConfig.tx_boost_priority;
+    highCount = ((UBaseType_t)CAN_ESP_TX_LEVEL_QUEUE_LENGTH * handle->taskConfig.tx_boost_high_pct) / 100U;
+    lowCount = ((UBaseType_t)CAN_ESP_TX_LEVEL_QUEUE_LENGTH * handle->taskConfig.tx_boost_low_pct) / 100U;
+    portEXIT_CRITICAL(&handle->txRingLock);
+
+    if (boostPriority <= basePriority) {
+        return CAN_ESP_OK;
+    }
+    if (!handle->txPriorityBoosted && count >= highCount) {
+        handle->txPriorityBoosted = true;
+        ESP_LOGI(TAG, "Alta saturação da fila (%u mensagens). Aumentando prioridade para %u.",
+                 (unsigned int)count, (unsigned int)boostPriority);
+        vTaskPrioritySet(handle->canTxTaskHandle, boostPriority);
+    } else if (handle->txPriorityBoosted && count < lowCount) {
+        handle->txPriorityBoosted = false;
+        ESP_LOGI(TAG, "Fila abaixo do limiar (%u mensagens). Restaurando prioridade para %u.",
+                 (unsigned int)count, (unsigned int)basePriority);
+        vTaskPrioritySet(handle->canTxTaskHandle, basePriority);
+    } else {
+        /* Dentro da histerese: mantém a prioridade atual */
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_AdjustTransmitTaskPriority(void)
+{
+    return CAN_ESP_AdjustTransmitTaskPriority_v2(&defaultInstance);
+}
+
+/*==============================================================================
+          RODA DE TEMPORIZAÇÃO PARA RETRANSMISSÕES (TIMER WHEEL)
+ ==============================================================================*/
+
+#define RETRY_WHEEL_TICK_US    ((int64_t)CAN_ESP_RETRY_WHEEL_TICK_MS * 1000LL)
+
+/* Backoff exponencial por quadro: CAN_ESP_BACKOFF_MS, 2x, 4x, ... conforme retry_count */
+static uint32_t retry_backoff_ms(uint8_t retry_count)
+{
+    uint8_t shift = (retry_count > 0U) ? (uint8_t)(retry_count - 1U) : 0U;
+    return CAN_ESP_BACKOFF_MS << shift;
+}
+
+static void retry_wheel_init(can_esp_handle_t inst, int64_t now)
+{
+    uint32_t i;
+    inst->retryFreeList = NULL;
+    for (i = 0U; i < CAN_ESP_RETRY_POOL_SIZE; i++) {
+        inst->retryPool[i].next = inst->retryFreeList;
+        inst->retryFreeList = &inst->retryPool[i];
+    }
+    for (i = 0U; i < CAN_ESP_RETRY_WHEEL_SLOTS; i++) {
+        inst->retryWheel[i] = NULL;
+    }
+    inst->retryWheelTick = now / RETRY_WHEEL_TICK_US;
+    inst->retryWheelInitialized = true;
+}
+
+/* Insere a entrada na posição correspondente ao seu prazo (sempre após o tick corrente) */
+static void retry_wheel_insert(can_esp_handle_t inst, CanEspRetryEntry_t *entry)
+{
+    int64_t due_tick = (entry->due_us + RETRY_WHEEL_TICK_US - 1) / RETRY_WHEEL_TICK_US;
+    uint32_t slot;
+    if (due_tick <= inst->retryWheelTick) {
+        due_tick = inst->retryWheelTick + 1;
+    }
+    slot = (uint32_t)(due_tick % CAN_ESP_RETRY_WHEEL_SLOTS);
+    entry->next = inst->retryWheel[slot];
+    inst->retryWheel[slot] = entry;
+}
+
+/*
+ * Estaciona um quadro que falhou. Retorna false se não houver entrada livre; nesse caso o
+ * chamador reinsere o quadro imediatamente na fila (sem backoff).
+ */
+static bool retry_wheel_park(can_esp_handle_t inst, CanEspMessage_t *msg, int64_t now)
+{
+    CanEspRetryEntry_t *entry = inst->retryFreeList;
+    uint32_t backoff_ms = retry_backoff_ms(msg->retry_count);
+    if (entry == NULL) {
+        portENTER_CRITICAL(&inst->retryStatsLock);
+        inst->retryStats.wheel_overflows++;
+        portEXIT_CRITICAL(&inst->retryStatsLock);
+        return false;
+    }
+    inst->retryFreeList = entry->next;
+    entry->slot = (uint16_t)(msg - inst->msgPool);
+    entry->parked_us = now;
+    entry->due_us = now + ((int64_t)backoff_ms * 1000LL);
+    retry_wheel_insert(inst, entry);
+
+    portENTER_CRITICAL(&inst->retryStatsLock);
+    inst->retryStats.retries_scheduled++;
+    inst->retryStats.parked_now++;
+    if (inst->retryStats.parked_now > inst->retryStats.parked_high_water) {
+        inst->retryStats.parked_high_water = inst->retryStats.parked_now;
+    }
+    portEXIT_CRITICAL(&inst->retryStatsLock);
+    if (inst->currentConfig.debug_level >= 2) {
+        ESP_LOGI(TAG, "Mensagem (ID: 0x%08X) estacionada para retransmissão %u em %" PRIu32 " ms.",
+                 (unsigned int)msg->id, (unsigned int)msg->retry_count, backoff_ms);
+    }
+    return true;
+}
+
+/*
+ * Devolve o slot de uma mensagem à frente do seu nível; retorna false se o nível estiver cheio.
+ * Com replace_queued, se um valor mais recente do mesmo ID já foi enfileirado (ainda na fila ou
+ * já transmitido), a retransmissão é cancelada e o slot volta ao pool (também retorna true).
+ */
+static bool tx_ring_requeue_front(can_esp_handle_t inst, CanEspMessage_t *msg)
+{
+    uint16_t slot = (uint16_t)(msg - inst->msgPool);
+    uint8_t level = inst->msgPoolLevel[slot];   /* Nível resolvido no enfileiramento (mantém high_priority) */
+    bool queued = false;
+    bool wake_producer = false;
+    portENTER_CRITICAL(&inst->txRingLock);
+    if (inst->msgPoolSuperseded[slot]) {
+        wake_producer = msg_pool_free_locked(inst, slot);
+        inst->txDeadlineStats.superseded_retries++;
+        queued = true;
+    } else if (inst->txLevels[level].count < CAN_ESP_TX_LEVEL_QUEUE_LENGTH) {
+        tx_ring_push_locked(inst, slot, level, true);
+        queued = true;
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    if (wake_producer) {
+        (void)xSemaphoreGive(inst->txSpaceSemaphore);
+    }
+    return queued;
+}
+
+/*
+ * Processa todos os ticks decorridos até now, devolvendo à frente do respectivo nível de
+ * prioridade os quadros cujo backoff expirou. Quadros que não couberem na fila voltam para o
+ * próximo tick. Após uma volta completa, todas as posições já foram visitadas.
+ */
+static void retry_wheel_advance(can_esp_handle_t inst, int64_t now)
+{
+    int64_t current_tick = now / RETRY_WHEEL_TICK_US;
+    int64_t tick;
+    CanEspRetryEntry_t *pending;
+    CanEspRetryEntry_t *entry;
+    uint32_t slot;
+
+    if (!inst->retryWheelInitialized || current_tick <= inst->retryWheelTick) {
+        return;
+    }
+    if (inst->retryStats.parked_now == 0U) {
+        inst->retryWheelTick = current_tick;
+        return;
+    }
+    tick = inst->retryWheelTick + 1;
+    if ((current_tick - inst->retryWheelTick) > (int64_t)CAN_ESP_RETRY_WHEEL_SLOTS) {
+        tick = current_tick - (int64_t)CAN_ESP_RETRY_WHEEL_SLOTS + 1;
+    }
+    inst->retryWheelTick = current_tick;
+    for (; tick <= current_tick; tick++) {
+        slot = (uint32_t)(tick % CAN_ESP_RETRY_WHEEL_SLOTS);
+        pending = inst->retryWheel[slot];
+        inst->retryWheel[slot] = NULL;
+        while (pending != NULL) {
+            entry = pending;
+            pending = pending->next;
+            if (entry->due_us > now || !tx_ring_requeue_front(inst, &inst->msgPool[entry->slot])) {
+                /* Volta futura ou nível cheio: permanece estacionado */
+                retry_wheel_insert(inst, entry);
+                continue;
+            }
+            portENTER_CRITICAL(&inst->retryStatsLock);
+            inst->retryStats.parked_now--;
+            inst->retryStats.total_backoff_us += (uint64_t)(now - entry->parked_us);
+            if ((uint32_t)(now - entry->parked_us) > inst->retryStats.max_backoff_us) {
+                inst->retryStats.max_backoff_us = (uint32_t)(now - entry->parked_us);
+            }
+            portEXIT_CRITICAL(&inst->retryStatsLock);
+            entry->next = inst->retryFreeList;
+            inst->retryFreeList = entry;
+        }
+    }
+}
+
+/* Tempo máximo de espera da tarefa de transmissão: até o próximo tick se houver quadros estacionados */
+static TickType_t retry_wheel_wait_ticks(can_esp_handle_t inst)
+{
+    TickType_t ticks;
+    if (inst->retryStats.parked_now == 0U) {
+        return portMAX_DELAY;
+    }
+    ticks = pdMS_TO_TICKS(CAN_ESP_RETRY_WHEEL_TICK_MS);
+    return (ticks > 0U) ? ticks : 1U;
+}
+
+can_esp_status_t CAN_ESP_GetRetryStats_v2(can_esp_handle_t handle, CanEspRetryStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas de retransmissão nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->retryStatsLock);
+    *stats = handle->retryStats;
+    portEXIT_CRITICAL(&handle->retryStatsLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetRetryStats(CanEspRetryStats_t *stats)
+{
+    return CAN_ESP_GetRetryStats_v2(&defaultInstance, stats);
+}
+
+/*==============================================================================
+                    TAREFA DE TRANSMISSÃO ASSÍNCRONA
+ ==============================================================================*/
+
+/* Indica se o prazo da mensagem (se houver) já terá vencido no instante at (slot fora da fila) */
+static bool tx_deadline_missed(can_esp_handle_t inst, const CanEspMessage_t *msg, int64_t at)
+{
+    int64_t deadline = inst->msgPoolDeadline[msg - inst->msgPool];
+    return (deadline != 0) && (at > deadline);
+}
+
+/* Descarta uma mensagem com o prazo vencido, informando o callback de transmissão */
+static void tx_drop_expired(can_esp_handle_t inst, CanEspMessage_t *msg, bool retry)
+{
+    portENTER_CRITICAL(&inst->txRingLock);
+    if (retry) {
+        inst->txDeadlineStats.expired_retries++;
+    } else {
+        inst->txDeadlineStats.expired_queued++;
+    }
+    portEXIT_CRITICAL(&inst->txRingLock);
+    if (inst->currentConfig.debug_level >= 2) {
+        ESP_LOGI(TAG, "Mensagem (ID: 0x%08X) descartada por prazo vencido.", (unsigned int)msg->id);
+    }
+    if (inst->transmit_callback != NULL) {
+        inst->transmit_callback(msg->id, msg->data, msg->length, CAN_ESP_ERR_TIMEOUT);
+    }
+    can_esp_tx_ring_release(inst, msg);
+}
+
+/*
+ * Transmite uma mensagem retirada da fila (slot do pool); falhas são estacionadas na roda de
+ * retransmissão com o próprio slot, que volta ao pool após o envio ou o descarte. Mensagens
+ * com o prazo vencido são descartadas sem ir ao barramento.
+ */
+static void transmit_queued_message(can_esp_handle_t inst, CanEspMessage_t *msg)
+{
+    twai_message_t tx_msg;
+    int64_t tx_start, tx_end, latency;
+
+    if (tx_deadline_missed(inst, msg, esp_timer_get_time())) {
+        tx_drop_expired(inst, msg, false);
+        return;
+    }
+    can_esp_convert_canesp_to_twai(inst, msg, &tx_msg);
+    inst->totalTransmissionAttempts++;
+    tx_start = esp_timer_get_time();
+    if (transmit_tracked(inst, &tx_msg, msg, pdMS_TO_TICKS(inst->currentConfig.transmit_timeout_ms)) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao transmitir mensagem (ID: 0x%08X).", (unsigned int)msg->id);
+        if (msg->retry_count < CAN_ESP_MAX_RETRANSMISSIONS &&
+            tx_deadline_missed(inst, msg, esp_timer_get_time() +
+                                          ((int64_t)retry_backoff_ms((uint8_t)(msg->retry_count + 1U)) * 1000LL))) {
+            /* O backoff terminaria após o prazo: a retransmissão levaria um valor vencido */
+            tx_drop_expired(inst, msg, true);
+        } else if (msg->retry_count < CAN_ESP_MAX_RETRANSMISSIONS) {
+            msg->retry_count++;
+            inst->totalRetransmissions++;
+            inst->totalCollisions++;
+            if (!retry_wheel_park(inst, msg, esp_timer_get_time()) && !tx_ring_requeue_front(inst, msg)) {
+                /* Roda e nível cheios: o quadro é descartado */
+                if (inst->transmit_callback != NULL) {
+                    inst->transmit_callback(msg->id, msg->data, msg->length, CAN_ESP_ERR_TRANSMIT);
+                }
+                can_esp_tx_ring_release(inst, msg);
+            }
+        } else {
+            portENTER_CRITICAL(&inst->retryStatsLock);
+            inst->retryStats.retry_exhausted++;
+            portEXIT_CRITICAL(&inst->retryStatsLock);
+            if (inst->transmit_callback != NULL) {
+                inst->transmit_callback(msg->id, msg->data, msg->length, CAN_ESP_ERR_TRANSMIT);
+            }
+            can_esp_tx_ring_release(inst, msg);
+        }
+        return;
+    }
+    tx_end = esp_timer_get_time();
+    latency = tx_end - tx_start;
+    can_esp_latency_hist_record(&inst->latencyTotal, latency);
+    can_esp_latency_hist_record(&inst->latencyWindows[atomic_load_explicit(&inst->latencyActiveWindow, memory_order_relaxed)], latency);
+    account_frame(inst, &tx_msg, true, tx_end);
+    if (msg->retry_count > 0U) {
+        portENTER_CRITICAL(&inst->retryStatsLock);
+        inst->retryStats.retry_successes++;
+        portEXIT_CRITICAL(&inst->retryStatsLock);
+    }
+    if (inst->currentConfig.debug_level >= 2) {
+        ESP_LOGI(TAG, "Mensagem (ID: 0x%08X) transmitida em %" PRId64 " ms",
+                 (unsigned int)msg->id, (latency / 1000U));
+    }
+    if (inst->transmit_callback != NULL) {
+        inst->transmit_callback(msg->id, msg->data, msg->length, CAN_ESP_OK);
+    }
+    can_esp_tx_ring_release(inst, msg);
+}
+
+/* Tarefa de transmissão assíncrona */
+static void CAN_ESP_TransmitTask(void *arg)
+{
+    can_esp_handle_t inst = (can_esp_handle_t)arg;
+    CanEspMessage_t *msg;
+    retry_wheel_init(inst, esp_timer_get_time());
+    for (;;) {
+        tx_task_pause_point(inst);
+        retry_wheel_advance(inst, esp_timer_get_time());
+        /* Drena a fila inteira a cada despertar; dorme somente quando ela esvazia */
+        while (!inst->reconfigPauseRequested && !inst->txHeldByBusOff) {
+            msg = can_esp_tx_ring_pop(inst);
+            if (msg == NULL) {
+                break;
+            }
+            transmit_queued_message(inst, msg);
+            retry_wheel_advance(inst, esp_timer_get_time());
+            (void)CAN_ESP_AdjustTransmitTaskPriority_v2(inst);
+        }
+        (void)ulTaskNotifyTake(pdTRUE, retry_wheel_wait_ticks(inst));
+    }
+}
+
+void CAN_ESP_StartTransmitTask_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    if (!can_esp_tx_ring_init(handle) || !reconfig_init(handle)) {
+        ESP_LOGE(TAG, "Falha ao criar a fila de transmissão.");
+        return;
+    }
+    (void)task_create(CAN_ESP_TransmitTask, "CAN_TX_Task", &handle->taskConfig.transmit, handle,
+                      &handle->canTxTaskHandle);
+}
+
+void CAN_ESP_StartTransmitTask(void)
+{
+    CAN_ESP_StartTransmitTask_v2(&defaultInstance);
+}
+
+/*==============================================================================
+               FUNÇÕES AUXILIARES PARA CODIFICAÇÃO DO ID CAN
+ ==============================================================================*/
+
+uint32_t CAN_ESP_EncodeID(uint8_t priority, uint16_t module, uint16_t command)
+{
+    return (((uint32_t)(priority & 0x07U) << 26) |
+            ((uint32_t)(module & 0x03FFU) << 16) |
+            ((uint32_t)(command & 0xFFFFU)));
+}
+
+void CAN_ESP_DecodeID(uint32_t id, uint8_t *priority, uint16_t *module, uint16_t *command)
+{
+    if (priority != NULL) {
+        *priority = (uint8_t)((id >> 26) & 0x07U);
+    }
+    if (module != NULL) {
+        *module = (uint16_t)((id >> 16) & 0x03FFU);
+    }
+    if (command != NULL) {
+        *command = (uint16_t)(id & 0xFFFFU);
+    }
+}
+
+/*==============================================================================
+            FUNÇÃO DE CALLBACK PARA TRANSMISSÃO (OPCIONAL)
+ ==============================================================================*/
+
+can_esp_status_t CAN_ESP_RegisterTransmitCallback_v2(can_esp_handle_t handle, can_esp_transmit_callback_t callback)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    handle->transmit_callback = callback;
+    ESP_LOGI(TAG, "Callback de transmissão registrado com sucesso (opcional).");
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_RegisterTransmitCallback(can_esp_transmit_callback_t callback)
+{
+    return CAN_ESP_RegisterTransmitCallback_v2(&defaultInstance, callback);
+}
+
+/*==============================================================================
+              SUPERVISOR DE RECUPERAÇÃO (ERROR-PASSIVE E BUS-OFF)
+ ==============================================================================*/
+
+void CAN_ESP_RecoveryDefaultPolicy(CanEspRecoveryPolicy_t *policy)
+{
+    if (policy == NULL) {
+        return;
+    }
+    policy->auto_recover = true;
+    policy->recovery_delay_ms = CAN_ESP_RECOVERY_DEFAULT_DELAY_MS;
+    policy->max_attempts = CAN_ESP_RECOVERY_DEFAULT_MAX_ATTEMPTS;
+    policy->stable_time_ms = CAN_ESP_RECOVERY_DEFAULT_STABLE_MS;
+    policy->flush_from_level = CAN_ESP_RECOVERY_DEFAULT_FLUSH_LEVEL;
+}
+
+/* Estado de confinamento a partir do estado do driver e dos contadores de erro */
+static CanEspBusState_t recovery_classify(const twai_status_info_t *info)
+{
+    if (info->state == TWAI_STATE_BUS_OFF) {
+        return CAN_ESP_BUS_STATE_BUS_OFF;
+    }
+    if (info->state == TWAI_STATE_RECOVERING) {
+        return CAN_ESP_BUS_STATE_RECOVERING;
+    }
+    if (info->tx_error_counter >= 128U || info->rx_error_counter >= 128U) {
+        return CAN_ESP_BUS_STATE_ERROR_PASSIVE;
+    }
+    if (info->tx_error_counter >= 96U || info->rx_error_counter >= 96U) {
+        return CAN_ESP_BUS_STATE_ERROR_WARNING;
+    }
+    return CAN_ESP_BUS_STATE_ERROR_ACTIVE;
+}
+
+/*
+ * Descarta as mensagens dos níveis first_level em diante, notificando o callback de transmissão,
+ * e retorna quantas foram descartadas; *held recebe as que permaneceram na fila.
+ */
+static uint32_t tx_ring_flush_from(can_esp_handle_t inst, uint8_t first_level, uint32_t *held)
+{
+    CanEspMessage_t *msg;
+    uint32_t flushed = 0U;
+
+    for (uint8_t level = first_level; level < CAN_ESP_NUM_PRIORITY_LEVELS; level++) {
+        do {
+            msg = NULL;
+            portENTER_CRITICAL(&inst->txRingLock);
+            if (inst->txLevels[level].count > 0U) {
+                msg = &inst->msgPool[tx_ring_take_locked(inst, level)];
+            }
+            portEXIT_CRITICAL(&inst->txRingLock);
+            if (msg != NULL) {
+                flushed++;
+                if (inst->transmit_callback != NULL) {
+                    inst->transmit_callback(msg->id, msg->data, msg->length, CAN_ESP_ERR_TRANSMIT);
+                }
+                can_esp_tx_ring_release(inst, msg);
+            }
+        } while (msg != NULL);
+    }
+    *held = tx_ring_count(inst);
+    return flushed;
+}
+
+/* Entrada em bus-off: suspende a transmissão, aplica a política da fila e agenda a recuperação */
+static void recovery_on_bus_off(can_esp_handle_t inst, const CanEspRecoveryPolicy_t *policy, int64_t now)
+{
+    uint32_t held = 0U;
+    uint32_t flushed;
+    bool allowed;
+
+    inst->txHeldByBusOff = true;
+    flushed = tx_ring_flush_from(inst, policy->flush_from_level, &held);
+
+    portENTER_CRITICAL(&inst->recoveryLock);
+    inst->recoveryStats.bus_off_events++;
+    inst->recoveryStats.consecutive_bus_offs++;
+    inst->recoveryStats.last_bus_off_us = now;
+    inst->recoveryStats.flushed_frames += flushed;
+    inst->recoveryStats.held_frames = held;
+    allowed = (policy->max_attempts == 0U) || (inst->recoveryStats.consecutive_bus_offs <= policy->max_attempts);
+    if (policy->auto_recover && !allowed) {
+        inst->recoveryStats.suppressed_recoveries++;
+    }
+    portEXIT_CRITICAL(&inst->recoveryLock);
+
+    inst->recoveryDueUs = (policy->auto_recover && allowed) ? (now + ((int64_t)policy->recovery_delay_ms * 1000LL)) : 0;
+    inst->busStableSinceUs = 0;
+    ESP_LOGW(TAG, "Bus-off detectado: %" PRIu32 " mensagens descartadas, %" PRIu32 " retidas.", flushed, held);
+    if (policy->auto_recover && !allowed) {
+        ESP_LOGE(TAG, "Limite de bus-offs consecutivos atingido; recuperação automática suspensa.");
+    }
+}
+
+/* Fim da recuperação: registra a duração e libera a tarefa de transmissão */
+static void recovery_on_recovered(can_esp_handle_t inst, int64_t now)
+{
+    int64_t duration;
+
+    portENTER_CRITICAL(&inst->recoveryLock);
+    duration = now - inst->recoveryStats.last_bus_off_us;
+    inst->recoveryStats.recoveries++;
+    inst->recoveryStats.last_recovery_time_us = duration;
+    if (duration > inst->recoveryStats.max_recovery_time_us) {
+        inst->recoveryStats.max_recovery_time_us = duration;
+    }
+    inst->recoveryStats.total_downtime_us += duration;
+    portEXIT_CRITICAL(&inst->recoveryLock);
+
+    inst->recoveryDueUs = 0;
+    inst->txHeldByBusOff = false;
+    if (inst->canTxTaskHandle != NULL) {
+        xTaskNotifyGive(inst->canTxTaskHandle);
+    }
+    ESP_LOGI(TAG, "Barramento recuperado em %" PRId64 " us.", duration);
+}
+
+/*
+ * Máquina de estados do supervisor, executada a cada despertar da tarefa de alertas. O estado é
+ * obtido do driver; os alertas apenas antecipam o despertar. Após BUS_RECOVERED o controlador
+ * fica parado e é reiniciado aqui.
+ */
+static void recovery_process(can_esp_handle_t inst, int64_t now)
+{
+    CanEspRecoveryPolicy_t policy;
+    twai_status_info_t info;
+    CanEspBusState_t previous;
+    CanEspBusState_t current;
+    bool was_off;
+    can_esp_bus_state_callback_t callback;
+
+    if (drv_get_status_info(inst, &info) != ESP_OK) {
+        return;
+    }
+    portENTER_CRITICAL(&inst->recoveryLock);
+    policy = inst->recoveryPolicy;
+    previous = inst->recoveryStats.state;
+    portEXIT_CRITICAL(&inst->recoveryLock);
+    was_off = (previous == CAN_ESP_BUS_STATE_BUS_OFF) || (previous == CAN_ESP_BUS_STATE_RECOVERING);
+
+    if (info.state == TWAI_STATE_STOPPED) {
+        if (!was_off) {
+            /* Parado pela aplicação (ex.: reconfiguração): nada a supervisionar */
+            return;
+        }
+        if (drv_start(inst) != ESP_OK) {
+            portENTER_CRITICAL(&inst->recoveryLock);
+            inst->recoveryStats.recovery_failures++;
+            portEXIT_CRITICAL(&inst->recoveryLock);
+            ESP_LOGE(TAG, "Falha ao reiniciar o driver após a recuperação.");
+            return;
+        }
+        (void)drv_get_status_info(inst, &info);
+    }
+    current = recovery_classify(&info);
+
+    if (current == CAN_ESP_BUS_STATE_BUS_OFF && !was_off) {
+        recovery_on_bus_off(inst, &policy, now);
+    }
+    if (current == CAN_ESP_BUS_STATE_BUS_OFF && inst->recoveryDueUs != 0 && now >= inst->recoveryDueUs) {
+        inst->recoveryDueUs = 0;
+        if (drv_initiate_recovery(inst) == ESP_OK) {
+            current = CAN_ESP_BUS_STATE_RECOVERING;
+        } else {
+            portENTER_CRITICAL(&inst->recoveryLock);
+            inst->recoveryStats.recovery_failures++;
+            portEXIT_CRITICAL(&inst->recoveryLock);
+            ESP_LOGE(TAG, "Falha ao iniciar a recuperação do bus-off.");
+        }
+    }
+    if (was_off && current != CAN_ESP_BUS_STATE_BUS_OFF && current != CAN_ESP_BUS_STATE_RECOVERING) {
+        recovery_on_recovered(inst, now);
+    }
+
+    /* Período estável em error-active zera a contagem de bus-offs consecutivos */
+    if (current == CAN_ESP_BUS_STATE_ERROR_ACTIVE) {
+        if (inst->busStableSinceUs == 0) {
+            inst->busStableSinceUs = now;
+        }
+    } else {
+        inst->busStableSinceUs = 0;
+    }
+
+    portENTER_CRITICAL(&inst->recoveryLock);
+    if (current == CAN_ESP_BUS_STATE_ERROR_WARNING && previous == CAN_ESP_BUS_STATE_ERROR_ACTIVE) {
+        inst->recoveryStats.error_warning_events++;
+    }
+    if (current == CAN_ESP_BUS_STATE_ERROR_PASSIVE &&
+        (previous == CAN_ESP_BUS_STATE_ERROR_ACTIVE || previous == CAN_ESP_BUS_STATE_ERROR_WARNING)) {
+        inst->recoveryStats.error_passive_events++;
+    }
+    if (inst->busStableSinceUs != 0 && (now - inst->busStableSinceUs) >= ((int64_t)policy.stable_time_ms * 1000LL)) {
+        inst->recoveryStats.consecutive_bus_offs = 0U;
+    }
+    inst->recoveryStats.state = current;
+    portEXIT_CRITICAL(&inst->recoveryLock);
+
+    if (current != previous) {
+        can_esp_capture_record_bus_state(instance_channel(inst), current, now);
+    }
+    callback = inst->bus_state_callback;
+    if (current != previous && callback != NULL) {
+        callback(previous, current);
+    }
+}
+
+/* Espera máxima por alertas: limitada pelo instante agendado para a recuperação */
+static TickType_t recovery_wait_ticks(can_esp_handle_t inst)
+{
+    TickType_t wait = pdMS_TO_TICKS(CAN_ESP_TX_COMPLETE_POLL_MS);
+    int64_t remaining_us;
+
+    if (inst->recoveryDueUs != 0) {
+        remaining_us = inst->recoveryDueUs - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            return 0;
+        }
+        if (pdMS_TO_TICKS((uint32_t)(remaining_us / 1000LL)) + 1U < wait) {
+            wait = pdMS_TO_TICKS((uint32_t)(remaining_us / 1000LL)) + 1U;
+        }
+    }
+    return wait;
+}
+
+can_esp_status_t CAN_ESP_StartRecoverySupervisor_v2(can_esp_handle_t handle, const CanEspRecoveryPolicy_t *policy)
+{
+    CanEspRecoveryPolicy_t applied;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (policy == NULL) {
+        CAN_ESP_RecoveryDefaultPolicy(&applied);
+    } else {
+        if (policy->flush_from_level > CAN_ESP_NUM_PRIORITY_LEVELS) {
+            ESP_LOGE(TAG, "Nível de descarte inválido: %u.", (unsigned int)policy->flush_from_level);
+            return CAN_ESP_ERR_INVALID_PARAM;
+        }
+        applied = *policy;
+    }
+    portENTER_CRITICAL(&handle->recoveryLock);
+    handle->recoveryPolicy = applied;
+    portEXIT_CRITICAL(&handle->recoveryLock);
+    handle->recoveryEnabled = true;
+    if (alert_task_start(handle) != CAN_ESP_OK) {
+        handle->recoveryEnabled = false;
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    ESP_LOGI(TAG, "Supervisor de recuperação ativo (automática: %s, atraso %" PRIu32 " ms).",
+             applied.auto_recover ? "sim" : "não", applied.recovery_delay_ms);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_StartRecoverySupervisor(const CanEspRecoveryPolicy_t *policy)
+{
+    return CAN_ESP_StartRecoverySupervisor_v2(&defaultInstance, policy);
+}
+
+can_esp_status_t CAN_ESP_InitiateRecovery_v2(can_esp_handle_t handle)
+{
+    twai_status_info_t info;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (drv_get_status_info(handle, &info) != ESP_OK || info.state != TWAI_STATE_BUS_OFF) {
+        ESP_LOGE(TAG, "Recuperação solicitada fora do estado de bus-off.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (drv_initiate_recovery(handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar a recuperação do bus-off.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_InitiateRecovery(void)
+{
+    return CAN_ESP_InitiateRecovery_v2(&defaultInstance);
+}
+
+can_esp_status_t CAN_ESP_GetRecoveryStats_v2(can_esp_handle_t handle, CanEspRecoveryStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    portENTER_CRITICAL(&handle->recoveryLock);
+    *stats = handle->recoveryStats;
+    portEXIT_CRITICAL(&handle->recoveryLock);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetRecoveryStats(CanEspRecoveryStats_t *stats)
+{
+    return CAN_ESP_GetRecoveryStats_v2(&defaultInstance, stats);
+}
+
+can_esp_status_t CAN_ESP_RegisterBusStateCallback_v2(can_esp_handle_t handle, can_esp_bus_state_callback_t callback)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    handle->bus_state_callback = callback;
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_RegisterBusStateCallback(can_esp_bus_state_callback_t callback)
+{
+    return CAN_ESP_RegisterBusStateCallback_v2(&defaultInstance, callback);
+}
+
+/*==============================================================================
+                 FUNÇÃO DE DIAGNÓSTICO / STATUS TWAI
+ ==============================================================================*/
+
+can_esp_status_t CAN_ESP_GetDiagnostics_v2(can_esp_handle_t handle, CanEspDiagnostics_t *diag)
+{
+    twai_status_info_t status_info;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (diag == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de diagnóstico nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (drv_get_status_info(handle, &status_info) != ESP_OK) {
+        ESP_LOGE(TAG, "Erro ao obter status TWAI.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    diag->tx_error_counter = status_info.tx_error_counter;
+    diag->rx_error_counter = status_info.rx_error_counter;
+    diag->bus_off = (status_info.state == TWAI_STATE_BUS_OFF) ? true : false;
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetDiagnostics(CanEspDiagnostics_t *diag)
+{
+    return CAN_ESP_GetDiagnostics_v2(&defaultInstance, diag);
+}
+
+/*==============================================================================
+         FUNÇÃO PARA MONITORAMENTO DE LATÊNCIA
+ ==============================================================================*/
+
+/* Índice do balde do histograma para um valor de latência (em microsegundos) */
+static uint32_t latency_bucket_index(int64_t value)
+{
+    uint32_t v, msb, k, index;
+    if (value < 16) {
+        return (value < 0) ? 0U : (uint32_t)value;
+    }
+    v = (value > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)value;
+    msb = 31U - (uint32_t)__builtin_clz(v);
+    k = msb - 3U;
+    index = (16U * k) + ((v >> (k - 1U)) - 16U);
+    return (index >= CAN_ESP_LATENCY_HIST_BUCKETS) ? (CAN_ESP_LATENCY_HIST_BUCKETS - 1U) : index;
+}
+
+/* Maior valor representado pelo balde (valor equivalente reportado nos percentis) */
+static int64_t latency_bucket_upper(uint32_t index)
+{
+    uint32_t k, sub;
+    if (index < 16U) {
+        return (int64_t)index;
+    }
+    k = index / 16U;
+    sub = index % 16U;
+    return ((int64_t)(16U + sub + 1U) << (k - 1U)) - 1;
+}
+
+/* Ponto médio do balde (usado na estimativa do desvio padrão) */
+static int64_t latency_bucket_mid(uint32_t index)
+{
+    uint32_t k;
+    if (index < 16U) {
+        return (int64_t)index;
+    }
+    k = index / 16U;
+    return latency_bucket_upper(index) - (((int64_t)1 << (k - 1U)) / 2);
+}
+
+void can_esp_latency_hist_reset(CanEspLatencyHist_t *hist)
+{
+    for (uint32_t i = 0U; i < CAN_ESP_LATENCY_HIST_BUCKETS; i++) {
+        atomic_store_explicit(&hist->counts[i], 0U, memory_order_relaxed);
+    }
+    atomic_store_explicit(&hist->num_samples, 0U, memory_order_relaxed);
+    atomic_store_explicit(&hist->total_latency, 0, memory_order_relaxed);
+    atomic_store_explicit(&hist->min_latency, INT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&hist->max_latency, 0, memory_order_relaxed);
+}
+
+void can_esp_latency_hist_record(CanEspLatencyHist_t *hist, int64_t latency)
+{
+    long long seen;
+
+    atomic_fetch_add_explicit(&hist->counts[latency_bucket_index(latency)], 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->num_samples, 1U, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->total_latency, latency, memory_order_relaxed);
+    seen = atomic_load_explicit(&hist->min_latency, memory_order_relaxed);
+    while (latency < seen &&
+           !atomic_compare_exchange_weak_explicit(&hist->min_latency, &seen, latency,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    seen = atomic_load_explicit(&hist->max_latency, memory_order_relaxed);
+    while (latency > seen &&
+           !atomic_compare_exchange_weak_explicit(&hist->max_latency, &seen, latency,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* Percentil (0 a 100) do histograma; o resultado é limitado ao máximo observado */
+static int64_t latency_hist_percentile(const uint32_t *counts, uint32_t total, int64_t max, float percentile)
+{
+    uint64_t target, seen = 0U;
+    if (total == 0U) {
+        return 0;
+    }
+    target = (uint64_t)(((double)percentile * (double)total / 100.0) + 0.999999);
+    if (target == 0U) {
+        target = 1U;
+    }
+    for (uint32_t i = 0U; i < CAN_ESP_LATENCY_HIST_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            int64_t upper = latency_bucket_upper(i);
+            return (upper > max) ? max : upper;
+        }
+    }
+    return max;
+}
+
+/* Copia o histograma e preenche as métricas (contagem, extremos, percentis e desvio padrão) */
+void can_esp_latency_hist_snapshot(CanEspLatencyHist_t *hist, CanEspLatencyMetrics_t *metrics)
+{
+    uint32_t counts[CAN_ESP_LATENCY_HIST_BUCKETS];
+    uint32_t total = 0U;
+    double mean, var_acc = 0.0;
+
+    for (uint32_t i = 0U; i < CAN_ESP_LATENCY_HIST_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&hist->counts[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    metrics->num_samples = total;
+    metrics->total_latency = atomic_load_explicit(&hist->total_latency, memory_order_relaxed);
+    metrics->min_latency = atomic_load_explicit(&hist->min_latency, memory_order_relaxed);
+    metrics->max_latency = atomic_load_explicit(&hist->max_latency, memory_order_relaxed);
+    metrics->p50_latency = latency_hist_percentile(counts, total, metrics->max_latency, 50.0f);
+    metrics->p90_latency = latency_hist_percentile(counts, total, metrics->max_latency, 90.0f);
+    metrics->p99_latency = latency_hist_percentile(counts, total, metrics->max_latency, 99.0f);
+    metrics->p999_latency = latency_hist_percentile(counts, total, metrics->max_latency, 99.9f);
+    metrics->stddev_latency = 0;
+    if (total == 0U) {
+        metrics->min_latency = 0;
+    } else {
+        mean = (double)metrics->total_latency / (double)total;
+        for (uint32_t i = 0U; i < CAN_ESP_LATENCY_HIST_BUCKETS; i++) {
+            if (counts[i] != 0U) {
+                double d = (double)latency_bucket_mid(i) - mean;
+                var_acc += d * d * (double)counts[i];
+            }
+        }
+        metrics->stddev_latency = (int64_t)sqrt(var_acc / (double)total);
+    }
+}
+
+can_esp_status_t CAN_ESP_GetLatencyMetrics_v2(can_esp_handle_t handle, CanEspLatencyMetrics_t *metrics)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (metrics == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de métricas nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    can_esp_latency_hist_snapshot(&handle->latencyTotal, metrics);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetLatencyMetrics(CanEspLatencyMetrics_t *metrics)
+{
+    return CAN_ESP_GetLatencyMetrics_v2(&defaultInstance, metrics);
+}
+
+can_esp_status_t CAN_ESP_GetLatencyPercentile_v2(can_esp_handle_t handle, float percentile, int64_t *latency_us)
+{
+    uint32_t counts[CAN_ESP_LATENCY_HIST_BUCKETS];
+    uint32_t total = 0U;
 
-/* Fila de transmissão */
-static QueueHandle_t txQueue = NULL;
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
 
-/* Handle da tarefa de transmissão (para ajuste dinâmico de prioridade) */
-static TaskHandle_t canTxTaskHandle = NULL;
+    if (latency_us == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de latência nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (!(percentile >= 0.0f && percentile <= 100.0f)) {
+        ESP_LOGE(TAG, "Percentil inválido (esperado 0 a 100).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    for (uint32_t i = 0U; i < CAN_ESP_LATENCY_HIST_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&handle->latencyTotal.counts[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    *latency_us = latency_hist_percentile(counts, total,
+                                          atomic_load_explicit(&handle->latencyTotal.max_latency, memory_order_relaxed),
+                                          percentile);
+    return CAN_ESP_OK;
+}
 
-/* Variáveis para medição de retransmissões, colisões e tentativas */
-static uint32_t totalRetransmissions = 0;
-static uint32_t totalCollisions = 0;
-static uint32_t totalTransmissionAttempts = 0;
+can_esp_status_t CAN_ESP_GetLatencyPercentile(float percentile, int64_t *latency_us)
+{
+    return CAN_ESP_GetLatencyPercentile_v2(&defaultInstance, percentile, latency_us);
+}
 
-/* Callbacks */
-static can_esp_receive_callback_t receive_callback = NULL;
-static can_esp_transmit_callback_t transmit_callback = NULL;
+can_esp_status_t CAN_ESP_ResetLatencyWindow_v2(can_esp_handle_t handle, CanEspLatencyMetrics_t *closed_window)
+{
+    uint32_t active;
+    uint32_t next;
 
-/* Configuração padrão; self_rx e use_checksum desabilitados */
-static CanEspConfig_t currentConfig = {
-    .bitrate = 1000000U,
-    .tx_gpio = CAN_TX_GPIO,
-    .rx_gpio = CAN_RX_GPIO,
-    .transmit_timeout_ms = CAN_DEFAULT_TRANSMIT_TIMEOUT_MS,
-    .receive_timeout_ms = CAN_DEFAULT_RECEIVE_TIMEOUT_MS,
-    .filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL(),
-    .mode = TWAI_MODE_NO_ACK,
-    .use_custom_timing = false,
-    .custom_timing_config = {0},
-    .auto_retransmit = true,
-    .debug_level = 2U,
-    .self_rx = false,
-    .use_checksum = false
-};
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
 
-static bool configInitialized = false;
+    active = atomic_load_explicit(&handle->latencyActiveWindow, memory_order_relaxed);
+    next = active ^ 1U;
 
-/* Estrutura para armazenar métricas de latência */
-static CanEspLatencyMetrics_t latencyMetrics = {0, 0, INT64_MAX, 0};
+    /* Prepara o histograma inativo, alterna a janela e só então lê a que foi fechada */
+    can_esp_latency_hist_reset(&handle->latencyWindows[next]);
+    atomic_store_explicit(&handle->latencyActiveWindow, next, memory_order_release);
+    if (closed_window != NULL) {
+        can_esp_latency_hist_snapshot(&handle->latencyWindows[active], closed_window);
+    }
+    return CAN_ESP_OK;
+}
 
-/* Variáveis para medição do bus load */
-static int64_t busLoadTotalTime = 0;
-static int64_t busLoadStartTime = 0;
+can_esp_status_t CAN_ESP_ResetLatencyWindow(CanEspLatencyMetrics_t *closed_window)
+{
+    return CAN_ESP_ResetLatencyWindow_v2(&defaultInstance, closed_window);
+}
 
-/* Protótipo para função auxiliar de temporização */
-static twai_timing_config_t GetTimingConfig(uint32_t bitrate);
+/*==============================================================================
+         FUNÇÃO PARA CONSULTA DO STATUS DA FILA DE TRANSMISSÃO
+ ==============================================================================*/
 
-/* Função auxiliar para obter configuração de temporização baseada no bitrate */
-static twai_timing_config_t GetTimingConfig(uint32_t bitrate)
+can_esp_status_t CAN_ESP_GetQueueStatus_v2(can_esp_handle_t handle, CanEspQueueStatus_t *status)
 {
-    if (bitrate == 1000000U) {
-        static const twai_timing_config_t timing_config_1mbits = TWAI_TIMING_CONFIG_1MBITS();
-        return timing_config_1mbits;
-    } else if (bitrate == 500000U) {
-        static const twai_timing_config_t timing_config_500kbits = TWAI_TIMING_CONFIG_500KBITS();
-        return timing_config_500kbits;
-    } else {
-        static const twai_timing_config_t timing_config_1mbits = TWAI_TIMING_CONFIG_1MBITS();
-        return timing_config_1mbits;
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-}
 
-/* Função auxiliar para converter CanEspMessage_t para twai_message_t */
-static void convert_canesp_to_twai(const CanEspMessage_t *src, twai_message_t *dst)
-{
-    if (src == NULL || dst == NULL) {
-        return;
+    if (status == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de status nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-    dst->identifier = src->id;
-    if (currentConfig.use_checksum && src->length < CAN_MAX_DATA_LENGTH) {
-        dst->data_length_code = src->length + 1;
-    } else {
-        dst->data_length_code = src->length;
+    if (handle->txSpaceSemaphore == NULL) {
+        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
+        return CAN_ESP_ERR_UNKNOWN;
     }
-    memcpy(dst->data, src->data, src->length);
-    dst->extd = 1U;
-    dst->rtr = 0;
-    dst->ss = 0;
-    dst->self = currentConfig.self_rx ? 1U : 0U;
+    portENTER_CRITICAL(&handle->txRingLock);
+    status->messages_waiting = handle->txTotalCount;
+    for (uint8_t level = 0U; level < CAN_ESP_NUM_PRIORITY_LEVELS; level++) {
+        status->level_waiting[level] = (uint16_t)handle->txLevels[level].count;
+    }
+    portEXIT_CRITICAL(&handle->txRingLock);
+    /* A ocupação total é limitada pelo pool de mensagens */
+    status->queue_capacity = ((CAN_ESP_TX_LEVEL_QUEUE_LENGTH * CAN_ESP_NUM_PRIORITY_LEVELS) < CAN_ESP_MSG_POOL_SIZE) ?
+                             (CAN_ESP_TX_LEVEL_QUEUE_LENGTH * CAN_ESP_NUM_PRIORITY_LEVELS) : CAN_ESP_MSG_POOL_SIZE;
+    status->level_capacity = CAN_ESP_TX_LEVEL_QUEUE_LENGTH;
+    return CAN_ESP_OK;
 }
 
-/* Calcula um checksum simples (XOR de todos os bytes) */
-uint8_t CAN_ESP_CalculateChecksum(const uint8_t *data, uint8_t length)
+can_esp_status_t CAN_ESP_GetQueueStatus(CanEspQueueStatus_t *status)
 {
-    uint8_t cs = 0;
-    for (uint8_t i = 0U; i < length; i++) {
-        cs ^= data[i];
-    }
-    return cs;
+    return CAN_ESP_GetQueueStatus_v2(&defaultInstance, status);
 }
 
 /*==============================================================================
-                         FUNÇÕES DE CONFIGURAÇÃO DINÂMICA
+          FUNÇÃO PARA CALCULAR BUS LOAD
  ==============================================================================*/
+/* Bits fixos após o CRC: delimitador de CRC, slot e delimitador de ACK, EOF (7) e IFS (3) */
+#define FRAME_FIXED_TAIL_BITS   (13U)
 
-can_esp_status_t CAN_ESP_InitWithConfig(const CanEspConfig_t *config)
+/* Anexa os nbits menos significativos de value (MSB primeiro) à sequência de bits */
+static uint32_t frame_put_bits(uint8_t *bits, uint32_t pos, uint32_t value, uint32_t nbits)
 {
-    twai_general_config_t generalConfig;
-    twai_timing_config_t timingConfig;
-    twai_filter_config_t filterConfig;
+    while (nbits > 0U) {
+        nbits--;
+        bits[pos++] = (uint8_t)((value >> nbits) & 1U);
+    }
+    return pos;
+}
 
-    if (config == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de configuração nulo.");
-        return CAN_ESP_ERR_NULL_POINTER;
+uint32_t CAN_ESP_CalculateFrameBits(uint32_t id, bool extended, bool rtr, uint8_t dlc,
+                                    const uint8_t *data, CanEspStuffingMode_t mode)
+{
+    uint8_t bits[160];
+    uint32_t n = 0U;
+    uint32_t payload = (dlc > CAN_MAX_DATA_LENGTH) ? CAN_MAX_DATA_LENGTH : dlc;
+    uint32_t data_bytes = rtr ? 0U : payload;
+    uint32_t stuffable = (extended ? 54U : 34U) + (8U * data_bytes);
+    uint32_t stuff = 0U;
+
+    if (mode == CAN_ESP_STUFFING_WORST_CASE || (data == NULL && data_bytes > 0U)) {
+        return stuffable + ((stuffable - 1U) / 4U) + FRAME_FIXED_TAIL_BITS;
     }
-    if (configMutex == NULL) {
-        configMutex = xSemaphoreCreateMutex();
-        if (configMutex == NULL) {
-            ESP_LOGE(TAG, "Falha ao criar mutex de configuração.");
-            return CAN_ESP_ERR_UNKNOWN;
+
+    /* Monta SOF .. dados exatamente como no fio */
+    n = frame_put_bits(bits, n, 0U, 1U);                                    /* SOF */
+    if (extended) {
+        n = frame_put_bits(bits, n, (id >> 18) & 0x7FFU, 11U);              /* ID base */
+        n = frame_put_bits(bits, n, 3U, 2U);                                /* SRR, IDE */
+        n = frame_put_bits(bits, n, id & 0x3FFFFU, 18U);                    /* ID estendido */
+        n = frame_put_bits(bits, n, rtr ? 1U : 0U, 1U);                     /* RTR */
+        n = frame_put_bits(bits, n, 0U, 2U);                                /* r1, r0 */
+    } else {
+        n = frame_put_bits(bits, n, id & 0x7FFU, 11U);
+        n = frame_put_bits(bits, n, rtr ? 1U : 0U, 1U);                     /* RTR */
+        n = frame_put_bits(bits, n, 0U, 2U);                                /* IDE, r0 */
+    }
+    n = frame_put_bits(bits, n, payload, 4U);                               /* DLC */
+    for (uint32_t i = 0U; i < data_bytes; i++) {
+        n = frame_put_bits(bits, n, data[i], 8U);
+    }
+
+    /* CRC-15 (polinômio 0x4599) sobre SOF .. dados */
+    uint32_t crc = 0U;
+    for (uint32_t i = 0U; i < n; i++) {
+        uint32_t next = bits[i] ^ ((crc >> 14) & 1U);
+        crc = (crc << 1) & 0x7FFFU;
+        if (next != 0U) {
+            crc ^= 0x4599U;
         }
     }
-    if (latencyMutex == NULL) {
-        latencyMutex = xSemaphoreCreateMutex();
-        if (latencyMutex == NULL) {
-            ESP_LOGE(TAG, "Falha ao criar mutex de latência.");
-            return CAN_ESP_ERR_UNKNOWN;
+    n = frame_put_bits(bits, n, crc, 15U);
+
+    /* Conta os bits de stuffing: após 5 bits iguais insere-se o complemento, que inicia nova sequência */
+    uint8_t last = bits[0];
+    uint32_t run = 1U;
+    for (uint32_t i = 1U; i < n; i++) {
+        if (bits[i] == last) {
+            run++;
+        } else {
+            last = bits[i];
+            run = 1U;
+        }
+        if (run == 5U) {
+            stuff++;
+            last = (uint8_t)(last ^ 1U);
+            run = 1U;
         }
     }
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig = *config;
-    configInitialized = true;
-    xSemaphoreGive(configMutex);
+    return stuffable + stuff + FRAME_FIXED_TAIL_BITS;
+}
 
-    /* Inicializa a medição do bus load */
-    busLoadStartTime = esp_timer_get_time();
-    busLoadTotalTime = 0;
+can_esp_status_t CAN_ESP_SetBusLoadStuffingMode_v2(can_esp_handle_t handle, CanEspStuffingMode_t mode)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
 
-    generalConfig = (twai_general_config_t)TWAI_GENERAL_CONFIG_DEFAULT(currentConfig.tx_gpio, currentConfig.rx_gpio, currentConfig.mode);
-    if (currentConfig.use_custom_timing) {
-        timingConfig = currentConfig.custom_timing_config;
-    } else {
-        timingConfig = GetTimingConfig(currentConfig.bitrate);
+    if (mode != CAN_ESP_STUFFING_WORST_CASE && mode != CAN_ESP_STUFFING_EXACT) {
+        ESP_LOGE(TAG, "Modo de stuffing inválido.");
+        return CAN_ESP_ERR_INVALID_PARAM;
     }
-    filterConfig = currentConfig.filter_config;
+    handle->busLoadStuffingMode = mode;
+    return CAN_ESP_OK;
+}
 
-    if (twai_driver_install(&generalConfig, &timingConfig, &filterConfig) != ESP_OK) {
-        ESP_LOGE(TAG, "Falha na instalação do driver TWAI.");
-        return CAN_ESP_ERR_DRIVER_INSTALL;
+can_esp_status_t CAN_ESP_SetBusLoadStuffingMode(CanEspStuffingMode_t mode)
+{
+    return CAN_ESP_SetBusLoadStuffingMode_v2(&defaultInstance, mode);
+}
+
+/* Avança a janela até a época corrente, zerando os baldes que saíram dela (chamar com busLoadLock) */
+static void load_window_advance(CanEspLoadWindow_t *win, int64_t now)
+{
+    int64_t epoch = now / win->bucket_us;
+    int64_t gap = epoch - win->epoch;
+    if (gap <= 0) {
+        return;
     }
-    if (twai_start() != ESP_OK) {
-        ESP_LOGE(TAG, "Falha ao iniciar o barramento CAN.");
-        return CAN_ESP_ERR_DRIVER_START;
+    if (gap > (int64_t)CAN_ESP_BUSLOAD_BUCKETS) {
+        gap = (int64_t)CAN_ESP_BUSLOAD_BUCKETS;
     }
-    ESP_LOGI(TAG, "Barramento CAN iniciado com configuração dinâmica.");
-
-    if (txQueue == NULL) {
-        txQueue = xQueueCreate(TX_QUEUE_LENGTH, sizeof(CanEspMessage_t));
-        if (txQueue == NULL) {
-            ESP_LOGE(TAG, "Falha ao criar a fila de transmissão.");
-            return CAN_ESP_ERR_UNKNOWN;
-        }
+    for (int64_t i = 1; i <= gap; i++) {
+        win->bits[(uint32_t)((win->epoch + i) % (int64_t)CAN_ESP_BUSLOAD_BUCKETS)] = 0U;
     }
-    return CAN_ESP_OK;
+    win->epoch = epoch;
 }
 
-can_esp_status_t CAN_ESP_Init(void)
+/* Contabiliza um quadro transmitido ou recebido nas janelas de bus load */
+static void bus_load_account(can_esp_handle_t inst, const twai_message_t *frame, bool is_tx, int64_t now)
 {
-    if (!configInitialized) {
-        currentConfig.bitrate = 1000000U;
-        currentConfig.tx_gpio = CAN_TX_GPIO;
-        currentConfig.rx_gpio = CAN_RX_GPIO;
-        currentConfig.transmit_timeout_ms = CAN_DEFAULT_TRANSMIT_TIMEOUT_MS;
-        currentConfig.receive_timeout_ms = CAN_DEFAULT_RECEIVE_TIMEOUT_MS;
-        currentConfig.use_checksum = false;  /* Padrão: checksum desabilitado */
-        configInitialized = true;
+    uint32_t bits = CAN_ESP_CalculateFrameBits(frame->identifier, frame->extd != 0U, frame->rtr != 0U,
+                                               frame->data_length_code, frame->data, inst->busLoadStuffingMode);
+
+    portENTER_CRITICAL(&inst->busLoadLock);
+    for (uint32_t w = 0U; w < 3U; w++) {
+        load_window_advance(&inst->busLoadWindows[w], now);
+        inst->busLoadWindows[w].bits[(uint32_t)(inst->busLoadWindows[w].epoch % (int64_t)CAN_ESP_BUSLOAD_BUCKETS)] += bits;
+    }
+    inst->busLoadTotalBits += bits;
+    if (is_tx) {
+        inst->busLoadTxFrames++;
+    } else {
+        inst->busLoadRxFrames++;
     }
-    return CAN_ESP_InitWithConfig(&currentConfig);
+    portEXIT_CRITICAL(&inst->busLoadLock);
 }
 
-can_esp_status_t CAN_ESP_UpdateConfig(const CanEspConfig_t *config)
+/*
+ * Utilização da janela em décimos de porcento: bits observados sobre a capacidade do barramento
+ * no intervalo coberto (9 baldes completos mais o balde corrente, limitado ao início da medição).
+ */
+static uint32_t load_window_permille(can_esp_handle_t inst, CanEspLoadWindow_t *win, int64_t now, uint32_t bitrate)
 {
-    can_esp_status_t status;
-    if (config == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de configuração nulo na atualização.");
-        return CAN_ESP_ERR_NULL_POINTER;
+    uint64_t sum = 0U;
+    int64_t span;
+
+    load_window_advance(win, now);
+    for (uint32_t i = 0U; i < CAN_ESP_BUSLOAD_BUCKETS; i++) {
+        sum += win->bits[i];
     }
-    status = CAN_ESP_Deinit();
-    if (status != CAN_ESP_OK) {
-        return status;
+    span = ((int64_t)(CAN_ESP_BUSLOAD_BUCKETS - 1U) * win->bucket_us) + (now - (win->epoch * win->bucket_us));
+    if (span > (now - inst->busLoadStartTime)) {
+        span = now - inst->busLoadStartTime;
+    }
+    if (span <= 0 || bitrate == 0U) {
+        return 0U;
     }
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig = *config;
-    xSemaphoreGive(configMutex);
-    return CAN_ESP_InitWithConfig(config);
+    /* capacidade em bits = bitrate * span_us / 1e6 */
+    uint64_t permille = (sum * 1000000ULL * 1000ULL) / ((uint64_t)bitrate * (uint64_t)span);
+    return (permille > 1000U) ? 1000U : (uint32_t)permille;
 }
 
-can_esp_status_t CAN_ESP_Deinit(void)
+can_esp_status_t CAN_ESP_GetBusLoadStats_v2(can_esp_handle_t handle, CanEspBusLoadStats_t *stats)
 {
-    if (twai_stop() != ESP_OK) {
-        ESP_LOGE(TAG, "Falha ao parar o barramento CAN.");
-        return CAN_ESP_ERR_DRIVER_STOP;
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-    if (twai_driver_uninstall() != ESP_OK) {
-        ESP_LOGE(TAG, "Falha ao desinstalar o driver TWAI.");
-        return CAN_ESP_ERR_DRIVER_UNINSTALL;
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas de bus load nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-    ESP_LOGI(TAG, "Barramento CAN desinicializado com sucesso.");
+    int64_t now = esp_timer_get_time();
+    uint32_t bitrate = handle->currentConfig.bitrate;
+
+    portENTER_CRITICAL(&handle->busLoadLock);
+    stats->load_100ms_permille = load_window_permille(handle, &handle->busLoadWindows[0], now, bitrate);
+    stats->load_1s_permille = load_window_permille(handle, &handle->busLoadWindows[1], now, bitrate);
+    stats->load_10s_permille = load_window_permille(handle, &handle->busLoadWindows[2], now, bitrate);
+    stats->total_bits = handle->busLoadTotalBits;
+    stats->tx_frames = handle->busLoadTxFrames;
+    stats->rx_frames = handle->busLoadRxFrames;
+    portEXIT_CRITICAL(&handle->busLoadLock);
+    stats->bitrate = bitrate;
+    stats->stuffing_mode = handle->busLoadStuffingMode;
     return CAN_ESP_OK;
 }
 
-/*==============================================================================
-                   FUNÇÕES DE ATUALIZAÇÃO PARCIAL
- ==============================================================================*/
+can_esp_status_t CAN_ESP_GetBusLoadStats(CanEspBusLoadStats_t *stats)
+{
+    return CAN_ESP_GetBusLoadStats_v2(&defaultInstance, stats);
+}
 
-can_esp_status_t CAN_ESP_SetFilterConfig(const twai_filter_config_t *new_filter_config)
+/**
+ * @brief Retorna a carga do barramento (bus load) em porcentagem.
+ *
+ * Utilização da janela deslizante de 1 s, calculada a partir dos bits no fio de todos os
+ * quadros transmitidos e recebidos (ver CAN_ESP_GetBusLoadStats).
+ *
+ * @return uint32_t Porcentagem de bus load.
+ */
+uint32_t CAN_ESP_GetBusLoad_v2(can_esp_handle_t handle)
 {
-    if (new_filter_config == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de nova configuração de filtro nulo.");
-        return CAN_ESP_ERR_NULL_POINTER;
+    CanEspBusLoadStats_t stats;
+
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    if (CAN_ESP_GetBusLoadStats_v2(handle, &stats) != CAN_ESP_OK) {
+        return 0U;
     }
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig.filter_config = *new_filter_config;
-    xSemaphoreGive(configMutex);
-    ESP_LOGI(TAG, "Nova configuração de filtro atualizada. Reinicializando driver...");
-    return CAN_ESP_UpdateConfig(&currentConfig);
+    return stats.load_1s_permille / 10U;
 }
 
-can_esp_status_t CAN_ESP_SetTimeouts(uint32_t tx_timeout_ms, uint32_t rx_timeout_ms)
+uint32_t CAN_ESP_GetBusLoad(void)
 {
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig.transmit_timeout_ms = tx_timeout_ms;
-    currentConfig.receive_timeout_ms  = rx_timeout_ms;
-    xSemaphoreGive(configMutex);
-    ESP_LOGI(TAG, "Timeouts atualizados: Tx = %" PRIu32 " ms, Rx = %" PRIu32 " ms", tx_timeout_ms, rx_timeout_ms);
-    return CAN_ESP_OK;
+    return CAN_ESP_GetBusLoad_v2(&defaultInstance);
 }
 
 /*==============================================================================
-                        FUNÇÕES DE COMUNICAÇÃO SÍNCRONA
+          ESTATÍSTICAS DE TRÁFEGO POR IDENTIFICADOR CAN
  ==============================================================================*/
 
-can_esp_status_t CAN_ESP_SendMessage(uint32_t id, const uint8_t *data, uint8_t length)
+#define ID_STATS_KEY_VALID  (0x80000000U)
+
+/* Hash multiplicativo (razão áurea) do identificador */
+static uint32_t id_stats_hash(uint32_t id)
 {
-    twai_message_t message;
-    if (data == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de dados nulo.");
-        return CAN_ESP_ERR_NULL_POINTER;
-    }
-    if (length > CAN_MAX_DATA_LENGTH) {
-        ESP_LOGE(TAG, "Tamanho inválido dos dados. Máximo de %u bytes permitido.", (unsigned int)CAN_MAX_DATA_LENGTH);
-        return CAN_ESP_ERR_INVALID_LENGTH;
-    }
-    message.identifier = id;
-    message.data_length_code = length;
-    message.extd = 1U;
-    message.rtr = 0;
-    message.ss = 0;
-    message.self = currentConfig.self_rx ? 1U : 0U;
-    memcpy(message.data, data, length);
-    if (currentConfig.use_checksum) {
-        if (length < CAN_MAX_DATA_LENGTH) {
-            uint8_t cs = CAN_ESP_CalculateChecksum(data, length);
-            message.data[length] = cs;
-            message.data_length_code = length + 1;
-        } else {
-            ESP_LOGE(TAG, "Não há espaço para checksum nos dados.");
-            return CAN_ESP_ERR_INVALID_LENGTH;
+    return ((id * 2654435761U) >> 16) & (CAN_ESP_ID_STATS_TABLE_SIZE - 1U);
+}
+
+/* Localiza (ou cria, se create) a entrada do ID por sondagem linear; chamar com idStatsLock */
+static CanEspIdStatsEntry_t *id_stats_lookup(can_esp_handle_t inst, uint32_t id, bool create)
+{
+    uint32_t key = id | ID_STATS_KEY_VALID;
+    uint32_t slot = id_stats_hash(id);
+    for (uint32_t probe = 0U; probe < CAN_ESP_ID_STATS_TABLE_SIZE; probe++) {
+        CanEspIdStatsEntry_t *entry = &inst->idStatsTable[slot];
+        if (entry->key == key) {
+            return entry;
         }
-    }
-    if (twai_transmit(&message, pdMS_TO_TICKS(currentConfig.transmit_timeout_ms)) != ESP_OK) {
-        ESP_LOGE(TAG, "Falha ao transmitir mensagem CAN (ID: 0x%08X).", (unsigned int)id);
-        if (transmit_callback != NULL) {
-            transmit_callback(id, data, length, CAN_ESP_ERR_TRANSMIT);
+        if (entry->key == 0U) {
+            if (!create) {
+                return NULL;
+            }
+            memset(entry, 0, sizeof(*entry));
+            entry->key = key;
+            return entry;
         }
-        return CAN_ESP_ERR_TRANSMIT;
+        slot = (slot + 1U) & (CAN_ESP_ID_STATS_TABLE_SIZE - 1U);
     }
-    if (transmit_callback != NULL) {
-        transmit_callback(id, data, length, CAN_ESP_OK);
-    }
-    return CAN_ESP_OK;
+    return NULL;
 }
 
-can_esp_status_t CAN_ESP_ReceiveMessage(CanEspMessage_t *message, uint32_t timeout_ms)
+static void id_stats_update_dir(CanEspIdDirAcc_t *acc, uint8_t length, int64_t now)
 {
-    twai_message_t rx_message;
-    if (message == NULL) {
-        ESP_LOGE(TAG, "Ponteiro para mensagem nulo.");
-        return CAN_ESP_ERR_NULL_POINTER;
-    }
-    if (twai_receive(&rx_message, pdMS_TO_TICKS(timeout_ms)) == ESP_OK) {
-        message->id = rx_message.identifier;
-        message->length = rx_message.data_length_code;
-        memcpy(message->data, rx_message.data, rx_message.data_length_code);
-        if (currentConfig.use_checksum) {
-            if (message->length < 1U) {
-                ESP_LOGE(TAG, "Mensagem recebida sem dados para checksum.");
-                return CAN_ESP_ERR_RECEIVE;
-            }
-            uint8_t calc_cs = CAN_ESP_CalculateChecksum(message->data, message->length - 1);
-            if (calc_cs != message->data[message->length - 1]) {
-                ESP_LOGE(TAG, "Falha na verificação de checksum para a mensagem (ID: 0x%08X).", (unsigned int)message->id);
-                return CAN_ESP_ERR_RECEIVE;
-            }
-            message->length -= 1;
+    if (acc->frames > 0U) {
+        uint32_t interarrival = (uint32_t)(now - acc->last_timestamp_us);
+        if (acc->frames > 1U) {
+            /* Jitter: média exponencial (1/16) da variação entre intervalos consecutivos */
+            int32_t d = (int32_t)(interarrival - acc->last_interarrival_us);
+            uint32_t abs_d = (d < 0) ? (uint32_t)(-d) : (uint32_t)d;
+            acc->jitter_x16 += abs_d - ((acc->jitter_x16 + 8U) >> 4);
+        }
+        acc->sum_interarrival_us += interarrival;
+        acc->last_interarrival_us = interarrival;
+        if (interarrival > acc->max_interarrival_us) {
+            acc->max_interarrival_us = interarrival;
         }
-        return CAN_ESP_OK;
     }
-    ESP_LOGE(TAG, "Timeout ou erro ao receber mensagem CAN.");
-    return CAN_ESP_ERR_TIMEOUT;
+    acc->frames++;
+    acc->bytes += length;
+    acc->last_timestamp_us = now;
 }
 
-/* Função para registrar callback de recepção */
-can_esp_status_t CAN_ESP_RegisterReceiveCallback(can_esp_receive_callback_t callback)
+static void id_stats_record(can_esp_handle_t inst, uint32_t id, uint8_t length, bool is_tx, int64_t now)
 {
-    if (callback == NULL) {
-        ESP_LOGE(TAG, "Tentativa de registrar callback de recepção nulo.");
-        return CAN_ESP_ERR_NULL_POINTER;
+    portENTER_CRITICAL(&inst->idStatsLock);
+    CanEspIdStatsEntry_t *entry = id_stats_lookup(inst, id, true);
+    if (entry == NULL) {
+        inst->idStatsUntracked++;
+    } else {
+        id_stats_update_dir(is_tx ? &entry->tx : &entry->rx, length, now);
     }
-    receive_callback = callback;
-    ESP_LOGI(TAG, "Callback de recepção registrado com sucesso.");
-    return CAN_ESP_OK;
+    portEXIT_CRITICAL(&inst->idStatsLock);
 }
 
-/* Processa mensagens recebidas chamando o callback registrado */
-void CAN_ESP_ProcessReceivedMessages(void)
+static void id_stats_export_dir(const CanEspIdDirAcc_t *acc, CanEspIdDirStats_t *out)
 {
-    CanEspMessage_t received_msg;
-    if (CAN_ESP_ReceiveMessage(&received_msg, CAN_PROCESS_TIMEOUT_MS) == CAN_ESP_OK) {
-        if (currentConfig.debug_level >= 2) {
-            ESP_LOGI(TAG, "Mensagem recebida - ID: 0x%08X, Length: %u",
-                     (unsigned int)received_msg.id, (unsigned int)received_msg.length);
-        }
-        if (receive_callback != NULL) {
-            receive_callback(&received_msg);
+    out->frames = acc->frames;
+    out->bytes = acc->bytes;
+    out->last_timestamp_us = acc->last_timestamp_us;
+    out->mean_interarrival_us = (acc->frames > 1U) ?
+                                (uint32_t)(acc->sum_interarrival_us / (acc->frames - 1U)) : 0U;
+    out->max_interarrival_us = acc->max_interarrival_us;
+    out->jitter_us = acc->jitter_x16 >> 4;
+}
+
+static void id_stats_export(const CanEspIdStatsEntry_t *entry, CanEspIdStats_t *out)
+{
+    out->id = entry->key & ~ID_STATS_KEY_VALID;
+    id_stats_export_dir(&entry->rx, &out->rx);
+    id_stats_export_dir(&entry->tx, &out->tx);
+}
+
+/* Ponto único de contabilização de quadros transmitidos e recebidos */
+static void account_frame(can_esp_handle_t inst, const twai_message_t *frame, bool is_tx, int64_t now)
+{
+    bus_load_account(inst, frame, is_tx, now);
+    id_stats_record(inst, frame->identifier, frame->data_length_code, is_tx, now);
+    can_esp_capture_record_frame(instance_channel(inst), frame, is_tx, now);
+}
+
+can_esp_status_t CAN_ESP_GetIdStats_v2(can_esp_handle_t handle, CanEspIdStats_t *out, size_t max, size_t *count, uint32_t *untracked_frames)
+{
+    CanEspIdStatsEntry_t entry;
+    size_t n = 0U;
+
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (out == NULL || count == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na consulta de estatísticas por ID.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    /* Cópia entrada a entrada: cada seção crítica dura apenas o memcpy de um slot */
+    for (uint32_t i = 0U; i < CAN_ESP_ID_STATS_TABLE_SIZE && n < max; i++) {
+        portENTER_CRITICAL(&handle->idStatsLock);
+        entry = handle->idStatsTable[i];
+        portEXIT_CRITICAL(&handle->idStatsLock);
+        if (entry.key != 0U) {
+            id_stats_export(&entry, &out[n]);
+            n++;
         }
     }
+    *count = n;
+    if (untracked_frames != NULL) {
+        *untracked_frames = handle->idStatsUntracked;
+    }
+    return CAN_ESP_OK;
 }
 
-/*==============================================================================
-                    FUNÇÕES DE TRANSMISSÃO ASSÍNCRONA
- ==============================================================================*/
+can_esp_status_t CAN_ESP_GetIdStats(CanEspIdStats_t *out, size_t max, size_t *count, uint32_t *untracked_frames)
+{
+    return CAN_ESP_GetIdStats_v2(&defaultInstance, out, max, count, untracked_frames);
+}
 
-can_esp_status_t CAN_ESP_EnqueueMessage(const CanEspMessage_t *msg, bool high_priority)
+can_esp_status_t CAN_ESP_GetIdStatsEntry_v2(can_esp_handle_t handle, uint32_t id, CanEspIdStats_t *out)
 {
-    CanEspMessage_t local_msg;
-    BaseType_t ret;
-    if (msg == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de mensagem nulo ao enfileirar.");
+    CanEspIdStatsEntry_t entry;
+    CanEspIdStatsEntry_t *found;
+
+    if (handle == NULL) {
         return CAN_ESP_ERR_NULL_POINTER;
     }
-    if (txQueue == NULL) {
-        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
-        return CAN_ESP_ERR_UNKNOWN;
+
+    if (out == NULL) {
+        ESP_LOGE(TAG, "Ponteiro nulo na consulta de estatísticas por ID.");
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-    memcpy(&local_msg, msg, sizeof(CanEspMessage_t));
-    local_msg.retry_count = 0U;
-    if (high_priority) {
-        ret = xQueueSendToFront(txQueue, &local_msg, portMAX_DELAY);
-    } else {
-        ret = xQueueSend(txQueue, &local_msg, portMAX_DELAY);
+    portENTER_CRITICAL(&handle->idStatsLock);
+    found = id_stats_lookup(handle, id, false);
+    if (found != NULL) {
+        entry = *found;
     }
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Falha ao enfileirar mensagem para transmissão.");
-        return CAN_ESP_ERR_TRANSMIT;
+    portEXIT_CRITICAL(&handle->idStatsLock);
+    if (found == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    id_stats_export(&entry, out);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetIdStatsEntry(uint32_t id, CanEspIdStats_t *out)
+{
+    return CAN_ESP_GetIdStatsEntry_v2(&defaultInstance, id, out);
+}
+
+void CAN_ESP_ResetIdStats_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&handle->idStatsLock);
+    memset(handle->idStatsTable, 0, sizeof(handle->idStatsTable));
+    handle->idStatsUntracked = 0U;
+    portEXIT_CRITICAL(&handle->idStatsLock);
+}
+
+void CAN_ESP_ResetIdStats(void)
+{
+    CAN_ESP_ResetIdStats_v2(&defaultInstance);
+}
+
+/*==============================================================================
+          ESCALONADOR DE MENSAGENS CÍCLICAS (ESP_TIMER ÚNICO)
+ ==============================================================================*/
+
+static uint32_t cyclic_gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0U) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
     }
-    return CAN_ESP_OK;
+    return a;
 }
 
-/* Ajusta dinamicamente a prioridade da tarefa de transmissão com base na saturação da fila */
-can_esp_status_t CAN_ESP_AdjustTransmitTaskPriority(void)
+/*
+ * Escolhe o deslocamento de fase da nova mensagem: entre CAN_ESP_CYCLIC_OFFSET_CANDIDATES
+ * candidatos uniformes em [0, período), maximiza a menor distância às liberações existentes.
+ * Duas mensagens de períodos P e Pi só coincidem módulo gcd(P, Pi), por isso a distância é
+ * medida nesse módulo (chamar com cyclicMutex).
+ */
+static uint32_t cyclic_choose_offset(can_esp_handle_t inst, uint32_t period_us)
 {
-    UBaseType_t count;
-    UBaseType_t threshold;
-    const UBaseType_t baselinePriority = 10U;
-    const UBaseType_t highPriority = 15U;
-    UBaseType_t currentPriority;
+    uint32_t step = period_us / CAN_ESP_CYCLIC_OFFSET_CANDIDATES;
+    uint32_t best_offset = 0U;
+    uint32_t best_distance = 0U;
 
-    if (txQueue == NULL || canTxTaskHandle == NULL) {
-        ESP_LOGE(TAG, "Fila de transmissão ou handle da tarefa nula.");
-        return CAN_ESP_ERR_UNKNOWN;
+    if (step == 0U) {
+        step = 1U;
     }
-    count = uxQueueMessagesWaiting(txQueue);
-    threshold = (TX_QUEUE_LENGTH * 80U) / 100U;
-    currentPriority = uxTaskPriorityGet(canTxTaskHandle);
-    if (count >= threshold && currentPriority < highPriority) {
-        ESP_LOGI(TAG, "Alta saturação da fila (%u mensagens). Aumentando prioridade para %u.",
-                 (unsigned int)count, (unsigned int)highPriority);
-        vTaskPrioritySet(canTxTaskHandle, highPriority);
-    } else if (count < threshold && currentPriority > baselinePriority) {
-        ESP_LOGI(TAG, "Fila abaixo do limiar (%u mensagens). Restaurando prioridade para %u.",
-                 (unsigned int)count, (unsigned int)baselinePriority);
-        vTaskPrioritySet(canTxTaskHandle, baselinePriority);
+    for (uint32_t candidate = 0U; candidate < period_us; candidate += step) {
+        uint32_t min_distance = UINT32_MAX;
+        for (uint32_t i = 0U; i < CAN_ESP_MAX_CYCLIC_MESSAGES; i++) {
+            if (!inst->cyclicEntries[i].in_use) {
+                continue;
+            }
+            uint32_t g = cyclic_gcd(period_us, inst->cyclicEntries[i].period_us);
+            uint32_t diff = (candidate % g + g - (inst->cyclicEntries[i].offset_us % g)) % g;
+            uint32_t distance = (diff < (g - diff)) ? diff : (g - diff);
+            if (distance < min_distance) {
+                min_distance = distance;
+            }
+        }
+        if (min_distance == UINT32_MAX) {
+            return 0U;      /* Primeira mensagem: fase zero */
+        }
+        if (min_distance > best_distance) {
+            best_distance = min_distance;
+            best_offset = candidate;
+        }
     }
-    return CAN_ESP_OK;
+    return best_offset;
 }
 
-/* Tarefa de transmissão assíncrona */
-static void CAN_ESP_TransmitTask(void *arg)
+/* Primeira liberação da grade época + offset + k * período que não esteja no passado */
+static int64_t cyclic_first_release(can_esp_handle_t inst, const CanEspCyclicEntry_t *entry, int64_t now)
 {
-    CanEspMessage_t msg;
-    twai_message_t tx_msg;
-    int64_t tx_start, tx_end, latency;
-    for (;;) {
-        if (xQueueReceive(txQueue, &msg, portMAX_DELAY) == pdPASS) {
-            convert_canesp_to_twai(&msg, &tx_msg);
-            totalTransmissionAttempts++;
-            tx_start = esp_timer_get_time();
-            if (twai_transmit(&tx_msg, pdMS_TO_TICKS(currentConfig.transmit_timeout_ms)) != ESP_OK) {
-                ESP_LOGE(TAG, "Falha ao transmitir mensagem (ID: 0x%08X).", (unsigned int)msg.id);
-                if (msg.retry_count < CAN_ESP_MAX_RETRANSMISSIONS) {
-                    msg.retry_count++;
-                    totalRetransmissions++;
-                    totalCollisions++;
-                    vTaskDelay(pdMS_TO_TICKS(CAN_ESP_BACKOFF_MS));
-                    (void)CAN_ESP_EnqueueMessage(&msg, true);
-                } else {
-                    if (transmit_callback != NULL) {
-                        transmit_callback(msg.id, msg.data, msg.length, CAN_ESP_ERR_TRANSMIT);
-                    }
-                }
-            } else {
-                tx_end = esp_timer_get_time();
-                latency = tx_end - tx_start;
-                xSemaphoreTake(latencyMutex, portMAX_DELAY);
-                latencyMetrics.num_samples++;
-                latencyMetrics.total_latency += latency;
-                if (latency < latencyMetrics.min_latency) {
-                    latencyMetrics.min_latency = latency;
-                }
-                if (latency > latencyMetrics.max_latency) {
-                    latencyMetrics.max_latency = latency;
-                }
-                xSemaphoreGive(latencyMutex);
-                busLoadTotalTime += latency;
-                if (currentConfig.debug_level >= 2) {
-                    ESP_LOGI(TAG, "Mensagem (ID: 0x%08X) transmitida em %" PRId64 " ms",
-                             (unsigned int)msg.id, (latency / 1000U));
-                }
-                if (transmit_callback != NULL) {
-                    transmit_callback(msg.id, msg.data, msg.length, CAN_ESP_OK);
-                }
-            }
-            (void)CAN_ESP_AdjustTransmitTaskPriority();
-        }
+    int64_t first = inst->cyclicEpochUs + (int64_t)entry->offset_us;
+    if (first < now) {
+        int64_t periods = ((now - first) + (int64_t)entry->period_us - 1) / (int64_t)entry->period_us;
+        first += periods * (int64_t)entry->period_us;
     }
+    return first;
 }
 
-void CAN_ESP_StartTransmitTask(void)
+/* Rearma o temporizador para a próxima liberação (chamar com cyclicMutex) */
+static void cyclic_arm_timer(can_esp_handle_t inst, int64_t now)
 {
-    if (txQueue == NULL) {
-        txQueue = xQueueCreate(TX_QUEUE_LENGTH, sizeof(CanEspMessage_t));
-        if (txQueue == NULL) {
-            ESP_LOGE(TAG, "Falha ao criar a fila de transmissão.");
-            return;
+    int64_t next = INT64_MAX;
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_CYCLIC_MESSAGES; i++) {
+        if (inst->cyclicEntries[i].in_use && inst->cyclicEntries[i].next_release_us < next) {
+            next = inst->cyclicEntries[i].next_release_us;
         }
     }
-    xTaskCreate(CAN_ESP_TransmitTask, "CAN_TX_Task", 4096, NULL, 10, &canTxTaskHandle);
+    (void)esp_timer_stop(inst->cyclicTimer);
+    if (next != INT64_MAX) {
+        (void)esp_timer_start_once(inst->cyclicTimer, (next > now) ? (uint64_t)(next - now) : 1U);
+    }
 }
 
-/*==============================================================================
-               FUNÇÕES AUXILIARES PARA CODIFICAÇÃO DO ID CAN
- ==============================================================================*/
+/* Nova tentativa do escalonador quando o callback encontra cyclicMutex ocupado */
+#define CYCLIC_LOCK_RETRY_US    (200U)
 
-uint32_t CAN_ESP_EncodeID(uint8_t priority, uint16_t module, uint16_t command)
+/*
+ * Callback do esp_timer: libera as mensagens vencidas em um único lote não bloqueante. Sob
+ * cyclicMutex (sem espera) apenas atualiza a agenda e copia as liberações vencidas; os
+ * callbacks de preenchimento e o enfileiramento executam fora do mutex. Os resultados (pulos
+ * e falhas de enfileiramento) voltam às entradas que não foram re-registradas nesse intervalo.
+ */
+static void cyclic_timer_callback(void *arg)
 {
-    return (((uint32_t)(priority & 0x07U) << 26) |
-            ((uint32_t)(module & 0x03FFU) << 16) |
-            ((uint32_t)(command & 0xFFFFU)));
-}
+    can_esp_handle_t inst = (can_esp_handle_t)arg;
+    CanEspMessage_t batch[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    can_esp_cyclic_fill_t fills[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    void *contexts[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    uint8_t slots[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    uint32_t generations[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    bool skipped[CAN_ESP_MAX_CYCLIC_MESSAGES];
+    size_t due = 0U;
+    size_t count = 0U;
+    size_t accepted = 0U;
+    size_t i;
+    int64_t now = esp_timer_get_time();
 
-void CAN_ESP_DecodeID(uint32_t id, uint8_t *priority, uint16_t *module, uint16_t *command)
-{
-    if (priority != NULL) {
-        *priority = (uint8_t)((id >> 26) & 0x07U);
+    if (xSemaphoreTake(inst->cyclicMutex, 0) != pdTRUE) {
+        /* Registro ou consulta em curso: não bloqueia a tarefa do esp_timer */
+        inst->cyclicLockContentions++;
+        (void)esp_timer_start_once(inst->cyclicTimer, CYCLIC_LOCK_RETRY_US);
+        return;
     }
-    if (module != NULL) {
-        *module = (uint16_t)((id >> 16) & 0x03FFU);
+    for (uint32_t n = 0U; n < CAN_ESP_MAX_CYCLIC_MESSAGES; n++) {
+        CanEspCyclicEntry_t *entry = &inst->cyclicEntries[n];
+        if (!entry->in_use || entry->next_release_us > now) {
+            continue;
+        }
+        uint32_t jitter = (uint32_t)(now - entry->next_release_us);
+        entry->stats.releases++;
+        entry->stats.last_jitter_us = jitter;
+        entry->sum_jitter_us += jitter;
+        entry->stats.mean_jitter_us = (uint32_t)(entry->sum_jitter_us / entry->stats.releases);
+        if (jitter > entry->stats.max_jitter_us) {
+            entry->stats.max_jitter_us = jitter;
+        }
+        /* Atrasos maiores que um período descartam as liberações perdidas em vez de gerar rajadas */
+        entry->next_release_us += entry->period_us;
+        if (entry->next_release_us <= now) {
+            int64_t missed = ((now - entry->next_release_us) / (int64_t)entry->period_us) + 1;
+            entry->stats.missed_releases += (uint32_t)missed;
+            entry->next_release_us += missed * (int64_t)entry->period_us;
+        }
+        memset(&batch[due], 0, sizeof(batch[due]));
+        batch[due].id = entry->id;
+        fills[due] = entry->fill;
+        contexts[due] = entry->ctx;
+        slots[due] = (uint8_t)n;
+        generations[due] = entry->generation;
+        due++;
     }
-    if (command != NULL) {
-        *command = (uint16_t)(id & 0xFFFFU);
+    cyclic_arm_timer(inst, esp_timer_get_time());
+    xSemaphoreGive(inst->cyclicMutex);
+
+    /* Preenchimento fora do mutex; o lote é compactado sobre as liberações puladas */
+    for (i = 0U; i < due; i++) {
+        skipped[i] = (fills[i] != NULL) && !fills[i](&batch[i], contexts[i]);
+        if (!skipped[i]) {
+            if (count != i) {
+                batch[count] = batch[i];
+            }
+            count++;
+        }
+    }
+    if (count > 0U) {
+        (void)CAN_ESP_TryEnqueueBatch_v2(inst, batch, count, false, &accepted);
+    }
+    if (count == due && accepted == count) {
+        return;
     }
-}
 
-/*==============================================================================
-            FUNÇÃO DE CALLBACK PARA TRANSMISSÃO (OPCIONAL)
- ==============================================================================*/
+    if (xSemaphoreTake(inst->cyclicMutex, 0) != pdTRUE) {
+        inst->cyclicLockContentions++;
+        return;
+    }
+    count = 0U;
+    for (i = 0U; i < due; i++) {
+        CanEspCyclicEntry_t *entry = &inst->cyclicEntries[slots[i]];
+        bool counted = entry->in_use && entry->generation == generations[i];
+        if (skipped[i]) {
+            if (counted) {
+                entry->stats.skipped++;
+            }
+            continue;
+        }
+        if (count >= accepted && counted) {
+            entry->stats.enqueue_failures++;
+        }
+        count++;
+    }
+    xSemaphoreGive(inst->cyclicMutex);
+}
 
-can_esp_status_t CAN_ESP_RegisterTransmitCallback(can_esp_transmit_callback_t callback)
+/* Cria o mutex e o esp_timer do escalonador na primeira utilização */
+static bool cyclic_init(can_esp_handle_t inst)
 {
-    transmit_callback = callback;
-    ESP_LOGI(TAG, "Callback de transmissão registrado com sucesso (opcional).");
-    return CAN_ESP_OK;
+    if (inst->cyclicMutex == NULL) {
+        inst->cyclicMutex = xSemaphoreCreateMutex();
+        if (inst->cyclicMutex == NULL) {
+            return false;
+        }
+    }
+    if (inst->cyclicTimer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = cyclic_timer_callback,
+            .arg = inst,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "can_cyclic",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&args, &inst->cyclicTimer) != ESP_OK) {
+            return false;
+        }
+        inst->cyclicEpochUs = esp_timer_get_time();
+    }
+    return true;
 }
 
-/*==============================================================================
-                 FUNÇÃO DE DIAGNÓSTICO / STATUS TWAI
- ==============================================================================*/
-
-can_esp_status_t CAN_ESP_GetDiagnostics(CanEspDiagnostics_t *diag)
+can_esp_status_t CAN_ESP_RegisterCyclicMessage_v2(can_esp_handle_t handle, uint32_t id, uint32_t period_us, uint32_t offset_us,
+                                                  can_esp_cyclic_fill_t fill_callback, void *ctx,
+                                                  can_esp_cyclic_t *cyclic)
 {
-    twai_status_info_t status_info;
-    if (diag == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de diagnóstico nulo.");
+    uint32_t slot = CAN_ESP_MAX_CYCLIC_MESSAGES;
+
+    if (handle == NULL) {
         return CAN_ESP_ERR_NULL_POINTER;
     }
-    if (twai_get_status_info(&status_info) != ESP_OK) {
-        ESP_LOGE(TAG, "Erro ao obter status TWAI.");
+
+    if (period_us < CAN_ESP_CYCLIC_MIN_PERIOD_US) {
+        ESP_LOGE(TAG, "Período cíclico inválido (mínimo de %u us).", (unsigned int)CAN_ESP_CYCLIC_MIN_PERIOD_US);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (!cyclic_init(handle)) {
+        ESP_LOGE(TAG, "Falha ao criar o escalonador de mensagens cíclicas.");
         return CAN_ESP_ERR_UNKNOWN;
     }
-    diag->tx_error_counter = status_info.tx_error_counter;
-    diag->rx_error_counter = status_info.rx_error_counter;
-    diag->bus_off = (status_info.state == TWAI_STATE_BUS_OFF) ? true : false;
+    xSemaphoreTake(handle->cyclicMutex, portMAX_DELAY);
+    for (uint32_t i = 0U; i < CAN_ESP_MAX_CYCLIC_MESSAGES; i++) {
+        if (!handle->cyclicEntries[i].in_use) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == CAN_ESP_MAX_CYCLIC_MESSAGES) {
+        xSemaphoreGive(handle->cyclicMutex);
+        ESP_LOGE(TAG, "Limite de mensagens cíclicas atingido.");
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    CanEspCyclicEntry_t *entry = &handle->cyclicEntries[slot];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = id;
+    entry->period_us = period_us;
+    entry->offset_us = (offset_us == CAN_ESP_CYCLIC_AUTO_OFFSET) ? cyclic_choose_offset(handle, period_us)
+                                                                 : (offset_us % period_us);
+    entry->fill = fill_callback;
+    entry->ctx = ctx;
+    entry->generation = ++handle->cyclicGeneration;
+    entry->next_release_us = cyclic_first_release(handle, entry, esp_timer_get_time());
+    entry->stats.offset_us = entry->offset_us;
+    entry->in_use = true;
+    cyclic_arm_timer(handle, esp_timer_get_time());
+    xSemaphoreGive(handle->cyclicMutex);
+
+    ESP_LOGI(TAG, "Mensagem cíclica 0x%08X registrada: período %" PRIu32 " us, fase %" PRIu32 " us.",
+             (unsigned int)id, period_us, entry->offset_us);
+    if (cyclic != NULL) {
+        *cyclic = slot;
+    }
     return CAN_ESP_OK;
 }
 
-/*==============================================================================
-         FUNÇÃO PARA MONITORAMENTO DE LATÊNCIA
- ==============================================================================*/
+can_esp_status_t CAN_ESP_RegisterCyclicMessage(uint32_t id, uint32_t period_us, uint32_t offset_us,
+                                               can_esp_cyclic_fill_t fill_callback, void *ctx,
+                                               can_esp_cyclic_t *cyclic)
+{
+    return CAN_ESP_RegisterCyclicMessage_v2(&defaultInstance, id, period_us, offset_us, fill_callback, ctx, cyclic);
+}
 
-can_esp_status_t CAN_ESP_GetLatencyMetrics(CanEspLatencyMetrics_t *metrics)
+can_esp_status_t CAN_ESP_UnregisterCyclicMessage_v2(can_esp_handle_t handle, can_esp_cyclic_t cyclic)
 {
-    if (metrics == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de métricas nulo.");
+    if (handle == NULL) {
         return CAN_ESP_ERR_NULL_POINTER;
     }
-    xSemaphoreTake(latencyMutex, portMAX_DELAY);
-    *metrics = latencyMetrics;
-    xSemaphoreGive(latencyMutex);
+
+    if (cyclic >= CAN_ESP_MAX_CYCLIC_MESSAGES || handle->cyclicMutex == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    xSemaphoreTake(handle->cyclicMutex, portMAX_DELAY);
+    if (!handle->cyclicEntries[cyclic].in_use) {
+        xSemaphoreGive(handle->cyclicMutex);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    handle->cyclicEntries[cyclic].in_use = false;
+    cyclic_arm_timer(handle, esp_timer_get_time());
+    xSemaphoreGive(handle->cyclicMutex);
     return CAN_ESP_OK;
 }
 
-/*==============================================================================
-         FUNÇÃO PARA CONSULTA DO STATUS DA FILA DE TRANSMISSÃO
- ==============================================================================*/
+can_esp_status_t CAN_ESP_UnregisterCyclicMessage(can_esp_cyclic_t cyclic)
+{
+    return CAN_ESP_UnregisterCyclicMessage_v2(&defaultInstance, cyclic);
+}
 
-can_esp_status_t CAN_ESP_GetQueueStatus(CanEspQueueStatus_t *status)
+can_esp_status_t CAN_ESP_GetCyclicStats_v2(can_esp_handle_t handle, can_esp_cyclic_t cyclic, CanEspCyclicStats_t *stats)
 {
-    if (status == NULL) {
-        ESP_LOGE(TAG, "Ponteiro de status nulo.");
+    if (handle == NULL) {
         return CAN_ESP_ERR_NULL_POINTER;
     }
-    if (txQueue == NULL) {
-        ESP_LOGE(TAG, "Fila de transmissão não inicializada.");
-        return CAN_ESP_ERR_UNKNOWN;
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas cíclicas nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
     }
-    status->messages_waiting = uxQueueMessagesWaiting(txQueue);
-    status->queue_capacity = TX_QUEUE_LENGTH;
+    if (cyclic >= CAN_ESP_MAX_CYCLIC_MESSAGES || handle->cyclicMutex == NULL) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    xSemaphoreTake(handle->cyclicMutex, portMAX_DELAY);
+    if (!handle->cyclicEntries[cyclic].in_use) {
+        xSemaphoreGive(handle->cyclicMutex);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    *stats = handle->cyclicEntries[cyclic].stats;
+    stats->lock_contentions = handle->cyclicLockContentions;
+    xSemaphoreGive(handle->cyclicMutex);
     return CAN_ESP_OK;
 }
 
-/*==============================================================================
-          FUNÇÃO PARA CALCULAR BUS LOAD
- ==============================================================================*/
-/**
- * @brief Retorna a carga do barramento (bus load) em porcentagem.
- *
- * Calcula a razão entre o tempo total de transmissão acumulado (busLoadTotalTime)
- * e o tempo decorrido desde o início da medição (busLoadStartTime).
- *
- * @return uint32_t Porcentagem de bus load.
- */
-uint32_t CAN_ESP_GetBusLoad(void)
+can_esp_status_t CAN_ESP_GetCyclicStats(can_esp_cyclic_t cyclic, CanEspCyclicStats_t *stats)
 {
-    int64_t now = esp_timer_get_time();
-    int64_t elapsed = now - busLoadStartTime;
-    if (elapsed <= 0) {
-        return 0U;
-    }
-    return (uint32_t)((busLoadTotalTime * 100LL) / elapsed);
+    return CAN_ESP_GetCyclicStats_v2(&defaultInstance, cyclic, stats);
 }
 
 /*==============================================================================
@@ -597,9 +4871,18 @@ uint32_t CAN_ESP_GetBusLoad(void)
  * 
  * @return uint32_t Total de retransmissões ocorridas.
  */
+uint32_t CAN_ESP_GetRetransmissionCount_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    return handle->totalRetransmissions;
+}
+
 uint32_t CAN_ESP_GetRetransmissionCount(void)
 {
-    return totalRetransmissions;
+    return CAN_ESP_GetRetransmissionCount_v2(&defaultInstance);
 }
 
 /*==============================================================================
@@ -612,9 +4895,18 @@ uint32_t CAN_ESP_GetRetransmissionCount(void)
  *
  * @return uint32_t Total de tentativas de transmissão.
  */
+uint32_t CAN_ESP_GetTransmissionAttempts_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    return handle->totalTransmissionAttempts;
+}
+
 uint32_t CAN_ESP_GetTransmissionAttempts(void)
 {
-    return totalTransmissionAttempts;
+    return CAN_ESP_GetTransmissionAttempts_v2(&defaultInstance);
 }
 
 /*==============================================================================
@@ -628,9 +4920,18 @@ uint32_t CAN_ESP_GetTransmissionAttempts(void)
  *
  * @return uint32_t Número total de colisões.
  */
+uint32_t CAN_ESP_GetCollisionCount_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    return handle->totalCollisions;
+}
+
 uint32_t CAN_ESP_GetCollisionCount(void)
 {
-    return totalCollisions;
+    return CAN_ESP_GetCollisionCount_v2(&defaultInstance);
 }
  
 /**
@@ -641,33 +4942,219 @@ uint32_t CAN_ESP_GetCollisionCount(void)
  *
  * @return uint32_t Taxa de colisões em porcentagem.
  */
-uint32_t CAN_ESP_GetCollisionRate(void)
+uint32_t CAN_ESP_GetCollisionRate_v2(can_esp_handle_t handle)
 {
-    if (totalTransmissionAttempts == 0) {
+    if (handle == NULL) {
+        return 0U;
+    }
+
+    if (handle->totalTransmissionAttempts == 0) {
         return 0U;
     }
-    return (uint32_t)((totalCollisions * 100ULL) / totalTransmissionAttempts);
+    return (uint32_t)((handle->totalCollisions * 100ULL) / handle->totalTransmissionAttempts);
+}
+
+uint32_t CAN_ESP_GetCollisionRate(void)
+{
+    return CAN_ESP_GetCollisionRate_v2(&defaultInstance);
+}
+
+/*==============================================================================
+          ANEL SPSC DE RECEPÇÃO (PRODUTOR: RX TASK / CONSUMIDOR: DESPACHO)
+ ==============================================================================*/
+
+/**
+ * @brief Reserva o próximo slot livre do anel (lado produtor).
+ *
+ * @return Ponteiro para o slot, ou NULL se o anel estiver cheio.
+ */
+static CanEspMessage_t *rx_ring_acquire_slot(can_esp_handle_t inst)
+{
+    uint32_t head = atomic_load_explicit(&inst->rxRingHead, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&inst->rxRingTail, memory_order_acquire);
+    if ((head - tail) >= CAN_ESP_RX_RING_SIZE) {
+        return NULL;
+    }
+    return &inst->rxRing[head & (CAN_ESP_RX_RING_SIZE - 1U)];
+}
+
+/**
+ * @brief Publica o slot reservado para o consumidor (lado produtor).
+ */
+static void rx_ring_commit_slot(can_esp_handle_t inst)
+{
+    uint32_t head = atomic_load_explicit(&inst->rxRingHead, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&inst->rxRingTail, memory_order_acquire);
+    uint32_t level = (head - tail) + 1U;
+    if (level > atomic_load_explicit(&inst->rxRingHighWater, memory_order_relaxed)) {
+        atomic_store_explicit(&inst->rxRingHighWater, level, memory_order_relaxed);
+    }
+    atomic_store_explicit(&inst->rxRingHead, head + 1U, memory_order_release);
+}
+
+/**
+ * @brief Obtém a mensagem mais antiga do anel sem copiá-la (lado consumidor).
+ *
+ * O slot permanece reservado ao consumidor até rx_ring_release.
+ *
+ * @return Ponteiro para o slot, ou NULL se o anel estiver vazio.
+ */
+static const CanEspMessage_t *rx_ring_peek(can_esp_handle_t inst)
+{
+    uint32_t tail = atomic_load_explicit(&inst->rxRingTail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&inst->rxRingHead, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+    return &inst->rxRing[tail & (CAN_ESP_RX_RING_SIZE - 1U)];
+}
+
+/**
+ * @brief Libera ao produtor o slot obtido com rx_ring_peek (lado consumidor).
+ */
+static void rx_ring_release(can_esp_handle_t inst)
+{
+    uint32_t tail = atomic_load_explicit(&inst->rxRingTail, memory_order_relaxed);
+    atomic_store_explicit(&inst->rxRingTail, tail + 1U, memory_order_release);
+}
+
+can_esp_status_t CAN_ESP_GetRxRingStats_v2(can_esp_handle_t handle, CanEspRxRingStats_t *stats)
+{
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas do anel nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    uint32_t head = atomic_load_explicit(&handle->rxRingHead, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&handle->rxRingTail, memory_order_acquire);
+    stats->capacity = CAN_ESP_RX_RING_SIZE;
+    stats->level = head - tail;
+    stats->high_water_mark = atomic_load_explicit(&handle->rxRingHighWater, memory_order_relaxed);
+    stats->pushed = head;
+    stats->popped = tail;
+    stats->overflows = atomic_load_explicit(&handle->rxRingOverflows, memory_order_relaxed);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_GetRxRingStats(CanEspRxRingStats_t *stats)
+{
+    return CAN_ESP_GetRxRingStats_v2(&defaultInstance, stats);
+}
+
+void CAN_ESP_ResetRxRingHighWaterMark_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    atomic_store_explicit(&handle->rxRingHighWater, 0U, memory_order_relaxed);
+}
+
+void CAN_ESP_ResetRxRingHighWaterMark(void)
+{
+    CAN_ESP_ResetRxRingHighWaterMark_v2(&defaultInstance);
 }
 
 /*==============================================================================
           IMPLEMENTAÇÃO DA TAREFA DE RECEPÇÃO (EVENTOS)
  ==============================================================================*/
 
+/* Recebe um quadro do driver sem registrar log em timeout (uso interno da tarefa de recepção) */
+static can_esp_status_t receive_from_driver(can_esp_handle_t inst, CanEspMessage_t *msg, TickType_t ticks)
+{
+    twai_message_t rx_message;
+    if (drv_receive(inst, &rx_message, ticks) != ESP_OK) {
+        return CAN_ESP_ERR_TIMEOUT;
+    }
+    return convert_twai_to_canesp(inst, &rx_message, msg, esp_timer_get_time());
+}
+
+/*
+ * Publica no anel um quadro recebido e acorda o consumidor. A notificação é enviada a cada
+ * quadro: notificar apenas na transição de vazio perderia o despertar quando o consumidor
+ * esvazia o anel e adormece entre a leitura do nível e a publicação do novo head.
+ */
+static void rx_task_receive_into_ring(can_esp_handle_t inst, TickType_t ticks)
+{
+    CanEspMessage_t discard;
+    CanEspMessage_t *slot = rx_ring_acquire_slot(inst);
+    if (slot == NULL) {
+        /* Anel cheio: mantém o driver drenado e descarta o quadro */
+        if (receive_from_driver(inst, &discard, ticks) == CAN_ESP_OK) {
+            atomic_fetch_add_explicit(&inst->rxRingOverflows, 1U, memory_order_relaxed);
+        }
+        return;
+    }
+    if (receive_from_driver(inst, slot, ticks) == CAN_ESP_OK) {
+        rx_ring_commit_slot(inst);
+        if (inst->canDispatchTaskHandle != NULL) {
+            xTaskNotifyGive(inst->canDispatchTaskHandle);
+        }
+    }
+}
+
+/*
+ * Tarefa produtora: recebe do driver diretamente no slot livre do anel e apenas acorda o
+ * consumidor, de modo que o custo do callback do usuário não atrasa a recepção. A espera é
+ * limitada a CAN_ESP_RX_PAUSE_POLL_MS para atender pedidos de reconfiguração; antes de pausar,
+ * drena para o anel todos os quadros já recebidos pelo driver.
+ */
 static void CAN_ESP_ReceiveTask(void *arg)
 {
-    CanEspMessage_t msg;
+    can_esp_handle_t inst = (can_esp_handle_t)arg;
+    twai_status_info_t info;
     for (;;) {
-        if (CAN_ESP_ReceiveMessage(&msg, portMAX_DELAY) == CAN_ESP_OK) {
-            if (receive_callback != NULL) {
-                receive_callback(&msg);
+        if (inst->reconfigPauseRequested) {
+            while (drv_get_status_info(inst, &info) == ESP_OK && info.msgs_to_rx > 0U) {
+                rx_task_receive_into_ring(inst, 0);
             }
+            (void)xSemaphoreGive(inst->reconfigAckSemaphore);
+            (void)xSemaphoreTake(inst->rxResumeSemaphore, portMAX_DELAY);
+            continue;
+        }
+        rx_task_receive_into_ring(inst, pdMS_TO_TICKS(CAN_ESP_RX_PAUSE_POLL_MS));
+    }
+}
+
+/*
+ * Tarefa consumidora: drena o anel e entrega as mensagens ao callback e às inscrições
+ * diretamente a partir do slot, liberado somente após o despacho.
+ */
+static void CAN_ESP_DispatchTask(void *arg)
+{
+    can_esp_handle_t inst = (can_esp_handle_t)arg;
+    const CanEspMessage_t *msg;
+    for (;;) {
+        for (msg = rx_ring_peek(inst); msg != NULL; msg = rx_ring_peek(inst)) {
+            dispatch_received_message(inst, msg);
+            rx_ring_release(inst);
         }
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
 }
 
+void CAN_ESP_StartReceiveTask_v2(can_esp_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    (void)task_create(CAN_ESP_DispatchTask, "CAN_Dispatch_Task", &handle->taskConfig.dispatch, handle,
+                      &handle->canDispatchTaskHandle);
+    if (!reconfig_init(handle)) {
+        ESP_LOGE(TAG, "Falha ao criar semáforos de reconfiguração.");
+        return;
+    }
+    (void)task_create(CAN_ESP_ReceiveTask, "CAN_RX_Task", &handle->taskConfig.receive, handle,
+                      &handle->canRxTaskHandle);
+}
+
 void CAN_ESP_StartReceiveTask(void)
 {
-    xTaskCreate(CAN_ESP_ReceiveTask, "CAN_RX_Task", 4096, NULL, 10, NULL);
+    CAN_ESP_StartReceiveTask_v2(&defaultInstance);
 }
 
 /*==============================================================================
@@ -680,8 +5167,12 @@ void CAN_ESP_StartReceiveTask(void)
  * Envia uma mensagem com o timestamp atual e, utilizando self_rx, aguarda o retorno para
  * calcular o tempo de round-trip.
  */
-can_esp_status_t CAN_ESP_MeasureRoundTripTime(int64_t *round_trip_time, uint32_t timeout_ms)
+can_esp_status_t CAN_ESP_MeasureRoundTripTime_v2(can_esp_handle_t handle, int64_t *round_trip_time, uint32_t timeout_ms)
 {
+    if (handle == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+
     if (round_trip_time == NULL) {
         ESP_LOGE(TAG, "Ponteiro de round_trip_time nulo.");
         return CAN_ESP_ERR_NULL_POINTER;
@@ -692,46 +5183,52 @@ can_esp_status_t CAN_ESP_MeasureRoundTripTime(int64_t *round_trip_time, uint32_t
     memcpy(payload, &send_timestamp, sizeof(send_timestamp));
 
     /* Ativa self_rx temporariamente */
-    bool original_self_rx = currentConfig.self_rx;
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig.self_rx = true;
-    xSemaphoreGive(configMutex);
+    bool original_self_rx = handle->currentConfig.self_rx;
+    xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+    handle->currentConfig.self_rx = true;
+    xSemaphoreGive(handle->configMutex);
 
-    can_esp_status_t status = CAN_ESP_SendMessage(CAN_ESP_SELF_TEST_ID, payload, sizeof(payload));
+    can_esp_status_t status = CAN_ESP_SendMessage_v2(handle, CAN_ESP_SELF_TEST_ID, payload, sizeof(payload));
     if (status != CAN_ESP_OK) {
         ESP_LOGE(TAG, "Falha ao enviar mensagem de self-test.");
-        xSemaphoreTake(configMutex, portMAX_DELAY);
-        currentConfig.self_rx = original_self_rx;
-        xSemaphoreGive(configMutex);
+        xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+        handle->currentConfig.self_rx = original_self_rx;
+        xSemaphoreGive(handle->configMutex);
         return status;
     }
 
     CanEspMessage_t rx_msg;
-    status = CAN_ESP_ReceiveMessage(&rx_msg, timeout_ms);
+    status = CAN_ESP_ReceiveMessage_v2(handle, &rx_msg, timeout_ms);
     if (status != CAN_ESP_OK) {
         ESP_LOGE(TAG, "Falha ou timeout na recepção da mensagem de self-test.");
-        xSemaphoreTake(configMutex, portMAX_DELAY);
-        currentConfig.self_rx = original_self_rx;
-        xSemaphoreGive(configMutex);
+        xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+        handle->currentConfig.self_rx = original_self_rx;
+        xSemaphoreGive(handle->configMutex);
         return status;
     }
 
     if (rx_msg.length < sizeof(send_timestamp)) {
         ESP_LOGE(TAG, "Mensagem de self-test com tamanho inválido.");
-        xSemaphoreTake(configMutex, portMAX_DELAY);
-        currentConfig.self_rx = original_self_rx;
-        xSemaphoreGive(configMutex);
+        xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+        handle->currentConfig.self_rx = original_self_rx;
+        xSemaphoreGive(handle->configMutex);
         return CAN_ESP_ERR_RECEIVE;
     }
     int64_t received_timestamp = 0;
     memcpy(&received_timestamp, rx_msg.data, sizeof(received_timestamp));
 
-    *round_trip_time = esp_timer_get_time() - send_timestamp;
+    /* Instante de recepção registrado junto ao driver, sem o atraso de escalonamento posterior */
+    *round_trip_time = rx_msg.timestamp_us - received_timestamp;
     ESP_LOGI(TAG, "Self-test round-trip time: %" PRId64 " ms", (*round_trip_time / 1000U));
 
-    xSemaphoreTake(configMutex, portMAX_DELAY);
-    currentConfig.self_rx = original_self_rx;
-    xSemaphoreGive(configMutex);
+    xSemaphoreTake(handle->configMutex, portMAX_DELAY);
+    handle->currentConfig.self_rx = original_self_rx;
+    xSemaphoreGive(handle->configMutex);
 
     return CAN_ESP_OK;
 }
+
+can_esp_status_t CAN_ESP_MeasureRoundTripTime(int64_t *round_trip_time, uint32_t timeout_ms)
+{
+    return CAN_ESP_MeasureRoundTripTime_v2(&defaultInstance, round_trip_time, timeout_ms);
+}
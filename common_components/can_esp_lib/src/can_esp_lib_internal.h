@@ -0,0 +1,54 @@
+/*
+ * can_esp_lib_internal.h
+ * Funções internas da can_esp_lib compartilhadas entre os módulos do componente
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ *
+ * Cabeçalho privado: não faz parte da API pública e não deve ser incluído pelas aplicações.
+ */
+
+#ifndef CAN_ESP_LIB_INTERNAL_H
+#define CAN_ESP_LIB_INTERNAL_H
+
+#include "can_esp_lib.h"
+
+#include <stdatomic.h>
+
+/* Conversão para o formato do driver (aplica checksum e self_rx da configuração da instância) */
+void can_esp_convert_canesp_to_twai(can_esp_handle_t inst, const CanEspMessage_t *src, twai_message_t *dst);
+
+/* Transmissão de um quadro bruto pelo caminho de transmissão da instância (can_esp_replay.c) */
+can_esp_status_t can_esp_transmit_raw_frame(can_esp_handle_t inst, const twai_message_t *frame);
+
+/* Fila de transmissão por níveis de prioridade da instância (slots do pool de mensagens) */
+bool can_esp_tx_ring_init(can_esp_handle_t inst);
+CanEspMessage_t *can_esp_tx_ring_pop(can_esp_handle_t inst);
+void can_esp_tx_ring_release(can_esp_handle_t inst, CanEspMessage_t *msg);
+
+/*
+ * Captura de quadros (can_esp_capture.c): chamadas a cada quadro contabilizado e a cada mudança
+ * de estado de erro; retornam de imediato se a captura não estiver ativa.
+ */
+void can_esp_capture_record_frame(uint8_t channel, const twai_message_t *frame, bool is_tx, int64_t now);
+void can_esp_capture_record_bus_state(uint8_t channel, CanEspBusState_t state, int64_t now);
+
+/*
+ * Histograma log-linear (estilo HDR) da latência de transmissão, em microsegundos: os 16
+ * primeiros baldes são unitários e cada faixa [16 * 2^(k-1), 16 * 2^k) é dividida em 16
+ * sub-baldes de largura 2^(k-1), o que limita o erro relativo a 1/16. Todos os campos são
+ * atômicos, de modo que a tarefa de transmissão registra amostras sem mutex.
+ */
+typedef struct {
+    atomic_uint counts[CAN_ESP_LATENCY_HIST_BUCKETS];
+    atomic_uint num_samples;
+    atomic_llong total_latency;
+    atomic_llong min_latency;
+    atomic_llong max_latency;
+} CanEspLatencyHist_t;
+
+void can_esp_latency_hist_reset(CanEspLatencyHist_t *hist);
+void can_esp_latency_hist_record(CanEspLatencyHist_t *hist, int64_t latency);
+void can_esp_latency_hist_snapshot(CanEspLatencyHist_t *hist, CanEspLatencyMetrics_t *metrics);
+
+#endif /* CAN_ESP_LIB_INTERNAL_H */
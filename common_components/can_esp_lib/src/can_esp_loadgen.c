@@ -0,0 +1,362 @@
+/*
+ * can_esp_loadgen.c
+ * Implementação do gerador de tráfego CAN sintético
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_loadgen.h"
+#include "can_esp_instance.h"
+#include "can_esp_lib_internal.h"
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+#define TAG    "CAN_ESP_LOADGEN"
+
+/* Cargas úteis amostradas por fluxo para estimar os bits no fio */
+#define LOADGEN_PLAN_SAMPLES    (8U)
+
+/* Semente usada quando a configuração informa 0 (o xorshift não aceita estado nulo) */
+#define LOADGEN_DEFAULT_SEED    (0x2545F491U)
+
+/* Mesmo layout de CAN_ESP_EncodeID, utilizável em inicializadores estáticos */
+#define LOADGEN_ID(priority, command) \
+    (((uint32_t)(priority) << 26) | ((uint32_t)CAN_ESP_LOADGEN_MODULE << 16) | (uint32_t)(command))
+
+/*
+ * Mistura padrão: prioridades 0 a 7, períodos e tamanhos típicos de um veículo. A concentração
+ * nos fluxos rápidos limita a carga máxima: com todos os períodos em proporção, o mais curto
+ * atinge CAN_ESP_CYCLIC_MIN_PERIOD_US em cerca de 120 % de 1 Mbit/s.
+ */
+static const CanEspLoadGenStream_t loadGenDefaultMix[] = {
+    { LOADGEN_ID(0U, 0x0001U), 8U, 10000U },
+    { LOADGEN_ID(0U, 0x0002U), 8U, 10000U },
+    { LOADGEN_ID(1U, 0x0003U), 8U, 10000U },
+    { LOADGEN_ID(1U, 0x0004U), 8U, 10000U },
+    { LOADGEN_ID(2U, 0x0005U), 6U, 10000U },
+    { LOADGEN_ID(2U, 0x0006U), 4U, 10000U },
+    { LOADGEN_ID(3U, 0x0007U), 8U, 20000U },
+    { LOADGEN_ID(4U, 0x0008U), 8U, 20000U },
+    { LOADGEN_ID(5U, 0x0009U), 2U, 20000U },
+    { LOADGEN_ID(5U, 0x000AU), 8U, 20000U },
+    { LOADGEN_ID(6U, 0x000BU), 8U, 50000U },
+    { LOADGEN_ID(7U, 0x000CU), 1U, 100000U },
+};
+
+typedef struct {
+    uint32_t id;
+    uint8_t  dlc;
+    uint32_t period_us;         /* Período escalado */
+    uint32_t bits;              /* Bits no fio estimados por quadro */
+    uint32_t sequence;
+    uint32_t rng;
+    can_esp_cyclic_t cyclic;
+} LoadGenStream_t;
+
+/* Um gerador por vez; os fluxos são o contexto dos callbacks de preenchimento */
+static LoadGenStream_t loadGenStreams[CAN_ESP_LOADGEN_MAX_STREAMS];
+static size_t loadGenStreamCount;
+static can_esp_handle_t loadGenHandle;
+static bool loadGenRandomPayload;
+static uint32_t loadGenTargetPermille;
+static uint32_t loadGenPlannedPermille;
+static bool loadGenActive;      /* Reservado por CAN_ESP_LoadGenStart até o fim de CAN_ESP_LoadGenStop */
+static bool loadGenRunning;     /* Fluxos registrados */
+static portMUX_TYPE loadGenLock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================
+                        GERAÇÃO DAS CARGAS ÚTEIS
+ ==============================================================================*/
+
+/* xorshift32: barato o bastante para o callback do esp_timer e reprodutível pela semente */
+static uint32_t loadgen_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void loadgen_payload(LoadGenStream_t *stream, bool random_payload, uint8_t *data)
+{
+    if (random_payload) {
+        for (uint8_t i = 0U; i < stream->dlc; i++) {
+            data[i] = (uint8_t)(loadgen_random(&stream->rng) >> 24);
+        }
+    } else {
+        /* Contador de sequência little-endian, permitindo detectar perdas no receptor */
+        for (uint8_t i = 0U; i < stream->dlc; i++) {
+            data[i] = (i < 4U) ? (uint8_t)(stream->sequence >> (8U * i)) : 0U;
+        }
+    }
+    stream->sequence++;
+}
+
+/* Executa no esp_timer do escalonador cíclico */
+static bool loadgen_fill(CanEspMessage_t *msg, void *ctx)
+{
+    LoadGenStream_t *stream = (LoadGenStream_t *)ctx;
+
+    msg->length = stream->dlc;
+    loadgen_payload(stream, loadGenRandomPayload, msg->data);
+    return true;
+}
+
+/*==============================================================================
+                      PLANEJAMENTO DA CARGA ALVO
+ ==============================================================================*/
+
+/*
+ * Média dos bits no fio de algumas cargas úteis do próprio gerador, no quadro convertido para o
+ * driver (inclui o checksum quando habilitado) e com o modo de bit stuffing usado na medição.
+ */
+static uint32_t loadgen_frame_bits(can_esp_handle_t inst, const LoadGenStream_t *stream, bool random_payload,
+                                   CanEspStuffingMode_t mode)
+{
+    LoadGenStream_t sample = *stream;
+    CanEspMessage_t msg;
+    twai_message_t frame;
+    uint32_t total = 0U;
+
+    for (uint32_t i = 0U; i < LOADGEN_PLAN_SAMPLES; i++) {
+        memset(&msg, 0, sizeof(msg));
+        memset(&frame, 0, sizeof(frame));
+        msg.id = sample.id;
+        msg.length = sample.dlc;
+        loadgen_payload(&sample, random_payload, msg.data);
+        can_esp_convert_canesp_to_twai(inst, &msg, &frame);
+        total += CAN_ESP_CalculateFrameBits(frame.identifier, frame.extd != 0U, frame.rtr != 0U,
+                                            frame.data_length_code, frame.data, mode);
+    }
+    return total / LOADGEN_PLAN_SAMPLES;
+}
+
+/* Carga em milésimos de bit por segundo: soma de bits * 1e6 / período, vezes 1000 */
+static uint64_t loadgen_millibits_per_s(const LoadGenStream_t *streams, size_t count)
+{
+    uint64_t sum = 0U;
+    for (size_t i = 0U; i < count; i++) {
+        sum += ((uint64_t)streams[i].bits * 1000000000ULL) / streams[i].period_us;
+    }
+    return sum;
+}
+
+/*
+ * Multiplica todos os períodos pela razão carga nominal / carga alvo, preservando as proporções
+ * da mistura. Falha se algum período ficar abaixo do mínimo do escalonador cíclico.
+ */
+static can_esp_status_t loadgen_plan(can_esp_handle_t inst, const CanEspLoadGenConfig_t *config, uint32_t bitrate)
+{
+    CanEspBusLoadStats_t load;
+    uint64_t nominal;
+    uint64_t target = (uint64_t)bitrate * config->target_load_pct * 10U;
+    uint32_t seed = (config->seed != 0U) ? config->seed : LOADGEN_DEFAULT_SEED;
+
+    (void)CAN_ESP_GetBusLoadStats_v2(inst, &load);
+    for (size_t i = 0U; i < loadGenStreamCount; i++) {
+        LoadGenStream_t *stream = &loadGenStreams[i];
+        /* Estados distintos por fluxo, derivados da semente (nunca nulos) */
+        stream->rng = seed ^ ((uint32_t)(i + 1U) * 0x9E3779B9U);
+        if (stream->rng == 0U) {
+            stream->rng = LOADGEN_DEFAULT_SEED;
+        }
+        stream->sequence = 0U;
+        stream->bits = loadgen_frame_bits(inst, stream, config->random_payload, load.stuffing_mode);
+    }
+
+    nominal = loadgen_millibits_per_s(loadGenStreams, loadGenStreamCount);
+    for (size_t i = 0U; i < loadGenStreamCount; i++) {
+        uint64_t period = ((uint64_t)loadGenStreams[i].period_us * nominal) / target;
+        if (period < CAN_ESP_CYCLIC_MIN_PERIOD_US || period > UINT32_MAX) {
+            ESP_LOGE(TAG, "Carga alvo de %" PRIu32 "%% exige período de %" PRIu64 " us para o ID 0x%08X.",
+                     config->target_load_pct, period, (unsigned int)loadGenStreams[i].id);
+            return CAN_ESP_ERR_INVALID_PARAM;
+        }
+        loadGenStreams[i].period_us = (uint32_t)period;
+    }
+    loadGenTargetPermille = config->target_load_pct * 10U;
+    loadGenPlannedPermille = (uint32_t)(loadgen_millibits_per_s(loadGenStreams, loadGenStreamCount) / bitrate);
+    return CAN_ESP_OK;
+}
+
+/* Remove os fluxos já registrados (do último ao primeiro) */
+static void loadgen_unregister(size_t count)
+{
+    while (count > 0U) {
+        count--;
+        (void)CAN_ESP_UnregisterCyclicMessage_v2(loadGenHandle, loadGenStreams[count].cyclic);
+    }
+}
+
+/*==============================================================================
+                              API PÚBLICA
+ ==============================================================================*/
+
+void CAN_ESP_LoadGenDefaultConfig(CanEspLoadGenConfig_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->handle = NULL;
+    config->target_load_pct = 30U;
+    config->streams = NULL;
+    config->stream_count = 0U;
+    config->random_phase = false;
+    config->random_payload = false;
+    config->seed = 0U;
+}
+
+can_esp_status_t CAN_ESP_LoadGenStart(const CanEspLoadGenConfig_t *config)
+{
+    CanEspLoadGenConfig_t cfg;
+    CanEspBusLoadStats_t load;
+    can_esp_status_t status;
+    uint32_t phase_rng;
+    size_t registered = 0U;
+
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        CAN_ESP_LoadGenDefaultConfig(&cfg);
+    }
+    if (cfg.streams == NULL) {
+        cfg.streams = loadGenDefaultMix;
+        cfg.stream_count = sizeof(loadGenDefaultMix) / sizeof(loadGenDefaultMix[0]);
+    }
+    if (cfg.target_load_pct == 0U || cfg.target_load_pct > 100U) {
+        ESP_LOGE(TAG, "Carga alvo inválida (1 a 100%%).");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (cfg.stream_count == 0U || cfg.stream_count > CAN_ESP_LOADGEN_MAX_STREAMS) {
+        ESP_LOGE(TAG, "Quantidade de fluxos inválida (1 a %u).", (unsigned int)CAN_ESP_LOADGEN_MAX_STREAMS);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    for (size_t i = 0U; i < cfg.stream_count; i++) {
+        if (cfg.streams[i].dlc > CAN_MAX_DATA_LENGTH || cfg.streams[i].period_us == 0U) {
+            ESP_LOGE(TAG, "Fluxo %u inválido (DLC ou período).", (unsigned int)i);
+            return CAN_ESP_ERR_INVALID_PARAM;
+        }
+    }
+    loadGenHandle = (cfg.handle != NULL) ? cfg.handle : CAN_ESP_GetDefaultHandle();
+    (void)CAN_ESP_GetBusLoadStats_v2(loadGenHandle, &load);
+    if (load.bitrate == 0U) {
+        ESP_LOGE(TAG, "Bitrate da instância não configurado.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+
+    portENTER_CRITICAL(&loadGenLock);
+    if (loadGenActive) {
+        portEXIT_CRITICAL(&loadGenLock);
+        ESP_LOGE(TAG, "Já existe um gerador de carga ativo.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    loadGenActive = true;
+    portEXIT_CRITICAL(&loadGenLock);
+
+    memset(loadGenStreams, 0, sizeof(loadGenStreams));
+    loadGenStreamCount = cfg.stream_count;
+    loadGenRandomPayload = cfg.random_payload;
+    for (size_t i = 0U; i < cfg.stream_count; i++) {
+        loadGenStreams[i].id = cfg.streams[i].id;
+        loadGenStreams[i].dlc = cfg.streams[i].dlc;
+        loadGenStreams[i].period_us = cfg.streams[i].period_us;
+    }
+    status = loadgen_plan(loadGenHandle, &cfg, load.bitrate);
+
+    /* Fases aleatórias usam um estado próprio, para não alterar as cargas úteis planejadas */
+    phase_rng = ((cfg.seed != 0U) ? cfg.seed : LOADGEN_DEFAULT_SEED) ^ 0xA5A5A5A5U;
+    if (phase_rng == 0U) {
+        phase_rng = LOADGEN_DEFAULT_SEED;
+    }
+    while (status == CAN_ESP_OK && registered < loadGenStreamCount) {
+        LoadGenStream_t *stream = &loadGenStreams[registered];
+        uint32_t offset = cfg.random_phase ? (loadgen_random(&phase_rng) % stream->period_us)
+                                           : CAN_ESP_CYCLIC_AUTO_OFFSET;
+        status = CAN_ESP_RegisterCyclicMessage_v2(loadGenHandle, stream->id, stream->period_us, offset,
+                                                  loadgen_fill, stream, &stream->cyclic);
+        if (status == CAN_ESP_OK) {
+            registered++;
+        }
+    }
+    if (status != CAN_ESP_OK) {
+        loadgen_unregister(registered);
+        portENTER_CRITICAL(&loadGenLock);
+        loadGenActive = false;
+        portEXIT_CRITICAL(&loadGenLock);
+        return status;
+    }
+
+    portENTER_CRITICAL(&loadGenLock);
+    loadGenRunning = true;
+    portEXIT_CRITICAL(&loadGenLock);
+    ESP_LOGI(TAG, "Gerador de carga iniciado: %u fluxos, alvo %" PRIu32 " por mil, planejado %" PRIu32 " por mil.",
+             (unsigned int)loadGenStreamCount, loadGenTargetPermille, loadGenPlannedPermille);
+    return CAN_ESP_OK;
+}
+
+void CAN_ESP_LoadGenStop(void)
+{
+    portENTER_CRITICAL(&loadGenLock);
+    if (!loadGenRunning) {
+        portEXIT_CRITICAL(&loadGenLock);
+        return;
+    }
+    loadGenRunning = false;
+    portEXIT_CRITICAL(&loadGenLock);
+
+    /* Após a remoção o escalonador não chama mais loadgen_fill para esses fluxos */
+    loadgen_unregister(loadGenStreamCount);
+
+    portENTER_CRITICAL(&loadGenLock);
+    loadGenActive = false;
+    portEXIT_CRITICAL(&loadGenLock);
+    ESP_LOGI(TAG, "Gerador de carga interrompido.");
+}
+
+can_esp_status_t CAN_ESP_LoadGenGetStats(CanEspLoadGenStats_t *stats)
+{
+    CanEspBusLoadStats_t load;
+    bool running;
+
+    if (stats == NULL) {
+        ESP_LOGE(TAG, "Ponteiro de estatísticas nulo.");
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    memset(stats, 0, sizeof(*stats));
+    portENTER_CRITICAL(&loadGenLock);
+    running = loadGenRunning;
+    portEXIT_CRITICAL(&loadGenLock);
+    stats->running = running;
+    if (!running) {
+        return CAN_ESP_OK;
+    }
+
+    stats->streams = (uint32_t)loadGenStreamCount;
+    stats->target_permille = loadGenTargetPermille;
+    stats->planned_permille = loadGenPlannedPermille;
+    if (CAN_ESP_GetBusLoadStats_v2(loadGenHandle, &load) == CAN_ESP_OK) {
+        stats->measured_permille = load.load_1s_permille;
+    }
+    for (size_t i = 0U; i < loadGenStreamCount; i++) {
+        CanEspCyclicStats_t cyclic;
+        if (CAN_ESP_GetCyclicStats_v2(loadGenHandle, loadGenStreams[i].cyclic, &cyclic) != CAN_ESP_OK) {
+            continue;
+        }
+        stats->releases += cyclic.releases;
+        stats->missed_releases += cyclic.missed_releases;
+        stats->enqueue_failures += cyclic.enqueue_failures;
+        if (cyclic.max_jitter_us > stats->max_jitter_us) {
+            stats->max_jitter_us = cyclic.max_jitter_us;
+        }
+    }
+    return CAN_ESP_OK;
+}
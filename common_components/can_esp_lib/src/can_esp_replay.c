@@ -0,0 +1,567 @@
+/*
+ * can_esp_replay.c
+ * Implementação da reprodução temporizada de logs CAN
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_replay.h"
+#include "can_esp_instance.h"
+#include "can_esp_lib_internal.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#define TAG    "CAN_ESP_REPLAY"
+
+/* Máximo de campos considerados em uma linha (ASC: 6 campos + 8 bytes de dados) */
+#define REPLAY_MAX_TOKENS   (16U)
+/* Cauda final de cada espera feita em espera ativa; o restante bloqueia a task */
+#define REPLAY_SPIN_TAIL_US (300)
+/* Tempo máximo sem bloquear antes de ceder um tick às tasks de menor prioridade (IDLE) */
+#define REPLAY_YIELD_US     (10000)
+
+/* Resultado da leitura do próximo registro */
+typedef enum {
+    REPLAY_NEXT_END = 0,
+    REPLAY_NEXT_FRAME,
+    REPLAY_NEXT_SKIP
+} ReplayNext_t;
+
+typedef ReplayNext_t (*replay_next_t)(void *ctx, CanEspCaptureRecord_t *record);
+
+typedef struct {
+    const CanEspCaptureRecord_t *records;
+    size_t count;
+    size_t index;
+} ReplayRecordSource_t;
+
+typedef struct {
+    CanEspCaptureFormat_t format;
+    can_esp_replay_line_reader_t reader;
+    void *ctx;
+    char line[CAN_ESP_REPLAY_MAX_LINE_LENGTH];
+} ReplayLogSource_t;
+
+/* Uma reprodução por vez: o histograma de desvio é estático por ser grande para a pilha */
+static CanEspLatencyHist_t replayDeviation;
+static bool replayActive;
+static volatile bool replayStopRequested;
+static esp_timer_handle_t replayTimer;
+static TaskHandle_t replayWaiter;
+static int64_t replayLastBlockUs;
+static portMUX_TYPE replayLock = portMUX_INITIALIZER_UNLOCKED;
+
+/*==============================================================================
+                           INTERPRETAÇÃO DAS LINHAS
+ ==============================================================================*/
+
+static int replay_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Converte exatamente len dígitos hexadecimais */
+static bool replay_parse_hex(const char *s, size_t len, uint32_t *value)
+{
+    uint32_t v = 0U;
+    int d;
+
+    if (len == 0U || len > 8U) {
+        return false;
+    }
+    for (size_t i = 0U; i < len; i++) {
+        d = replay_hex_digit(s[i]);
+        if (d < 0) {
+            return false;
+        }
+        v = (v << 4) | (uint32_t)d;
+    }
+    *value = v;
+    return true;
+}
+
+/* Converte "segundos.fração" em microsegundos (frações com mais de 6 dígitos são truncadas) */
+static bool replay_parse_seconds(const char *s, int64_t *us)
+{
+    int64_t sec = 0;
+    int64_t frac = 0;
+    uint32_t digits = 0U;
+
+    if (*s < '0' || *s > '9') {
+        return false;
+    }
+    while (*s >= '0' && *s <= '9') {
+        sec = (sec * 10) + (int64_t)(*s - '0');
+        s++;
+    }
+    if (*s == '.') {
+        s++;
+        while (*s >= '0' && *s <= '9') {
+            if (digits < 6U) {
+                frac = (frac * 10) + (int64_t)(*s - '0');
+                digits++;
+            }
+            s++;
+        }
+    }
+    for (; digits < 6U; digits++) {
+        frac *= 10;
+    }
+    *us = (sec * 1000000) + frac;
+    return true;
+}
+
+/* Separa a linha (copiada em buf) em campos delimitados por espaços */
+static size_t replay_tokenize(const char *line, char *buf, size_t size, char **tokens)
+{
+    size_t n = 0U;
+    char *save = NULL;
+    char *tok;
+
+    (void)strncpy(buf, line, size - 1U);
+    buf[size - 1U] = '\0';
+    for (tok = strtok_r(buf, " \t\r\n", &save); tok != NULL && n < REPLAY_MAX_TOKENS;
+         tok = strtok_r(NULL, " \t\r\n", &save)) {
+        tokens[n++] = tok;
+    }
+    return n;
+}
+
+/* candump: "(s.us) canN ID#DADOS" ou "(s.us) canN ID#R[dlc]" */
+static can_esp_status_t replay_parse_candump(char **tok, size_t n, CanEspCaptureRecord_t *rec)
+{
+    const char *frame;
+    const char *hash;
+    const char *name;
+    size_t digits;
+    size_t idLen;
+    size_t dataLen;
+    uint32_t value;
+
+    if (n < 3U || tok[0][0] != '(' || !replay_parse_seconds(&tok[0][1], &rec->timestamp_us)) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    /* Canal: número no final do nome da interface (can0, vcan1...) */
+    name = tok[1];
+    digits = strlen(name);
+    while (digits > 0U && name[digits - 1U] >= '0' && name[digits - 1U] <= '9') {
+        digits--;
+    }
+    rec->channel = (uint8_t)atoi(&name[digits]);
+    frame = tok[2];
+    hash = strchr(frame, '#');
+    if (hash == NULL || hash[1] == '#') {
+        return CAN_ESP_ERR_INVALID_PARAM;       /* Sem separador ou CAN FD */
+    }
+    idLen = (size_t)(hash - frame);
+    if ((idLen != 3U && idLen != 8U) || !replay_parse_hex(frame, idLen, &rec->id)) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    rec->flags = (idLen == 8U) ? CAN_ESP_CAPTURE_FLAG_EXTD : 0U;
+    if ((rec->id & 0x20000000U) != 0U) {
+        return CAN_ESP_ERR_INVALID_PARAM;       /* Quadro de erro do SocketCAN */
+    }
+    rec->id &= 0x1FFFFFFFU;
+    (void)memset(rec->data, 0, sizeof(rec->data));
+    if (hash[1] == 'R') {
+        rec->flags |= CAN_ESP_CAPTURE_FLAG_RTR;
+        rec->length = (uint8_t)((hash[2] >= '0' && hash[2] <= '8') ? (hash[2] - '0') : 0);
+        return CAN_ESP_OK;
+    }
+    dataLen = strlen(&hash[1]);
+    if ((dataLen % 2U) != 0U || dataLen > (2U * CAN_MAX_DATA_LENGTH)) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    rec->length = (uint8_t)(dataLen / 2U);
+    for (uint8_t i = 0U; i < rec->length; i++) {
+        if (!replay_parse_hex(&hash[1U + (2U * i)], 2U, &value)) {
+            return CAN_ESP_ERR_INVALID_PARAM;
+        }
+        rec->data[i] = (uint8_t)value;
+    }
+    return CAN_ESP_OK;
+}
+
+/* ASC: "tempo canal ID[x] Rx|Tx d|r dlc [bytes]"; demais linhas (cabeçalho, eventos) são ignoradas */
+static can_esp_status_t replay_parse_asc(char **tok, size_t n, CanEspCaptureRecord_t *rec)
+{
+    size_t idLen;
+    uint32_t value;
+    int channel;
+
+    if (n < 6U || !replay_parse_seconds(tok[0], &rec->timestamp_us)) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (tok[1][0] < '0' || tok[1][0] > '9') {
+        return CAN_ESP_ERR_INVALID_PARAM;       /* Eventos como "CAN 1 Status:..." */
+    }
+    channel = atoi(tok[1]);
+    if (channel < 1) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    rec->channel = (uint8_t)(channel - 1);
+    idLen = strlen(tok[2]);
+    rec->flags = 0U;
+    if (idLen > 1U && (tok[2][idLen - 1U] == 'x' || tok[2][idLen - 1U] == 'X')) {
+        rec->flags |= CAN_ESP_CAPTURE_FLAG_EXTD;
+        idLen--;
+    }
+    if (!replay_parse_hex(tok[2], idLen, &rec->id) || rec->id > 0x1FFFFFFFU) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (strcmp(tok[3], "Tx") == 0) {
+        rec->flags |= CAN_ESP_CAPTURE_FLAG_TX;
+    } else if (strcmp(tok[3], "Rx") != 0) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (!replay_parse_hex(tok[5], strlen(tok[5]), &value) || value > CAN_MAX_DATA_LENGTH) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    rec->length = (uint8_t)value;
+    (void)memset(rec->data, 0, sizeof(rec->data));
+    if (strcmp(tok[4], "r") == 0) {
+        rec->flags |= CAN_ESP_CAPTURE_FLAG_RTR;
+        return CAN_ESP_OK;
+    }
+    if (strcmp(tok[4], "d") != 0 || n < (6U + rec->length)) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    for (uint8_t i = 0U; i < rec->length; i++) {
+        if (strlen(tok[6U + i]) != 2U || !replay_parse_hex(tok[6U + i], 2U, &value)) {
+            return CAN_ESP_ERR_INVALID_PARAM;
+        }
+        rec->data[i] = (uint8_t)value;
+    }
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_ReplayParseLine(CanEspCaptureFormat_t format, const char *line, CanEspCaptureRecord_t *record)
+{
+    char buf[CAN_ESP_REPLAY_MAX_LINE_LENGTH];
+    char *tokens[REPLAY_MAX_TOKENS];
+    size_t n;
+
+    if (line == NULL || record == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    n = replay_tokenize(line, buf, sizeof(buf), tokens);
+    if (format == CAN_ESP_CAPTURE_FORMAT_ASC) {
+        return replay_parse_asc(tokens, n, record);
+    }
+    return replay_parse_candump(tokens, n, record);
+}
+
+/*==============================================================================
+                               MOTOR DE REPRODUÇÃO
+ ==============================================================================*/
+
+void CAN_ESP_ReplayDefaultConfig(CanEspReplayConfig_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    config->handle = NULL;
+    config->speed_factor = 1.0f;
+    config->replay_rx = true;
+    config->replay_tx = true;
+    config->channel = -1;
+    config->bypass_tx_queue = false;
+}
+
+void CAN_ESP_ReplayStop(void)
+{
+    TaskHandle_t waiter;
+
+    portENTER_CRITICAL(&replayLock);
+    replayStopRequested = true;
+    waiter = replayWaiter;
+    portEXIT_CRITICAL(&replayLock);
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+/* Disparo do temporizador de espera: acorda a task da reprodução */
+static void replay_timer_callback(void *arg)
+{
+    (void)arg;
+    TaskHandle_t waiter;
+
+    portENTER_CRITICAL(&replayLock);
+    waiter = replayWaiter;
+    portEXIT_CRITICAL(&replayLock);
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+/*
+ * Aguarda até target_us: bloqueia em um temporizador one-shot até REPLAY_SPIN_TAIL_US antes do
+ * instante e faz espera ativa só nessa cauda, para que o desvio não dependa do tick. Retorna
+ * false se CAN_ESP_ReplayStop interromper a espera.
+ */
+static bool replay_wait_until(int64_t target_us)
+{
+    int64_t remaining = target_us - esp_timer_get_time();
+
+    while (remaining > REPLAY_SPIN_TAIL_US) {
+        if (replayStopRequested) {
+            return false;
+        }
+        if (esp_timer_start_once(replayTimer, (uint64_t)(remaining - REPLAY_SPIN_TAIL_US)) != ESP_OK) {
+            break;
+        }
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        (void)esp_timer_stop(replayTimer);
+        replayLastBlockUs = esp_timer_get_time();
+        remaining = target_us - replayLastBlockUs;
+    }
+    if (remaining > 0) {
+        esp_rom_delay_us((uint32_t)((remaining < REPLAY_SPIN_TAIL_US) ? remaining : REPLAY_SPIN_TAIL_US));
+    }
+    return !replayStopRequested;
+}
+
+/* Intervalos curtos nunca bloqueiam: cede um tick periodicamente para não esfomear a IDLE */
+static void replay_yield_if_busy(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (now - replayLastBlockUs >= REPLAY_YIELD_US) {
+        vTaskDelay(1);
+        replayLastBlockUs = esp_timer_get_time();
+    }
+}
+
+static bool replay_selected(const CanEspReplayConfig_t *config, const CanEspCaptureRecord_t *rec)
+{
+    bool is_tx = (rec->flags & CAN_ESP_CAPTURE_FLAG_TX) != 0U;
+
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_ERROR) != 0U) {
+        return false;
+    }
+    if (is_tx ? !config->replay_tx : !config->replay_rx) {
+        return false;
+    }
+    return (config->channel < 0) || ((int32_t)rec->channel == config->channel);
+}
+
+static void replay_to_twai(const CanEspCaptureRecord_t *rec, twai_message_t *frame)
+{
+    (void)memset(frame, 0, sizeof(*frame));
+    frame->identifier = rec->id;
+    frame->extd = ((rec->flags & CAN_ESP_CAPTURE_FLAG_EXTD) != 0U) ? 1U : 0U;
+    frame->rtr = ((rec->flags & CAN_ESP_CAPTURE_FLAG_RTR) != 0U) ? 1U : 0U;
+    frame->data_length_code = (rec->length <= CAN_MAX_DATA_LENGTH) ? rec->length : CAN_MAX_DATA_LENGTH;
+    if (frame->rtr == 0U) {
+        (void)memcpy(frame->data, rec->data, frame->data_length_code);
+    }
+}
+
+/*
+ * Envia um registro pela fila de transmissão ou, com bypass_tx_queue, direto no driver. Retorna
+ * false (sem enviar) se o quadro não cabe na fila: a biblioteca só transmite dados com ID estendido.
+ */
+static bool replay_send(const CanEspReplayConfig_t *config, can_esp_handle_t inst, const CanEspCaptureRecord_t *rec,
+                        can_esp_status_t *status)
+{
+    twai_message_t frame;
+    CanEspMessage_t msg = {0};
+
+    if (config->bypass_tx_queue) {
+        replay_to_twai(rec, &frame);
+        *status = can_esp_transmit_raw_frame(inst, &frame);
+        return true;
+    }
+    if ((rec->flags & CAN_ESP_CAPTURE_FLAG_EXTD) == 0U || (rec->flags & CAN_ESP_CAPTURE_FLAG_RTR) != 0U) {
+        return false;
+    }
+    msg.id = rec->id;
+    msg.length = (rec->length <= CAN_MAX_DATA_LENGTH) ? rec->length : CAN_MAX_DATA_LENGTH;
+    (void)memcpy(msg.data, rec->data, msg.length);
+    *status = CAN_ESP_EnqueueMessage_v2(inst, &msg, false);
+    return true;
+}
+
+static can_esp_status_t replay_run(const CanEspReplayConfig_t *config, replay_next_t next, void *src,
+                                   CanEspReplayStats_t *out)
+{
+    CanEspReplayConfig_t cfg;
+    CanEspReplayStats_t stats = {0};
+    CanEspCaptureRecord_t rec;
+    can_esp_status_t sent;
+    ReplayNext_t r;
+    can_esp_handle_t inst;
+    int64_t origin = 0;
+    int64_t start = 0;
+    int64_t offset;
+    int64_t target;
+    int64_t now;
+    bool started = false;
+
+    if (config == NULL) {
+        CAN_ESP_ReplayDefaultConfig(&cfg);
+    } else {
+        cfg = *config;
+    }
+    if (!(cfg.speed_factor >= 0.0f)) {
+        ESP_LOGE(TAG, "Fator de velocidade inválido.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    inst = (cfg.handle != NULL) ? cfg.handle : CAN_ESP_GetDefaultHandle();
+
+    portENTER_CRITICAL(&replayLock);
+    if (replayActive) {
+        portEXIT_CRITICAL(&replayLock);
+        ESP_LOGE(TAG, "Já existe uma reprodução em andamento.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    replayActive = true;
+    replayStopRequested = false;
+    portEXIT_CRITICAL(&replayLock);
+
+    if (replayTimer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = replay_timer_callback,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "can_replay",
+            .skip_unhandled_events = true,
+        };
+        if (esp_timer_create(&args, &replayTimer) != ESP_OK) {
+            replayTimer = NULL;
+            portENTER_CRITICAL(&replayLock);
+            replayActive = false;
+            portEXIT_CRITICAL(&replayLock);
+            ESP_LOGE(TAG, "Falha ao criar o temporizador da reprodução.");
+            return CAN_ESP_ERR_UNKNOWN;
+        }
+    }
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+    portENTER_CRITICAL(&replayLock);
+    replayWaiter = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&replayLock);
+    replayLastBlockUs = esp_timer_get_time();
+    can_esp_latency_hist_reset(&replayDeviation);
+
+    for (r = next(src, &rec); r != REPLAY_NEXT_END; r = next(src, &rec)) {
+        if (replayStopRequested) {
+            stats.aborted = true;
+            break;
+        }
+        if (r != REPLAY_NEXT_FRAME || !replay_selected(&cfg, &rec)) {
+            stats.frames_skipped++;
+            continue;
+        }
+        if (!started) {
+            origin = rec.timestamp_us;
+            start = esp_timer_get_time();
+            started = true;
+        }
+        /* Logs fora de ordem não voltam o cronograma: o quadro segue imediatamente */
+        offset = rec.timestamp_us - origin;
+        if (offset > stats.log_span_us) {
+            stats.log_span_us = offset;
+        }
+        if (cfg.speed_factor > 0.0f) {
+            target = start + (int64_t)((double)offset / (double)cfg.speed_factor);
+            if (!replay_wait_until(target)) {
+                stats.aborted = true;
+                break;
+            }
+            now = esp_timer_get_time();
+            can_esp_latency_hist_record(&replayDeviation, (now > target) ? (now - target) : 0);
+        }
+        replay_yield_if_busy();
+        if (!replay_send(&cfg, inst, &rec, &sent)) {
+            stats.frames_skipped++;
+        } else if (sent == CAN_ESP_OK) {
+            stats.frames_sent++;
+        } else {
+            stats.frames_failed++;
+        }
+    }
+    stats.elapsed_us = started ? (esp_timer_get_time() - start) : 0;
+    can_esp_latency_hist_snapshot(&replayDeviation, &stats.deviation);
+
+    (void)esp_timer_stop(replayTimer);
+    portENTER_CRITICAL(&replayLock);
+    replayWaiter = NULL;
+    replayActive = false;
+    portEXIT_CRITICAL(&replayLock);
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+
+    ESP_LOGI(TAG, "Reprodução: %" PRIu32 " enviados, %" PRIu32 " falhas, desvio p99 %" PRId64 " us, máx %" PRId64 " us.",
+             stats.frames_sent, stats.frames_failed, stats.deviation.p99_latency, stats.deviation.max_latency);
+    if (out != NULL) {
+        *out = stats;
+    }
+    return stats.aborted ? CAN_ESP_ERR_ABORTED : CAN_ESP_OK;
+}
+
+static ReplayNext_t replay_next_record(void *ctx, CanEspCaptureRecord_t *record)
+{
+    ReplayRecordSource_t *src = (ReplayRecordSource_t *)ctx;
+
+    if (src->index >= src->count) {
+        return REPLAY_NEXT_END;
+    }
+    *record = src->records[src->index];
+    src->index++;
+    return REPLAY_NEXT_FRAME;
+}
+
+static ReplayNext_t replay_next_line(void *ctx, CanEspCaptureRecord_t *record)
+{
+    ReplayLogSource_t *src = (ReplayLogSource_t *)ctx;
+
+    if (!src->reader(src->line, sizeof(src->line), src->ctx)) {
+        return REPLAY_NEXT_END;
+    }
+    return (CAN_ESP_ReplayParseLine(src->format, src->line, record) == CAN_ESP_OK) ? REPLAY_NEXT_FRAME
+                                                                                   : REPLAY_NEXT_SKIP;
+}
+
+can_esp_status_t CAN_ESP_ReplayRecords(const CanEspReplayConfig_t *config, const CanEspCaptureRecord_t *records,
+                                       size_t count, CanEspReplayStats_t *stats)
+{
+    ReplayRecordSource_t src = { records, count, 0U };
+
+    if (records == NULL && count > 0U) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    return replay_run(config, replay_next_record, &src, stats);
+}
+
+can_esp_status_t CAN_ESP_ReplayLog(const CanEspReplayConfig_t *config, CanEspCaptureFormat_t format,
+                                   can_esp_replay_line_reader_t reader, void *ctx, CanEspReplayStats_t *stats)
+{
+    ReplayLogSource_t src;
+
+    if (reader == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    src.format = format;
+    src.reader = reader;
+    src.ctx = ctx;
+    return replay_run(config, replay_next_line, &src, stats);
+}
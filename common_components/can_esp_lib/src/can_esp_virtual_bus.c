@@ -0,0 +1,896 @@
+/*
+ * can_esp_virtual_bus.c
+ * Barramento CAN virtual em processo (múltiplos nós) para builds de host e testes
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Adaptado para conformidade com MISRA C:2012.
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include "can_esp_virtual_bus.h"
+#include "can_esp_instance.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "CAN_ESP_VBUS";
+
+/* Período de verificação quando o barramento está ocioso (recuperações de bus-off pendentes) */
+#define CAN_ESP_VBUS_IDLE_POLL_MS       (10U)
+
+/* Bits acrescentados por um quadro de erro (flag ativo, sobreposição de flags e delimitador) */
+#define CAN_ESP_VBUS_ERROR_FRAME_BITS   (20U)
+
+/* Atraso máximo admitido do tempo virtual antes de reancorar a cadência no tempo real */
+#define CAN_ESP_VBUS_MAX_LAG_US         (100000)
+
+/*==============================================================================
+                               ESTADO DO BARRAMENTO
+ ==============================================================================*/
+
+typedef struct {
+    bool used;
+    bool installed;
+    twai_state_t state;
+    twai_mode_t mode;
+    twai_filter_config_t filter;
+    QueueHandle_t txQueue;
+    QueueHandle_t rxQueue;
+    uint32_t queueUsers;            /* Transmissões/recepções em andamento: a desinstalação aguarda zerar */
+    bool hasPending;                /* Quadro em disputa (cabeça da fila de transmissão) */
+    twai_message_t pending;
+    uint32_t tec;
+    uint32_t rec;
+    bool errWarn;
+    bool errPassive;
+    uint32_t injectedErrors;
+    int64_t recoveryEndUs;
+    uint32_t alertsEnabled;
+    uint32_t alertsPending;
+    SemaphoreHandle_t alertSemaphore;
+    uint32_t txFailedCount;
+    uint32_t rxMissedCount;
+    uint32_t arbLostCount;
+    uint32_t busErrorCount;
+} vbus_node_t;
+
+static vbus_node_t vbusNodes[CAN_ESP_VBUS_MAX_NODES];
+static uint32_t vbusNodeCount = 0U;
+static uint32_t vbusBitrate = 0U;
+static bool vbusInitialized = false;
+static volatile bool vbusStopRequested = false;
+static TaskHandle_t vbusStopWaiter = NULL;
+static SemaphoreHandle_t vbusMutex = NULL;
+static SemaphoreHandle_t vbusWakeSemaphore = NULL;
+static CanEspVirtualBusStats_t vbusStats;
+
+/* Cadência: tempo virtual acumulado desde a âncora de tempo real */
+static int64_t paceAnchorUs = 0;
+static uint64_t paceVirtualNs = 0U;
+
+/*==============================================================================
+                           FUNÇÕES AUXILIARES DOS NÓS
+ ==============================================================================*/
+
+static vbus_node_t *vbus_node_from_ctx(void *ctx)
+{
+    vbus_node_t *node = (vbus_node_t *)ctx;
+
+    if (node == NULL || node < &vbusNodes[0] || node >= &vbusNodes[CAN_ESP_VBUS_MAX_NODES] || !node->used) {
+        return NULL;
+    }
+    return node;
+}
+
+static void vbus_raise_alerts(vbus_node_t *node, uint32_t alerts)
+{
+    uint32_t enabled = alerts & node->alertsEnabled;
+
+    if (enabled != 0U) {
+        node->alertsPending |= enabled;
+        (void)xSemaphoreGive(node->alertSemaphore);
+    }
+}
+
+/* Chave de arbitragem: bits na ordem de transmissão (menor valor = mais bits dominantes = vence) */
+static uint32_t vbus_arbitration_key(const twai_message_t *msg)
+{
+    uint32_t rtr = (msg->rtr != 0U) ? 1U : 0U;
+
+    if (msg->extd != 0U) {
+        uint32_t base = (msg->identifier >> 18) & 0x7FFU;
+        uint32_t ext = msg->identifier & 0x3FFFFU;
+        /* ID base, SRR e IDE recessivos, ID estendido, RTR */
+        return (base << 21) | (1UL << 20) | (1UL << 19) | (ext << 1) | rtr;
+    }
+    /* ID, RTR, IDE dominante */
+    return ((msg->identifier & 0x7FFU) << 21) | (rtr << 20);
+}
+
+/* Filtro de aceitação com a semântica do TWAI; os campos de bytes de dados não são simulados */
+static bool vbus_filter_accepts(const twai_filter_config_t *filter, const twai_message_t *msg)
+{
+    uint32_t code = filter->acceptance_code;
+    uint32_t mask = filter->acceptance_mask;
+    uint32_t rtr = (msg->rtr != 0U) ? 1U : 0U;
+
+    if (filter->single_filter) {
+        uint32_t raw;
+        uint32_t care;
+        if (msg->extd != 0U) {
+            raw = (msg->identifier << 3) | (rtr << 2);
+            care = ~mask & 0xFFFFFFFCU;
+        } else {
+            raw = (msg->identifier << 21) | (rtr << 20);
+            care = ~mask & 0xFFF00000U;
+        }
+        return ((raw ^ code) & care) == 0U;
+    }
+
+    if (msg->extd != 0U) {
+        /* Filtro duplo estendido: apenas os bits 28..13 do ID */
+        uint32_t hi = (msg->identifier >> 13) & 0xFFFFU;
+        bool f1 = ((hi ^ (code >> 16)) & ~(mask >> 16) & 0xFFFFU) == 0U;
+        bool f2 = ((hi ^ code) & ~mask & 0xFFFFU) == 0U;
+        return f1 || f2;
+    } else {
+        uint32_t raw1 = ((msg->identifier & 0x7FFU) << 21) | (rtr << 20);
+        uint32_t raw2 = ((msg->identifier & 0x7FFU) << 5) | (rtr << 4);
+        bool f1 = ((raw1 ^ code) & ~mask & 0xFFF00000U) == 0U;
+        bool f2 = ((raw2 ^ code) & ~mask & 0x0000FFF0U) == 0U;
+        return f1 || f2;
+    }
+}
+
+/* Descarta os quadros pendentes do nó (stop e bus-off), contando-os como falhas */
+static void vbus_flush_tx(vbus_node_t *node, bool count_failed)
+{
+    uint32_t flushed = (uint32_t)uxQueueMessagesWaiting(node->txQueue) + (node->hasPending ? 1U : 0U);
+
+    (void)xQueueReset(node->txQueue);
+    node->hasPending = false;
+    if (count_failed) {
+        node->txFailedCount += flushed;
+    }
+}
+
+/* Reavalia o estado de confinamento de falhas após alteração de TEC/REC */
+static void vbus_update_error_state(vbus_node_t *node)
+{
+    bool warn;
+    bool passive;
+
+    if (node->state != TWAI_STATE_RUNNING) {
+        return;
+    }
+    if (node->tec >= CAN_ESP_VBUS_BUS_OFF_LIMIT) {
+        node->state = TWAI_STATE_BUS_OFF;
+        node->tec = CAN_ESP_VBUS_BUS_OFF_LIMIT;
+        vbus_flush_tx(node, true);
+        vbus_raise_alerts(node, TWAI_ALERT_BUS_OFF);
+        ESP_LOGW(TAG, "Nó %u entrou em bus-off.", (unsigned)(node - vbusNodes));
+        return;
+    }
+
+    warn = (node->tec >= CAN_ESP_VBUS_ERR_WARN_LIMIT) || (node->rec >= CAN_ESP_VBUS_ERR_WARN_LIMIT);
+    passive = (node->tec >= CAN_ESP_VBUS_ERR_PASSIVE_LIMIT) || (node->rec >= CAN_ESP_VBUS_ERR_PASSIVE_LIMIT);
+    if (warn != node->errWarn) {
+        node->errWarn = warn;
+        vbus_raise_alerts(node, warn ? TWAI_ALERT_ABOVE_ERR_WARN : TWAI_ALERT_BELOW_ERR_WARN);
+    }
+    if (passive != node->errPassive) {
+        node->errPassive = passive;
+        vbus_raise_alerts(node, passive ? TWAI_ALERT_ERR_PASS : TWAI_ALERT_ERR_ACTIVE);
+    }
+}
+
+/* Nó participa do barramento (recebe quadros e sinaliza erros) */
+static bool vbus_node_active(const vbus_node_t *node)
+{
+    return node->used && node->installed && node->state == TWAI_STATE_RUNNING;
+}
+
+/*==============================================================================
+                               CICLO DO BARRAMENTO
+ ==============================================================================*/
+
+static void vbus_complete_recoveries(int64_t now)
+{
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        vbus_node_t *node = &vbusNodes[i];
+        if (node->installed && node->state == TWAI_STATE_RECOVERING && now >= node->recoveryEndUs) {
+            node->state = TWAI_STATE_STOPPED;
+            node->tec = 0U;
+            node->rec = 0U;
+            node->errWarn = false;
+            node->errPassive = false;
+            vbus_raise_alerts(node, TWAI_ALERT_BUS_RECOVERED);
+        }
+    }
+}
+
+static void vbus_deliver(vbus_node_t *sender, const twai_message_t *msg)
+{
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        vbus_node_t *node = &vbusNodes[i];
+        if (!vbus_node_active(node)) {
+            continue;
+        }
+        if (node == sender && msg->self == 0U) {
+            continue;
+        }
+        if (node != sender && node->rec > 0U) {
+            node->rec = (node->rec > (CAN_ESP_VBUS_ERR_PASSIVE_LIMIT - 1U)) ? (CAN_ESP_VBUS_ERR_PASSIVE_LIMIT - 1U) : (node->rec - 1U);
+        }
+        if (!vbus_filter_accepts(&node->filter, msg)) {
+            continue;
+        }
+        if (xQueueSend(node->rxQueue, msg, 0) != pdTRUE) {
+            node->rxMissedCount++;
+            vbus_raise_alerts(node, TWAI_ALERT_RX_QUEUE_FULL);
+        } else {
+            vbus_raise_alerts(node, TWAI_ALERT_RX_DATA);
+        }
+    }
+}
+
+/* Quadro destruído: incrementa contadores de erro e decide entre retransmissão e descarte */
+static void vbus_fail_frame(vbus_node_t *sender, bool ack_error)
+{
+    /* Transmissor error-passive não incrementa o TEC por erro de ACK (ISO 11898-1) */
+    if (!(ack_error && sender->errPassive)) {
+        sender->tec += 8U;
+    }
+    sender->busErrorCount++;
+    vbus_raise_alerts(sender, TWAI_ALERT_BUS_ERROR);
+
+    if (!ack_error) {
+        for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+            vbus_node_t *node = &vbusNodes[i];
+            if (node != sender && vbus_node_active(node)) {
+                node->rec++;
+                node->busErrorCount++;
+                vbus_raise_alerts(node, TWAI_ALERT_BUS_ERROR);
+            }
+        }
+    }
+
+    if (sender->pending.ss != 0U) {
+        sender->hasPending = false;
+        sender->txFailedCount++;
+        vbus_raise_alerts(sender, TWAI_ALERT_TX_FAILED);
+    } else {
+        vbus_raise_alerts(sender, TWAI_ALERT_TX_RETRIED);
+    }
+    vbusStats.error_frames++;
+}
+
+/*
+ * Executa uma disputa do barramento: arbitra entre os quadros pendentes, transmite o vencedor
+ * (ou o destrói, se houver erro injetado ou falta de ACK) e retorna os bits consumidos
+ * (0 se o barramento ficou ocioso).
+ */
+static uint32_t vbus_run_once(void)
+{
+    vbus_node_t *winner = NULL;
+    uint32_t bestKey = UINT32_MAX;
+    uint32_t bits;
+    bool acked = false;
+
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+
+    vbus_complete_recoveries(esp_timer_get_time());
+
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        vbus_node_t *node = &vbusNodes[i];
+        if (!vbus_node_active(node) || node->mode == TWAI_MODE_LISTEN_ONLY) {
+            continue;
+        }
+        if (!node->hasPending && xQueueReceive(node->txQueue, &node->pending, 0) == pdTRUE) {
+            node->hasPending = true;
+        }
+        if (node->hasPending) {
+            uint32_t key = vbus_arbitration_key(&node->pending);
+            if (winner == NULL || key < bestKey) {
+                winner = node;
+                bestKey = key;
+            }
+        }
+    }
+
+    if (winner == NULL) {
+        (void)xSemaphoreGive(vbusMutex);
+        return 0U;
+    }
+
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        vbus_node_t *node = &vbusNodes[i];
+        if (node != winner && node->hasPending && vbus_node_active(node)) {
+            node->arbLostCount++;
+            vbusStats.arbitration_losses++;
+            vbus_raise_alerts(node, TWAI_ALERT_ARB_LOST);
+        }
+        if (node != winner && vbus_node_active(node) && node->mode != TWAI_MODE_LISTEN_ONLY) {
+            acked = true;
+        }
+    }
+
+    bits = CAN_ESP_CalculateFrameBits(winner->pending.identifier, winner->pending.extd != 0U,
+                                      winner->pending.rtr != 0U, winner->pending.data_length_code,
+                                      winner->pending.data, CAN_ESP_STUFFING_EXACT);
+
+    if (winner->injectedErrors > 0U) {
+        winner->injectedErrors--;
+        bits += CAN_ESP_VBUS_ERROR_FRAME_BITS;
+        vbus_fail_frame(winner, false);
+    } else if (!acked && winner->mode != TWAI_MODE_NO_ACK) {
+        bits += CAN_ESP_VBUS_ERROR_FRAME_BITS;
+        vbus_fail_frame(winner, true);
+    } else {
+        twai_message_t frame = winner->pending;
+        winner->hasPending = false;
+        if (winner->tec > 0U) {
+            winner->tec--;
+        }
+        vbus_deliver(winner, &frame);
+        vbus_raise_alerts(winner, TWAI_ALERT_TX_SUCCESS);
+        if (uxQueueMessagesWaiting(winner->txQueue) == 0U) {
+            vbus_raise_alerts(winner, TWAI_ALERT_TX_IDLE);
+        }
+        vbusStats.frames++;
+    }
+
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        vbus_update_error_state(&vbusNodes[i]);
+    }
+
+    vbusStats.busy_bits += bits;
+    vbusStats.virtual_time_us = (vbusStats.busy_bits * 1000000ULL) / vbusBitrate;
+
+    (void)xSemaphoreGive(vbusMutex);
+    return bits;
+}
+
+/* Retém a tarefa enquanto o tempo virtual estiver à frente do tempo real */
+static void vbus_pace(uint32_t bits)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t ahead_us;
+
+    paceVirtualNs += ((uint64_t)bits * 1000000000ULL) / vbusBitrate;
+    ahead_us = (int64_t)(paceVirtualNs / 1000ULL) - (now - paceAnchorUs);
+
+    if (ahead_us < -CAN_ESP_VBUS_MAX_LAG_US) {
+        paceAnchorUs = now;
+        paceVirtualNs = 0U;
+    } else if (ahead_us >= (int64_t)portTICK_PERIOD_MS * 1000) {
+        vTaskDelay((TickType_t)(ahead_us / ((int64_t)portTICK_PERIOD_MS * 1000)));
+    }
+}
+
+static void vbus_task(void *arg)
+{
+    (void)arg;
+
+    while (!vbusStopRequested) {
+        uint32_t bits = vbus_run_once();
+        if (bits == 0U) {
+            (void)xSemaphoreTake(vbusWakeSemaphore, pdMS_TO_TICKS(CAN_ESP_VBUS_IDLE_POLL_MS));
+            paceAnchorUs = esp_timer_get_time();
+            paceVirtualNs = 0U;
+        } else {
+            vbus_pace(bits);
+        }
+    }
+    xTaskNotifyGive(vbusStopWaiter);
+    vTaskDelete(NULL);
+}
+
+/*==============================================================================
+                            OPERAÇÕES DE DRIVER DO NÓ
+ ==============================================================================*/
+
+static esp_err_t vbus_install(void *ctx, const twai_general_config_t *g_config,
+                              const twai_timing_config_t *t_config, const twai_filter_config_t *f_config)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+    UBaseType_t txLen;
+    UBaseType_t rxLen;
+
+    (void)t_config;
+    if (node == NULL || g_config == NULL || f_config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Filas ainda presentes: instalado ou desinstalação aguardando usuários das filas */
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (node->installed || node->txQueue != NULL) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    (void)xSemaphoreGive(vbusMutex);
+
+    txLen = (g_config->tx_queue_len > 0U) ? (UBaseType_t)g_config->tx_queue_len : 1U;
+    rxLen = (g_config->rx_queue_len > 0U) ? (UBaseType_t)g_config->rx_queue_len : 1U;
+    node->txQueue = xQueueCreate(txLen, sizeof(twai_message_t));
+    node->rxQueue = xQueueCreate(rxLen, sizeof(twai_message_t));
+    if (node->txQueue == NULL || node->rxQueue == NULL) {
+        if (node->txQueue != NULL) {
+            vQueueDelete(node->txQueue);
+            node->txQueue = NULL;
+        }
+        if (node->rxQueue != NULL) {
+            vQueueDelete(node->rxQueue);
+            node->rxQueue = NULL;
+        }
+        return ESP_ERR_NO_MEM;
+    }
+
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    node->mode = g_config->mode;
+    node->filter = *f_config;
+    node->alertsEnabled = g_config->alerts_enabled;
+    node->alertsPending = 0U;
+    node->state = TWAI_STATE_STOPPED;
+    node->hasPending = false;
+    node->tec = 0U;
+    node->rec = 0U;
+    node->errWarn = false;
+    node->errPassive = false;
+    node->installed = true;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_uninstall(void *ctx)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed || (node->state != TWAI_STATE_STOPPED && node->state != TWAI_STATE_BUS_OFF)) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    node->installed = false;
+    node->hasPending = false;
+
+    /* Nenhum novo usuário entra nas filas; os que estão nelas saem em até uma fatia de espera */
+    while (node->queueUsers > 0U) {
+        (void)xSemaphoreGive(vbusMutex);
+        vTaskDelay(1);
+        (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    }
+    vQueueDelete(node->txQueue);
+    vQueueDelete(node->rxQueue);
+    node->txQueue = NULL;
+    node->rxQueue = NULL;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_start(void *ctx)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed || node->state != TWAI_STATE_STOPPED) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Como no TWAI: o início zera os contadores de erro e a fila de recepção */
+    (void)xQueueReset(node->rxQueue);
+    node->tec = 0U;
+    node->rec = 0U;
+    node->errWarn = false;
+    node->errPassive = false;
+    node->state = TWAI_STATE_RUNNING;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_stop(void *ctx)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed || (node->state != TWAI_STATE_RUNNING && node->state != TWAI_STATE_BUS_OFF)) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    vbus_flush_tx(node, false);
+    node->state = TWAI_STATE_STOPPED;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+/* Libera a fila usada por vbus_transmit/vbus_receive (a desinstalação aguarda a última) */
+static void vbus_queue_release(vbus_node_t *node)
+{
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    node->queueUsers--;
+    (void)xSemaphoreGive(vbusMutex);
+}
+
+/*
+ * Envia para (send) ou recebe da fila do nó em fatias de CAN_ESP_VBUS_IDLE_POLL_MS, para que uma
+ * desinstalação concorrente não espere o prazo inteiro: desinstalado, desiste na fatia seguinte.
+ */
+static bool vbus_queue_wait(vbus_node_t *node, QueueHandle_t queue, bool send, twai_message_t *message,
+                            TickType_t ticks_to_wait)
+{
+    const TickType_t slice = (pdMS_TO_TICKS(CAN_ESP_VBUS_IDLE_POLL_MS) > 0U) ?
+                             pdMS_TO_TICKS(CAN_ESP_VBUS_IDLE_POLL_MS) : 1U;
+    const TickType_t start = xTaskGetTickCount();
+    TickType_t waited = 0U;
+    TickType_t wait;
+    BaseType_t done;
+    bool installed;
+
+    for (;;) {
+        wait = (ticks_to_wait == portMAX_DELAY || (ticks_to_wait - waited) > slice) ? slice
+                                                                                  : (ticks_to_wait - waited);
+        done = send ? xQueueSend(queue, message, wait) : xQueueReceive(queue, message, wait);
+        if (done == pdTRUE) {
+            return true;
+        }
+        waited = xTaskGetTickCount() - start;
+        (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+        installed = node->installed;
+        (void)xSemaphoreGive(vbusMutex);
+        if (!installed || (ticks_to_wait != portMAX_DELAY && waited >= ticks_to_wait)) {
+            return false;
+        }
+    }
+}
+
+static esp_err_t vbus_transmit(void *ctx, const twai_message_t *message, TickType_t ticks_to_wait)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+    esp_err_t err = ESP_OK;
+    twai_message_t frame;
+    bool sent;
+
+    if (node == NULL || message == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (message->data_length_code > CAN_MAX_DATA_LENGTH && message->dlc_non_comp == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed || node->state != TWAI_STATE_RUNNING) {
+        err = ESP_ERR_INVALID_STATE;
+    } else if (node->mode == TWAI_MODE_LISTEN_ONLY) {
+        err = ESP_ERR_NOT_SUPPORTED;
+    } else {
+        node->queueUsers++;
+    }
+    (void)xSemaphoreGive(vbusMutex);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    frame = *message;
+    sent = vbus_queue_wait(node, node->txQueue, true, &frame, ticks_to_wait);
+    vbus_queue_release(node);
+    if (!sent) {
+        return ESP_ERR_TIMEOUT;
+    }
+    (void)xSemaphoreGive(vbusWakeSemaphore);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_receive(void *ctx, twai_message_t *message, TickType_t ticks_to_wait)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+    bool received;
+
+    if (node == NULL || message == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    node->queueUsers++;
+    (void)xSemaphoreGive(vbusMutex);
+
+    received = vbus_queue_wait(node, node->rxQueue, false, message, ticks_to_wait);
+    vbus_queue_release(node);
+    return received ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+static esp_err_t vbus_get_status_info(void *ctx, twai_status_info_t *status_info)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL || status_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(status_info, 0, sizeof(*status_info));
+    status_info->state = node->state;
+    status_info->msgs_to_tx = (uint32_t)uxQueueMessagesWaiting(node->txQueue) + (node->hasPending ? 1U : 0U);
+    status_info->msgs_to_rx = (uint32_t)uxQueueMessagesWaiting(node->rxQueue);
+    status_info->tx_error_counter = node->tec;
+    status_info->rx_error_counter = node->rec;
+    status_info->tx_failed_count = node->txFailedCount;
+    status_info->rx_missed_count = node->rxMissedCount;
+    status_info->arb_lost_count = node->arbLostCount;
+    status_info->bus_error_count = node->busErrorCount;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_read_alerts(void *ctx, uint32_t *alerts, TickType_t ticks_to_wait)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+    const TickType_t start = xTaskGetTickCount();
+    TickType_t waited;
+
+    if (node == NULL || alerts == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Um give antigo (alertas já consumidos) acorda sem alertas: volta a esperar até o prazo */
+    for (;;) {
+        (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+        *alerts = node->alertsPending;
+        node->alertsPending = 0U;
+        (void)xSemaphoreGive(vbusMutex);
+        if (*alerts != 0U) {
+            return ESP_OK;
+        }
+        waited = xTaskGetTickCount() - start;
+        if (ticks_to_wait != portMAX_DELAY && waited >= ticks_to_wait) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (xSemaphoreTake(node->alertSemaphore,
+                           (ticks_to_wait == portMAX_DELAY) ? portMAX_DELAY : (ticks_to_wait - waited)) != pdTRUE) {
+            ticks_to_wait = 0U;
+        }
+    }
+}
+
+static esp_err_t vbus_reconfigure_alerts(void *ctx, uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (current_alerts != NULL) {
+        *current_alerts = node->alertsPending;
+    }
+    node->alertsPending = 0U;
+    node->alertsEnabled = alerts_enabled;
+    (void)xSemaphoreGive(vbusMutex);
+    return ESP_OK;
+}
+
+static esp_err_t vbus_initiate_recovery(void *ctx)
+{
+    vbus_node_t *node = vbus_node_from_ctx(ctx);
+
+    if (node == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (!node->installed || node->state != TWAI_STATE_BUS_OFF) {
+        (void)xSemaphoreGive(vbusMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    node->state = TWAI_STATE_RECOVERING;
+    node->recoveryEndUs = esp_timer_get_time() +
+                          (int64_t)(((uint64_t)CAN_ESP_VBUS_RECOVERY_BITS * 1000000ULL) / vbusBitrate);
+    vbus_raise_alerts(node, TWAI_ALERT_RECOVERY_IN_PROGRESS);
+    (void)xSemaphoreGive(vbusMutex);
+    (void)xSemaphoreGive(vbusWakeSemaphore);
+    return ESP_OK;
+}
+
+static const CanEspDriverOps_t vbusDriverOps = {
+    .install = vbus_install,
+    .uninstall = vbus_uninstall,
+    .start = vbus_start,
+    .stop = vbus_stop,
+    .transmit = vbus_transmit,
+    .receive = vbus_receive,
+    .get_status_info = vbus_get_status_info,
+    .read_alerts = vbus_read_alerts,
+    .reconfigure_alerts = vbus_reconfigure_alerts,
+    .initiate_recovery = vbus_initiate_recovery,
+};
+
+/*==============================================================================
+                                 API PÚBLICA
+ ==============================================================================*/
+
+/* Libera a sincronização criada por uma inicialização que falhou */
+static void vbus_delete_sync(void)
+{
+    if (vbusMutex != NULL) {
+        vSemaphoreDelete(vbusMutex);
+        vbusMutex = NULL;
+    }
+    if (vbusWakeSemaphore != NULL) {
+        vSemaphoreDelete(vbusWakeSemaphore);
+        vbusWakeSemaphore = NULL;
+    }
+}
+
+can_esp_status_t CAN_ESP_VirtualBusInit(uint32_t bitrate)
+{
+    if (vbusInitialized) {
+        ESP_LOGE(TAG, "Barramento virtual já inicializado.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    if (bitrate == 0U) {
+        ESP_LOGE(TAG, "Taxa de bits inválida para o barramento virtual.");
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+
+    vbusMutex = xSemaphoreCreateMutex();
+    vbusWakeSemaphore = xSemaphoreCreateBinary();
+    if (vbusMutex == NULL || vbusWakeSemaphore == NULL) {
+        ESP_LOGE(TAG, "Falha ao criar sincronização do barramento virtual.");
+        vbus_delete_sync();
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    memset(vbusNodes, 0, sizeof(vbusNodes));
+    memset(&vbusStats, 0, sizeof(vbusStats));
+    vbusNodeCount = 0U;
+    vbusStopRequested = false;
+    vbusBitrate = bitrate;
+    vbusStats.bitrate = bitrate;
+    paceAnchorUs = esp_timer_get_time();
+    paceVirtualNs = 0U;
+
+    if (xTaskCreate(vbus_task, "can_vbus", CAN_ESP_VBUS_TASK_STACK_SIZE, NULL,
+                    CAN_ESP_VBUS_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar a tarefa do barramento virtual.");
+        vbus_delete_sync();
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    vbusInitialized = true;
+    ESP_LOGI(TAG, "Barramento virtual iniciado a %" PRIu32 " bps.", bitrate);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_VirtualBusDeinit(void)
+{
+    if (!vbusInitialized) {
+        ESP_LOGE(TAG, "Barramento virtual não inicializado.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    /* Encerra a tarefa de arbitragem antes de liberar os nós que ela percorre */
+    vbusStopWaiter = xTaskGetCurrentTaskHandle();
+    vbusStopRequested = true;
+    (void)xSemaphoreGive(vbusWakeSemaphore);
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    for (uint32_t i = 0U; i < vbusNodeCount; i++) {
+        if (vbusNodes[i].installed) {
+            vQueueDelete(vbusNodes[i].txQueue);
+            vQueueDelete(vbusNodes[i].rxQueue);
+        }
+        vSemaphoreDelete(vbusNodes[i].alertSemaphore);
+    }
+    memset(vbusNodes, 0, sizeof(vbusNodes));
+    vbusNodeCount = 0U;
+    vbus_delete_sync();
+    vbusInitialized = false;
+    ESP_LOGI(TAG, "Barramento virtual encerrado.");
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_VirtualBusAddNode(can_esp_vbus_node_t *node)
+{
+    SemaphoreHandle_t alertSemaphore;
+
+    if (node == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (!vbusInitialized) {
+        ESP_LOGE(TAG, "Barramento virtual não inicializado.");
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    alertSemaphore = xSemaphoreCreateBinary();
+    if (alertSemaphore == NULL) {
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    if (vbusNodeCount >= CAN_ESP_VBUS_MAX_NODES) {
+        (void)xSemaphoreGive(vbusMutex);
+        vSemaphoreDelete(alertSemaphore);
+        ESP_LOGE(TAG, "Número máximo de nós do barramento virtual atingido.");
+        return CAN_ESP_ERR_QUEUE_FULL;
+    }
+    *node = vbusNodeCount;
+    vbusNodes[vbusNodeCount].used = true;
+    vbusNodes[vbusNodeCount].state = TWAI_STATE_STOPPED;
+    vbusNodes[vbusNodeCount].alertSemaphore = alertSemaphore;
+    vbusNodeCount++;
+    vbusStats.node_count = vbusNodeCount;
+    (void)xSemaphoreGive(vbusMutex);
+    return CAN_ESP_OK;
+}
+
+const CanEspDriverOps_t *CAN_ESP_VirtualBusGetOps(void)
+{
+    return &vbusDriverOps;
+}
+
+void *CAN_ESP_VirtualBusNodeContext(can_esp_vbus_node_t node)
+{
+    if (node >= vbusNodeCount) {
+        return NULL;
+    }
+    return &vbusNodes[node];
+}
+
+can_esp_status_t CAN_ESP_VirtualBusAttach_v2(can_esp_handle_t handle, can_esp_vbus_node_t node)
+{
+    void *ctx = CAN_ESP_VirtualBusNodeContext(node);
+
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Nó %" PRIu32 " inexistente no barramento virtual.", node);
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    return CAN_ESP_SetDriverBackend_v2(handle, &vbusDriverOps, ctx);
+}
+
+can_esp_status_t CAN_ESP_VirtualBusAttach(can_esp_vbus_node_t node)
+{
+    return CAN_ESP_VirtualBusAttach_v2(CAN_ESP_GetDefaultHandle(), node);
+}
+
+can_esp_status_t CAN_ESP_VirtualBusInjectErrors(can_esp_vbus_node_t node, uint32_t count)
+{
+    if (node >= vbusNodeCount) {
+        return CAN_ESP_ERR_INVALID_PARAM;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    vbusNodes[node].injectedErrors += count;
+    (void)xSemaphoreGive(vbusMutex);
+    return CAN_ESP_OK;
+}
+
+can_esp_status_t CAN_ESP_VirtualBusGetStats(CanEspVirtualBusStats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_ESP_ERR_NULL_POINTER;
+    }
+    if (!vbusInitialized) {
+        return CAN_ESP_ERR_UNKNOWN;
+    }
+    (void)xSemaphoreTake(vbusMutex, portMAX_DELAY);
+    *stats = vbusStats;
+    (void)xSemaphoreGive(vbusMutex);
+    return CAN_ESP_OK;
+}
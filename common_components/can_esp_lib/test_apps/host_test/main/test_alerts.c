@@ -0,0 +1,82 @@
+/*
+ * test_alerts.c
+ * Testes dos alertas do driver: conclusão de transmissão só com o acompanhamento registrado
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_virtual_bus.h"
+
+#define ALERT_TEST_BITRATE      (500000U)
+#define ALERT_TEST_TX_ALERTS    (TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED)
+
+/* Backend do barramento virtual que registra os alertas pedidos pela biblioteca */
+static const CanEspDriverOps_t *alertBase;
+static CanEspDriverOps_t alertOps;
+static uint32_t alertInstalled;
+static uint32_t alertReconfigured;
+
+static esp_err_t alert_test_install(void *ctx, const twai_general_config_t *g_config,
+                                    const twai_timing_config_t *t_config, const twai_filter_config_t *f_config)
+{
+    alertInstalled = g_config->alerts_enabled;
+    return alertBase->install(ctx, g_config, t_config, f_config);
+}
+
+static esp_err_t alert_test_reconfigure(void *ctx, uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    alertReconfigured = alerts_enabled;
+    return alertBase->reconfigure_alerts(ctx, alerts_enabled, current_alerts);
+}
+
+static void alert_test_complete(const CanEspMessage_t *msg, can_esp_status_t status)
+{
+    (void)msg;
+    (void)status;
+}
+
+/*
+ * Usa a instância padrão: o registro do callback cria a tarefa de alertas, que não pode ser
+ * encerrada (uma instância privada não poderia mais ser removida).
+ */
+TEST_CASE("alerts: TX_SUCCESS/TX_FAILED só com callback de conclusão", "[alerts]")
+{
+    can_esp_handle_t inst = CAN_ESP_GetDefaultHandle();
+    can_esp_vbus_node_t node;
+    CanEspConfig_t config;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(ALERT_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node));
+    alertBase = CAN_ESP_VirtualBusGetOps();
+    alertOps = *alertBase;
+    alertOps.install = alert_test_install;
+    alertOps.reconfigure_alerts = alert_test_reconfigure;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, &alertOps, CAN_ESP_VirtualBusNodeContext(node)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = ALERT_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+
+    /* Sem acompanhamento: só os alertas de estado de erro usados pela recuperação */
+    TEST_ASSERT_EQUAL(0U, alertInstalled & ALERT_TEST_TX_ALERTS);
+    TEST_ASSERT_EQUAL(TWAI_ALERT_BUS_OFF, alertInstalled & TWAI_ALERT_BUS_OFF);
+
+    alertReconfigured = 0U;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RegisterTransmitCompleteCallback_v2(inst, alert_test_complete));
+    TEST_ASSERT_EQUAL(ALERT_TEST_TX_ALERTS, alertReconfigured & ALERT_TEST_TX_ALERTS);
+    TEST_ASSERT_EQUAL(TWAI_ALERT_BUS_OFF, alertReconfigured & TWAI_ALERT_BUS_OFF);
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RegisterTransmitCompleteCallback_v2(inst, NULL));
+    TEST_ASSERT_EQUAL(0U, alertReconfigured & ALERT_TEST_TX_ALERTS);
+    TEST_ASSERT_EQUAL(TWAI_ALERT_BUS_OFF, alertReconfigured & TWAI_ALERT_BUS_OFF);
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, NULL, NULL));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
@@ -0,0 +1,100 @@
+/*
+ * test_benchmark.c
+ * Testes dos benchmarks: execução em instância privada, sem tocar na instância padrão
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_benchmark.h"
+#include "can_esp_instance.h"
+
+#define BENCH_TEST_MICRO_LINES  (9U)    /* meta + 8 medições */
+#define BENCH_TEST_MACRO_LINES  (6U)    /* meta + 2 vazões + 3 pontos de latência */
+#define BENCH_TEST_FRAMES       (20U)
+
+typedef struct {
+    uint32_t lines;
+    uint32_t malformed;
+    bool send_sync_delivered;
+    bool enqueue_async_delivered;
+} bench_test_output_t;
+
+static void bench_test_writer(const char *line, void *ctx)
+{
+    bench_test_output_t *out = (bench_test_output_t *)ctx;
+    size_t len = strlen(line);
+
+    out->lines++;
+    if (len == 0U || line[0] != '{' || line[len - 1U] != '}') {
+        out->malformed++;
+    }
+    if (strstr(line, "\"send_sync\"") != NULL && strstr(line, "\"delivered\":20,") != NULL) {
+        out->send_sync_delivered = true;
+    }
+    if (strstr(line, "\"enqueue_async\"") != NULL && strstr(line, "\"delivered\":20,") != NULL) {
+        out->enqueue_async_delivered = true;
+    }
+}
+
+static void bench_test_config(CanEspBenchmarkConfig_t *config, bench_test_output_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    CAN_ESP_BenchmarkDefaultConfig(config, bench_test_writer, out);
+    config->micro_iterations = 100U;
+    config->throughput_frames = BENCH_TEST_FRAMES;
+    config->latency_samples = 5U;
+}
+
+static void bench_test_assert_default_untouched(const CanEspPoolStats_t *before)
+{
+    CanEspPoolStats_t after;
+
+    /* Nem a fila nem o pool da instância padrão foram inicializados ou usados */
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetMessagePoolStats_v2(CAN_ESP_GetDefaultHandle(), &after));
+    TEST_ASSERT_EQUAL(before->capacity, after.capacity);
+    TEST_ASSERT_EQUAL(before->allocations, after.allocations);
+}
+
+TEST_CASE("bench: micro benchmarks usam instância privada e a liberam", "[bench]")
+{
+    CanEspBenchmarkConfig_t config;
+    bench_test_output_t out;
+    CanEspPoolStats_t before;
+
+    bench_test_config(&config, &out);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetMessagePoolStats_v2(CAN_ESP_GetDefaultHandle(), &before));
+
+    /* Mais execuções que vagas no pool: a instância privada precisa voltar a ele a cada uma */
+    for (uint32_t run = 0U; run < CAN_ESP_MAX_INSTANCES; run++) {
+        TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RunMicroBenchmarks(&config));
+    }
+    TEST_ASSERT_EQUAL(CAN_ESP_MAX_INSTANCES * BENCH_TEST_MICRO_LINES, out.lines);
+    TEST_ASSERT_EQUAL(0U, out.malformed);
+    bench_test_assert_default_untouched(&before);
+}
+
+TEST_CASE("bench: macro benchmarks não usam a instância padrão", "[bench]")
+{
+    CanEspBenchmarkConfig_t config;
+    bench_test_output_t out;
+    CanEspPoolStats_t before;
+
+    bench_test_config(&config, &out);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetMessagePoolStats_v2(CAN_ESP_GetDefaultHandle(), &before));
+
+    /* Duas execuções: a segunda reaproveita a instância privada e sua tarefa de transmissão */
+    for (uint32_t run = 0U; run < 2U; run++) {
+        out.send_sync_delivered = false;
+        out.enqueue_async_delivered = false;
+        TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RunMacroBenchmarks(&config));
+        TEST_ASSERT_TRUE(out.send_sync_delivered);
+        TEST_ASSERT_TRUE(out.enqueue_async_delivered);
+    }
+    TEST_ASSERT_EQUAL(2U * BENCH_TEST_MACRO_LINES, out.lines);
+    TEST_ASSERT_EQUAL(0U, out.malformed);
+    bench_test_assert_default_untouched(&before);
+}
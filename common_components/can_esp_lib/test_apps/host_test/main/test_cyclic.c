@@ -0,0 +1,111 @@
+/*
+ * test_cyclic.c
+ * Testes do escalonador cíclico: preenchimento fora do mutex e liberações na fila de transmissão
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_virtual_bus.h"
+
+#define CYCLIC_TEST_BITRATE     (500000U)
+#define CYCLIC_TEST_PERIOD_US   (2000U)
+
+typedef struct {
+    can_esp_handle_t inst;
+    can_esp_cyclic_t cyclic;
+    volatile uint32_t fills;
+    volatile can_esp_status_t unregister_status;
+} cyclic_test_ctx_t;
+
+/* Instância privada sobre um nó do barramento virtual, sem tarefas (os quadros ficam na fila) */
+static can_esp_handle_t cyclic_test_setup(void)
+{
+    CanEspConfig_t config;
+    can_esp_vbus_node_t node;
+    can_esp_handle_t inst;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(CYCLIC_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_CreateInstance(&inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, CAN_ESP_VirtualBusGetOps(),
+                                                             CAN_ESP_VirtualBusNodeContext(node)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = CYCLIC_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+    return inst;
+}
+
+static void cyclic_test_teardown(can_esp_handle_t inst)
+{
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_DeleteInstance(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+static bool cyclic_test_fill(CanEspMessage_t *msg, void *ctx)
+{
+    cyclic_test_ctx_t *test = (cyclic_test_ctx_t *)ctx;
+
+    test->fills++;
+    msg->length = 1U;
+    msg->data[0] = (uint8_t)test->fills;
+    return true;
+}
+
+/* Cancela o próprio registro na primeira liberação (exige preenchimento fora do mutex) */
+static bool cyclic_test_fill_unregister(CanEspMessage_t *msg, void *ctx)
+{
+    cyclic_test_ctx_t *test = (cyclic_test_ctx_t *)ctx;
+
+    (void)msg;
+    test->fills++;
+    test->unregister_status = CAN_ESP_UnregisterCyclicMessage_v2(test->inst, test->cyclic);
+    return false;
+}
+
+TEST_CASE("cyclic: liberações enfileiradas e contabilizadas", "[cyclic]")
+{
+    can_esp_handle_t inst = cyclic_test_setup();
+    uint32_t id = CAN_ESP_EncodeID(4U, 0x31U, 0x1U);
+    cyclic_test_ctx_t test = { .inst = inst, .fills = 0U };
+    CanEspCyclicStats_t stats;
+    CanEspQueueStatus_t queue;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RegisterCyclicMessage_v2(inst, id, CYCLIC_TEST_PERIOD_US, 0U,
+                                                                  cyclic_test_fill, &test, &test.cyclic));
+    vTaskDelay(pdMS_TO_TICKS(50U));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_UnregisterCyclicMessage_v2(inst, test.cyclic));
+    TEST_ASSERT_GREATER_THAN_UINT32(0U, test.fills);
+
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_INVALID_PARAM, CAN_ESP_GetCyclicStats_v2(inst, test.cyclic, &stats));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &queue));
+    TEST_ASSERT_GREATER_THAN_UINT32(0U, queue.level_waiting[4]);
+
+    cyclic_test_teardown(inst);
+}
+
+TEST_CASE("cyclic: callback de preenchimento pode cancelar o registro", "[cyclic]")
+{
+    can_esp_handle_t inst = cyclic_test_setup();
+    cyclic_test_ctx_t test = { .inst = inst, .fills = 0U, .unregister_status = CAN_ESP_ERR_UNKNOWN };
+    CanEspCyclicStats_t stats;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_RegisterCyclicMessage_v2(inst, 0x123U, CYCLIC_TEST_PERIOD_US, 0U,
+                                                                  cyclic_test_fill_unregister, &test, &test.cyclic));
+    vTaskDelay(pdMS_TO_TICKS(50U));
+    TEST_ASSERT_EQUAL(1U, test.fills);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, test.unregister_status);
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_INVALID_PARAM, CAN_ESP_GetCyclicStats_v2(inst, test.cyclic, &stats));
+
+    cyclic_test_teardown(inst);
+}
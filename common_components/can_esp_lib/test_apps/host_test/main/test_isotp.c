@@ -0,0 +1,126 @@
+/*
+ * test_isotp.c
+ * Testes do ISO-TP: Flow Control enfileirado sem bloqueio e validação do FF_DL
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_isotp.h"
+#include "can_esp_virtual_bus.h"
+
+#define ISOTP_TEST_BITRATE      (500000U)
+#define ISOTP_TEST_WAIT_MS      (1000U)
+#define ISOTP_TEST_TX_ID        (0x18DA10F1U)
+#define ISOTP_TEST_RX_ID        (0x18DAF110U)
+
+static const CanEspDriverOps_t *isotpOps;
+static void *isotpPeer;
+static uint8_t isotpBuffer[64];
+
+/*
+ * Instância privada sobre o nó a, sem tarefas: os quadros injetados pelo nó b são despachados
+ * por CAN_ESP_ProcessReceivedMessages_v2 e os Flow Control permanecem na fila de transmissão.
+ */
+static can_esp_handle_t isotp_test_setup(can_esp_isotp_t *session)
+{
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    CanEspIsoTpConfig_t isotp;
+    CanEspConfig_t config;
+    can_esp_vbus_node_t node_a;
+    can_esp_vbus_node_t node_b;
+    can_esp_handle_t inst;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(ISOTP_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_a));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_b));
+    isotpOps = CAN_ESP_VirtualBusGetOps();
+    isotpPeer = CAN_ESP_VirtualBusNodeContext(node_b);
+    TEST_ASSERT_EQUAL(ESP_OK, isotpOps->install(isotpPeer, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, isotpOps->start(isotpPeer));
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_CreateInstance(&inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, isotpOps, CAN_ESP_VirtualBusNodeContext(node_a)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = ISOTP_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    config.filter_config = filter;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+
+    CAN_ESP_IsoTpDefaultConfig(&isotp, ISOTP_TEST_TX_ID, ISOTP_TEST_RX_ID, isotpBuffer, sizeof(isotpBuffer));
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_NULL_POINTER, CAN_ESP_IsoTpOpen_v2(NULL, &isotp, session));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_IsoTpOpen_v2(inst, &isotp, session));
+    return inst;
+}
+
+static void isotp_test_teardown(can_esp_handle_t inst, can_esp_isotp_t session)
+{
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_IsoTpClose(session));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_DeleteInstance(inst));
+    TEST_ASSERT_EQUAL(ESP_OK, isotpOps->stop(isotpPeer));
+    TEST_ASSERT_EQUAL(ESP_OK, isotpOps->uninstall(isotpPeer));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+/* Injeta um quadro do par e o despacha na instância */
+static void isotp_test_deliver(can_esp_handle_t inst, const uint8_t *data, uint8_t length)
+{
+    twai_message_t frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.identifier = ISOTP_TEST_RX_ID;
+    frame.extd = 1U;
+    frame.data_length_code = length;
+    memcpy(frame.data, data, length);
+    TEST_ASSERT_EQUAL(ESP_OK, isotpOps->transmit(isotpPeer, &frame, pdMS_TO_TICKS(ISOTP_TEST_WAIT_MS)));
+    CAN_ESP_ProcessReceivedMessages_v2(inst);
+}
+
+static uint16_t isotp_test_queued_fc(can_esp_handle_t inst)
+{
+    CanEspQueueStatus_t status;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    return status.level_waiting[0];
+}
+
+TEST_CASE("isotp: First Frame enfileira o Flow Control sem bloquear", "[isotp]")
+{
+    can_esp_isotp_t session;
+    can_esp_handle_t inst = isotp_test_setup(&session);
+    const uint8_t first[8] = { 0x10U, 20U, 1U, 2U, 3U, 4U, 5U, 6U };
+    CanEspIsoTpStats_t stats;
+
+    /* Sem tarefa de transmissão: o FC fica na fila em vez de aguardar o driver */
+    isotp_test_deliver(inst, first, sizeof(first));
+    TEST_ASSERT_EQUAL(1U, isotp_test_queued_fc(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_IsoTpGetStats(session, &stats));
+    TEST_ASSERT_EQUAL(0U, stats.rx_errors);
+
+    isotp_test_teardown(inst, session);
+}
+
+TEST_CASE("isotp: First Frame com FF_DL inválido é ignorado", "[isotp]")
+{
+    can_esp_isotp_t session;
+    can_esp_handle_t inst = isotp_test_setup(&session);
+    const uint8_t short_ff[8] = { 0x10U, 7U, 1U, 2U, 3U, 4U, 5U, 6U };
+    const uint8_t short_escape[8] = { 0x10U, 0x00U, 0x00U, 0x00U, 0x0FU, 0xFFU, 1U, 2U };
+    CanEspIsoTpStats_t stats;
+
+    isotp_test_deliver(inst, short_ff, sizeof(short_ff));
+    isotp_test_deliver(inst, short_escape, sizeof(short_escape));
+    TEST_ASSERT_EQUAL(0U, isotp_test_queued_fc(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_IsoTpGetStats(session, &stats));
+    TEST_ASSERT_EQUAL(2U, stats.rx_errors);
+
+    isotp_test_teardown(inst, session);
+}
@@ -0,0 +1,20 @@
+/*
+ * test_main.c
+ * Executor dos testes de host da can_esp_lib (alvo linux)
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <stdlib.h>
+
+#include "unity.h"
+
+void app_main(void)
+{
+    int failures;
+
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    failures = UNITY_END();
+    exit((failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
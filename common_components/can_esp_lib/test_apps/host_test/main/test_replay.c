@@ -0,0 +1,184 @@
+/*
+ * test_replay.c
+ * Testes da reprodução de logs: caminho pela fila, bypass explícito e interrupção
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_replay.h"
+#include "can_esp_virtual_bus.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define REPLAY_TEST_BITRATE     (500000U)
+#define REPLAY_TEST_WAIT_MS     (1000U)
+#define REPLAY_TEST_MODULE      (0x2BU)
+#define REPLAY_TEST_STOP_MS     (50U)
+
+static const CanEspDriverOps_t *replayOps;
+static void *replayPeer;
+
+/* Instância privada sobre o nó a, sem tarefas (a fila retém o que for enfileirado); o nó b escuta */
+static can_esp_handle_t replay_test_setup(void)
+{
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    CanEspConfig_t config;
+    can_esp_vbus_node_t node_a;
+    can_esp_vbus_node_t node_b;
+    can_esp_handle_t inst;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(REPLAY_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_a));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_b));
+    replayOps = CAN_ESP_VirtualBusGetOps();
+    replayPeer = CAN_ESP_VirtualBusNodeContext(node_b);
+    TEST_ASSERT_EQUAL(ESP_OK, replayOps->install(replayPeer, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, replayOps->start(replayPeer));
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_CreateInstance(&inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, replayOps, CAN_ESP_VirtualBusNodeContext(node_a)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = REPLAY_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    config.filter_config = filter;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+    return inst;
+}
+
+static void replay_test_teardown(can_esp_handle_t inst)
+{
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_DeleteInstance(inst));
+    TEST_ASSERT_EQUAL(ESP_OK, replayOps->stop(replayPeer));
+    TEST_ASSERT_EQUAL(ESP_OK, replayOps->uninstall(replayPeer));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+static CanEspCaptureRecord_t replay_test_record(int64_t timestamp_us, uint32_t id, uint8_t flags)
+{
+    CanEspCaptureRecord_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.timestamp_us = timestamp_us;
+    rec.id = id;
+    rec.flags = flags;
+    rec.length = 2U;
+    rec.data[0] = 0xCAU;
+    rec.data[1] = 0xFEU;
+    return rec;
+}
+
+static uint32_t replay_test_queued(can_esp_handle_t inst)
+{
+    CanEspQueueStatus_t status;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    return (uint32_t)status.messages_waiting;
+}
+
+TEST_CASE("replay: quadros passam pela fila e pelos limites de taxa", "[replay]")
+{
+    can_esp_handle_t inst = replay_test_setup();
+    uint32_t limited = CAN_ESP_EncodeID(3U, REPLAY_TEST_MODULE, 1U);
+    CanEspRateLimitConfig_t limit = {
+        .id = limited,
+        .mask = CAN_ESP_ID_MASK_EXACT,
+        .rate_per_s = 1U,
+        .burst = 1U,
+        .policy = CAN_ESP_RATE_LIMIT_DROP,
+        .max_delay_ms = 0U,
+    };
+    const CanEspCaptureRecord_t records[] = {
+        replay_test_record(0, limited, CAN_ESP_CAPTURE_FLAG_EXTD),
+        replay_test_record(10, limited, CAN_ESP_CAPTURE_FLAG_EXTD),
+        replay_test_record(20, CAN_ESP_EncodeID(3U, REPLAY_TEST_MODULE, 2U), CAN_ESP_CAPTURE_FLAG_EXTD),
+        replay_test_record(30, 0x123U, 0U),
+    };
+    CanEspReplayConfig_t config;
+    CanEspReplayStats_t stats;
+    twai_message_t rx;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_AddRateLimit_v2(inst, &limit, NULL));
+    CAN_ESP_ReplayDefaultConfig(&config);
+    TEST_ASSERT_FALSE(config.bypass_tx_queue);
+    config.handle = inst;
+    config.speed_factor = 0.0f;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_ReplayRecords(&config, records, 4U, &stats));
+    TEST_ASSERT_EQUAL(2U, stats.frames_sent);
+    TEST_ASSERT_EQUAL(1U, stats.frames_failed);     /* segundo quadro recusado pelo limite de taxa */
+    TEST_ASSERT_EQUAL(1U, stats.frames_skipped);    /* ID padrão: fora do formato da fila */
+    TEST_ASSERT_FALSE(stats.aborted);
+
+    /* Sem tarefa de transmissão os quadros aguardam na fila: nada foi direto ao driver */
+    TEST_ASSERT_EQUAL(2U, replay_test_queued(inst));
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, replayOps->receive(replayPeer, &rx, pdMS_TO_TICKS(REPLAY_TEST_STOP_MS)));
+
+    replay_test_teardown(inst);
+}
+
+TEST_CASE("replay: bypass_tx_queue transmite o quadro bruto fora da fila", "[replay]")
+{
+    can_esp_handle_t inst = replay_test_setup();
+    const CanEspCaptureRecord_t record = replay_test_record(0, 0x123U, 0U);
+    CanEspReplayConfig_t config;
+    CanEspReplayStats_t stats;
+    twai_message_t rx;
+
+    CAN_ESP_ReplayDefaultConfig(&config);
+    config.handle = inst;
+    config.speed_factor = 0.0f;
+    config.bypass_tx_queue = true;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_ReplayRecords(&config, &record, 1U, &stats));
+    TEST_ASSERT_EQUAL(1U, stats.frames_sent);
+    TEST_ASSERT_EQUAL(0U, replay_test_queued(inst));
+
+    TEST_ASSERT_EQUAL(ESP_OK, replayOps->receive(replayPeer, &rx, pdMS_TO_TICKS(REPLAY_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL_HEX32(0x123U, rx.identifier);
+    TEST_ASSERT_EQUAL(0U, rx.extd);
+    TEST_ASSERT_EQUAL(2U, rx.data_length_code);
+    TEST_ASSERT_EQUAL_HEX8(0xCAU, rx.data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xFEU, rx.data[1]);
+
+    replay_test_teardown(inst);
+}
+
+static void replay_test_stop_task(void *arg)
+{
+    (void)arg;
+    vTaskDelay(pdMS_TO_TICKS(REPLAY_TEST_STOP_MS));
+    CAN_ESP_ReplayStop();
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("replay: interrupção retorna CAN_ESP_ERR_ABORTED", "[replay]")
+{
+    can_esp_handle_t inst = replay_test_setup();
+    const CanEspCaptureRecord_t records[] = {
+        replay_test_record(0, CAN_ESP_EncodeID(3U, REPLAY_TEST_MODULE, 1U), CAN_ESP_CAPTURE_FLAG_EXTD),
+        replay_test_record(10000000, CAN_ESP_EncodeID(3U, REPLAY_TEST_MODULE, 2U), CAN_ESP_CAPTURE_FLAG_EXTD),
+    };
+    CanEspReplayConfig_t config;
+    CanEspReplayStats_t stats;
+
+    CAN_ESP_ReplayDefaultConfig(&config);
+    config.handle = inst;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(replay_test_stop_task, "replay_stop", 4096U, NULL, 5U, NULL));
+
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_ABORTED, CAN_ESP_ReplayRecords(&config, records, 2U, &stats));
+    TEST_ASSERT_TRUE(stats.aborted);
+    TEST_ASSERT_EQUAL(1U, stats.frames_sent);
+    TEST_ASSERT_LESS_THAN(1000000, stats.elapsed_us);
+
+    replay_test_teardown(inst);
+}
@@ -0,0 +1,118 @@
+/*
+ * test_subscriptions.c
+ * Testes das inscrições de recepção: despacho fora do mutex e validação de CAN_ESP_Unsubscribe
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_virtual_bus.h"
+
+#define SUB_TEST_BITRATE        (500000U)
+#define SUB_TEST_WAIT_MS        (1000U)
+
+typedef struct {
+    can_esp_handle_t inst;
+    can_esp_subscription_t sub;
+    uint32_t calls;
+    can_esp_status_t unsubscribe_status;
+} sub_test_ctx_t;
+
+static const CanEspDriverOps_t *subOps;
+static void *subPeer;
+
+/* Instância privada sobre o nó a; o nó b injeta quadros */
+static can_esp_handle_t sub_test_setup(void)
+{
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    CanEspConfig_t config;
+    can_esp_vbus_node_t node_a;
+    can_esp_vbus_node_t node_b;
+    can_esp_handle_t inst;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(SUB_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_a));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_b));
+    subOps = CAN_ESP_VirtualBusGetOps();
+    subPeer = CAN_ESP_VirtualBusNodeContext(node_b);
+    TEST_ASSERT_EQUAL(ESP_OK, subOps->install(subPeer, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, subOps->start(subPeer));
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_CreateInstance(&inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, subOps, CAN_ESP_VirtualBusNodeContext(node_a)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = SUB_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    config.filter_config = filter;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+    return inst;
+}
+
+static void sub_test_teardown(can_esp_handle_t inst)
+{
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_DeleteInstance(inst));
+    TEST_ASSERT_EQUAL(ESP_OK, subOps->stop(subPeer));
+    TEST_ASSERT_EQUAL(ESP_OK, subOps->uninstall(subPeer));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+/* Injeta um quadro pelo nó b e o despacha na instância */
+static void sub_test_deliver(can_esp_handle_t inst, uint32_t id)
+{
+    twai_message_t frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.identifier = id;
+    frame.extd = 1U;
+    frame.data_length_code = 1U;
+    TEST_ASSERT_EQUAL(ESP_OK, subOps->transmit(subPeer, &frame, pdMS_TO_TICKS(SUB_TEST_WAIT_MS)));
+    CAN_ESP_ProcessReceivedMessages_v2(inst);
+}
+
+/* Handler que cancela a própria inscrição (exige despacho fora do mutex de inscrições) */
+static void sub_test_self_unsubscribe(const CanEspMessage_t *msg, void *ctx)
+{
+    sub_test_ctx_t *test = (sub_test_ctx_t *)ctx;
+
+    (void)msg;
+    test->calls++;
+    test->unsubscribe_status = CAN_ESP_Unsubscribe_v2(test->inst, test->sub);
+}
+
+TEST_CASE("sub: handler pode cancelar a própria inscrição", "[sub]")
+{
+    can_esp_handle_t inst = sub_test_setup();
+    uint32_t id = CAN_ESP_EncodeID(2U, 0x15U, 0x7U);
+    sub_test_ctx_t test = { .inst = inst, .calls = 0U, .unsubscribe_status = CAN_ESP_ERR_UNKNOWN };
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SubscribeId_v2(inst, id, sub_test_self_unsubscribe, &test, &test.sub));
+    sub_test_deliver(inst, id);
+    TEST_ASSERT_EQUAL(1U, test.calls);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, test.unsubscribe_status);
+
+    sub_test_deliver(inst, id);
+    TEST_ASSERT_EQUAL(1U, test.calls);
+
+    sub_test_teardown(inst);
+}
+
+TEST_CASE("sub: Unsubscribe recusa handle inválido ou livre", "[sub]")
+{
+    can_esp_handle_t inst = sub_test_setup();
+    sub_test_ctx_t test = { .inst = inst, .calls = 0U };
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SubscribeId_v2(inst, 0x100U, sub_test_self_unsubscribe, &test, &test.sub));
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_INVALID_PARAM, CAN_ESP_Unsubscribe_v2(inst, CAN_ESP_MAX_SUBSCRIPTIONS));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Unsubscribe_v2(inst, test.sub));
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_INVALID_PARAM, CAN_ESP_Unsubscribe_v2(inst, test.sub));
+
+    sub_test_teardown(inst);
+}
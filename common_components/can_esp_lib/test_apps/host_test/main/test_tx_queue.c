@@ -0,0 +1,139 @@
+/*
+ * test_tx_queue.c
+ * Testes da fila de transmissão: substituição de valores (replace_queued) e admissão de lotes
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "can_esp_instance.h"
+#include "can_esp_virtual_bus.h"
+
+#include "esp_timer.h"
+
+#define TXQ_TEST_BITRATE        (500000U)
+#define TXQ_TEST_MODULE         (0x2AU)
+#define TXQ_TEST_IDS            (20U)
+
+/*
+ * Instância privada sobre um nó do barramento virtual, sem tarefas: as mensagens enfileiradas
+ * permanecem na fila e podem ser contadas por nível.
+ */
+static can_esp_handle_t txq_test_setup(void)
+{
+    CanEspConfig_t config;
+    can_esp_vbus_node_t node;
+    can_esp_handle_t inst;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(TXQ_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_CreateInstance(&inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_SetDriverBackend_v2(inst, CAN_ESP_VirtualBusGetOps(),
+                                                             CAN_ESP_VirtualBusNodeContext(node)));
+    memset(&config, 0, sizeof(config));
+    config.bitrate = TXQ_TEST_BITRATE;
+    config.transmit_timeout_ms = 10U;
+    config.receive_timeout_ms = 10U;
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_InitWithConfig_v2(inst, &config));
+    return inst;
+}
+
+static void txq_test_teardown(can_esp_handle_t inst)
+{
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_Deinit_v2(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_DeleteInstance(inst));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+static CanEspMessage_t txq_test_message(uint8_t priority, uint16_t command, uint8_t value)
+{
+    CanEspMessage_t msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.id = CAN_ESP_EncodeID(priority, TXQ_TEST_MODULE, command);
+    msg.length = 1U;
+    msg.data[0] = value;
+    return msg;
+}
+
+TEST_CASE("txq: replace_queued mantém um slot por ID na fila", "[txq]")
+{
+    can_esp_handle_t inst = txq_test_setup();
+    CanEspTxDeadlinePolicy_t policy = {
+        .id = CAN_ESP_EncodeID(3U, TXQ_TEST_MODULE, 0U),
+        .mask = CAN_ESP_EncodeID(7U, 0x3FFU, 0U),
+        .lifetime_us = 0U,
+        .replace_queued = true,
+    };
+    CanEspTxDeadlineStats_t stats;
+    CanEspQueueStatus_t status;
+    CanEspMessage_t msg;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_AddTxDeadlinePolicy_v2(inst, &policy, NULL));
+
+    /* Várias atualizações de muitos IDs (colisões no índice): cada ID ocupa um único slot */
+    for (uint8_t round = 0U; round < 3U; round++) {
+        for (uint16_t i = 0U; i < TXQ_TEST_IDS; i++) {
+            msg = txq_test_message(3U, i, round);
+            TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_EnqueueMessage_v2(inst, &msg, false));
+        }
+    }
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    TEST_ASSERT_EQUAL(TXQ_TEST_IDS, status.level_waiting[3]);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetTxDeadlineStats_v2(inst, &stats));
+    TEST_ASSERT_EQUAL(2U * TXQ_TEST_IDS, stats.replaced);
+
+    /* Outro nível (high_priority) não substitui o valor que aguarda no nível 3 */
+    msg = txq_test_message(3U, 0U, 9U);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_EnqueueMessage_v2(inst, &msg, true));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    TEST_ASSERT_EQUAL(1U, status.level_waiting[0]);
+    TEST_ASSERT_EQUAL(TXQ_TEST_IDS, status.level_waiting[3]);
+
+    /* IDs fora da política não são substituídos */
+    msg = txq_test_message(5U, 1U, 0U);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_EnqueueMessage_v2(inst, &msg, false));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_EnqueueMessage_v2(inst, &msg, false));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    TEST_ASSERT_EQUAL(2U, status.level_waiting[5]);
+
+    txq_test_teardown(inst);
+}
+
+TEST_CASE("txq: max_delay do limite de taxa é um prazo único para o lote", "[txq]")
+{
+    can_esp_handle_t inst = txq_test_setup();
+    CanEspMessage_t batch[3];
+    CanEspRateLimitConfig_t limit = {
+        .id = CAN_ESP_EncodeID(4U, TXQ_TEST_MODULE, 1U),
+        .mask = CAN_ESP_ID_MASK_EXACT,
+        .rate_per_s = 10U,
+        .burst = 1U,
+        .policy = CAN_ESP_RATE_LIMIT_DELAY,
+        .max_delay_ms = 150U,
+    };
+    CanEspQueueStatus_t status;
+    int64_t start;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_AddRateLimit_v2(inst, &limit, NULL));
+    for (uint8_t i = 0U; i < 3U; i++) {
+        batch[i] = txq_test_message(4U, 1U, i);
+    }
+
+    /* Cada mensagem esperaria 100 ms (dentro de max_delay), mas o lote precisaria de 200 ms */
+    start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(CAN_ESP_ERR_RATE_LIMITED, CAN_ESP_EnqueueBatch_v2(inst, batch, 3U, false));
+    TEST_ASSERT_LESS_THAN(200000, esp_timer_get_time() - start);
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    TEST_ASSERT_EQUAL(0U, status.messages_waiting);
+
+    /* Os tokens devolvidos permitem um lote que cabe no prazo */
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_EnqueueBatch_v2(inst, batch, 2U, false));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_GetQueueStatus_v2(inst, &status));
+    TEST_ASSERT_EQUAL(2U, status.messages_waiting);
+
+    txq_test_teardown(inst);
+}
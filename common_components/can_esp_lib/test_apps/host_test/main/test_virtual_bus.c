@@ -0,0 +1,172 @@
+/*
+ * test_virtual_bus.c
+ * Testes do barramento CAN virtual: tráfego entre nós e desinstalação concorrente com filas em uso
+ * Projeto acadêmico para Mestrado Profissional em Engenharia Elétrica - UnB
+ * Nome da biblioteca: can_esp_lib
+ */
+
+#include <string.h>
+
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "can_esp_virtual_bus.h"
+
+#define VBUS_TEST_BITRATE       (500000U)
+#define VBUS_TEST_WAIT_MS       (1000U)
+
+typedef struct {
+    const CanEspDriverOps_t *ops;
+    void *ctx;
+    SemaphoreHandle_t done;
+    esp_err_t result;
+    uint32_t sent;
+} vbus_test_worker_t;
+
+static const CanEspDriverOps_t *vbus_test_setup(void **a, void **b)
+{
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    const CanEspDriverOps_t *ops;
+    can_esp_vbus_node_t node_a;
+    can_esp_vbus_node_t node_b;
+
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusInit(VBUS_TEST_BITRATE));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_a));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusAddNode(&node_b));
+    ops = CAN_ESP_VirtualBusGetOps();
+    *a = CAN_ESP_VirtualBusNodeContext(node_a);
+    *b = CAN_ESP_VirtualBusNodeContext(node_b);
+    TEST_ASSERT_EQUAL(ESP_OK, ops->install(*a, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->install(*b, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->start(*a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->start(*b));
+    return ops;
+}
+
+static twai_message_t vbus_test_frame(uint32_t id)
+{
+    twai_message_t frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.identifier = id;
+    frame.data_length_code = 2U;
+    frame.data[0] = 0xA5U;
+    frame.data[1] = 0x5AU;
+    return frame;
+}
+
+/* Receptor bloqueado sem prazo: deve sair quando o nó for desinstalado */
+static void vbus_test_receiver(void *arg)
+{
+    vbus_test_worker_t *worker = (vbus_test_worker_t *)arg;
+    twai_message_t frame;
+
+    worker->result = worker->ops->receive(worker->ctx, &frame, portMAX_DELAY);
+    (void)xSemaphoreGive(worker->done);
+    vTaskDelete(NULL);
+}
+
+/* Transmissor contínuo: deve parar com ESP_ERR_INVALID_STATE quando o nó for parado e desinstalado */
+static void vbus_test_sender(void *arg)
+{
+    vbus_test_worker_t *worker = (vbus_test_worker_t *)arg;
+    twai_message_t frame = vbus_test_frame(0x123U);
+    esp_err_t err;
+
+    do {
+        err = worker->ops->transmit(worker->ctx, &frame, pdMS_TO_TICKS(5U));
+        if (err == ESP_OK) {
+            worker->sent++;
+        }
+    } while (err == ESP_OK || err == ESP_ERR_TIMEOUT);
+    worker->result = err;
+    (void)xSemaphoreGive(worker->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("vbus: quadro transmitido por um nó chega ao outro", "[vbus]")
+{
+    void *a;
+    void *b;
+    const CanEspDriverOps_t *ops = vbus_test_setup(&a, &b);
+    twai_message_t tx = vbus_test_frame(0x18FF0001U);
+    twai_message_t rx;
+
+    tx.extd = 1U;
+    TEST_ASSERT_EQUAL(ESP_OK, ops->transmit(a, &tx, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->receive(b, &rx, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL_HEX32(tx.identifier, rx.identifier);
+    TEST_ASSERT_EQUAL(2, rx.data_length_code);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(tx.data, rx.data, 2);
+
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(b));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(b));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+}
+
+TEST_CASE("vbus: desinstalação aguarda o receptor bloqueado na fila", "[vbus]")
+{
+    void *a;
+    void *b;
+    const CanEspDriverOps_t *ops = vbus_test_setup(&a, &b);
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(TWAI_IO_UNUSED, TWAI_IO_UNUSED, TWAI_MODE_NORMAL);
+    twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    twai_message_t frame = vbus_test_frame(0x100U);
+    vbus_test_worker_t worker = { .ops = ops, .ctx = b, .result = ESP_FAIL };
+
+    worker.done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(worker.done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(vbus_test_receiver, "vbus_rx", 4096U, &worker, 5U, NULL));
+    vTaskDelay(pdMS_TO_TICKS(20U));
+
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(b));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(b));
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(worker.done, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, worker.result);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, ops->receive(b, &frame, 0U));
+
+    /* O nó volta a ser utilizável depois da desinstalação */
+    TEST_ASSERT_EQUAL(ESP_OK, ops->install(b, &general, &timing, &filter));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->start(b));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->transmit(a, &frame, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->receive(b, &frame, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(b));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(b));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+    vSemaphoreDelete(worker.done);
+}
+
+TEST_CASE("vbus: desinstalação durante transmissões contínuas", "[vbus]")
+{
+    void *a;
+    void *b;
+    const CanEspDriverOps_t *ops = vbus_test_setup(&a, &b);
+    vbus_test_worker_t worker = { .ops = ops, .ctx = a, .result = ESP_FAIL, .sent = 0U };
+
+    worker.done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(worker.done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(vbus_test_sender, "vbus_tx", 4096U, &worker, 5U, NULL));
+    vTaskDelay(pdMS_TO_TICKS(50U));
+
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(a));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(a));
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(worker.done, pdMS_TO_TICKS(VBUS_TEST_WAIT_MS)));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, worker.result);
+    TEST_ASSERT_GREATER_THAN_UINT32(0U, worker.sent);
+
+    TEST_ASSERT_EQUAL(ESP_OK, ops->stop(b));
+    TEST_ASSERT_EQUAL(ESP_OK, ops->uninstall(b));
+    TEST_ASSERT_EQUAL(CAN_ESP_OK, CAN_ESP_VirtualBusDeinit());
+    vSemaphoreDelete(worker.done);
+}
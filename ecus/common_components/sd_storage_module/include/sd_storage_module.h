@@ -106,6 +106,31 @@ bool sd_storage_module_init(void);
  */
 bool sd_storage_module_write(const char *filename, const char *data);
 
+/**
+ * @brief Abre um arquivo para gravação contínua em blocos (ex.: exportação de captura CAN).
+ *
+ * Mantém o arquivo aberto e o acesso ao SD Card reservado até sd_storage_module_stream_close(),
+ * evitando abrir e fechar o arquivo a cada bloco. Apenas um fluxo pode estar aberto por vez.
+ *
+ * @param filename Nome do arquivo (relativo ao MOUNT_POINT); o conteúdo existente é preservado.
+ * @return true se o arquivo foi aberto, false caso contrário.
+ */
+bool sd_storage_module_stream_open(const char *filename);
+
+/**
+ * @brief Grava um bloco no fluxo aberto, sem acrescentar nova linha.
+ *
+ * @param data Dados a serem gravados.
+ * @param length Tamanho dos dados.
+ * @return true se a gravação for bem-sucedida, false caso contrário.
+ */
+bool sd_storage_module_stream_write(const char *data, size_t length);
+
+/**
+ * @brief Fecha o fluxo aberto e libera o acesso ao SD Card.
+ */
+void sd_storage_module_stream_close(void);
+
 /**
  * @brief Lê um arquivo do SD Card e retorna seu conteúdo.
  *
@@ -44,6 +44,9 @@ static SemaphoreHandle_t sd_mutex = NULL;
 static bool sd_initialized = false;
 static sdmmc_card_t *sd_card = NULL;
 
+/* Arquivo do fluxo de gravação em blocos (aberto com sd_mutex adquirido) */
+static FILE *stream_file = NULL;
+
 /* Fila de escrita assíncrona */
 static QueueHandle_t async_write_queue = NULL;
 
@@ -276,6 +279,72 @@ bool sd_storage_module_write(const char *filename, const char *data)
     return false;
 }
 
+/**
+ * @brief Abre um arquivo para gravação contínua em blocos.
+ *
+ * @param filename Nome do arquivo.
+ * @return true se o arquivo foi aberto, false caso contrário.
+ */
+bool sd_storage_module_stream_open(const char *filename)
+{
+    char path[MAX_FILENAME_LENGTH];
+
+    if (filename == NULL)
+    {
+        ESP_LOGE(TAG, "Parâmetros inválidos para abertura do fluxo.");
+        return false;
+    }
+    if (!sd_initialized)
+    {
+        ESP_LOGE(TAG, "SD Card não inicializado.");
+        return false;
+    }
+    (void)snprintf(path, MAX_FILENAME_LENGTH, "%s/%s", MOUNT_POINT, filename);
+    if (xSemaphoreTake(sd_mutex, portMAX_DELAY) != pdTRUE)
+    {
+        return false;
+    }
+    stream_file = fopen(path, "a");
+    if (stream_file == NULL)
+    {
+        ESP_LOGE(TAG, "Falha ao abrir arquivo %s", path);
+        xSemaphoreGive(sd_mutex);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Grava um bloco no fluxo aberto.
+ *
+ * @param data Dados a serem gravados.
+ * @param length Tamanho dos dados.
+ * @return true se a gravação for bem-sucedida, false caso contrário.
+ */
+bool sd_storage_module_stream_write(const char *data, size_t length)
+{
+    if ((stream_file == NULL) || (data == NULL))
+    {
+        ESP_LOGE(TAG, "Fluxo de gravação não aberto.");
+        return false;
+    }
+    return fwrite(data, 1U, length, stream_file) == length;
+}
+
+/**
+ * @brief Fecha o fluxo aberto e libera o acesso ao SD Card.
+ */
+void sd_storage_module_stream_close(void)
+{
+    if (stream_file == NULL)
+    {
+        return;
+    }
+    fclose(stream_file);
+    stream_file = NULL;
+    xSemaphoreGive(sd_mutex);
+}
+
 /**
  * @brief Lê um arquivo do SD Card e copia seu conteúdo para um buffer.
  *
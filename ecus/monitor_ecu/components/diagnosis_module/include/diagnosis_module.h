@@ -30,9 +30,11 @@ extern "C" {
  */
 typedef struct {
     CanEspDiagnostics_t can_diag;           /**< Diagnóstico do barramento CAN (TX/RX erros, Bus-Off). */
-    CanEspLatencyMetrics_t latency;         /**< Métricas de latência da transmissão CAN. */
+    CanEspLatencyMetrics_t latency;         /**< Métricas de latência da transmissão CAN (acumuladas). */
+    CanEspLatencyMetrics_t latency_window;  /**< Métricas de latência desde a medição anterior. */
     CanEspQueueStatus_t queue_status;       /**< Status da fila de transmissão. */
-    uint32_t bus_load;                      /**< Carga do barramento CAN (em porcentagem). */
+    uint32_t bus_load;                      /**< Carga do barramento CAN (em porcentagem, janela de 1 s). */
+    CanEspBusLoadStats_t bus_load_stats;    /**< Utilização por janela (100 ms / 1 s / 10 s) em bits no fio. */
     uint32_t retransmission_count;          /**< Número total de retransmissões ocorridas. */
     uint32_t collision_count;               /**< Número total de colisões (proxy). */
     uint32_t transmission_attempts;         /**< Número total de tentativas de transmissão. */
@@ -122,8 +124,8 @@ bool diagnosis_module_register_alert_callback(diagnosis_alert_callback_t callbac
 /**
  * @brief Calcula estatísticas avançadas da latência utilizando o histórico.
  *
- * Calcula a média e o desvio padrão da latência (campo max_latency de cada medição)
- * a partir dos registros históricos.
+ * Calcula a média e o desvio padrão da latência de transmissão a partir do histograma
+ * acumulado mantido pela biblioteca CAN (todas as amostras, não apenas os máximos).
  *
  * @param[out] average Ponteiro para armazenar a média da latência (em microsegundos).
  * @param[out] stddev Ponteiro para armazenar o desvio padrão da latência (em microsegundos).
@@ -16,7 +16,6 @@
 #include "esp_timer.h"
 
 #include <stdio.h>
-#include <math.h>
 
 static const char *TAG = "DIAGNOSIS_MODULE";
 
@@ -82,6 +81,12 @@ bool diagnosis_module_init(void)
         ESP_LOGE(TAG, "Falha ao inicializar a camada CAN.");
         return false;
     }
+    /* Recuperação de bus-off conduzida pelos alertas do driver, sem depender do polling */
+    if (CAN_ESP_StartRecoverySupervisor(NULL) != CAN_ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao iniciar o supervisor de recuperação CAN.");
+        return false;
+    }
     ESP_LOGI(TAG, "Módulo de diagnóstico inicializado com sucesso.");
     return true;
 }
@@ -105,12 +110,18 @@ bool diagnosis_module_update(DiagnosisData_t *data)
         ESP_LOGE(TAG, "Falha ao obter métricas de latência.");
         return false;
     }
+    (void)CAN_ESP_ResetLatencyWindow(&data->latency_window);
     if (CAN_ESP_GetQueueStatus(&data->queue_status) != CAN_ESP_OK)
     {
         ESP_LOGE(TAG, "Falha ao obter status da fila de transmissão.");
         return false;
     }
-    data->bus_load = CAN_ESP_GetBusLoad();
+    if (CAN_ESP_GetBusLoadStats(&data->bus_load_stats) != CAN_ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao obter estatísticas de bus load.");
+        return false;
+    }
+    data->bus_load = data->bus_load_stats.load_1s_permille / 10U;
     data->retransmission_count = CAN_ESP_GetRetransmissionCount();
     data->collision_count = CAN_ESP_GetCollisionCount();
     data->transmission_attempts = CAN_ESP_GetTransmissionAttempts();
@@ -146,12 +157,30 @@ void diagnosis_module_print(const DiagnosisData_t *data)
              (data->latency.total_latency / 1000U),
              (data->latency.min_latency / 1000U),
              (data->latency.max_latency / 1000U));
+    ESP_LOGI(TAG, "Latência na janela (us): Amostras = %" PRIu32 ", p50 = %" PRId64 ", p90 = %" PRId64 ", p99 = %" PRId64 ", p99.9 = %" PRId64 ", Máxima = %" PRId64,
+             data->latency_window.num_samples,
+             data->latency_window.p50_latency,
+             data->latency_window.p90_latency,
+             data->latency_window.p99_latency,
+             data->latency_window.p999_latency,
+             data->latency_window.max_latency);
     
     ESP_LOGI(TAG, "Status da Fila: %u mensagens esperando de %u",
              (unsigned int)data->queue_status.messages_waiting,
              (unsigned int)data->queue_status.queue_capacity);
+    ESP_LOGI(TAG, "Fila por prioridade (P0..P7, capacidade %u cada): %u %u %u %u %u %u %u %u",
+             (unsigned int)data->queue_status.level_capacity,
+             (unsigned int)data->queue_status.level_waiting[0], (unsigned int)data->queue_status.level_waiting[1],
+             (unsigned int)data->queue_status.level_waiting[2], (unsigned int)data->queue_status.level_waiting[3],
+             (unsigned int)data->queue_status.level_waiting[4], (unsigned int)data->queue_status.level_waiting[5],
+             (unsigned int)data->queue_status.level_waiting[6], (unsigned int)data->queue_status.level_waiting[7]);
     
     ESP_LOGI(TAG, "Bus Load: %" PRIu32 "%%", data->bus_load);
+    ESP_LOGI(TAG, "Bus Load por janela: 100 ms = %" PRIu32 ".%" PRIu32 "%%, 1 s = %" PRIu32 ".%" PRIu32 "%%, 10 s = %" PRIu32 ".%" PRIu32 "%% (TX %" PRIu32 ", RX %" PRIu32 " quadros)",
+             data->bus_load_stats.load_100ms_permille / 10U, data->bus_load_stats.load_100ms_permille % 10U,
+             data->bus_load_stats.load_1s_permille / 10U, data->bus_load_stats.load_1s_permille % 10U,
+             data->bus_load_stats.load_10s_permille / 10U, data->bus_load_stats.load_10s_permille % 10U,
+             data->bus_load_stats.tx_frames, data->bus_load_stats.rx_frames);
     
     ESP_LOGI(TAG, "Retransmissões Totais: %" PRIu32 "", data->retransmission_count);
     ESP_LOGI(TAG, "Colisões Totais: %" PRIu32 "", data->collision_count);
@@ -226,9 +255,9 @@ bool diagnosis_module_register_alert_callback(diagnosis_alert_callback_t callbac
  *------------------------------------------------------------------------------*/
 
 /**
- * @brief Calcula a média e o desvio padrão da latência (max_latency) utilizando o histórico.
+ * @brief Calcula a média e o desvio padrão da latência de transmissão.
  *
- * Itera sobre o buffer histórico e calcula a média e o desvio padrão do campo max_latency.
+ * Utiliza o histograma acumulado da biblioteca CAN, que contém todas as amostras de latência.
  *
  * @param[out] average Ponteiro para a média da latência (em microsegundos).
  * @param[out] stddev Ponteiro para o desvio padrão da latência (em microsegundos).
@@ -236,35 +265,23 @@ bool diagnosis_module_register_alert_callback(diagnosis_alert_callback_t callbac
  */
 bool diagnosis_module_get_latency_statistics(int64_t *average, int64_t *stddev)
 {
-    uint32_t count = DIAG_HISTORY_SIZE;
-    uint32_t valid_samples = 0U;
-    int64_t sum = 0;
-    int64_t sum_sq = 0;
-    uint32_t i;
+    CanEspLatencyMetrics_t metrics;
 
     if (average == NULL || stddev == NULL) {
         ESP_LOGE(TAG, "Ponteiro nulo nos parâmetros de estatísticas.");
         return false;
     }
-    /* Percorre o buffer histórico para acumular os valores de latência máxima */
-    for (i = 0U; i < count; i++) {
-        if (diag_history[i].timestamp != 0) { /* Considera apenas entradas válidas */
-            int64_t lat = diag_history[i].latency.max_latency;
-            sum += lat;
-            sum_sq += (lat * lat);
-            valid_samples++;
-        }
+    if (CAN_ESP_GetLatencyMetrics(&metrics) != CAN_ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao obter métricas de latência.");
+        return false;
     }
-    if (valid_samples == 0U) {
+    if (metrics.num_samples == 0U) {
         ESP_LOGW(TAG, "Nenhuma amostra válida para estatísticas de latência.");
         *average = 0;
         *stddev = 0;
         return true;
     }
-    *average = sum / valid_samples;
-    /* Calcula o desvio padrão (populacional) */
-    double mean = (double)*average;
-    double variance = ((double)sum_sq / valid_samples) - (mean * mean);
-    *stddev = (int64_t)sqrt(variance);
+    *average = metrics.total_latency / (int64_t)metrics.num_samples;
+    *stddev = metrics.stddev_latency;
     return true;
 }
@@ -33,8 +33,10 @@
 #include "sd_storage_module.h"
 #include "diagnosis_module.h"
 #include "logger_module.h"
+#include "can_esp_capture.h"
 #include <string.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 /* Tag para logs */
 #define TAG "MONITOR_ECU"
@@ -65,10 +67,19 @@ static uint32_t g_monitor_comm_interval_ms = 1000U;              /* Intervalo pa
 
 #define CAN_ACQ_TASK_STACK_SIZE   3072U
 #define CAN_ACQ_TASK_PRIORITY     3U
+#define CAN_ACQ_BATCH_SIZE        32U
 
-#define DIAG_ACQ_TASK_STACK_SIZE  3072U
+/* A exportação da captura CAN (buffers do CAN_ESP_CaptureExport, strftime e cadeia VFS/FATFS) roda nesta task */
+#define DIAG_ACQ_TASK_STACK_SIZE  6144U
 #define DIAG_ACQ_TASK_PRIORITY    3U
 
+/* Formato dos arquivos de captura CAN gravados no SD Card após um bus-off */
+#define CAN_CAPTURE_FORMAT        CAN_ESP_CAPTURE_FORMAT_ASC
+#define CAN_CAPTURE_FILE_EXT      ".asc"
+
+/* Quantidade de identificadores mais ativos reportados a cada persistência diagnóstica */
+#define CAN_TOP_TALKERS           5U
+
 /* Estrutura para armazenar estatísticas de aquisição CAN */
 typedef struct
 {
@@ -77,6 +88,9 @@ typedef struct
 
 static CanAcquisitionStats_t can_stats = { 0 };
 
+/* Snapshot da tabela de estatísticas por ID (estático para não pesar na pilha da task) */
+static CanEspIdStats_t can_id_stats[CAN_ESP_ID_STATS_TABLE_SIZE];
+
 /* Variável para controle do último log persistente dos diagnósticos (em ms) */
 static uint32_t last_diag_persist_time_ms = 0U;
 
@@ -225,7 +239,8 @@ static bool perform_rollback(const char *ecu_id)
 /**
  * @brief Task de aquisição de mensagens CAN.
  *
- * Captura continuamente as mensagens que transitam na rede CAN-ESP utilizando CAN_ESP_ReceiveMessage().
+ * Captura continuamente as mensagens que transitam na rede CAN-ESP utilizando CAN_ESP_ReceiveBatch(),
+ * que bloqueia apenas pelo primeiro quadro e drena em seguida todos os quadros já enfileirados no driver.
  * Atualiza estatísticas e registra os dados em nível DEBUG, utilizando identificador CAN estendido (29 bits).
  *
  * @param pvParameters Parâmetro da task (não utilizado).
@@ -233,34 +248,131 @@ static bool perform_rollback(const char *ecu_id)
 static void can_acquisition_task(void *pvParameters)
 {
     (void)pvParameters;
-    CanEspMessage_t msg;
+    CanEspMessage_t msgs[CAN_ACQ_BATCH_SIZE];
+    size_t count = 0U;
     uint8_t priority = 0;
     uint16_t ecu_id = 0;
     uint16_t command_id = 0;
 
     for (;;)
     {
-        if (CAN_ESP_ReceiveMessage(&msg, pdMS_TO_TICKS(g_monitor_can_receive_timeout_ms)) == CAN_ESP_OK)
+        if (CAN_ESP_ReceiveBatch(msgs, CAN_ACQ_BATCH_SIZE, g_monitor_can_receive_timeout_ms, &count) != CAN_ESP_OK)
         {
+            continue;
+        }
+        for (size_t i = 0U; i < count; i++)
+        {
+            const CanEspMessage_t *msg = &msgs[i];
             can_stats.total_messages_received++;
             /* Decodifica o identificador estendido de 29 bits */
-            priority = (uint8_t)((msg.id >> 26) & 0x07U);
-            ecu_id = (uint16_t)((msg.id >> 16) & 0x03FFU);
-            command_id = (uint16_t)(msg.id & 0xFFFFU);
-            ESP_LOGD(TAG, "CAN Acquisition: Msg received - Ext ID: 0x%08X, Priority: %u, ECU ID: 0x%03X, Command: 0x%04X, Length: %u, Total: %u",
-                     msg.id, priority, ecu_id, command_id, msg.length, can_stats.total_messages_received);
+            priority = (uint8_t)((msg->id >> 26) & 0x07U);
+            ecu_id = (uint16_t)((msg->id >> 16) & 0x03FFU);
+            command_id = (uint16_t)(msg->id & 0xFFFFU);
+            ESP_LOGD(TAG, "CAN Acquisition: Msg received - Ext ID: 0x%08X, Priority: %u, ECU ID: 0x%03X, Command: 0x%04X, Length: %u, Rx time: %" PRId64 " us, Total: %u",
+                     msg->id, priority, ecu_id, command_id, msg->length, msg->timestamp_us, can_stats.total_messages_received);
             /* Processamento adicional pode ser adicionado aqui */
         }
-        vTaskDelay(pdMS_TO_TICKS(5));
     }
 }
 
+/**
+ * @brief Reporta os identificadores CAN com maior tráfego recebido.
+ *
+ * Ordena o snapshot da tabela por ID da biblioteca CAN pelo número de quadros recebidos e
+ * registra, para os CAN_TOP_TALKERS primeiros, a taxa, o intervalo máximo e o jitter, o que
+ * permite identificar a ECU que inunda o barramento ou a mensagem cíclica que está derivando.
+ */
+static void log_can_top_talkers(void)
+{
+    size_t count = 0U;
+    uint32_t untracked = 0U;
+    char line[160];
+
+    if (CAN_ESP_GetIdStats(can_id_stats, CAN_ESP_ID_STATS_TABLE_SIZE, &count, &untracked) != CAN_ESP_OK)
+    {
+        return;
+    }
+    /* Seleção parcial: posiciona os CAN_TOP_TALKERS maiores no início do vetor */
+    for (size_t i = 0U; (i < CAN_TOP_TALKERS) && (i < count); i++)
+    {
+        size_t best = i;
+        for (size_t j = i + 1U; j < count; j++)
+        {
+            if (can_id_stats[j].rx.frames > can_id_stats[best].rx.frames)
+            {
+                best = j;
+            }
+        }
+        CanEspIdStats_t tmp = can_id_stats[i];
+        can_id_stats[i] = can_id_stats[best];
+        can_id_stats[best] = tmp;
+
+        const CanEspIdDirStats_t *rx = &can_id_stats[i].rx;
+        uint32_t rate_hz = (rx->mean_interarrival_us > 0U) ? (1000000U / rx->mean_interarrival_us) : 0U;
+        (void)snprintf(line, sizeof(line),
+                       "CAN ID 0x%08" PRIX32 ": RX=%" PRIu32 " quadros, %" PRIu32 " Hz, Max Intervalo=%" PRIu32
+                       " us, Jitter=%" PRIu32 " us",
+                       can_id_stats[i].id, rx->frames, rate_hz, rx->max_interarrival_us, rx->jitter_us);
+        ESP_LOGI(TAG, "%s", line);
+        logger_module_async_write(line);
+    }
+    if (untracked > 0U)
+    {
+        ESP_LOGW(TAG, "Tabela de estatísticas por ID cheia: %" PRIu32 " quadros não contabilizados.", untracked);
+    }
+}
+
+/**
+ * @brief Destino da exportação da captura CAN: grava cada bloco no fluxo aberto no SD Card.
+ */
+static bool can_capture_sd_writer(const char *text, size_t length, void *ctx)
+{
+    (void)ctx;
+    return sd_storage_module_stream_write(text, length);
+}
+
+/**
+ * @brief Grava no SD Card a captura CAN congelada após um bus-off e retoma a gravação.
+ *
+ * O anel da can_esp_lib guarda os quadros que antecederam o bus-off e alguns posteriores; o
+ * arquivo recebe o instante da exportação no nome para não sobrescrever capturas anteriores.
+ * Se o arquivo não puder ser aberto, a captura permanece congelada e a gravação é tentada
+ * novamente no próximo ciclo.
+ */
+static void dump_can_capture(void)
+{
+    char filename[MAX_FILENAME_LENGTH];
+
+    if (!CAN_ESP_CaptureIsFrozen())
+    {
+        return;
+    }
+    (void)snprintf(filename, sizeof(filename), "can_capture_%" PRIu32 CAN_CAPTURE_FILE_EXT,
+                   (uint32_t)(esp_timer_get_time() / 1000U));
+    if (!sd_storage_module_stream_open(filename))
+    {
+        ESP_LOGE(TAG, "Falha ao abrir %s; captura CAN mantida congelada.", filename);
+        return;
+    }
+    if (CAN_ESP_CaptureExport(CAN_CAPTURE_FORMAT, can_capture_sd_writer, NULL) == CAN_ESP_OK)
+    {
+        ESP_LOGW(TAG, "Captura CAN gravada em %s.", filename);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Falha ao gravar a captura CAN em %s.", filename);
+    }
+    sd_storage_module_stream_close();
+    CAN_ESP_CaptureResume(true);
+}
+
 /**
  * @brief Task de aquisição e persistência dos dados diagnósticos.
  *
  * Periodicamente, invoca diagnosis_module_update() para coletar os dados diagnósticos da rede CAN.
  * Se os dados indicarem uma condição anormal ou se o intervalo de persistência for atingido, gera
- * um resumo e o armazena de forma assíncrona utilizando logger_module_async_write().
+ * um resumo e o armazena de forma assíncrona utilizando logger_module_async_write(). A cada ciclo,
+ * descarrega também a captura CAN congelada por um bus-off (dump_can_capture()).
  *
  * @param pvParameters Parâmetro da task (não utilizado).
  */
@@ -287,6 +399,7 @@ static void diagnosis_acquisition_task(void *pvParameters)
                                diag.can_diag.rx_error_counter, diag.retransmission_count,
                                diag.collision_count, diag.latency.max_latency);
                 logger_module_async_write(diag_summary);
+                log_can_top_talkers();
                 last_diag_persist_time_ms = current_time_ms;
             }
         }
@@ -294,6 +407,7 @@ static void diagnosis_acquisition_task(void *pvParameters)
         {
             ESP_LOGW(TAG, "Falha ao atualizar dados diagnósticos.");
         }
+        dump_can_capture();
         vTaskDelay(pdMS_TO_TICKS(g_monitor_diag_acq_interval_ms));
     }
 }
@@ -535,6 +649,12 @@ bool monitor_ecu_init(void)
     }
     ESP_LOGI(TAG, "Configuration Update task created successfully.");
 
+    /* Gravador de voo: o anel congela após um bus-off e é descarregado no SD Card */
+    if (CAN_ESP_CaptureStart(NULL) != CAN_ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to start CAN capture.");
+    }
+
     if (xTaskCreate(can_acquisition_task, "CAN_Acq_Task", CAN_ACQ_TASK_STACK_SIZE, NULL, CAN_ACQ_TASK_PRIORITY, NULL) != pdPASS)
     {
         ESP_LOGE(TAG, "Failed to create CAN Acquisition task.");
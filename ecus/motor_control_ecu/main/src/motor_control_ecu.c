@@ -12,6 +12,7 @@
  */
 
 #include "motor_control_ecu.h"
+#include "can_esp_lib.h"
 
 /* Definições de constantes para evitar números mágicos (MISRA C:2012) */
 #define CAN_CMD_SET_SPEED   ((uint32_t)0x100U)  /**< ID CAN para comando de definição de velocidade */
@@ -25,13 +26,17 @@ static volatile uint16_t currentSpeed = 0U;                /**< Velocidade atual
 static volatile MotorControl_State_t motorState = MOTOR_STATE_OFF;  /**< Estado atual do motor */
 static volatile MotorControl_Error_t motorError = MOTOR_CONTROL_OK; /**< Status de erro atual */
 
-/* Protótipo de função interna */
+/* Protótipos de funções internas */
 static void MotorControl_ECU_ProcessFault(uint8_t faultCode);
+static void MotorControl_ECU_ApplySpeedCommand(const uint8_t *data, uint8_t length);
+static void MotorControl_ECU_ApplyFaultMessage(const uint8_t *data, uint8_t length);
+static void MotorControl_ECU_OnSetSpeedFrame(const CanEspMessage_t *msg, void *ctx);
+static void MotorControl_ECU_OnFaultFrame(const CanEspMessage_t *msg, void *ctx);
 
 /**
  * @brief Inicializa o módulo Motor Control ECU.
  *
- * Configura as variáveis internas e prepara a interface de comunicação com o motor.
+ * Configura as variáveis internas e registra as inscrições CAN (por ID) na can_esp_lib.
  */
 void MotorControl_ECU_Init(void)
 {
@@ -41,7 +46,14 @@ void MotorControl_ECU_Init(void)
     motorState = MOTOR_STATE_OFF;
     motorError = MOTOR_CONTROL_OK;
 
-    /* Inicialização de interfaces de hardware (ex.: CAN, PWM) deve ser implementada aqui */
+    /* Inscrições por ID na can_esp_lib: cada comando é entregue diretamente ao seu handler */
+    if ((CAN_ESP_SubscribeId(CAN_CMD_SET_SPEED, MotorControl_ECU_OnSetSpeedFrame, NULL, NULL) != CAN_ESP_OK) ||
+        (CAN_ESP_SubscribeId(CAN_FAULT_MSG, MotorControl_ECU_OnFaultFrame, NULL, NULL) != CAN_ESP_OK))
+    {
+        motorError = MOTOR_CONTROL_ERROR_CAN;
+    }
+
+    /* Inicialização de interfaces de hardware (ex.: PWM) deve ser implementada aqui */
     /* O código de inicialização específico do hardware não é incluído nesta implementação genérica */
 }
 
@@ -121,20 +133,11 @@ void MotorControl_ECU_HandleCANMessage(const CAN_Message_t *msg)
     switch (msg->id)
     {
         case CAN_CMD_SET_SPEED:
-            if (msg->dlc >= 2U)
-            {
-                /* Extrai os dois primeiros bytes para compor a velocidade desejada */
-                uint16_t speedValue = (uint16_t)((((uint16_t)msg->data[0]) << 8U) |
-                                                  ((uint16_t)msg->data[1]));
-                MotorControl_ECU_SetSpeed(speedValue);
-            }
+            MotorControl_ECU_ApplySpeedCommand(msg->data, msg->dlc);
             break;
 
         case CAN_FAULT_MSG:
-            if (msg->dlc >= 1U)
-            {
-                MotorControl_ECU_ProcessFault(msg->data[0]);
-            }
+            MotorControl_ECU_ApplyFaultMessage(msg->data, msg->dlc);
             break;
 
         default:
@@ -143,6 +146,55 @@ void MotorControl_ECU_HandleCANMessage(const CAN_Message_t *msg)
     }
 }
 
+/**
+ * @brief Aplica o comando de definição de velocidade.
+ *
+ * Os dois primeiros bytes (big-endian) compõem a velocidade desejada.
+ *
+ * @param data Campo de dados da mensagem.
+ * @param length Número de bytes válidos em data.
+ */
+static void MotorControl_ECU_ApplySpeedCommand(const uint8_t *data, uint8_t length)
+{
+    if (length >= 2U)
+    {
+        uint16_t speedValue = (uint16_t)((((uint16_t)data[0]) << 8U) | ((uint16_t)data[1]));
+        MotorControl_ECU_SetSpeed(speedValue);
+    }
+}
+
+/**
+ * @brief Aplica a mensagem de falha do motor (código no primeiro byte).
+ *
+ * @param data Campo de dados da mensagem.
+ * @param length Número de bytes válidos em data.
+ */
+static void MotorControl_ECU_ApplyFaultMessage(const uint8_t *data, uint8_t length)
+{
+    if (length >= 1U)
+    {
+        MotorControl_ECU_ProcessFault(data[0]);
+    }
+}
+
+/**
+ * @brief Handler da inscrição CAN_CMD_SET_SPEED na can_esp_lib.
+ */
+static void MotorControl_ECU_OnSetSpeedFrame(const CanEspMessage_t *msg, void *ctx)
+{
+    (void)ctx;
+    MotorControl_ECU_ApplySpeedCommand(msg->data, msg->length);
+}
+
+/**
+ * @brief Handler da inscrição CAN_FAULT_MSG na can_esp_lib.
+ */
+static void MotorControl_ECU_OnFaultFrame(const CanEspMessage_t *msg, void *ctx)
+{
+    (void)ctx;
+    MotorControl_ECU_ApplyFaultMessage(msg->data, msg->length);
+}
+
 /**
  * @brief Função de atualização periódica do controle do motor.
  *